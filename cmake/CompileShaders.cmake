@@ -37,8 +37,25 @@ else()
     message(STATUS "Using predefined Vulkan target-env: ${VULKAN_TARGET_ENV}")
 endif()
 
+# Optional: optimize every module after compilation when spirv-opt is available
+find_program(SPIRV_OPT
+        NAMES spirv-opt
+        HINTS
+        $ENV{VULKAN_SDK}/Bin
+        $ENV{VULKAN_SDK}/Bin32
+)
+if(SPIRV_OPT)
+    message(STATUS "Optimizing shaders with ${SPIRV_OPT}")
+endif()
+
 # Function to compile shaders
+# add_shader(<target> <shader> [DEFINES <define>...])
+# A call with DEFINES builds one permutation, named <file>+<define>+... like wc_shader_register
+# looks it up in the shader pack. Includes are tracked through a depfile, so editing a shared
+# header rebuilds every shader and permutation using it.
 function(add_shader TARGET SHADER)
+    cmake_parse_arguments(PARSE_ARGV 2 ARG "" "" "DEFINES")
+
     find_program(GLSLANG_VALIDATOR
             NAMES glslangValidator
             HINTS
@@ -52,11 +69,23 @@ function(add_shader TARGET SHADER)
 
     set(current_shader_path ${CMAKE_CURRENT_SOURCE_DIR}/${SHADER})
     get_filename_component(current_shader_name ${SHADER} NAME)
+    set(define_flags "")
+    foreach(define ${ARG_DEFINES})
+        string(APPEND current_shader_name "+${define}")
+        list(APPEND define_flags "-D${define}")
+    endforeach()
     set(current_output_path ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/shaders/${current_shader_name}.spv)
+    set(current_depfile ${CMAKE_CURRENT_BINARY_DIR}/shader_deps/${current_shader_name}.d)
 
-    # Create output directory
+    # Create output directories
     get_filename_component(current_output_dir ${current_output_path} DIRECTORY)
     file(MAKE_DIRECTORY ${current_output_dir})
+    file(MAKE_DIRECTORY ${CMAKE_CURRENT_BINARY_DIR}/shader_deps)
+
+    set(optimize_command "")
+    if(SPIRV_OPT)
+        set(optimize_command COMMAND ${SPIRV_OPT} -O --target-env=${VULKAN_TARGET_ENV} ${current_output_path} -o ${current_output_path})
+    endif()
 
     # Add custom command for shader compilation
     add_custom_command(
@@ -64,16 +93,20 @@ function(add_shader TARGET SHADER)
             COMMAND ${GLSLANG_VALIDATOR}
             -V                          # Generate SPIR-V
             --target-env ${VULKAN_TARGET_ENV}  # Target Vulkan version from SDK
+            ${define_flags}             # Permutation defines
+            --depfile ${current_depfile} # Included files, for incremental rebuilds
             -o ${current_output_path}   # Output file
             ${current_shader_path}      # Input file
+            ${optimize_command}
             DEPENDS ${current_shader_path}
-            COMMENT "Compiling shader ${SHADER}"
+            DEPFILE ${current_depfile}
+            COMMENT "Compiling shader ${current_shader_name}"
             VERBATIM
     )
 
-    # Add shader to target
+    # Built by compile_shaders only: listing the output in several targets makes parallel
+    # Makefile builds run the same command twice
     set_source_files_properties(${current_output_path} PROPERTIES GENERATED TRUE)
-    target_sources(${TARGET} PRIVATE ${current_output_path})
 
     # Add to global list of SPIR-V binaries
     set(SPIRV_BINARY_FILES ${SPIRV_BINARY_FILES} ${current_output_path} CACHE INTERNAL "List of SPIR-V binary files")
@@ -158,26 +191,39 @@ function(add_hlsl_shader TARGET SHADER)
             VERBATIM
     )
 
-    # Add shader to target
     set_source_files_properties(${current_output_path} PROPERTIES GENERATED TRUE)
-    target_sources(${TARGET} PRIVATE ${current_output_path})
 
     # Add to global list of SPIR-V binaries
     set(SPIRV_BINARY_FILES ${SPIRV_BINARY_FILES} ${current_output_path} CACHE INTERNAL "List of SPIR-V binary files")
 endfunction()
 
 # Create custom target for shader compilation only
-# This should be called after all shaders have been added
+# This should be called after all shaders have been added. Every module is packed into
+# shaders.pak next to the executable, which the game maps once at startup.
 function(create_shader_target)
     if(SPIRV_BINARY_FILES)
+        add_executable(shader_pack ${CMAKE_CURRENT_SOURCE_DIR}/src/tools/shader_pack.c)
+        if(MSVC)
+            target_compile_definitions(shader_pack PRIVATE _CRT_SECURE_NO_WARNINGS)
+        endif()
+
+        set(shader_pack_path ${CMAKE_RUNTIME_OUTPUT_DIRECTORY}/shaders.pak)
+        add_custom_command(
+                OUTPUT ${shader_pack_path}
+                COMMAND shader_pack ${shader_pack_path} ${SPIRV_BINARY_FILES}
+                DEPENDS shader_pack ${SPIRV_BINARY_FILES}
+                COMMENT "Packing shaders"
+                VERBATIM
+        )
+
         add_custom_target(compile_shaders
-                DEPENDS ${SPIRV_BINARY_FILES}
+                DEPENDS ${shader_pack_path}
                 COMMENT "Compiling all shaders"
         )
 
         # Also create a clean target for shaders
         add_custom_target(clean_shaders
-                COMMAND ${CMAKE_COMMAND} -E remove ${SPIRV_BINARY_FILES}
+                COMMAND ${CMAKE_COMMAND} -E remove ${SPIRV_BINARY_FILES} ${shader_pack_path}
                 COMMENT "Cleaning compiled shaders"
         )
     else()
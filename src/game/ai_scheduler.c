@@ -0,0 +1,179 @@
+#include "ai_scheduler.h"
+
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_atomic.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+
+static const uint32_t s_intervals[WC_AI_PRIORITY_COUNT] = {WC_AI_INTERVAL_COMBAT, WC_AI_INTERVAL_NEAR, WC_AI_INTERVAL_IDLE};
+static const uint32_t s_first_bucket[WC_AI_PRIORITY_COUNT] = {0, WC_AI_INTERVAL_COMBAT, WC_AI_INTERVAL_COMBAT + WC_AI_INTERVAL_NEAR};
+
+int wc_ai_scheduler_init(WC_AiScheduler* scheduler, const uint32_t capacity)
+{
+    SDL_memset(scheduler, 0, sizeof(*scheduler));
+    // Zero is combat priority: new units think on their first tick, which sorts them where they belong
+    scheduler->priority = wc_calloc(capacity, sizeof(uint8_t));
+    scheduler->bucket = wc_calloc(capacity, sizeof(uint8_t));
+    scheduler->queued = wc_calloc(capacity, sizeof(uint8_t));
+    scheduler->members = wc_malloc(capacity * sizeof(uint32_t));
+    scheduler->queue = wc_malloc(capacity * sizeof(uint32_t));
+    scheduler->capacity = capacity;
+    if (!scheduler->priority || !scheduler->bucket || !scheduler->queued || !scheduler->members || !scheduler->queue)
+    {
+        wc_ai_scheduler_free(scheduler);
+        return -1;
+    }
+    return 0;
+}
+
+void wc_ai_scheduler_free(WC_AiScheduler* scheduler)
+{
+    wc_free(scheduler->priority);
+    wc_free(scheduler->bucket);
+    wc_free(scheduler->queued);
+    wc_free(scheduler->members);
+    wc_free(scheduler->queue);
+    SDL_memset(scheduler, 0, sizeof(*scheduler));
+}
+
+static uint32_t ai_bucket(const WC_AiScheduler* scheduler, const uint32_t unit)
+{
+    const uint32_t priority = scheduler->priority[unit];
+    return s_first_bucket[priority] + unit % s_intervals[priority];
+}
+
+// Counting sort by bucket, in unit order within each bucket
+static void ai_rebuild_buckets(WC_AiScheduler* scheduler, const uint32_t unit_count)
+{
+    uint32_t* start = scheduler->bucket_start;
+    SDL_memset(start, 0, sizeof(scheduler->bucket_start));
+    for (uint32_t unit = 0; unit < unit_count; unit++)
+    {
+        scheduler->bucket[unit] = (uint8_t) ai_bucket(scheduler, unit);
+        start[scheduler->bucket[unit] + 1]++;
+    }
+    for (uint32_t b = 0; b < WC_AI_BUCKET_COUNT; b++)
+        start[b + 1] += start[b];
+
+    uint32_t cursor[WC_AI_BUCKET_COUNT];
+    SDL_memcpy(cursor, start, sizeof(cursor));
+    for (uint32_t unit = 0; unit < unit_count; unit++)
+        scheduler->members[cursor[scheduler->bucket[unit]]++] = unit;
+    scheduler->member_count = unit_count;
+}
+
+// Units added since the rebuild go after the sorted buckets, keeping the bucket they are given now
+static void ai_join(WC_AiScheduler* scheduler, const uint32_t unit_count)
+{
+    for (uint32_t unit = scheduler->member_count; unit < unit_count; unit++)
+    {
+        scheduler->bucket[unit] = (uint8_t) ai_bucket(scheduler, unit);
+        scheduler->members[unit] = unit;
+    }
+    scheduler->member_count = unit_count;
+}
+
+static void ai_enqueue(WC_AiScheduler* scheduler, const uint32_t unit)
+{
+    if (scheduler->queued[unit])
+        return;
+    scheduler->queued[unit] = 1;
+    scheduler->queue[(scheduler->head + scheduler->count) % scheduler->capacity] = unit;
+    scheduler->count++;
+}
+
+// A bucket comes due when the tick lines up with its slot in the interval. Units still queued from
+// an earlier tick keep their place instead of being queued twice.
+static void ai_enqueue_due(WC_AiScheduler* scheduler)
+{
+    bool due[WC_AI_BUCKET_COUNT] = {0};
+    for (uint32_t priority = 0; priority < WC_AI_PRIORITY_COUNT; priority++)
+    {
+        const uint32_t bucket = s_first_bucket[priority] + (uint32_t) (scheduler->tick % s_intervals[priority]);
+        due[bucket] = true;
+        for (uint32_t i = scheduler->bucket_start[bucket]; i < scheduler->bucket_start[bucket + 1]; i++)
+            ai_enqueue(scheduler, scheduler->members[i]);
+    }
+
+    for (uint32_t i = scheduler->bucket_start[WC_AI_BUCKET_COUNT]; i < scheduler->member_count; i++)
+    {
+        const uint32_t unit = scheduler->members[i];
+        if (due[scheduler->bucket[unit]])
+            ai_enqueue(scheduler, unit);
+    }
+}
+
+typedef struct
+{
+    WC_AiScheduler* scheduler;
+    WC_AiThinkFunc think;
+    void* data;
+    uint32_t available;
+    uint64_t deadline; // Zero without a time budget
+    SDL_AtomicInt cursor;
+} AiTickData;
+
+// Every job claims batches from the front of the queue until it runs dry or the deadline passes.
+// The deadline is checked before claiming, so claimed batches always finish and the thought units
+// form a prefix of the queue.
+static void ai_think_jobs(const u32 start, const u32 end, void* data)
+{
+    (void) start;
+    (void) end;
+    AiTickData* tick = (AiTickData*) data;
+    WC_AiScheduler* scheduler = tick->scheduler;
+
+    for (;;)
+    {
+        if (tick->deadline && SDL_GetPerformanceCounter() >= tick->deadline)
+            return;
+        const uint32_t first = (uint32_t) SDL_AddAtomicInt(&tick->cursor, WC_AI_THINKS_PER_JOB);
+        if (first >= tick->available)
+            return;
+
+        // The batch may wrap around the end of the ring
+        const uint32_t count = SDL_min(tick->available - first, (uint32_t) WC_AI_THINKS_PER_JOB);
+        const uint32_t slot = (scheduler->head + first) % scheduler->capacity;
+        const uint32_t contiguous = SDL_min(count, scheduler->capacity - slot);
+        tick->think(scheduler->queue + slot, contiguous, tick->data);
+        if (contiguous < count)
+            tick->think(scheduler->queue, count - contiguous, tick->data);
+
+        for (uint32_t i = 0; i < count; i++)
+            scheduler->queued[scheduler->queue[(slot + i) % scheduler->capacity]] = 0;
+    }
+}
+
+void wc_ai_scheduler_tick(WC_AiScheduler* scheduler, const uint32_t unit_count, const WC_AiBudget* budget, const WC_AiThinkFunc think,
+                          void* data)
+{
+    const uint64_t begin = SDL_GetPerformanceCounter();
+
+    // Priorities set by thinks take effect once per idle cycle, so every unit of a bucket is still
+    // visited exactly once per interval. Only a shrinking unit count forces an early rebuild.
+    const uint32_t members = SDL_min(unit_count, scheduler->capacity);
+    if (scheduler->tick % WC_AI_INTERVAL_IDLE == 0 || members < scheduler->member_count)
+        ai_rebuild_buckets(scheduler, members);
+    else
+        ai_join(scheduler, members);
+    ai_enqueue_due(scheduler);
+
+    AiTickData tick = {
+        .scheduler = scheduler,
+        .think = think,
+        .data = data,
+        .available = budget->max_thinks ? SDL_min(scheduler->count, budget->max_thinks) : scheduler->count,
+        .deadline = budget->time_ns ? begin + budget->time_ns * SDL_GetPerformanceFrequency() / SDL_NS_PER_SECOND : 0,
+    };
+    if (tick.available > 0)
+        job_wait(job_parallel_for(job_get_worker_count() + 1, 1, ai_think_jobs, &tick));
+
+    const uint32_t thought = SDL_min((uint32_t) SDL_GetAtomicInt(&tick.cursor), tick.available);
+    scheduler->head = (scheduler->head + thought) % SDL_max(scheduler->capacity, 1u);
+    scheduler->count -= thought;
+    scheduler->thinks = thought;
+    scheduler->elapsed_ns = (SDL_GetPerformanceCounter() - begin) * SDL_NS_PER_SECOND / SDL_GetPerformanceFrequency();
+    scheduler->tick++;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <stdint.h>
+
+#define WC_AI_THINKS_PER_JOB 64
+
+// Units close to combat think every tick, the rest progressively less often
+typedef enum WC_AiPriority
+{
+    WC_AI_PRIORITY_COMBAT,
+    WC_AI_PRIORITY_NEAR,
+    WC_AI_PRIORITY_IDLE,
+    WC_AI_PRIORITY_COUNT,
+} WC_AiPriority;
+
+// Ticks between thinks per priority. Each priority is split into that many round-robin buckets,
+// one of which comes due every tick, so its units are spread evenly over the interval.
+#define WC_AI_INTERVAL_COMBAT 1
+#define WC_AI_INTERVAL_NEAR 4
+#define WC_AI_INTERVAL_IDLE 16
+#define WC_AI_BUCKET_COUNT (WC_AI_INTERVAL_COMBAT + WC_AI_INTERVAL_NEAR + WC_AI_INTERVAL_IDLE)
+
+// Thinks a batch of units. Each unit is passed to exactly one call per think, so writing to the unit
+// and setting its priority is race-free.
+typedef void (*WC_AiThinkFunc)(const uint32_t* units, uint32_t count, void* data);
+
+// A zero time budget only caps the think count, which keeps the choice of thinking units identical on
+// every machine. A time budget adapts to the machine instead, so lockstep matches should not use it.
+typedef struct WC_AiBudget
+{
+    uint64_t time_ns;
+    uint32_t max_thinks;
+} WC_AiBudget;
+
+typedef struct WC_AiScheduler
+{
+    uint8_t* priority; // Per unit, takes effect when the buckets are next rebuilt
+    uint8_t* bucket;   // Per unit, the bucket it was placed in
+    uint8_t* queued;   // Per unit, set while it waits in the queue
+    // Units grouped by bucket, up to bucket_start[WC_AI_BUCKET_COUNT], then units that joined since
+    uint32_t* members;
+    uint32_t bucket_start[WC_AI_BUCKET_COUNT + 1];
+    uint32_t member_count;
+
+    // Due units not thought yet, carried over between ticks when the budget runs out
+    uint32_t* queue;
+    uint32_t head;
+    uint32_t count;
+    uint32_t capacity;
+    uint64_t tick;
+
+    // Last tick, for tuning the budget
+    uint32_t thinks;
+    uint64_t elapsed_ns;
+} WC_AiScheduler;
+
+int wc_ai_scheduler_init(WC_AiScheduler* scheduler, uint32_t capacity);
+void wc_ai_scheduler_free(WC_AiScheduler* scheduler);
+
+static inline void wc_ai_scheduler_set_priority(WC_AiScheduler* scheduler, const uint32_t unit, const WC_AiPriority priority)
+{
+    scheduler->priority[unit] = (uint8_t) priority;
+}
+
+// Queues this tick's buckets, then thinks queued units in order on the job system until the queue is
+// empty or the budget is spent, blocking until done. Units in [0, unit_count) take part. Buckets are
+// rebuilt once per idle interval; units added in between join right away, in the bucket their
+// priority puts them in, and are sorted in at the next rebuild.
+void wc_ai_scheduler_tick(WC_AiScheduler* scheduler, uint32_t unit_count, const WC_AiBudget* budget, WC_AiThinkFunc think, void* data);
@@ -0,0 +1,421 @@
+#include "economy.h"
+
+#include "../system/common.h"
+#include "../system/job.h"
+#include "../system/math.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_stdinc.h>
+#include <float.h>
+
+// Timer of a worker or building with nothing to do; never expires
+#define ECONOMY_IDLE FLT_MAX
+
+static uint32_t economy_chunks(const uint32_t count)
+{
+    return (count + WC_ECONOMY_CHUNK - 1) / WC_ECONOMY_CHUNK;
+}
+
+int wc_economy_init(WC_Economy* economy, const WC_EconomyDesc* desc)
+{
+    SDL_memset(economy, 0, sizeof(*economy));
+    if (desc->player_count == 0 || desc->player_count > WC_ECONOMY_MAX_PLAYERS)
+        return -1;
+
+    economy->player_count = desc->player_count;
+    economy->types = desc->types;
+    economy->type_count = desc->type_count;
+    economy->worker_speed = desc->worker_speed;
+    economy->gather_time = desc->gather_time;
+    economy->carry = desc->carry;
+
+    // Whole chunks, so the wide timer passes never need a scalar tail
+    const uint32_t workers = (uint32_t) war_align_up(desc->worker_capacity, WC_ECONOMY_CHUNK);
+    const uint32_t buildings = (uint32_t) war_align_up(desc->building_capacity, WC_ECONOMY_CHUNK);
+    economy->node_capacity = desc->node_capacity;
+    economy->worker_capacity = workers;
+    economy->building_capacity = buildings;
+    economy->army_capacity = desc->army_capacity;
+
+    economy->node_x = wc_malloc(desc->node_capacity * sizeof(float));
+    economy->node_y = wc_malloc(desc->node_capacity * sizeof(float));
+    economy->node_amount = wc_malloc(desc->node_capacity * sizeof(uint32_t));
+
+    economy->worker_player = wc_calloc(workers, sizeof(uint32_t));
+    economy->worker_node = wc_calloc(workers, sizeof(uint32_t));
+    economy->worker_carry = wc_calloc(workers, sizeof(uint32_t));
+    economy->worker_state = wc_calloc(workers, sizeof(uint8_t));
+    economy->worker_trip = wc_calloc(workers, sizeof(float));
+    economy->worker_timer = wc_aligned_alloc(workers * sizeof(float), 32);
+
+    economy->building_x = wc_calloc(buildings, sizeof(float));
+    economy->building_y = wc_calloc(buildings, sizeof(float));
+    economy->building_player = wc_calloc(buildings, sizeof(uint32_t));
+    economy->building_supply = wc_calloc(buildings, sizeof(uint32_t));
+    economy->building_queue = wc_calloc((size_t) buildings * WC_PRODUCTION_QUEUE_CAPACITY, sizeof(uint8_t));
+    economy->building_head = wc_calloc(buildings, sizeof(uint8_t));
+    economy->building_queued = wc_calloc(buildings, sizeof(uint8_t));
+    economy->building_timer = wc_aligned_alloc(buildings * sizeof(float), 32);
+
+    economy->worker_partials = wc_calloc((size_t) economy_chunks(workers) * WC_ECONOMY_MAX_PLAYERS * 2, sizeof(uint32_t));
+    economy->building_partials = wc_calloc((size_t) economy_chunks(buildings) * WC_ECONOMY_MAX_PLAYERS, sizeof(uint32_t));
+    economy->army_partials = wc_calloc((size_t) SDL_max(economy_chunks(desc->army_capacity), 1u) * WC_ECONOMY_MAX_PLAYERS, sizeof(uint32_t));
+    economy->claims = wc_malloc(workers * sizeof(uint32_t));
+    economy->claim_counts = wc_calloc(economy_chunks(workers), sizeof(uint32_t));
+    economy->finished = wc_malloc(buildings * sizeof(WC_Produced));
+    economy->finished_counts = wc_calloc(economy_chunks(buildings), sizeof(uint32_t));
+    economy->produced = wc_malloc(buildings * sizeof(WC_Produced));
+
+    if (!economy->node_x || !economy->node_y || !economy->node_amount || !economy->worker_player || !economy->worker_node ||
+        !economy->worker_carry || !economy->worker_state || !economy->worker_trip || !economy->worker_timer || !economy->building_x ||
+        !economy->building_y || !economy->building_player || !economy->building_supply || !economy->building_queue ||
+        !economy->building_head || !economy->building_queued || !economy->building_timer || !economy->worker_partials ||
+        !economy->building_partials || !economy->army_partials || !economy->claims || !economy->claim_counts || !economy->finished ||
+        !economy->finished_counts || !economy->produced)
+    {
+        wc_economy_free(economy);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < workers; i++)
+        economy->worker_timer[i] = ECONOMY_IDLE;
+    for (uint32_t i = 0; i < buildings; i++)
+        economy->building_timer[i] = ECONOMY_IDLE;
+    return 0;
+}
+
+void wc_economy_free(WC_Economy* economy)
+{
+    wc_free(economy->node_x);
+    wc_free(economy->node_y);
+    wc_free(economy->node_amount);
+    wc_free(economy->worker_player);
+    wc_free(economy->worker_node);
+    wc_free(economy->worker_carry);
+    wc_free(economy->worker_state);
+    wc_free(economy->worker_trip);
+    wc_aligned_free(economy->worker_timer, 32);
+    wc_free(economy->building_x);
+    wc_free(economy->building_y);
+    wc_free(economy->building_player);
+    wc_free(economy->building_supply);
+    wc_free(economy->building_queue);
+    wc_free(economy->building_head);
+    wc_free(economy->building_queued);
+    wc_aligned_free(economy->building_timer, 32);
+    wc_free(economy->worker_partials);
+    wc_free(economy->building_partials);
+    wc_free(economy->army_partials);
+    wc_free(economy->claims);
+    wc_free(economy->claim_counts);
+    wc_free(economy->finished);
+    wc_free(economy->finished_counts);
+    wc_free(economy->produced);
+    SDL_memset(economy, 0, sizeof(*economy));
+}
+
+void wc_economy_set_base(WC_Economy* economy, const uint32_t player, const float x, const float y)
+{
+    economy->base_x[player] = x;
+    economy->base_y[player] = y;
+}
+
+uint32_t wc_economy_add_node(WC_Economy* economy, const float x, const float y, const uint32_t amount)
+{
+    if (economy->node_count >= economy->node_capacity)
+        return UINT32_MAX;
+    const uint32_t i = economy->node_count++;
+    economy->node_x[i] = x;
+    economy->node_y[i] = y;
+    economy->node_amount[i] = amount;
+    return i;
+}
+
+static float economy_trip(const WC_Economy* economy, const uint32_t player, const uint32_t node)
+{
+    const float dx = economy->node_x[node] - economy->base_x[player];
+    const float dy = economy->node_y[node] - economy->base_y[player];
+    return SDL_sqrtf(dx * dx + dy * dy) / economy->worker_speed;
+}
+
+uint32_t wc_economy_add_worker(WC_Economy* economy, const uint32_t player, const uint32_t node)
+{
+    if (economy->worker_count >= economy->worker_capacity || node >= economy->node_count)
+        return UINT32_MAX;
+    const uint32_t i = economy->worker_count++;
+    economy->worker_player[i] = player;
+    economy->worker_node[i] = node;
+    economy->worker_carry[i] = 0;
+    economy->worker_state[i] = WC_WORKER_TO_NODE;
+    economy->worker_trip[i] = economy_trip(economy, player, node);
+    economy->worker_timer[i] = economy->worker_trip[i];
+    return i;
+}
+
+uint32_t wc_economy_add_building(WC_Economy* economy, const uint32_t player, const float x, const float y, const uint32_t supply)
+{
+    if (economy->building_count >= economy->building_capacity)
+        return UINT32_MAX;
+    const uint32_t i = economy->building_count++;
+    economy->building_x[i] = x;
+    economy->building_y[i] = y;
+    economy->building_player[i] = player;
+    economy->building_supply[i] = supply;
+    economy->building_head[i] = 0;
+    economy->building_queued[i] = 0;
+    economy->building_timer[i] = ECONOMY_IDLE;
+    return i;
+}
+
+int wc_economy_produce(WC_Economy* economy, const uint32_t building, const uint32_t type)
+{
+    if (building >= economy->building_count || type >= economy->type_count ||
+        economy->building_queued[building] == WC_PRODUCTION_QUEUE_CAPACITY)
+        return -1;
+
+    const uint32_t player = economy->building_player[building];
+    const WC_ProductionType* production = &economy->types[type];
+    if (economy->stock[player] < production->cost || economy->supply_used[player] + production->supply > economy->supply_cap[player])
+        return -1;
+
+    economy->stock[player] -= production->cost;
+    economy->reserved[player] += production->supply;
+    // Counted right away, so several orders in one tick cannot overrun the cap together
+    economy->supply_used[player] += production->supply;
+
+    const uint32_t slot = (economy->building_head[building] + economy->building_queued[building]) % WC_PRODUCTION_QUEUE_CAPACITY;
+    economy->building_queue[(size_t) building * WC_PRODUCTION_QUEUE_CAPACITY + slot] = (uint8_t) type;
+    if (economy->building_queued[building]++ == 0)
+        economy->building_timer[building] = production->time;
+    return 0;
+}
+
+typedef struct
+{
+    WC_Economy* economy;
+    const WC_EconomyArmy* army;
+    float delta_time;
+} EconomyJobData;
+
+// Counts a batch of timers down; returns a bit per lane that expired
+static uint32_t economy_tick_batch(float* timer, const wc_wide delta)
+{
+    const wc_wide remaining = wc_wide_sub(wc_wide_load(timer), delta);
+    wc_wide_store(timer, remaining);
+    return wc_wide_mask_bits(wc_wide_lt(remaining, wc_wide_zero()));
+}
+
+// Workers that reach a node start gathering, workers that are done gathering are claimed for the
+// serial pass that takes from the nodes, and workers back at base add their load to the partials.
+// Partials hold income then worker supply per player.
+static void economy_workers(const EconomyJobData* job, const uint32_t chunk)
+{
+    WC_Economy* economy = job->economy;
+    const wc_wide delta = wc_wide_set1(job->delta_time);
+
+    uint32_t* income = economy->worker_partials + (size_t) chunk * WC_ECONOMY_MAX_PLAYERS * 2;
+    uint32_t* supply = income + WC_ECONOMY_MAX_PLAYERS;
+    SDL_memset(income, 0, WC_ECONOMY_MAX_PLAYERS * 2 * sizeof(uint32_t));
+    uint32_t* claims = economy->claims + chunk * WC_ECONOMY_CHUNK;
+    uint32_t claim_count = 0;
+
+    const uint32_t first = chunk * WC_ECONOMY_CHUNK;
+    const uint32_t last = SDL_min(first + WC_ECONOMY_CHUNK, economy->worker_count);
+    for (uint32_t batch = first; batch < last; batch += WC_WIDE_LANES)
+    {
+        const uint32_t expired = economy_tick_batch(economy->worker_timer + batch, delta);
+        if (!expired)
+            continue;
+
+        for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+        {
+            if (!((expired >> lane) & 1))
+                continue;
+            const uint32_t w = batch + lane;
+            switch (economy->worker_state[w])
+            {
+            case WC_WORKER_TO_NODE:
+                economy->worker_state[w] = WC_WORKER_GATHER;
+                economy->worker_timer[w] += economy->gather_time;
+                break;
+            case WC_WORKER_GATHER:
+                claims[claim_count++] = w;
+                break;
+            default:
+                income[economy->worker_player[w]] += economy->worker_carry[w];
+                economy->worker_carry[w] = 0;
+                economy->worker_state[w] = WC_WORKER_TO_NODE;
+                economy->worker_timer[w] += economy->worker_trip[w];
+                break;
+            }
+        }
+    }
+    for (uint32_t w = first; w < last; w++)
+        supply[economy->worker_player[w]]++;
+    economy->claim_counts[chunk] = claim_count;
+}
+
+// Buildings finish the head of their queue and start the next; partials hold supply provided
+static void economy_buildings(const EconomyJobData* job, const uint32_t chunk)
+{
+    WC_Economy* economy = job->economy;
+    const wc_wide delta = wc_wide_set1(job->delta_time);
+
+    uint32_t* cap = economy->building_partials + (size_t) chunk * WC_ECONOMY_MAX_PLAYERS;
+    SDL_memset(cap, 0, WC_ECONOMY_MAX_PLAYERS * sizeof(uint32_t));
+    WC_Produced* finished = economy->finished + chunk * WC_ECONOMY_CHUNK;
+    uint32_t finished_count = 0;
+
+    const uint32_t first = chunk * WC_ECONOMY_CHUNK;
+    const uint32_t last = SDL_min(first + WC_ECONOMY_CHUNK, economy->building_count);
+    for (uint32_t batch = first; batch < last; batch += WC_WIDE_LANES)
+    {
+        const uint32_t expired = economy_tick_batch(economy->building_timer + batch, delta);
+        if (!expired)
+            continue;
+
+        for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+        {
+            if (!((expired >> lane) & 1))
+                continue;
+            const uint32_t b = batch + lane;
+            const uint8_t* queue = economy->building_queue + (size_t) b * WC_PRODUCTION_QUEUE_CAPACITY;
+            finished[finished_count++] = (WC_Produced) {b, economy->building_player[b], queue[economy->building_head[b]]};
+            economy->building_head[b] = (uint8_t) ((economy->building_head[b] + 1) % WC_PRODUCTION_QUEUE_CAPACITY);
+
+            // The overshoot carries into the next unit, which finishes at the next update at the earliest
+            if (--economy->building_queued[b] > 0)
+                economy->building_timer[b] += economy->types[queue[economy->building_head[b]]].time;
+            else
+                economy->building_timer[b] = ECONOMY_IDLE;
+        }
+    }
+    for (uint32_t b = first; b < last; b++)
+        cap[economy->building_player[b]] += economy->building_supply[b];
+    economy->finished_counts[chunk] = finished_count;
+}
+
+static void economy_army(const EconomyJobData* job, const uint32_t chunk)
+{
+    const WC_EconomyArmy* army = job->army;
+    uint32_t* supply = job->economy->army_partials + (size_t) chunk * WC_ECONOMY_MAX_PLAYERS;
+    SDL_memset(supply, 0, WC_ECONOMY_MAX_PLAYERS * sizeof(uint32_t));
+
+    const uint32_t last = SDL_min((chunk + 1) * WC_ECONOMY_CHUNK, army->count);
+    for (uint32_t i = chunk * WC_ECONOMY_CHUNK; i < last; i++)
+        supply[army->player[i]] += army->supply[i];
+}
+
+// One range over the worker, building and army chunks, so the update is a single fork and join
+static void economy_chunk_jobs(const u32 start, const u32 end, void* data)
+{
+    const EconomyJobData* job = (const EconomyJobData*) data;
+    const uint32_t worker_chunks = economy_chunks(job->economy->worker_count);
+    const uint32_t building_chunks = economy_chunks(job->economy->building_count);
+
+    for (uint32_t chunk = start; chunk < end; chunk++)
+    {
+        if (chunk < worker_chunks)
+            economy_workers(job, chunk);
+        else if (chunk < worker_chunks + building_chunks)
+            economy_buildings(job, chunk - worker_chunks);
+        else
+            economy_army(job, chunk - worker_chunks - building_chunks);
+    }
+}
+
+// Workers done gathering take their load in chunk order, the nodes being shared. A worker whose node
+// ran dry moves on to the next one with anything left, or idles when there is none.
+static void economy_claim(WC_Economy* economy)
+{
+    const uint32_t chunks = economy_chunks(economy->worker_count);
+    for (uint32_t chunk = 0; chunk < chunks; chunk++)
+    {
+        const uint32_t* claims = economy->claims + chunk * WC_ECONOMY_CHUNK;
+        for (uint32_t i = 0; i < economy->claim_counts[chunk]; i++)
+        {
+            const uint32_t w = claims[i];
+            const uint32_t node = economy->worker_node[w];
+            const uint32_t take = SDL_min(economy->carry, economy->node_amount[node]);
+            economy->node_amount[node] -= take;
+            economy->worker_carry[w] = take;
+            economy->worker_state[w] = WC_WORKER_RETURN;
+            economy->worker_timer[w] += economy->worker_trip[w];
+            if (economy->node_amount[node] > 0)
+                continue;
+
+            uint32_t next = node;
+            for (uint32_t step = 1; step < economy->node_count && economy->node_amount[next] == 0; step++)
+                next = (node + step) % economy->node_count;
+            if (economy->node_amount[next] == 0)
+            {
+                // Still brings home what it got, then stays there
+                if (take == 0)
+                    economy->worker_timer[w] = ECONOMY_IDLE;
+                continue;
+            }
+            economy->worker_node[w] = next;
+            economy->worker_trip[w] = economy_trip(economy, economy->worker_player[w], next);
+        }
+    }
+}
+
+void wc_economy_update(WC_Economy* economy, const WC_EconomyArmy* army, const float delta_time)
+{
+    const uint32_t worker_chunks = economy_chunks(economy->worker_count);
+    const uint32_t building_chunks = economy_chunks(economy->building_count);
+    const uint32_t army_chunks = economy_chunks(SDL_min(army->count, economy->army_capacity));
+    const WC_EconomyArmy clamped = {army->player, army->supply, SDL_min(army->count, economy->army_capacity)};
+
+    EconomyJobData data = {economy, &clamped, delta_time};
+    if (worker_chunks + building_chunks + army_chunks > 0)
+        job_wait(job_parallel_for(worker_chunks + building_chunks + army_chunks, 1, economy_chunk_jobs, &data));
+
+    economy_claim(economy);
+
+    // Partials are merged in chunk order
+    uint32_t workers[WC_ECONOMY_MAX_PLAYERS] = {0};
+    uint32_t army_supply[WC_ECONOMY_MAX_PLAYERS] = {0};
+    SDL_memset(economy->income, 0, sizeof(economy->income));
+    SDL_memset(economy->supply_cap, 0, sizeof(economy->supply_cap));
+    for (uint32_t chunk = 0; chunk < worker_chunks; chunk++)
+    {
+        const uint32_t* partials = economy->worker_partials + (size_t) chunk * WC_ECONOMY_MAX_PLAYERS * 2;
+        for (uint32_t player = 0; player < economy->player_count; player++)
+        {
+            economy->income[player] += partials[player];
+            workers[player] += partials[WC_ECONOMY_MAX_PLAYERS + player];
+        }
+    }
+    for (uint32_t chunk = 0; chunk < building_chunks; chunk++)
+    {
+        for (uint32_t player = 0; player < economy->player_count; player++)
+            economy->supply_cap[player] += economy->building_partials[(size_t) chunk * WC_ECONOMY_MAX_PLAYERS + player];
+    }
+    for (uint32_t chunk = 0; chunk < army_chunks; chunk++)
+    {
+        for (uint32_t player = 0; player < economy->player_count; player++)
+            army_supply[player] += economy->army_partials[(size_t) chunk * WC_ECONOMY_MAX_PLAYERS + player];
+    }
+
+    // Finished units leave the reservation, but keep counting until they show up in the army
+    uint32_t finished_supply[WC_ECONOMY_MAX_PLAYERS] = {0};
+    economy->produced_count = 0;
+    for (uint32_t chunk = 0; chunk < building_chunks; chunk++)
+    {
+        const WC_Produced* finished = economy->finished + chunk * WC_ECONOMY_CHUNK;
+        for (uint32_t i = 0; i < economy->finished_counts[chunk]; i++)
+        {
+            const uint32_t supply = economy->types[finished[i].type].supply;
+            economy->reserved[finished[i].player] -= supply;
+            finished_supply[finished[i].player] += supply;
+            economy->produced[economy->produced_count++] = finished[i];
+        }
+    }
+
+    for (uint32_t player = 0; player < economy->player_count; player++)
+    {
+        economy->stock[player] += economy->income[player];
+        economy->supply_used[player] = workers[player] + army_supply[player] + economy->reserved[player] + finished_supply[player];
+    }
+}
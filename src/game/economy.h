@@ -0,0 +1,136 @@
+#pragma once
+
+#include <stdint.h>
+
+#define WC_ECONOMY_MAX_PLAYERS 8
+// Workers, buildings or army units per job. Every job sums into its own per-player partials, which
+// are merged in chunk order, so totals never depend on scheduling and need no shared counters.
+#define WC_ECONOMY_CHUNK 256
+#define WC_PRODUCTION_QUEUE_CAPACITY 5
+
+// What a building can produce, indexed by type
+typedef struct WC_ProductionType
+{
+    uint32_t cost;
+    uint32_t supply;
+    float time;
+} WC_ProductionType;
+
+typedef enum WC_WorkerState
+{
+    WC_WORKER_TO_NODE,
+    WC_WORKER_GATHER,
+    WC_WORKER_RETURN, // Carrying its load back to the player's base
+} WC_WorkerState;
+
+// A unit finished this update, for the game to spawn
+typedef struct WC_Produced
+{
+    uint32_t building;
+    uint32_t player;
+    uint32_t type;
+} WC_Produced;
+
+typedef struct WC_EconomyDesc
+{
+    uint32_t player_count;
+    const WC_ProductionType* types; // Borrowed for the economy's lifetime
+    uint32_t type_count;
+    uint32_t node_capacity;
+    uint32_t worker_capacity;
+    uint32_t building_capacity;
+    uint32_t army_capacity;
+    float worker_speed;
+    float gather_time;
+    uint32_t carry; // Taken from a node per trip
+} WC_EconomyDesc;
+
+// Supply used by the army, per unit and borrowed for the update; zero for the dead
+typedef struct WC_EconomyArmy
+{
+    const uint32_t* player;
+    const uint8_t* supply;
+    uint32_t count;
+} WC_EconomyArmy;
+
+// Resource gathering, production queues and supply for every player. Workers and buildings are
+// SoA, padded to whole chunks; their timers count down a full wc_wide at a time and only the
+// lanes that expire take the scalar path. Walking is a timer too: workers shuttle between their
+// player's base and a resource node without being units on the map.
+typedef struct WC_Economy
+{
+    uint32_t player_count;
+    const WC_ProductionType* types;
+    uint32_t type_count;
+    float worker_speed;
+    float gather_time;
+    uint32_t carry;
+
+    // Per player
+    float base_x[WC_ECONOMY_MAX_PLAYERS];
+    float base_y[WC_ECONOMY_MAX_PLAYERS];
+    uint32_t stock[WC_ECONOMY_MAX_PLAYERS];
+    uint32_t income[WC_ECONOMY_MAX_PLAYERS];      // Last update
+    uint32_t supply_used[WC_ECONOMY_MAX_PLAYERS]; // Workers, army and units in production
+    uint32_t supply_cap[WC_ECONOMY_MAX_PLAYERS];
+    uint32_t reserved[WC_ECONOMY_MAX_PLAYERS]; // Supply of units in production
+
+    float* node_x;
+    float* node_y;
+    uint32_t* node_amount;
+    uint32_t node_count;
+    uint32_t node_capacity;
+
+    uint32_t* worker_player;
+    uint32_t* worker_node;
+    uint32_t* worker_carry;
+    uint8_t* worker_state;
+    float* worker_trip;  // One way, in seconds
+    float* worker_timer; // Until the current state ends
+    uint32_t worker_count;
+    uint32_t worker_capacity;
+
+    float* building_x;
+    float* building_y;
+    uint32_t* building_player;
+    uint32_t* building_supply; // Provided
+    uint8_t* building_queue;   // WC_PRODUCTION_QUEUE_CAPACITY types per building
+    uint8_t* building_head;
+    uint8_t* building_queued;
+    float* building_timer; // Until the head of the queue is done
+    uint32_t building_count;
+    uint32_t building_capacity;
+
+    uint32_t army_capacity;
+
+    // Per chunk scratch, written by one job each: partial sums per player, workers done gathering
+    // and units finished, the latter two at the chunk's base index
+    uint32_t* worker_partials;
+    uint32_t* building_partials;
+    uint32_t* army_partials;
+    uint32_t* claims;
+    uint32_t* claim_counts;
+    WC_Produced* finished;
+    uint32_t* finished_counts;
+
+    // Units finished by the last update, in building order
+    WC_Produced* produced;
+    uint32_t produced_count;
+} WC_Economy;
+
+int wc_economy_init(WC_Economy* economy, const WC_EconomyDesc* desc);
+void wc_economy_free(WC_Economy* economy);
+
+void wc_economy_set_base(WC_Economy* economy, uint32_t player, float x, float y);
+// Return the new index, or UINT32_MAX when full
+uint32_t wc_economy_add_node(WC_Economy* economy, float x, float y, uint32_t amount);
+uint32_t wc_economy_add_worker(WC_Economy* economy, uint32_t player, uint32_t node);
+uint32_t wc_economy_add_building(WC_Economy* economy, uint32_t player, float x, float y, uint32_t supply);
+
+// Queues a unit at a building, paying for it and reserving its supply up front. Returns non-zero
+// when the queue is full, the player cannot afford it or is out of supply.
+int wc_economy_produce(WC_Economy* economy, uint32_t building, uint32_t type);
+
+// Advances gathering and production on the job system and recomputes every player's totals from
+// per-chunk partial sums, blocking until done. Finished units are listed in produced.
+void wc_economy_update(WC_Economy* economy, const WC_EconomyArmy* army, float delta_time);
@@ -0,0 +1,334 @@
+#include "formation.h"
+
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+#define SQUAD_ROWS_PER_JOB 32
+// Fraction of the way the heading turns towards the next waypoint per second
+#define SQUAD_TURN_RATE 2.0f
+
+int wc_squad_init(WC_Squad* squad, const uint32_t capacity)
+{
+    SDL_memset(squad, 0, sizeof(*squad));
+    squad->members = wc_malloc(capacity * sizeof(uint32_t));
+    squad->slot_x = wc_malloc(capacity * sizeof(float));
+    squad->slot_y = wc_malloc(capacity * sizeof(float));
+    squad->slot = wc_malloc(capacity * sizeof(uint32_t));
+    squad->capacity = capacity;
+    squad->heading_y = 1.0f;
+    squad->spacing = 2.0f;
+    squad->speed = 6.0f;
+    squad->max_speed = 10.0f;
+    if (!squad->members || !squad->slot_x || !squad->slot_y || !squad->slot)
+    {
+        wc_squad_free(squad);
+        return -1;
+    }
+    return 0;
+}
+
+void wc_squad_free(WC_Squad* squad)
+{
+    wc_free(squad->members);
+    wc_free(squad->slot_x);
+    wc_free(squad->slot_y);
+    wc_free(squad->slot);
+    SDL_memset(squad, 0, sizeof(*squad));
+}
+
+void wc_squad_add(WC_Squad* squad, const uint32_t unit)
+{
+    if (squad->member_count < squad->capacity)
+        squad->members[squad->member_count++] = unit;
+}
+
+void wc_squad_remove(WC_Squad* squad, const uint32_t member)
+{
+    const uint32_t last = --squad->member_count;
+    squad->members[member] = squad->members[last];
+    squad->slot[member] = squad->slot[last];
+}
+
+// Rows from the front, each centred, the last one possibly short
+static void squad_layout(WC_Squad* squad)
+{
+    const uint32_t count = squad->member_count;
+    uint32_t columns = squad->columns ? squad->columns : (uint32_t) SDL_ceilf(SDL_sqrtf(2.0f * (float) count));
+    columns = SDL_clamp(columns, 1u, SDL_max(count, 1u));
+    const uint32_t rows = (count + columns - 1) / columns;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t row = i / columns;
+        const uint32_t column = i % columns;
+        const uint32_t row_count = row == rows - 1 ? count - row * columns : columns;
+        squad->slot_x[i] = ((float) column - (float) (row_count - 1) * 0.5f) * squad->spacing;
+        squad->slot_y[i] = ((float) (rows - 1) * 0.5f - (float) row) * squad->spacing;
+    }
+}
+
+static void squad_slot_position(const WC_Squad* squad, const uint32_t slot, float* x, float* y)
+{
+    // Right is the heading turned clockwise
+    *x = squad->anchor_x + squad->slot_x[slot] * squad->heading_y + squad->slot_y[slot] * squad->heading_x;
+    *y = squad->anchor_y - squad->slot_x[slot] * squad->heading_x + squad->slot_y[slot] * squad->heading_y;
+}
+
+typedef struct
+{
+    const WC_Squad* squad;
+    const float* unit_x;
+    const float* unit_y;
+    float* cost; // member_count x member_count, a row per member
+    uint32_t* partner;
+} SquadAssignData;
+
+static void squad_cost_rows(const u32 start, const u32 end, void* data)
+{
+    const SquadAssignData* assign = (const SquadAssignData*) data;
+    const WC_Squad* squad = assign->squad;
+    const uint32_t count = squad->member_count;
+
+    for (uint32_t m = start; m < end; m++)
+    {
+        const float ux = assign->unit_x[squad->members[m]];
+        const float uy = assign->unit_y[squad->members[m]];
+        float* row = assign->cost + (size_t) m * count;
+        for (uint32_t s = 0; s < count; s++)
+        {
+            float sx, sy;
+            squad_slot_position(squad, s, &sx, &sy);
+            row[s] = SDL_sqrtf((sx - ux) * (sx - ux) + (sy - uy) * (sy - uy));
+        }
+    }
+}
+
+// Best slot swap partner per member under the current assignment
+static void squad_swap_search(const u32 start, const u32 end, void* data)
+{
+    const SquadAssignData* assign = (const SquadAssignData*) data;
+    const WC_Squad* squad = assign->squad;
+    const uint32_t count = squad->member_count;
+    const float* cost = assign->cost;
+
+    for (uint32_t m = start; m < end; m++)
+    {
+        const uint32_t sm = squad->slot[m];
+        const float* row = cost + (size_t) m * count;
+        float best_gain = 1e-4f;
+        uint32_t best = m;
+        for (uint32_t j = 0; j < count; j++)
+        {
+            const uint32_t sj = squad->slot[j];
+            const float gain = row[sm] + cost[(size_t) j * count + sj] - row[sj] - cost[(size_t) j * count + sm];
+            if (gain > best_gain)
+            {
+                best_gain = gain;
+                best = j;
+            }
+        }
+        assign->partner[m] = best;
+    }
+}
+
+typedef struct
+{
+    float distance;
+    uint32_t member;
+} SquadOrder;
+
+static int compare_squad_order(const void* a, const void* b)
+{
+    const SquadOrder* oa = (const SquadOrder*) a;
+    const SquadOrder* ob = (const SquadOrder*) b;
+    if (oa->distance != ob->distance)
+        return oa->distance < ob->distance ? -1 : 1;
+    return (oa->member > ob->member) - (oa->member < ob->member);
+}
+
+// An approximation of the optimal (Hungarian) assignment at a fraction of its O(n^3): members
+// closest to the anchor take their nearest free slot first, then each round every member looks for
+// the swap that shortens the total most, in parallel, and non-conflicting swaps are applied in
+// member order so the result does not depend on scheduling.
+static void squad_assign(WC_Squad* squad, const float* unit_x, const float* unit_y)
+{
+    const uint32_t count = squad->member_count;
+    float* cost = wc_malloc((size_t) count * count * sizeof(float));
+    uint32_t* partner = wc_malloc(count * sizeof(uint32_t));
+    uint8_t* taken = wc_calloc(count, sizeof(uint8_t));
+    SquadOrder* order = wc_malloc(count * sizeof(SquadOrder));
+    if (!cost || !partner || !taken || !order)
+    {
+        // Out of memory: members keep the slot matching their index
+        for (uint32_t m = 0; m < count; m++)
+            squad->slot[m] = m;
+        goto cleanup;
+    }
+
+    SquadAssignData data = {squad, unit_x, unit_y, cost, partner};
+    job_wait(job_parallel_for(count, SQUAD_ROWS_PER_JOB, squad_cost_rows, &data));
+
+    for (uint32_t m = 0; m < count; m++)
+    {
+        const float dx = unit_x[squad->members[m]] - squad->anchor_x;
+        const float dy = unit_y[squad->members[m]] - squad->anchor_y;
+        order[m] = (SquadOrder) {dx * dx + dy * dy, m};
+    }
+    SDL_qsort(order, count, sizeof(SquadOrder), compare_squad_order);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const uint32_t m = order[i].member;
+        const float* row = cost + (size_t) m * count;
+        uint32_t best = UINT32_MAX;
+        for (uint32_t s = 0; s < count; s++)
+        {
+            if (!taken[s] && (best == UINT32_MAX || row[s] < row[best]))
+                best = s;
+        }
+        taken[best] = 1;
+        squad->slot[m] = best;
+    }
+
+    for (uint32_t round = 0; round < WC_SQUAD_SWAP_ROUNDS; round++)
+    {
+        job_wait(job_parallel_for(count, SQUAD_ROWS_PER_JOB, squad_swap_search, &data));
+
+        // taken now marks members already swapped this round, whose searched gains are stale
+        SDL_memset(taken, 0, count);
+        uint32_t swaps = 0;
+        for (uint32_t m = 0; m < count; m++)
+        {
+            const uint32_t j = partner[m];
+            if (j == m || taken[m] || taken[j])
+                continue;
+            const uint32_t slot = squad->slot[m];
+            squad->slot[m] = squad->slot[j];
+            squad->slot[j] = slot;
+            taken[m] = taken[j] = 1;
+            swaps++;
+        }
+        if (swaps == 0)
+            break;
+    }
+
+cleanup:
+    wc_free(order);
+    wc_free(taken);
+    wc_free(partner);
+    wc_free(cost);
+}
+
+void wc_squad_order(WC_Squad* squad, const float* unit_x, const float* unit_y, const float* path_x, const float* path_y,
+                    const uint32_t path_count)
+{
+    squad->waypoint_count = SDL_min(path_count, (uint32_t) WC_SQUAD_MAX_WAYPOINTS);
+    squad->waypoint = 0;
+    SDL_memcpy(squad->waypoint_x, path_x, squad->waypoint_count * sizeof(float));
+    SDL_memcpy(squad->waypoint_y, path_y, squad->waypoint_count * sizeof(float));
+    if (squad->member_count == 0)
+        return;
+
+    float cx = 0.0f, cy = 0.0f;
+    for (uint32_t m = 0; m < squad->member_count; m++)
+    {
+        cx += unit_x[squad->members[m]];
+        cy += unit_y[squad->members[m]];
+    }
+    squad->anchor_x = cx / (float) squad->member_count;
+    squad->anchor_y = cy / (float) squad->member_count;
+
+    if (squad->waypoint_count > 0)
+    {
+        const float dx = squad->waypoint_x[0] - squad->anchor_x;
+        const float dy = squad->waypoint_y[0] - squad->anchor_y;
+        const float length = SDL_sqrtf(dx * dx + dy * dy);
+        if (length > 1e-3f)
+        {
+            squad->heading_x = dx / length;
+            squad->heading_y = dy / length;
+        }
+    }
+
+    squad_layout(squad);
+    squad_assign(squad, unit_x, unit_y);
+}
+
+void wc_squad_update(WC_Squad* squad, const float* unit_x, const float* unit_y, const float delta_time, float* velocity_x,
+                     float* velocity_y)
+{
+    if (squad->member_count == 0)
+        return;
+
+    if (squad->waypoint < squad->waypoint_count)
+    {
+        const float dx = squad->waypoint_x[squad->waypoint] - squad->anchor_x;
+        const float dy = squad->waypoint_y[squad->waypoint] - squad->anchor_y;
+        const float distance = SDL_sqrtf(dx * dx + dy * dy);
+
+        // The anchor slows down as members fall behind and stops at two spacings of average lag
+        const float lag = wc_squad_assignment_cost(squad, unit_x, unit_y) / (float) squad->member_count;
+        const float pace = squad->speed * SDL_clamp(2.0f - lag / squad->spacing, 0.0f, 1.0f);
+        const float step = pace * delta_time;
+
+        if (distance <= step || distance < 1e-3f)
+        {
+            squad->anchor_x += dx;
+            squad->anchor_y += dy;
+            squad->waypoint++;
+        }
+        else
+        {
+            squad->anchor_x += dx / distance * step;
+            squad->anchor_y += dy / distance * step;
+
+            // Turn gradually, so the far flanks of a wide formation do not sweep around at once
+            const float turn = SDL_min(SQUAD_TURN_RATE * delta_time, 1.0f);
+            const float hx = squad->heading_x + (dx / distance - squad->heading_x) * turn;
+            const float hy = squad->heading_y + (dy / distance - squad->heading_y) * turn;
+            const float length = SDL_sqrtf(hx * hx + hy * hy);
+            if (length > 1e-3f)
+            {
+                squad->heading_x = hx / length;
+                squad->heading_y = hy / length;
+            }
+        }
+    }
+
+    // Arrival steering: full speed far from the slot, easing off linearly inside two spacings
+    const float slowing_radius = squad->spacing * 2.0f;
+    for (uint32_t m = 0; m < squad->member_count; m++)
+    {
+        const uint32_t unit = squad->members[m];
+        float sx, sy;
+        squad_slot_position(squad, squad->slot[m], &sx, &sy);
+        const float dx = sx - unit_x[unit];
+        const float dy = sy - unit_y[unit];
+        const float distance = SDL_sqrtf(dx * dx + dy * dy);
+        if (distance < 0.05f)
+        {
+            velocity_x[unit] = 0.0f;
+            velocity_y[unit] = 0.0f;
+            continue;
+        }
+        const float speed = squad->max_speed * SDL_min(distance / slowing_radius, 1.0f);
+        velocity_x[unit] = dx / distance * speed;
+        velocity_y[unit] = dy / distance * speed;
+    }
+}
+
+float wc_squad_assignment_cost(const WC_Squad* squad, const float* unit_x, const float* unit_y)
+{
+    float total = 0.0f;
+    for (uint32_t m = 0; m < squad->member_count; m++)
+    {
+        float sx, sy;
+        squad_slot_position(squad, squad->slot[m], &sx, &sy);
+        const float dx = sx - unit_x[squad->members[m]];
+        const float dy = sy - unit_y[squad->members[m]];
+        total += SDL_sqrtf(dx * dx + dy * dy);
+    }
+    return total;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <stdint.h>
+
+#define WC_SQUAD_MAX_WAYPOINTS 32
+// Rounds of pairwise slot swaps after the greedy assignment
+#define WC_SQUAD_SWAP_ROUNDS 4
+
+// A group moving as one: the squad follows a single path with a formation anchor, and every member
+// steers towards its slot around the anchor. Members are unit ids owned by the caller; positions
+// come in and velocities go out through arrays indexed by unit.
+typedef struct WC_Squad
+{
+    uint32_t* members;
+    uint32_t member_count;
+    uint32_t capacity;
+
+    // Per member slot in formation space: x to the right, y forwards
+    float* slot_x;
+    float* slot_y;
+    uint32_t* slot; // Per member, index into the slot arrays
+
+    float waypoint_x[WC_SQUAD_MAX_WAYPOINTS];
+    float waypoint_y[WC_SQUAD_MAX_WAYPOINTS];
+    uint32_t waypoint_count;
+    uint32_t waypoint;
+
+    float anchor_x;
+    float anchor_y;
+    float heading_x;
+    float heading_y;
+
+    float spacing;
+    uint32_t columns; // Zero picks a box about twice as wide as deep
+    float speed;      // Of the anchor; members may go faster to catch up
+    float max_speed;
+} WC_Squad;
+
+int wc_squad_init(WC_Squad* squad, uint32_t capacity);
+void wc_squad_free(WC_Squad* squad);
+void wc_squad_add(WC_Squad* squad, uint32_t unit);
+// Swap-removes a member; its slot is left empty until the next order
+void wc_squad_remove(WC_Squad* squad, uint32_t member);
+
+// Orders the squad along a path, usually one from a single path query for the whole squad. Forms up
+// at the members' centroid facing the first waypoint, then assigns members to slots: greedy nearest
+// slot first, improved by rounds of pairwise swaps searched on the job system.
+void wc_squad_order(WC_Squad* squad, const float* unit_x, const float* unit_y, const float* path_x, const float* path_y,
+                    uint32_t path_count);
+
+// Advances the anchor along the path and writes an arrival-steered velocity for every member to
+// velocity_x/y, indexed by unit. The anchor waits while members lag far behind their slots.
+void wc_squad_update(WC_Squad* squad, const float* unit_x, const float* unit_y, float delta_time, float* velocity_x,
+                     float* velocity_y);
+
+// Sum of member distances to their slots, what the assignment minimizes
+float wc_squad_assignment_cost(const WC_Squad* squad, const float* unit_x, const float* unit_y);
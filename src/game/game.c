@@ -1,8 +1,18 @@
 #include "game.h"
-
+#include "ai_scheduler.h"
+#include "economy.h"
+#include "formation.h"
+#include "influence.h"
+#include "orders.h"
+#include "projectile.h"
+#include "terrain.h"
+
+#include "../render/resource.h"
 #include "../system/job.h"
 #include "../system/memory.h"
+#include "../system/random.h"
 
+#include <SDL3/SDL_filesystem.h>
 #include <SDL3/SDL_log.h>
 #include <math.h>
 
@@ -11,16 +21,39 @@ typedef struct
     float x, y, z;
     float vx, vy, vz;
     float health;
+    float cooldown; // Until the weapon can fire again
     uint32_t unit_type;
     uint32_t player_id;
+    uint32_t squad; // SQUAD_NONE when the unit moves on its own
 } Unit;
 
+#define SQUAD_NONE UINT32_MAX
+#define PLAYER_COUNT 4
+
 typedef struct
 {
     Unit* units;
-    WC_Arena arena;
     uint32_t unit_count;
     uint32_t capacity;
+    uint64_t seed;
+    uint64_t tick;
+    WC_Projectiles projectiles;
+    WC_ProjectileTargets targets;
+    WC_ProjectileHits hits;
+    WC_InfluenceMap influence;
+    WC_AiScheduler ai;
+    WC_Terrain terrain;
+    float* strength; // Per unit, what it adds to its player's influence
+    WC_Squad squads[PLAYER_COUNT];
+    uint32_t squad_count;
+    float* steer_vx; // Per unit, written by its squad or its orders
+    float* steer_vy;
+    uint8_t* engaged; // Per unit, enemies close enough to halt an attack-move
+    WC_OrderTable orders;
+    WC_CommandBuffer commands; // Applied at the start of the next tick
+    float command_credit;      // Test commands owed to each player
+    WC_Economy economy;
+    uint8_t* supply; // Per unit, what it counts against its player's supply
 } GameWorld;
 
 // Example task data structures
@@ -30,27 +63,51 @@ typedef struct
     uint32_t start_index;
     uint32_t count;
     float delta_time;
+    const WC_Terrain* terrain;
 } MovementTaskData;
 
 typedef struct
 {
     Unit* units;
-    uint32_t start_index;
+    const uint32_t* unit_ids;
     uint32_t count;
     GameWorld* world;
 } AITaskData;
 
-// AI decision making task
+// Threat around a unit decides how soon it thinks again: about one enemy within a cell is a fight,
+// the faint edge of the blur is close to one
+#define AI_COMBAT_THREAT 0.05f
+#define AI_NEAR_THREAT 0.005f
+
+// AI decision making task, over the units the scheduler picked this tick
 void process_ai_decisions(void* data)
 {
     AITaskData* ai_data = (AITaskData*) data;
 
     for (uint32_t i = 0; i < ai_data->count; i++)
     {
-        Unit* unit = &ai_data->units[ai_data->start_index + i];
+        const uint32_t unit_id = ai_data->unit_ids[i];
+        Unit* unit = &ai_data->units[unit_id];
+        if (unit->health <= 0.0f)
+        {
+            unit->vx = 0.0f;
+            unit->vy = 0.0f;
+            wc_ai_scheduler_set_priority(&ai_data->world->ai, unit_id, WC_AI_PRIORITY_IDLE);
+            continue;
+        }
+        // Units with orders or a squad follow those, not their own decisions
+        if (unit->squad != SQUAD_NONE || wc_orders_queue(&ai_data->world->orders, unit_id))
+        {
+            wc_ai_scheduler_set_priority(&ai_data->world->ai, unit_id, WC_AI_PRIORITY_IDLE);
+            continue;
+        }
 
-        // Simple AI: move towards center if health is good
-        if (unit->health > 50.0f)
+        const WC_InfluenceMap* influence = &ai_data->world->influence;
+        const float ally = wc_influence_sample(influence, WC_INFLUENCE_ALLY, unit->player_id, unit->x, unit->y);
+        const float threat = wc_influence_sample(influence, WC_INFLUENCE_THREAT, unit->player_id, unit->x, unit->y);
+
+        // Healthy units push towards the center while their side holds the ground around them
+        if (unit->health > 50.0f && ally >= threat)
         {
             float dx = 0.0f - unit->x;
             float dy = 0.0f - unit->y;
@@ -62,9 +119,33 @@ void process_ai_decisions(void* data)
                 unit->vy = (dy / distance) * 10.0f;
             }
         }
+        // Wounded or outnumbered ones fall back down the threat gradient
+        else
+        {
+            float gx, gy;
+            wc_influence_gradient(influence, WC_INFLUENCE_THREAT, unit->player_id, unit->x, unit->y, &gx, &gy);
+            float slope = sqrtf(gx * gx + gy * gy);
+
+            if (slope > 1e-4f)
+            {
+                unit->vx = -(gx / slope) * 10.0f;
+                unit->vy = -(gy / slope) * 10.0f;
+            }
+        }
+
+        const WC_AiPriority priority = threat > AI_COMBAT_THREAT ? WC_AI_PRIORITY_COMBAT
+                                       : threat > AI_NEAR_THREAT ? WC_AI_PRIORITY_NEAR
+                                                                 : WC_AI_PRIORITY_IDLE;
+        wc_ai_scheduler_set_priority(&ai_data->world->ai, unit_id, priority);
     }
 }
 
+static bool unit_can_enter(const WC_Terrain* terrain, const bool stuck, const float x, const float y)
+{
+    uint32_t tx, ty;
+    return stuck ? wc_terrain_tile(terrain, x, y, &tx, &ty) : wc_terrain_passable(terrain, x, y);
+}
+
 // Movement processing task
 void process_movement(void* data)
 {
@@ -73,36 +154,33 @@ void process_movement(void* data)
     for (uint32_t i = 0; i < move_data->count; i++)
     {
         Unit* unit = &move_data->units[move_data->start_index + i];
-
-        // Update position based on velocity
-        unit->x += unit->vx * move_data->delta_time;
-        unit->y += unit->vy * move_data->delta_time;
-        unit->z += unit->vz * move_data->delta_time;
-
-        // Simple boundary checking
-        if (unit->x < -100.0f)
-            unit->x = -100.0f;
-        if (unit->x > 100.0f)
-            unit->x = 100.0f;
-        if (unit->y < -100.0f)
-            unit->y = -100.0f;
-        if (unit->y > 100.0f)
-            unit->y = 100.0f;
+        const WC_Terrain* terrain = move_data->terrain;
+
+        // Each axis moves only onto passable ground, so units slide along walls and the map edge.
+        // A unit already standing on blocked ground, e.g. under a new building, may walk off it.
+        const float x = unit->x + unit->vx * move_data->delta_time;
+        const float y = unit->y + unit->vy * move_data->delta_time;
+        const bool stuck = !wc_terrain_passable(terrain, unit->x, unit->y);
+        if (unit_can_enter(terrain, stuck, x, unit->y))
+            unit->x = x;
+        if (unit_can_enter(terrain, stuck, unit->x, y))
+            unit->y = y;
+
+        // Units walk on the ground
+        unit->z = wc_terrain_height(terrain, unit->x, unit->y);
     }
 }
 
-// Combat resolution task
+// Combat resolution task: weapons recharge here, damage arrives through projectile hits
 void process_combat(void* data)
 {
     MovementTaskData* combat_data = (MovementTaskData*) data;
 
-    // Simple combat: reduce health over time
     for (uint32_t i = 0; i < combat_data->count; i++)
     {
         Unit* unit = &combat_data->units[combat_data->start_index + i];
-        unit->health -= 1.0f * combat_data->delta_time;
-        if (unit->health < 0.0f)
-            unit->health = 0.0f;
+        if (unit->cooldown > 0.0f)
+            unit->cooldown -= combat_data->delta_time;
     }
 }
 
@@ -110,123 +188,550 @@ void process_combat(void* data)
 // Task system integration with game loop
 //-------------------------------------------------------------------------------------------------
 
-void wc_game_frame_with_tasks(GameWorld* world, float delta_time)
+#define UNIT_COUNT 10000
+// Room for units produced during the match
+#define UNIT_CAPACITY 16384
+#define UNITS_PER_TASK 256
+#define UNIT_RADIUS 0.5f
+// Units spawn on this many lattice points along each side of the map
+#define SPAWN_LATTICE 200
+// Members of each player's squad, taken from the front of the unit array
+#define SQUAD_SIZE 500
+
+// Thinks per tick; units that miss the cap think first next tick. A count rather than a time keeps
+// lockstep peers thinking the same units whatever their machines.
+#define AI_MAX_THINKS 8192
+// Debug builds also stop at a wall-clock budget, which is not lockstep safe
+#define AI_DEBUG_BUDGET_NS 1000000
+
+// Ticks between influence map rebuilds
+#define INFLUENCE_INTERVAL 4
+#define INFLUENCE_CELL_SIZE 8.0f
+
+// Units with queues of their own; the rest have at most an empty index
+#define ORDER_QUEUE_COUNT 4096
+#define ORDER_SPEED 10.0f
+#define ORDER_ARRIVAL_RADIUS 1.0f
+// Commands per minute from each stand-in player, and units per command
+#define COMMAND_APM 300
+#define COMMAND_MAX_SELECTION 24
+#define COMMAND_CAPACITY 256
+
+// Each player's base sits in a corner, with its resource nodes around it and its buildings on it
+#define ECONOMY_BASE_OFFSET 80.0f
+#define ECONOMY_NODES_PER_PLAYER 8
+#define ECONOMY_NODE_AMOUNT 20000
+#define ECONOMY_WORKERS_PER_PLAYER 1000
+#define ECONOMY_BUILDINGS_PER_PLAYER 250
+#define ECONOMY_BUILDING_SUPPLY 32
+#define ECONOMY_START_STOCK 500
+
+// Cost, supply and build time per unit type
+static const WC_ProductionType s_production[] = {
+    {50, 1, 4.0f},
+    {100, 2, 6.0f},
+    {150, 3, 9.0f},
+};
+
+// Used when there is no map file: flat ground over the 200m square around the origin
+#define TERRAIN_MAP "maps/test.wcmap"
+#define TERRAIN_TILES 200
+#define TERRAIN_TILE_SIZE 1.0f
+#define TEST_BUILDING_COUNT 12
+#define TEST_BUILDING_SIZE 6
+
+#define PROJECTILE_CAPACITY (1 << 20)
+#define PROJECTILE_SPEED 40.0f
+#define PROJECTILE_DAMAGE 10.0f
+#define PROJECTILE_LIFETIME 2.0f
+#define WEAPON_COOLDOWN 1.0f
+// Ticks between reordering projectiles by cell for the hit tests
+#define PROJECTILE_SORT_INTERVAL 8
+
+// Stream ids: every system draws from its own streams derived from the match seed
+enum
 {
-    const uint32_t units_per_task = 256;
-    const uint32_t total_units = world->unit_count;
-    const uint32_t num_jobs = (total_units + units_per_task - 1) / units_per_task;
+    GAME_RANDOM_WORLD = 1,
+    GAME_RANDOM_WEAPONS = 2,
+    GAME_RANDOM_TERRAIN = 3,
+    GAME_RANDOM_COMMANDS = 4,
+    GAME_RANDOM_ECONOMY = 5,
+};
 
-    JobHandle* ai_jobs = wc_malloc(sizeof(JobHandle) * num_jobs);
-    JobHandle* move_jobs = wc_malloc(sizeof(JobHandle) * num_jobs);
-    JobHandle* combat_jobs = wc_malloc(sizeof(JobHandle) * num_jobs);
+typedef struct
+{
+    GameWorld* world;
+    float delta_time;
+} FrameTaskData;
 
-    // Task data arrays (allocated from frame arena)
-    AITaskData* ai_data = wc_arena_alloc(&world->arena, num_jobs * sizeof(AITaskData));
-    MovementTaskData* movement_data = wc_arena_alloc(&world->arena,
-                                                     num_jobs * sizeof(MovementTaskData));
-    MovementTaskData* combat_data = wc_arena_alloc(&world->arena,
-                                                   num_jobs * sizeof(MovementTaskData));
+// Feeds the projectile targets and the influence sources
+static void publish_unit(GameWorld* world, const uint32_t i)
+{
+    const Unit* unit = &world->units[i];
+    WC_ProjectileTargets* targets = &world->targets;
+    targets->x[i] = unit->x;
+    targets->y[i] = unit->y;
+    targets->z[i] = unit->z;
+    targets->radius[i] = unit->health > 0.0f ? UNIT_RADIUS : 0.0f;
+    targets->player[i] = unit->player_id;
+    world->strength[i] = SDL_max(unit->health, 0.0f) * 0.01f;
+    world->supply[i] = unit->health > 0.0f ? (uint8_t) s_production[unit->unit_type].supply : 0;
+    world->engaged[i] = wc_influence_sample(&world->influence, WC_INFLUENCE_THREAT, unit->player_id, unit->x, unit->y) > AI_COMBAT_THREAT;
+}
+
+// Movement and combat only touch the unit they update, so each range runs both phases back to
+// back instead of waiting for every range between phases
+static void process_unit_range(const u32 start, const u32 end, void* data)
+{
+    const FrameTaskData* frame = (const FrameTaskData*) data;
 
-    // Phase 1: Create AI jobs (no dependencies)
-    for (uint32_t i = 0; i < num_jobs; i++)
+    MovementTaskData movement_data = {frame->world->units, start, end - start, frame->delta_time, &frame->world->terrain};
+
+    process_movement(&movement_data);
+    process_combat(&movement_data);
+
+    // Publish the range while it is still in cache
+    for (uint32_t i = start; i < end; i++)
+        publish_unit(frame->world, i);
+}
+
+// One job per squad: the squad steers from last tick's published positions and its members take
+// the velocities. Members only ever belong to one squad, so jobs never write the same unit.
+static void update_squads(const u32 start, const u32 end, void* data)
+{
+    const FrameTaskData* frame = (const FrameTaskData*) data;
+    GameWorld* world = frame->world;
+
+    for (uint32_t s = start; s < end; s++)
     {
-        uint32_t start_index = i * units_per_task;
-        uint32_t count = (start_index + units_per_task > total_units) ? total_units - start_index
-                                                                      : units_per_task;
+        WC_Squad* squad = &world->squads[s];
 
-        // Setup AI task data
-        ai_data[i].units = world->units;
-        ai_data[i].start_index = start_index;
-        ai_data[i].count = count;
-        ai_data[i].world = world;
+        // The dead leave, otherwise the squad would wait for them forever, and so do units given
+        // orders of their own
+        for (uint32_t m = squad->member_count; m-- > 0;)
+        {
+            Unit* unit = &world->units[squad->members[m]];
+            if (unit->health > 0.0f && !wc_orders_queue(&world->orders, squad->members[m]))
+                continue;
+            unit->vx = 0.0f;
+            unit->vy = 0.0f;
+            unit->squad = SQUAD_NONE;
+            wc_squad_remove(squad, m);
+        }
 
-        // Create AI task
-        ai_jobs[i] = job_schedule("Unit AI", process_ai_decisions, &ai_data[i], g_job_none);
+        wc_squad_update(squad, world->targets.x, world->targets.y, frame->delta_time, world->steer_vx, world->steer_vy);
+        for (uint32_t m = 0; m < squad->member_count; m++)
+        {
+            const uint32_t unit_id = squad->members[m];
+            world->units[unit_id].vx = world->steer_vx[unit_id];
+            world->units[unit_id].vy = world->steer_vy[unit_id];
+        }
     }
+}
 
-    // Phase 2: Create movement tasks (depend on AI)
-    for (uint32_t i = 0; i < num_jobs; i++)
+// Hits are merged in projectile order, so the damage lands the same way on every machine
+static void apply_projectile_hits(GameWorld* world)
+{
+    for (uint32_t i = 0; i < world->hits.count; i++)
     {
-        uint32_t start_index = i * units_per_task;
-        uint32_t count = (start_index + units_per_task > total_units) ? total_units - start_index
-                                                                      : units_per_task;
+        const WC_ProjectileHit* hit = &world->hits.merged[i];
+        Unit* unit = &world->units[hit->unit];
+        unit->health = SDL_max(unit->health - hit->damage, 0.0f);
+        if (unit->health <= 0.0f)
+            wc_orders_clear(&world->orders, hit->unit);
+    }
+}
 
-        // Setup movement task data
-        movement_data[i].units = world->units;
-        movement_data[i].start_index = start_index;
-        movement_data[i].count = count;
-        movement_data[i].delta_time = delta_time;
+// Order state machines run in parallel, then their velocities are copied to the units serially:
+// the copy only visits units with orders, a small share of the army
+static void execute_orders(GameWorld* world)
+{
+    const WC_OrderStep step = {
+        .x = world->targets.x,
+        .y = world->targets.y,
+        .engaged = world->engaged,
+        .velocity_x = world->steer_vx,
+        .velocity_y = world->steer_vy,
+        .speed = ORDER_SPEED,
+        .arrival_radius = ORDER_ARRIVAL_RADIUS,
+    };
+    wc_orders_execute(&world->orders, &step);
+
+    for (uint32_t i = 0; i < world->orders.active_count; i++)
+    {
+        const uint32_t unit_id = world->orders.queues[world->orders.active[i]].unit;
+        world->units[unit_id].vx = world->steer_vx[unit_id];
+        world->units[unit_id].vy = world->steer_vy[unit_id];
+    }
+}
 
-        // Create movement task
-        move_jobs[i] = job_schedule("Unit Movement", process_movement, &movement_data[i],
-                                    ai_jobs[i]);
+// Produced units walk out of their building; once the unit array is full the rest are lost, as
+// slots of dead units are not reused yet
+static void spawn_produced_units(GameWorld* world)
+{
+    const WC_Economy* economy = &world->economy;
+    for (uint32_t i = 0; i < economy->produced_count && world->unit_count < world->capacity; i++)
+    {
+        const WC_Produced* produced = &economy->produced[i];
+        const uint32_t unit_id = world->unit_count++;
+        world->units[unit_id] = (Unit) {
+            .x = economy->building_x[produced->building],
+            .y = economy->building_y[produced->building],
+            .z = 0.0f,
+            .health = 100.0f,
+            .unit_type = produced->type,
+            .player_id = produced->player,
+            .squad = SQUAD_NONE,
+        };
+        publish_unit(world, unit_id);
     }
+}
 
-    // Phase 3: Create combat tasks (depend on movement)
-    for (uint32_t i = 0; i < num_jobs; i++)
+// Totals come from per-chunk partial sums, so the army's supply is read from what was published
+// this tick
+static void update_economy(GameWorld* world, const float delta_time)
+{
+    const WC_EconomyArmy army = {world->targets.player, world->supply, world->unit_count};
+    wc_economy_update(&world->economy, &army, delta_time);
+    spawn_produced_units(world);
+}
+
+// Each stand-in player tries to queue one unit a tick at a random building of theirs, and is
+// held back by its stock and supply
+static void queue_test_production(GameWorld* world)
+{
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_ECONOMY, 1, world->tick);
+    for (uint32_t player = 0; player < PLAYER_COUNT; player++)
     {
-        uint32_t start_index = i * units_per_task;
-        uint32_t count = (start_index + units_per_task > total_units) ? total_units - start_index
-                                                                      : units_per_task;
+        const uint32_t building = player * ECONOMY_BUILDINGS_PER_PLAYER + wc_random_below(&random, ECONOMY_BUILDINGS_PER_PLAYER);
+        wc_economy_produce(&world->economy, building, wc_random_below(&random, SDL_arraysize(s_production)));
+    }
+}
 
-        // Setup combat task data
-        combat_data[i].units = world->units;
-        combat_data[i].start_index = start_index;
-        combat_data[i].count = count;
-        combat_data[i].delta_time = delta_time;
+// Stand-in players: each issues COMMAND_APM commands a minute to a handful of its units outside the
+// squads, drawn from this tick's command stream, to load test order processing at realistic rates
+static void issue_test_commands(GameWorld* world, const float delta_time)
+{
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_COMMANDS, 0, world->tick);
+    world->command_credit += COMMAND_APM / 60.0f * delta_time;
+    // Targets keep a twentieth of the map's size clear of its edges
+    const WC_Terrain* terrain = &world->terrain;
+    const float margin_x = wc_terrain_width(terrain) * 0.05f;
+    const float margin_y = wc_terrain_depth(terrain) * 0.05f;
+    for (; world->command_credit >= 1.0f; world->command_credit -= 1.0f)
+    {
+        for (uint32_t player = 0; player < PLAYER_COUNT; player++)
+        {
+            uint32_t selection[COMMAND_MAX_SELECTION];
+            uint32_t count = 0;
+            const uint32_t size = 1 + wc_random_below(&random, COMMAND_MAX_SELECTION);
+            for (uint32_t attempt = 0; attempt < size * PLAYER_COUNT * 2 && count < size; attempt++)
+            {
+                const uint32_t unit_id = wc_random_below(&random, world->unit_count);
+                const Unit* unit = &world->units[unit_id];
+                if (unit->player_id == player && unit->health > 0.0f && unit->squad == SQUAD_NONE)
+                    selection[count++] = unit_id;
+            }
+
+            const WC_Command command = {
+                .player = player,
+                .type = (uint8_t) wc_random_below(&random, WC_ORDER_STOP + 1),
+                .queued = wc_random_below(&random, 4) == 0,
+                .x = wc_random_range(&random, terrain->origin_x + margin_x, terrain->origin_x + wc_terrain_width(terrain) - margin_x),
+                .y = wc_random_range(&random, terrain->origin_y + margin_y, terrain->origin_y + wc_terrain_depth(terrain) - margin_y),
+            };
+            wc_command_buffer_push(&world->commands, &command, selection, count);
+        }
+    }
+}
 
-        // Create combat task
-        combat_jobs[i] = job_schedule("Unit Combat", process_combat, &combat_data[i], move_jobs[i]);
+// Spawning appends to the shared pool, so it runs on one thread in unit order. Shots leave along
+// the facing with a little spread drawn from this tick's weapon stream.
+static void fire_weapons(GameWorld* world)
+{
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_WEAPONS, 0, world->tick);
+    for (uint32_t i = 0; i < world->unit_count; i++)
+    {
+        Unit* unit = &world->units[i];
+        if (unit->health <= 0.0f || unit->cooldown > 0.0f)
+            continue;
+
+        const float yaw = atan2f(unit->vy, unit->vx) + wc_random_range(&random, -0.05f, 0.05f);
+        const float dx = cosf(yaw);
+        const float dy = sinf(yaw);
+        const WC_ProjectileDesc desc = {
+            .x = unit->x + dx * UNIT_RADIUS * 2.0f,
+            .y = unit->y + dy * UNIT_RADIUS * 2.0f,
+            .z = unit->z + UNIT_RADIUS,
+            .vx = dx * PROJECTILE_SPEED,
+            .vy = dy * PROJECTILE_SPEED,
+            .vz = 2.0f,
+            .damage = PROJECTILE_DAMAGE,
+            .radius = 0.1f,
+            .lifetime = PROJECTILE_LIFETIME,
+            .target = WC_PROJECTILE_NONE,
+            .owner = unit->player_id,
+        };
+        if (wc_projectiles_spawn(&world->projectiles, &desc) == WC_PROJECTILE_NONE)
+            break;
+        unit->cooldown = WEAPON_COOLDOWN;
+    }
+}
+
+static void think_units(const uint32_t* unit_ids, const uint32_t count, void* data)
+{
+    GameWorld* world = (GameWorld*) data;
+    AITaskData ai_data = {world->units, unit_ids, count, world};
+    process_ai_decisions(&ai_data);
+}
+
+void wc_game_frame_with_tasks(GameWorld* world, float delta_time)
+{
+    // Commands apply before anything thinks or moves, in the order they were issued
+    wc_orders_apply(&world->orders, &world->commands, world->targets.player);
+
+    // Thinks are spread over ticks by priority, so this stays within the budget as units grow
+#ifdef WC_DEBUG
+    const WC_AiBudget budget = {.time_ns = AI_DEBUG_BUDGET_NS, .max_thinks = AI_MAX_THINKS};
+#else
+    const WC_AiBudget budget = {.max_thinks = AI_MAX_THINKS};
+#endif
+    wc_ai_scheduler_tick(&world->ai, world->unit_count, &budget, think_units, world);
+
+    // Footprints placed or removed since the last tick reach the nav grid before anyone moves
+    wc_terrain_update(&world->terrain);
+
+    FrameTaskData frame = {world, delta_time};
+    job_wait(job_parallel_for(world->squad_count, 1, update_squads, &frame));
+    execute_orders(world);
+    job_wait(job_parallel_for(world->unit_count, UNITS_PER_TASK, process_unit_range, &frame));
+
+    // AI jobs read the influence map, so it is only rebuilt while none are running
+    if (world->tick % INFLUENCE_INTERVAL == 0)
+    {
+        const WC_InfluenceSources sources = {
+            .x = world->targets.x,
+            .y = world->targets.y,
+            .strength = world->strength,
+            .player = world->targets.player,
+            .count = world->unit_count,
+            .resource_x = world->economy.node_x,
+            .resource_y = world->economy.node_y,
+            .resource_amount = world->economy.node_amount,
+            .resource_count = world->economy.node_count,
+        };
+        wc_influence_update(&world->influence, &sources);
     }
 
-    wc_free(ai_jobs);
-    wc_free(move_jobs);
-    wc_free(combat_jobs);
+    world->targets.count = world->unit_count;
+    wc_projectile_targets_build(&world->targets);
+    if (world->tick % PROJECTILE_SORT_INTERVAL == 0)
+        wc_projectiles_sort(&world->projectiles, &world->targets);
+    wc_projectiles_update(&world->projectiles, &world->targets, delta_time, &world->hits);
+    apply_projectile_hits(world);
+    update_economy(world, delta_time);
+    fire_weapons(world);
+    issue_test_commands(world, delta_time);
+    queue_test_production(world);
+    world->tick++;
 }
 
 //-------------------------------------------------------------------------------------------------
 // Example usage and integration
 //-------------------------------------------------------------------------------------------------
 
-#define UNIT_COUNT 10000
-#define UNITS_PER_TASK 256
-
 static GameWorld g_world;
 
-static void create_test_world()
+#define GAME_DEFAULT_SEED 0x5741524352590001ull
+
+// One stream per chunk, so the layout depends only on the seed, not on which worker ran a chunk
+static void spawn_unit_range(const u32 start, const u32 end, void* data)
 {
-    g_world.capacity = UNIT_COUNT;
-    g_world.unit_count = UNIT_COUNT;
-    g_world.units = wc_malloc(UNIT_COUNT * sizeof(Unit));
+    GameWorld* world = (GameWorld*) data;
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_WORLD, start / UNITS_PER_TASK, 0);
+
+    const uint32_t count = end - start;
+    uint32_t x[UNITS_PER_TASK], y[UNITS_PER_TASK], type[UNITS_PER_TASK], player[UNITS_PER_TASK];
+    wc_random_fill_below(&random, SPAWN_LATTICE, x, count);
+    wc_random_fill_below(&random, SPAWN_LATTICE, y, count);
+    wc_random_fill_below(&random, 3, type, count);
+    wc_random_fill_below(&random, PLAYER_COUNT, player, count);
+
+    const WC_Terrain* terrain = &world->terrain;
+    const float spacing_x = wc_terrain_width(terrain) / (float) SPAWN_LATTICE;
+    const float spacing_y = wc_terrain_depth(terrain) / (float) SPAWN_LATTICE;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Unit* unit = &world->units[start + i];
+        unit->x = terrain->origin_x + (float) x[i] * spacing_x;
+        unit->y = terrain->origin_y + (float) y[i] * spacing_y;
+        unit->z = 0.0f;
+        unit->vx = 0.0f;
+        unit->vy = 0.0f;
+        unit->vz = 0.0f;
+        unit->health = 100.0f;
+        unit->cooldown = 0.0f;
+        unit->unit_type = type[i];
+        unit->player_id = player[i];
+        unit->squad = SQUAD_NONE;
+    }
+}
+
+// Each player's first SQUAD_SIZE units march as a squad across the map, on one path for all of
+// them. The path is a straight line to the side mirrored through the map center: the nav grid
+// only says which tiles are passable and there is no path search over it yet, so squads rely on
+// movement sliding members along blocked tiles rather than routing around them.
+static int create_test_squads(GameWorld* world)
+{
+    const float center_x = world->terrain.origin_x + wc_terrain_width(&world->terrain) * 0.5f;
+    const float center_y = world->terrain.origin_y + wc_terrain_depth(&world->terrain) * 0.5f;
+    for (uint32_t player = 0; player < PLAYER_COUNT; player++)
+    {
+        WC_Squad* squad = &world->squads[player];
+        if (wc_squad_init(squad, SQUAD_SIZE) != 0)
+            return -1;
+        world->squad_count++;
+
+        float cx = 0.0f, cy = 0.0f;
+        for (uint32_t i = 0; i < world->unit_count && squad->member_count < SQUAD_SIZE; i++)
+        {
+            Unit* unit = &world->units[i];
+            if (unit->player_id != player)
+                continue;
+            unit->squad = player;
+            wc_squad_add(squad, i);
+            cx += unit->x;
+            cy += unit->y;
+        }
+        if (squad->member_count == 0)
+            continue;
+
+        cx = cx / (float) squad->member_count - center_x;
+        cy = cy / (float) squad->member_count - center_y;
+        const float path_x[] = {center_x + cx * -0.4f, center_x + cx * -0.8f};
+        const float path_y[] = {center_y + cy * -0.4f, center_y + cy * -0.8f};
+        wc_squad_order(squad, world->targets.x, world->targets.y, path_x, path_y, 2);
+    }
+    return 0;
+}
 
-    const uint32_t num_jobs = (g_world.unit_count + UNITS_PER_TASK - 1) / UNITS_PER_TASK;
+static int create_test_terrain(GameWorld* world)
+{
+    char path[512];
+    SDL_snprintf(path, sizeof(path), "%s%s", SDL_GetBasePath(), TERRAIN_MAP);
+    if (wc_terrain_load(&world->terrain, path) != 0)
+    {
+        SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "No terrain map at %s, using flat ground\n", path);
+        if (wc_terrain_init(&world->terrain, TERRAIN_TILES, TERRAIN_TILES, -100.0f, -100.0f, TERRAIN_TILE_SIZE) != 0)
+            return -1;
+    }
 
-    wc_arena_init(&g_world.arena, sizeof(AITaskData) * num_jobs +
-                                      sizeof(MovementTaskData) * num_jobs +
-                                      sizeof(MovementTaskData) * num_jobs);
+    // A few buildings to walk around
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_TERRAIN, 0, 0);
+    for (uint32_t i = 0; i < TEST_BUILDING_COUNT; i++)
+    {
+        const WC_TerrainRect footprint = {
+            wc_random_below(&random, world->terrain.tiles_x),
+            wc_random_below(&random, world->terrain.tiles_y),
+            TEST_BUILDING_SIZE,
+            TEST_BUILDING_SIZE,
+        };
+        wc_terrain_occupy(&world->terrain, footprint);
+    }
+    wc_terrain_update(&world->terrain);
+    return 0;
+}
 
-    // Initialize units with random positions
-    for (uint32_t i = 0; i < UNIT_COUNT; i++)
+static int create_test_economy(GameWorld* world)
+{
+    const WC_EconomyDesc desc = {
+        .player_count = PLAYER_COUNT,
+        .types = s_production,
+        .type_count = SDL_arraysize(s_production),
+        .node_capacity = PLAYER_COUNT * ECONOMY_NODES_PER_PLAYER,
+        .worker_capacity = PLAYER_COUNT * ECONOMY_WORKERS_PER_PLAYER,
+        .building_capacity = PLAYER_COUNT * ECONOMY_BUILDINGS_PER_PLAYER,
+        .army_capacity = world->capacity,
+        .worker_speed = 4.0f,
+        .gather_time = 2.0f,
+        .carry = 5,
+    };
+    if (wc_economy_init(&world->economy, &desc) != 0)
+        return -1;
+
+    WC_Random random = wc_random_stream(world->seed, GAME_RANDOM_ECONOMY, 0, 0);
+    for (uint32_t player = 0; player < PLAYER_COUNT; player++)
     {
-        g_world.units[i].x = (float) (SDL_rand(200) - 100);
-        g_world.units[i].y = (float) (SDL_rand(200) - 100);
-        g_world.units[i].z = 0.0f;
-        g_world.units[i].vx = 0.0f;
-        g_world.units[i].vy = 0.0f;
-        g_world.units[i].vz = 0.0f;
-        g_world.units[i].health = 100.0f;
-        g_world.units[i].unit_type = SDL_rand(3);
-        g_world.units[i].player_id = SDL_rand(4);
+        const float base_x = player & 1 ? ECONOMY_BASE_OFFSET : -ECONOMY_BASE_OFFSET;
+        const float base_y = player & 2 ? ECONOMY_BASE_OFFSET : -ECONOMY_BASE_OFFSET;
+        wc_economy_set_base(&world->economy, player, base_x, base_y);
+        world->economy.stock[player] = ECONOMY_START_STOCK;
+
+        const uint32_t first_node = world->economy.node_count;
+        for (uint32_t i = 0; i < ECONOMY_NODES_PER_PLAYER; i++)
+        {
+            // Towards the middle of the map, so the nodes stay on it
+            const float x = base_x - SDL_copysignf(wc_random_range(&random, 10.0f, 40.0f), base_x);
+            const float y = base_y - SDL_copysignf(wc_random_range(&random, 10.0f, 40.0f), base_y);
+            wc_economy_add_node(&world->economy, x, y, ECONOMY_NODE_AMOUNT);
+        }
+        for (uint32_t i = 0; i < ECONOMY_WORKERS_PER_PLAYER; i++)
+            wc_economy_add_worker(&world->economy, player, first_node + i % ECONOMY_NODES_PER_PLAYER);
+        for (uint32_t i = 0; i < ECONOMY_BUILDINGS_PER_PLAYER; i++)
+        {
+            const float x = base_x + wc_random_range(&random, -10.0f, 10.0f);
+            const float y = base_y + wc_random_range(&random, -10.0f, 10.0f);
+            wc_economy_add_building(&world->economy, player, x, y, ECONOMY_BUILDING_SUPPLY);
+        }
     }
+    return 0;
+}
+
+static int create_test_world(const uint64_t seed)
+{
+    g_world.capacity = UNIT_CAPACITY;
+    g_world.unit_count = UNIT_COUNT;
+    g_world.units = wc_malloc(UNIT_CAPACITY * sizeof(Unit));
+    g_world.strength = wc_calloc(UNIT_CAPACITY, sizeof(float));
+    g_world.steer_vx = wc_calloc(UNIT_CAPACITY, sizeof(float));
+    g_world.steer_vy = wc_calloc(UNIT_CAPACITY, sizeof(float));
+    g_world.engaged = wc_calloc(UNIT_CAPACITY, sizeof(uint8_t));
+    g_world.supply = wc_calloc(UNIT_CAPACITY, sizeof(uint8_t));
+    g_world.seed = seed;
+    g_world.tick = 0;
+    if (!g_world.units || !g_world.strength || !g_world.steer_vx || !g_world.steer_vy || !g_world.engaged || !g_world.supply)
+        return -1;
+
+    if (create_test_terrain(&g_world) != 0)
+        return -1;
+
+    // Units are kept on the terrain, so the spatial grids cover exactly the map
+    const WC_Terrain* terrain = &g_world.terrain;
+    const float width = wc_terrain_width(terrain);
+    const float depth = wc_terrain_depth(terrain);
+    if (wc_projectiles_init(&g_world.projectiles, PROJECTILE_CAPACITY) != 0 ||
+        wc_projectile_targets_init(&g_world.targets, UNIT_CAPACITY, terrain->origin_x, terrain->origin_y, width, depth, 4.0f) != 0 ||
+        wc_influence_init(&g_world.influence, PLAYER_COUNT, terrain->origin_x, terrain->origin_y, width, depth, INFLUENCE_CELL_SIZE) != 0 ||
+        wc_ai_scheduler_init(&g_world.ai, UNIT_CAPACITY) != 0 || wc_orders_init(&g_world.orders, UNIT_CAPACITY, ORDER_QUEUE_COUNT) != 0 ||
+        wc_command_buffer_init(&g_world.commands, COMMAND_CAPACITY, COMMAND_CAPACITY * COMMAND_MAX_SELECTION) != 0 ||
+        create_test_economy(&g_world) != 0)
+        return -1;
+
+    job_wait(job_parallel_for(g_world.unit_count, UNITS_PER_TASK, spawn_unit_range, &g_world));
+    for (uint32_t i = 0; i < g_world.unit_count; i++)
+        publish_unit(&g_world, i);
+    return create_test_squads(&g_world);
 }
 
 int wc_game_init()
 {
     SDL_SetLogPriority(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_DEBUG);
 
-    job_init();
-
-    create_test_world();
+    if (create_test_world(GAME_DEFAULT_SEED) != 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create the test world\n");
+        return -1;
+    }
 
     return 0;
 }
@@ -234,17 +739,45 @@ int wc_game_init()
 void wc_game_update(const double delta_time)
 {
     wc_game_frame_with_tasks(&g_world, (float) delta_time);
-
-    wc_arena_reset(&g_world.arena);
 }
 
+// Extract: units are written straight into this frame's mapped instance region, no staging copy
 void wc_game_render(const double interpolant)
 {
+    (void) interpolant;
+
+    uint32_t first_instance;
+    WC_GpuInstance* instances = wc_gpu_resource_map_instances(&first_instance);
+    if (!instances)
+        return;
+
+    const uint32_t count = SDL_min(g_world.unit_count, WC_MAX_INSTANCES);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const Unit* unit = &g_world.units[i];
+        const float yaw = atan2f(unit->vy, unit->vx);
+        instances[i] = wc_gpu_instance_pack(unit->x, unit->y, unit->z, yaw, 1.0f, unit->unit_type, unit->player_id);
+    }
+    wc_gpu_resource_commit_instances(count);
 }
 
 void wc_game_quit()
 {
-    wc_arena_free(&g_world.arena);
+    wc_projectile_hits_free(&g_world.hits);
+    wc_projectile_targets_free(&g_world.targets);
+    wc_projectiles_free(&g_world.projectiles);
+    wc_ai_scheduler_free(&g_world.ai);
+    wc_influence_free(&g_world.influence);
+    wc_terrain_free(&g_world.terrain);
+    for (uint32_t s = 0; s < g_world.squad_count; s++)
+        wc_squad_free(&g_world.squads[s]);
+    wc_free(g_world.steer_vx);
+    wc_free(g_world.steer_vy);
+    wc_free(g_world.engaged);
+    wc_free(g_world.supply);
+    wc_economy_free(&g_world.economy);
+    wc_command_buffer_free(&g_world.commands);
+    wc_orders_free(&g_world.orders);
+    wc_free(g_world.strength);
     wc_free(g_world.units);
-    job_shutdown();
 }
@@ -0,0 +1,195 @@
+#include "influence.h"
+
+#include "../system/common.h"
+#include "../system/job.h"
+#include "../system/math.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+// Guard cells between rows: the right neighbour of each row's last batch and the left neighbour of
+// the next row's first. Eight keeps every row 32-byte aligned.
+#define INFLUENCE_GUARD 8
+
+int wc_influence_init(WC_InfluenceMap* map, const uint32_t player_count, const float origin_x, const float origin_y, const float width,
+                      const float height, const float cell_size)
+{
+    SDL_memset(map, 0, sizeof(*map));
+    if (player_count == 0 || player_count > WC_INFLUENCE_MAX_PLAYERS)
+        return -1;
+
+    map->origin_x = origin_x;
+    map->origin_y = origin_y;
+    map->inv_cell_size = 1.0f / cell_size;
+    map->cells_x = (uint32_t) SDL_max(1.0f, SDL_ceilf(width / cell_size));
+    map->cells_y = (uint32_t) SDL_max(1.0f, SDL_ceilf(height / cell_size));
+    map->row_cells = (uint32_t) war_align_up(map->cells_x, 8);
+    map->stride = map->row_cells + INFLUENCE_GUARD;
+    // A zeroed guard row above and below
+    map->layer_size = (size_t) map->stride * (map->cells_y + 2);
+    map->player_count = player_count;
+
+    // Ally and threat per player plus resources, then a blur scratch layer per build job
+    const size_t layer_count = 2 * player_count + 1;
+    const size_t scratch_count = player_count + 1;
+    const size_t size = map->layer_size * (layer_count + scratch_count) * sizeof(float);
+    map->block = wc_aligned_alloc(size, 32);
+    if (!map->block)
+        return -1;
+    SDL_memset(map->block, 0, size);
+
+    map->layers = map->block + map->stride;
+    map->scratch = map->layers + map->layer_size * layer_count;
+    return 0;
+}
+
+void wc_influence_free(WC_InfluenceMap* map)
+{
+    wc_aligned_free(map->block, 32);
+    SDL_memset(map, 0, sizeof(*map));
+}
+
+static float* influence_layer(const WC_InfluenceMap* map, const WC_InfluenceLayer layer, const uint32_t player)
+{
+    return (float*) wc_influence_layer(map, layer, player);
+}
+
+static void influence_clear(const WC_InfluenceMap* map, float* layer)
+{
+    for (uint32_t y = 0; y < map->cells_y; y++)
+        SDL_memset(layer + (size_t) y * map->stride, 0, map->row_cells * sizeof(float));
+}
+
+// Bilinear, so a unit's influence shifts smoothly as it crosses cells instead of jumping
+static void influence_splat(const WC_InfluenceMap* map, float* layer, const float x, const float y, const float amount)
+{
+    float fx = (x - map->origin_x) * map->inv_cell_size - 0.5f;
+    float fy = (y - map->origin_y) * map->inv_cell_size - 0.5f;
+    fx = fx > 0.0f ? SDL_min(fx, (float) (map->cells_x - 1)) : 0.0f;
+    fy = fy > 0.0f ? SDL_min(fy, (float) (map->cells_y - 1)) : 0.0f;
+
+    const uint32_t x0 = (uint32_t) fx;
+    const uint32_t y0 = (uint32_t) fy;
+    const uint32_t x1 = SDL_min(x0 + 1, map->cells_x - 1);
+    const uint32_t y1 = SDL_min(y0 + 1, map->cells_y - 1);
+    const float tx = fx - (float) x0;
+    const float ty = fy - (float) y0;
+
+    float* row0 = layer + (size_t) y0 * map->stride;
+    float* row1 = layer + (size_t) y1 * map->stride;
+    row0[x0] += amount * (1.0f - tx) * (1.0f - ty);
+    row0[x1] += amount * tx * (1.0f - ty);
+    row1[x0] += amount * (1.0f - tx) * ty;
+    row1[x1] += amount * tx * ty;
+}
+
+// Separable [1 2 1] / 4 passes, a full wc_wide of cells per iteration. The neighbours of the first
+// and last cells are guards, so no row needs a scalar edge case.
+static void influence_blur(const WC_InfluenceMap* map, float* layer, float* scratch)
+{
+    const wc_wide quarter = wc_wide_set1(0.25f);
+    const wc_wide two = wc_wide_set1(2.0f);
+    const size_t stride = map->stride;
+
+    for (uint32_t pass = 0; pass < WC_INFLUENCE_BLUR_PASSES; pass++)
+    {
+        for (uint32_t y = 0; y < map->cells_y; y++)
+        {
+            const float* in = layer + y * stride;
+            float* out = scratch + y * stride;
+            for (uint32_t x = 0; x < map->row_cells; x += WC_WIDE_LANES)
+            {
+                const wc_wide sides = wc_wide_add(wc_wide_load(in + x - 1), wc_wide_load(in + x + 1));
+                wc_wide_store(out + x, wc_wide_mul(quarter, wc_wide_madd(two, wc_wide_load(in + x), sides)));
+            }
+        }
+
+        for (uint32_t y = 0; y < map->cells_y; y++)
+        {
+            const float* in = scratch + y * stride;
+            float* out = layer + y * stride;
+            for (uint32_t x = 0; x < map->row_cells; x += WC_WIDE_LANES)
+            {
+                const wc_wide sides = wc_wide_add(wc_wide_load(in + x - stride), wc_wide_load(in + x + stride));
+                wc_wide_store(out + x, wc_wide_mul(quarter, wc_wide_madd(two, wc_wide_load(in + x), sides)));
+            }
+            // Padding past the last cell picked up influence; it has to read as zero next pass
+            for (uint32_t x = map->cells_x; x < map->row_cells; x++)
+                out[x] = 0.0f;
+        }
+    }
+}
+
+typedef struct
+{
+    WC_InfluenceMap* map;
+    const WC_InfluenceSources* sources;
+} InfluenceJobData;
+
+// Jobs [0, player_count) build a player's ally layer, the last one the resource layer. Each job
+// scans every unit for its player: cheaper than bucketing at a few players and keeps the
+// accumulation order fixed.
+static void influence_build(const u32 start, const u32 end, void* data)
+{
+    const InfluenceJobData* job = (const InfluenceJobData*) data;
+    const WC_InfluenceMap* map = job->map;
+    const WC_InfluenceSources* sources = job->sources;
+
+    for (uint32_t index = start; index < end; index++)
+    {
+        float* scratch = map->scratch + map->layer_size * index;
+        if (index < map->player_count)
+        {
+            float* layer = influence_layer(map, WC_INFLUENCE_ALLY, index);
+            influence_clear(map, layer);
+            for (uint32_t i = 0; i < sources->count; i++)
+            {
+                if (sources->player[i] == index && sources->strength[i] > 0.0f)
+                    influence_splat(map, layer, sources->x[i], sources->y[i], sources->strength[i]);
+            }
+            influence_blur(map, layer, scratch);
+        }
+        else
+        {
+            float* layer = influence_layer(map, WC_INFLUENCE_RESOURCES, 0);
+            influence_clear(map, layer);
+            for (uint32_t i = 0; i < sources->resource_count; i++)
+                influence_splat(map, layer, sources->resource_x[i], sources->resource_y[i], (float) sources->resource_amount[i]);
+            influence_blur(map, layer, scratch);
+        }
+    }
+}
+
+// Threat is summed from the other players' ally layers in player order rather than subtracted from
+// a total, which would leave rounding residue where only the player itself stands
+static void influence_threat(const u32 start, const u32 end, void* data)
+{
+    const InfluenceJobData* job = (const InfluenceJobData*) data;
+    const WC_InfluenceMap* map = job->map;
+
+    for (uint32_t player = start; player < end; player++)
+    {
+        float* threat = influence_layer(map, WC_INFLUENCE_THREAT, player);
+        for (uint32_t y = 0; y < map->cells_y; y++)
+        {
+            float* out = threat + (size_t) y * map->stride;
+            for (uint32_t x = 0; x < map->row_cells; x += WC_WIDE_LANES)
+            {
+                wc_wide sum = wc_wide_zero();
+                for (uint32_t other = 0; other < map->player_count; other++)
+                {
+                    if (other != player)
+                        sum = wc_wide_add(sum, wc_wide_load(wc_influence_layer(map, WC_INFLUENCE_ALLY, other) + (size_t) y * map->stride + x));
+                }
+                wc_wide_store(out + x, sum);
+            }
+        }
+    }
+}
+
+void wc_influence_update(WC_InfluenceMap* map, const WC_InfluenceSources* sources)
+{
+    InfluenceJobData data = {map, sources};
+    job_wait(job_parallel_for(map->player_count + 1, 1, influence_build, &data));
+    job_wait(job_parallel_for(map->player_count, 1, influence_threat, &data));
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WC_INFLUENCE_MAX_PLAYERS 8
+// Each pass is a [1 2 1] / 4 kernel along x then y; two passes spread a unit over about five cells
+#define WC_INFLUENCE_BLUR_PASSES 2
+
+typedef enum WC_InfluenceLayer
+{
+    WC_INFLUENCE_ALLY,      // The player's own strength
+    WC_INFLUENCE_THREAT,    // Summed strength of every other player
+    WC_INFLUENCE_RESOURCES, // Shared by all players
+} WC_InfluenceLayer;
+
+// What the map is built from, borrowed for the duration of wc_influence_update
+typedef struct WC_InfluenceSources
+{
+    const float* x;
+    const float* y;
+    const float* strength; // Zero for units that should not count, e.g. dead ones
+    const uint32_t* player;
+    uint32_t count;
+
+    // Resource nodes, weighted by what they have left, laid out like WC_Economy's node arrays
+    const float* resource_x;
+    const float* resource_y;
+    const uint32_t* resource_amount;
+    uint32_t resource_count;
+} WC_InfluenceSources;
+
+// Coarse grids over the map, one ally and one threat layer per player plus the resource layer. Rows
+// are padded to whole SIMD batches and surrounded by zeroed guard cells, so the blur runs wide
+// across every row without edge cases and influence falls off at the map border.
+typedef struct WC_InfluenceMap
+{
+    float origin_x;
+    float origin_y;
+    float inv_cell_size;
+    uint32_t cells_x;
+    uint32_t cells_y;
+    uint32_t row_cells; // cells_x rounded up to whole batches
+    uint32_t stride;    // Floats per row, guards included
+    size_t layer_size;  // Floats per layer, guard rows included
+    uint32_t player_count;
+    float* block;
+    float* layers; // Cell (0, 0) of the first layer
+    float* scratch; // One blur scratch layer per job
+} WC_InfluenceMap;
+
+int wc_influence_init(WC_InfluenceMap* map, uint32_t player_count, float origin_x, float origin_y, float width, float height,
+                      float cell_size);
+void wc_influence_free(WC_InfluenceMap* map);
+
+// Rebuilds every layer on the job system, one job per player, blocking until done. Cheap enough to
+// run every few ticks; queries in between see the last update.
+void wc_influence_update(WC_InfluenceMap* map, const WC_InfluenceSources* sources);
+
+static inline const float* wc_influence_layer(const WC_InfluenceMap* map, const WC_InfluenceLayer layer, const uint32_t player)
+{
+    const uint32_t index = layer == WC_INFLUENCE_RESOURCES ? 2 * map->player_count : (uint32_t) layer * map->player_count + player;
+    return map->layers + map->layer_size * index;
+}
+
+static inline uint32_t wc_influence_coord(const float offset, const float inv_cell_size, const uint32_t cells)
+{
+    const float cell = offset * inv_cell_size;
+    if (!(cell > 0.0f))
+        return 0;
+    if (cell >= (float) cells)
+        return cells - 1;
+    return (uint32_t) cell;
+}
+
+// Value of the cell containing (x, y), clamped to the map. A single load, safe from any job while
+// no update is running.
+static inline float wc_influence_sample(const WC_InfluenceMap* map, const WC_InfluenceLayer layer, const uint32_t player, const float x,
+                                        const float y)
+{
+    const uint32_t cx = wc_influence_coord(x - map->origin_x, map->inv_cell_size, map->cells_x);
+    const uint32_t cy = wc_influence_coord(y - map->origin_y, map->inv_cell_size, map->cells_y);
+    return wc_influence_layer(map, layer, player)[cy * map->stride + cx];
+}
+
+// Central differences around the cell containing (x, y), in influence per cell. The guard cells
+// make the neighbours of border cells valid reads.
+static inline void wc_influence_gradient(const WC_InfluenceMap* map, const WC_InfluenceLayer layer, const uint32_t player, const float x,
+                                         const float y, float* gx, float* gy)
+{
+    const uint32_t cx = wc_influence_coord(x - map->origin_x, map->inv_cell_size, map->cells_x);
+    const uint32_t cy = wc_influence_coord(y - map->origin_y, map->inv_cell_size, map->cells_y);
+    const float* cell = wc_influence_layer(map, layer, player) + cy * map->stride + cx;
+    *gx = (cell[1] - cell[-1]) * 0.5f;
+    *gy = (cell[map->stride] - cell[-(int32_t) map->stride]) * 0.5f;
+}
@@ -0,0 +1,257 @@
+#include "orders.h"
+
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+#define ORDERS_PER_JOB 64
+
+int wc_orders_init(WC_OrderTable* table, const uint32_t unit_capacity, const uint32_t queue_capacity)
+{
+    SDL_memset(table, 0, sizeof(*table));
+    table->unit_queue = wc_malloc(unit_capacity * sizeof(uint32_t));
+    table->queues = wc_malloc(queue_capacity * sizeof(WC_OrderQueue));
+    table->free = wc_malloc(queue_capacity * sizeof(uint32_t));
+    table->active = wc_malloc(queue_capacity * sizeof(uint32_t));
+    if (!table->unit_queue || !table->queues || !table->free || !table->active)
+    {
+        wc_orders_free(table);
+        return -1;
+    }
+    table->unit_capacity = unit_capacity;
+    table->queue_capacity = queue_capacity;
+
+    for (uint32_t unit = 0; unit < unit_capacity; unit++)
+        table->unit_queue[unit] = WC_ORDER_NONE;
+    // Taken from the back, so the first queues out are the lowest
+    for (uint32_t i = 0; i < queue_capacity; i++)
+        table->free[i] = queue_capacity - 1 - i;
+    table->free_count = queue_capacity;
+    return 0;
+}
+
+void wc_orders_free(WC_OrderTable* table)
+{
+    wc_free(table->unit_queue);
+    wc_free(table->queues);
+    wc_free(table->free);
+    wc_free(table->active);
+    SDL_memset(table, 0, sizeof(*table));
+}
+
+void wc_orders_clear(WC_OrderTable* table, const uint32_t unit)
+{
+    const uint32_t queue = table->unit_queue[unit];
+    if (queue == WC_ORDER_NONE)
+        return;
+    // Stays listed for one more execute, which zeroes the unit's velocity
+    table->queues[queue].count = 0;
+    table->queues[queue].settled = 0;
+}
+
+int wc_command_buffer_init(WC_CommandBuffer* buffer, const uint32_t capacity, const uint32_t unit_capacity)
+{
+    SDL_memset(buffer, 0, sizeof(*buffer));
+    buffer->commands = wc_malloc(capacity * sizeof(WC_Command));
+    buffer->units = wc_malloc(unit_capacity * sizeof(uint32_t));
+    if (!buffer->commands || !buffer->units)
+    {
+        wc_command_buffer_free(buffer);
+        return -1;
+    }
+    buffer->capacity = capacity;
+    buffer->unit_capacity = unit_capacity;
+    return 0;
+}
+
+void wc_command_buffer_free(WC_CommandBuffer* buffer)
+{
+    wc_free(buffer->commands);
+    wc_free(buffer->units);
+    SDL_memset(buffer, 0, sizeof(*buffer));
+}
+
+int wc_command_buffer_push(WC_CommandBuffer* buffer, const WC_Command* command, const uint32_t* units, const uint32_t unit_count)
+{
+    if (buffer->count == buffer->capacity || unit_count > buffer->unit_capacity - buffer->unit_count)
+        return -1;
+
+    WC_Command* stored = &buffer->commands[buffer->count++];
+    *stored = *command;
+    stored->first_unit = buffer->unit_count;
+    stored->unit_count = unit_count;
+    SDL_memcpy(buffer->units + buffer->unit_count, units, unit_count * sizeof(uint32_t));
+    buffer->unit_count += unit_count;
+    return 0;
+}
+
+// The unit's queue, taken from the pool if it has none yet
+static WC_OrderQueue* orders_take(WC_OrderTable* table, const uint32_t unit)
+{
+    uint32_t queue = table->unit_queue[unit];
+    if (queue == WC_ORDER_NONE)
+    {
+        if (table->free_count == 0)
+            return NULL;
+        queue = table->free[--table->free_count];
+        table->queues[queue].unit = unit;
+        table->queues[queue].head = 0;
+        table->queues[queue].count = 0;
+        table->queues[queue].settled = 0;
+        table->unit_queue[unit] = queue;
+        table->active[table->active_count++] = queue;
+    }
+    return &table->queues[queue];
+}
+
+void wc_orders_apply(WC_OrderTable* table, WC_CommandBuffer* buffer, const uint32_t* unit_player)
+{
+    table->commands = buffer->count;
+    table->issued = 0;
+    table->dropped = 0;
+
+    for (uint32_t c = 0; c < buffer->count; c++)
+    {
+        const WC_Command* command = &buffer->commands[c];
+        const uint32_t* units = buffer->units + command->first_unit;
+        for (uint32_t i = 0; i < command->unit_count; i++)
+        {
+            const uint32_t unit = units[i];
+            if (unit >= table->unit_capacity || unit_player[unit] != command->player || command->type > WC_ORDER_STOP)
+            {
+                table->dropped++;
+                continue;
+            }
+            if (command->type == WC_ORDER_STOP)
+            {
+                wc_orders_clear(table, unit);
+                table->issued++;
+                continue;
+            }
+
+            WC_OrderQueue* queue = orders_take(table, unit);
+            if (queue && !command->queued)
+                queue->count = 0;
+            if (!queue || queue->count == WC_ORDER_QUEUE_CAPACITY)
+            {
+                table->dropped++;
+                continue;
+            }
+            queue->orders[(queue->head + queue->count) % WC_ORDER_QUEUE_CAPACITY] = (WC_Order) {
+                .x = command->x,
+                .y = command->y,
+                .type = command->type,
+                .state = WC_ORDER_STATE_START,
+            };
+            queue->count++;
+            table->issued++;
+        }
+    }
+
+    buffer->count = 0;
+    buffer->unit_count = 0;
+}
+
+// Steers straight at the point; true once within the arrival radius
+static bool order_seek(const WC_OrderStep* step, const uint32_t unit, const float x, const float y)
+{
+    const float dx = x - step->x[unit];
+    const float dy = y - step->y[unit];
+    const float distance = SDL_sqrtf(dx * dx + dy * dy);
+    if (distance <= step->arrival_radius)
+    {
+        step->velocity_x[unit] = 0.0f;
+        step->velocity_y[unit] = 0.0f;
+        return true;
+    }
+    step->velocity_x[unit] = dx / distance * step->speed;
+    step->velocity_y[unit] = dy / distance * step->speed;
+    return false;
+}
+
+// One tick of an order's state machine; true when the order is done
+static bool order_run(const WC_OrderStep* step, const uint32_t unit, WC_Order* order)
+{
+    if (order->state == WC_ORDER_STATE_START)
+    {
+        order->origin_x = step->x[unit];
+        order->origin_y = step->y[unit];
+        order->state = WC_ORDER_STATE_ACTIVE;
+    }
+
+    switch (order->type)
+    {
+    case WC_ORDER_ATTACK_MOVE:
+        order->state = step->engaged[unit] ? WC_ORDER_STATE_ENGAGED : WC_ORDER_STATE_ACTIVE;
+        if (order->state == WC_ORDER_STATE_ENGAGED)
+            break;
+        return order_seek(step, unit, order->x, order->y);
+    case WC_ORDER_MOVE:
+        return order_seek(step, unit, order->x, order->y);
+    case WC_ORDER_PATROL:
+    {
+        const bool back = order->state == WC_ORDER_STATE_RETURN;
+        if (order_seek(step, unit, back ? order->origin_x : order->x, back ? order->origin_y : order->y))
+            order->state = back ? WC_ORDER_STATE_ACTIVE : WC_ORDER_STATE_RETURN;
+        return false;
+    }
+    default:
+        break;
+    }
+
+    step->velocity_x[unit] = 0.0f;
+    step->velocity_y[unit] = 0.0f;
+    return false;
+}
+
+typedef struct
+{
+    WC_OrderTable* table;
+    const WC_OrderStep* step;
+} OrderJobData;
+
+// A queue is only touched by its job, and its unit's velocity only by that queue
+static void orders_execute_range(const u32 start, const u32 end, void* data)
+{
+    const OrderJobData* job = (const OrderJobData*) data;
+    const WC_OrderStep* step = job->step;
+
+    for (uint32_t i = start; i < end; i++)
+    {
+        WC_OrderQueue* queue = &job->table->queues[job->table->active[i]];
+
+        // An order done on arrival hands over to the next within the same tick
+        step->velocity_x[queue->unit] = 0.0f;
+        step->velocity_y[queue->unit] = 0.0f;
+        while (queue->count > 0 && order_run(step, queue->unit, &queue->orders[queue->head]))
+        {
+            queue->head = (uint8_t) ((queue->head + 1) % WC_ORDER_QUEUE_CAPACITY);
+            queue->count--;
+        }
+        queue->settled = queue->count == 0;
+    }
+}
+
+void wc_orders_execute(WC_OrderTable* table, const WC_OrderStep* step)
+{
+    // Only queues the last call left empty go back to the pool. One cleared since then is still
+    // listed, so its unit's velocity is zeroed below like that of a unit whose last order finished.
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < table->active_count; i++)
+    {
+        const uint32_t queue = table->active[i];
+        if (table->queues[queue].count > 0 || !table->queues[queue].settled)
+        {
+            table->active[kept++] = queue;
+            continue;
+        }
+        table->unit_queue[table->queues[queue].unit] = WC_ORDER_NONE;
+        table->free[table->free_count++] = queue;
+    }
+    table->active_count = kept;
+
+    OrderJobData data = {table, step};
+    if (table->active_count > 0)
+        job_wait(job_parallel_for(table->active_count, ORDERS_PER_JOB, orders_execute_range, &data));
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WC_ORDER_NONE UINT32_MAX
+// Orders a unit can have queued; further queued commands are dropped, like a full shift-queue
+#define WC_ORDER_QUEUE_CAPACITY 8
+
+typedef enum WC_OrderType
+{
+    WC_ORDER_MOVE,        // Go to the point, then done
+    WC_ORDER_ATTACK_MOVE, // Go to the point, halting while engaged
+    WC_ORDER_PATROL,      // Go back and forth between where it started and the point, never done
+    WC_ORDER_HOLD,        // Stand still until replaced
+    WC_ORDER_STOP,        // Command only: clears the queue
+} WC_OrderType;
+
+typedef enum WC_OrderState
+{
+    WC_ORDER_STATE_START, // Not executed yet
+    WC_ORDER_STATE_ACTIVE,
+    WC_ORDER_STATE_ENGAGED, // Attack-move halted by an enemy
+    WC_ORDER_STATE_RETURN,  // Patrol on its way back
+} WC_OrderState;
+
+typedef struct WC_Order
+{
+    float x;
+    float y;
+    float origin_x; // Where the order started, for patrols
+    float origin_y;
+    uint8_t type;
+    uint8_t state;
+} WC_Order;
+
+// A ring of orders, owned by one unit while it has any
+typedef struct WC_OrderQueue
+{
+    WC_Order orders[WC_ORDER_QUEUE_CAPACITY];
+    uint32_t unit;
+    uint8_t head;
+    uint8_t count;
+    uint8_t settled; // Empty and its unit's velocity zeroed by the last execute
+} WC_OrderQueue;
+
+// Per-unit order queues in a pooled side table: units without orders, usually most of them, cost
+// one index. Queues in use are listed densely, so executing orders only visits units that have any.
+typedef struct WC_OrderTable
+{
+    uint32_t* unit_queue; // Per unit, WC_ORDER_NONE without orders
+    uint32_t unit_capacity;
+
+    WC_OrderQueue* queues;
+    uint32_t queue_capacity;
+    uint32_t* free;
+    uint32_t free_count;
+    uint32_t* active; // Queues in use, in the order they were taken
+    uint32_t active_count;
+
+    // Last apply, for load testing
+    uint32_t commands;
+    uint32_t issued;
+    uint32_t dropped; // Foreign units, full queues or no free queue
+} WC_OrderTable;
+
+// A player command for a set of units, as it arrives from input or the network
+typedef struct WC_Command
+{
+    uint32_t player;
+    uint8_t type;   // WC_OrderType
+    uint8_t queued; // Appends to the queue instead of replacing it
+    float x;
+    float y;
+    uint32_t first_unit; // Range in the buffer's unit array
+    uint32_t unit_count;
+} WC_Command;
+
+// Commands collected for the next tick, their selections packed in one array
+typedef struct WC_CommandBuffer
+{
+    WC_Command* commands;
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t* units;
+    uint32_t unit_count;
+    uint32_t unit_capacity;
+} WC_CommandBuffer;
+
+// What executing orders reads and writes, indexed by unit and borrowed for the call
+typedef struct WC_OrderStep
+{
+    const float* x;
+    const float* y;
+    const uint8_t* engaged; // Non-zero while enemies are close
+    float* velocity_x;      // Written for every unit with orders
+    float* velocity_y;
+    float speed;
+    float arrival_radius;
+} WC_OrderStep;
+
+int wc_orders_init(WC_OrderTable* table, uint32_t unit_capacity, uint32_t queue_capacity);
+void wc_orders_free(WC_OrderTable* table);
+
+// The unit's orders, or NULL when it has none left
+static inline const WC_OrderQueue* wc_orders_queue(const WC_OrderTable* table, const uint32_t unit)
+{
+    const uint32_t queue = table->unit_queue[unit];
+    return queue == WC_ORDER_NONE || table->queues[queue].count == 0 ? NULL : &table->queues[queue];
+}
+
+// Drops every order of the unit, e.g. when it dies. The next execute zeroes its velocity, the one
+// after returns its queue to the pool.
+void wc_orders_clear(WC_OrderTable* table, uint32_t unit);
+
+int wc_command_buffer_init(WC_CommandBuffer* buffer, uint32_t capacity, uint32_t unit_capacity);
+void wc_command_buffer_free(WC_CommandBuffer* buffer);
+// Copies the selection; returns non-zero when the buffer is full and the command was not added
+int wc_command_buffer_push(WC_CommandBuffer* buffer, const WC_Command* command, const uint32_t* units, uint32_t unit_count);
+
+// Applies the buffered commands in order at the start of a tick, then empties the buffer. Only
+// units owned by the commanding player, per unit_player, take orders.
+void wc_orders_apply(WC_OrderTable* table, WC_CommandBuffer* buffer, const uint32_t* unit_player);
+
+// Returns queues the last call left empty to the pool, then runs every unit's current order on the
+// job system, one state machine per queue, and writes its velocity. Finished orders are popped. A
+// unit whose orders ended, by finishing or by being cleared, gets a zero velocity and its queue
+// stays listed until the next call, so the caller can copy velocities for every listed queue.
+void wc_orders_execute(WC_OrderTable* table, const WC_OrderStep* step);
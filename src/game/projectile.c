@@ -0,0 +1,730 @@
+#include "projectile.h"
+
+#include "../system/common.h"
+#include "../system/job.h"
+#include "../system/math.h"
+#include "../system/memory.h"
+#include "../system/random.h"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+
+#define PROJECTILE_FLOAT_STREAMS 12
+#define PROJECTILE_UINT_STREAMS 2
+#define PROJECTILE_STREAMS (PROJECTILE_FLOAT_STREAMS + PROJECTILE_UINT_STREAMS)
+#define TARGET_FLOAT_STREAMS 8
+#define TARGET_UINT_STREAMS 3
+
+// Streams are padded to whole batches of the widest backend, so the last batch of a tick runs
+// through the wide path on spare lanes instead of a scalar tail
+static uint32_t projectile_padded(const uint32_t count)
+{
+    return (uint32_t) war_align_up(count, 8);
+}
+
+static size_t projectile_stream_size(const uint32_t capacity)
+{
+    return war_align_up((u64) projectile_padded(capacity) * sizeof(float), 32);
+}
+
+// Points the streams into one block: the float streams, then target and owner
+static void projectile_bind(WC_Projectiles* projectiles, char* block)
+{
+    const size_t stream_size = projectile_stream_size(projectiles->capacity);
+    float** floats[PROJECTILE_FLOAT_STREAMS] = {
+        &projectiles->x,  &projectiles->y,  &projectiles->z,  &projectiles->vx,     &projectiles->vy,     &projectiles->vz,
+        &projectiles->px, &projectiles->py, &projectiles->pz, &projectiles->damage, &projectiles->radius, &projectiles->lifetime,
+    };
+    for (uint32_t i = 0; i < PROJECTILE_FLOAT_STREAMS; i++)
+        *floats[i] = (float*) (block + stream_size * i);
+    projectiles->target = (uint32_t*) (block + stream_size * PROJECTILE_FLOAT_STREAMS);
+    projectiles->owner = (uint32_t*) (block + stream_size * (PROJECTILE_FLOAT_STREAMS + 1));
+}
+
+int wc_projectiles_init(WC_Projectiles* projectiles, const uint32_t capacity)
+{
+    SDL_memset(projectiles, 0, sizeof(*projectiles));
+    projectiles->capacity = capacity;
+
+    // Two blocks, each split into 32-byte aligned streams for aligned AVX loads
+    const size_t stream_size = projectile_stream_size(capacity);
+    const size_t block_size = stream_size * PROJECTILE_STREAMS;
+    char* block = wc_aligned_alloc(block_size * 2, 32);
+    projectiles->order = wc_malloc((size_t) SDL_max(capacity, 1u) * sizeof(uint32_t));
+    if (!block || !projectiles->order)
+    {
+        wc_aligned_free(block, 32);
+        wc_free(projectiles->order);
+        return -1;
+    }
+
+    // Spare lanes never home in on anything
+    SDL_memset(block, 0, block_size * 2);
+    SDL_memset(block + stream_size * PROJECTILE_FLOAT_STREAMS, 0xFF, stream_size);
+    SDL_memset(block + block_size + stream_size * PROJECTILE_FLOAT_STREAMS, 0xFF, stream_size);
+    projectile_bind(projectiles, block);
+    projectiles->spare = block + block_size;
+    return 0;
+}
+
+void wc_projectiles_free(WC_Projectiles* projectiles)
+{
+    // The streams may live in either half of the block after sorting
+    wc_aligned_free(SDL_min((char*) projectiles->x, (char*) projectiles->spare), 32);
+    wc_free(projectiles->order);
+    wc_free(projectiles->cell_offsets);
+    SDL_memset(projectiles, 0, sizeof(*projectiles));
+}
+
+uint32_t wc_projectiles_spawn(WC_Projectiles* projectiles, const WC_ProjectileDesc* desc)
+{
+    if (projectiles->count >= projectiles->capacity)
+        return WC_PROJECTILE_NONE;
+
+    const uint32_t i = projectiles->count++;
+    projectiles->x[i] = projectiles->px[i] = desc->x;
+    projectiles->y[i] = projectiles->py[i] = desc->y;
+    projectiles->z[i] = projectiles->pz[i] = desc->z;
+    projectiles->vx[i] = desc->vx;
+    projectiles->vy[i] = desc->vy;
+    projectiles->vz[i] = desc->vz;
+    projectiles->damage[i] = desc->damage;
+    projectiles->radius[i] = desc->radius;
+    projectiles->lifetime[i] = desc->lifetime;
+    projectiles->target[i] = desc->target;
+    projectiles->owner[i] = desc->owner;
+    return i;
+}
+
+void wc_projectiles_remove(WC_Projectiles* projectiles, const uint32_t index)
+{
+    const uint32_t last = --projectiles->count;
+    if (index == last)
+        return;
+
+    projectiles->x[index] = projectiles->x[last];
+    projectiles->y[index] = projectiles->y[last];
+    projectiles->z[index] = projectiles->z[last];
+    projectiles->vx[index] = projectiles->vx[last];
+    projectiles->vy[index] = projectiles->vy[last];
+    projectiles->vz[index] = projectiles->vz[last];
+    projectiles->px[index] = projectiles->px[last];
+    projectiles->py[index] = projectiles->py[last];
+    projectiles->pz[index] = projectiles->pz[last];
+    projectiles->damage[index] = projectiles->damage[last];
+    projectiles->radius[index] = projectiles->radius[last];
+    projectiles->lifetime[index] = projectiles->lifetime[last];
+    projectiles->target[index] = projectiles->target[last];
+    projectiles->owner[index] = projectiles->owner[last];
+}
+
+//-------------------------------------------------------------------------------------------------
+// Targets
+
+int wc_projectile_targets_init(WC_ProjectileTargets* targets, const uint32_t capacity, const float origin_x, const float origin_y,
+                               const float width, const float height, const float cell_size)
+{
+    SDL_memset(targets, 0, sizeof(*targets));
+    const size_t stream_size = war_align_up((u64) capacity * sizeof(float), 32);
+    char* block = wc_aligned_alloc(stream_size * (TARGET_FLOAT_STREAMS + TARGET_UINT_STREAMS), 32);
+    if (!block)
+        return -1;
+
+    targets->cells_x = (uint32_t) SDL_max(1.0f, SDL_ceilf(width / cell_size));
+    targets->cells_y = (uint32_t) SDL_max(1.0f, SDL_ceilf(height / cell_size));
+    targets->cell_start = wc_calloc((size_t) targets->cells_x * targets->cells_y + 1, sizeof(uint32_t));
+    if (!targets->cell_start)
+    {
+        wc_aligned_free(block, 32);
+        return -1;
+    }
+
+    float** floats[TARGET_FLOAT_STREAMS] = {
+        &targets->x,        &targets->y,        &targets->z,        &targets->radius,
+        &targets->sorted_x, &targets->sorted_y, &targets->sorted_z, &targets->sorted_radius,
+    };
+    for (uint32_t i = 0; i < TARGET_FLOAT_STREAMS; i++)
+        *floats[i] = (float*) (block + stream_size * i);
+    targets->player = (uint32_t*) (block + stream_size * TARGET_FLOAT_STREAMS);
+    targets->sorted = (uint32_t*) (block + stream_size * (TARGET_FLOAT_STREAMS + 1));
+    targets->sorted_player = (uint32_t*) (block + stream_size * (TARGET_FLOAT_STREAMS + 2));
+
+    targets->capacity = capacity;
+    targets->origin_x = origin_x;
+    targets->origin_y = origin_y;
+    targets->inv_cell_size = 1.0f / cell_size;
+    return 0;
+}
+
+void wc_projectile_targets_free(WC_ProjectileTargets* targets)
+{
+    wc_aligned_free(targets->x, 32);
+    wc_free(targets->cell_start);
+    SDL_memset(targets, 0, sizeof(*targets));
+}
+
+// Clamped in float first: converting an out of range float to an integer is undefined
+static inline uint32_t projectile_cell_coord(const float offset, const float inv_cell_size, const uint32_t cells)
+{
+    const float cell = offset * inv_cell_size;
+    if (!(cell > 0.0f))
+        return 0;
+    if (cell >= (float) cells)
+        return cells - 1;
+    return (uint32_t) cell;
+}
+
+static inline uint32_t projectile_cell(const WC_ProjectileTargets* targets, const float x, const float y)
+{
+    const uint32_t cx = projectile_cell_coord(x - targets->origin_x, targets->inv_cell_size, targets->cells_x);
+    const uint32_t cy = projectile_cell_coord(y - targets->origin_y, targets->inv_cell_size, targets->cells_y);
+    return cy * targets->cells_x + cx;
+}
+
+void wc_projectile_targets_build(WC_ProjectileTargets* targets)
+{
+    const uint32_t cell_count = targets->cells_x * targets->cells_y;
+    uint32_t* start = targets->cell_start;
+    SDL_memset(start, 0, (cell_count + 1) * sizeof(uint32_t));
+
+    float max_radius = 0.0f;
+    for (uint32_t i = 0; i < targets->count; i++)
+    {
+        if (targets->radius[i] <= 0.0f)
+            continue;
+        start[projectile_cell(targets, targets->x[i], targets->y[i]) + 1]++;
+        max_radius = SDL_max(max_radius, targets->radius[i]);
+    }
+    for (uint32_t c = 0; c < cell_count; c++)
+        start[c + 1] += start[c];
+
+    // Placing advances each cell's offset to the start of the next cell, shifted back afterwards
+    for (uint32_t i = 0; i < targets->count; i++)
+    {
+        if (targets->radius[i] <= 0.0f)
+            continue;
+        const uint32_t slot = start[projectile_cell(targets, targets->x[i], targets->y[i])]++;
+        targets->sorted[slot] = i;
+        targets->sorted_x[slot] = targets->x[i];
+        targets->sorted_y[slot] = targets->y[i];
+        targets->sorted_z[slot] = targets->z[i];
+        targets->sorted_radius[slot] = targets->radius[i];
+        targets->sorted_player[slot] = targets->player[i];
+    }
+    SDL_memmove(start + 1, start, cell_count * sizeof(uint32_t));
+    start[0] = 0;
+    targets->max_radius = max_radius;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Update
+
+typedef struct
+{
+    const WC_Projectiles* projectiles;
+    const char* source;
+    char* destination;
+} ProjectileSortData;
+
+static void projectile_scatter_streams(const u32 start, const u32 end, void* data)
+{
+    const ProjectileSortData* sort = (const ProjectileSortData*) data;
+    const size_t stream_size = projectile_stream_size(sort->projectiles->capacity);
+    const uint32_t* order = sort->projectiles->order;
+    for (uint32_t s = start; s < end; s++)
+    {
+        const uint32_t* source = (const uint32_t*) (sort->source + stream_size * s);
+        uint32_t* destination = (uint32_t*) (sort->destination + stream_size * s);
+        for (uint32_t i = 0; i < sort->projectiles->count; i++)
+            destination[order[i]] = source[i];
+    }
+}
+
+void wc_projectiles_sort(WC_Projectiles* projectiles, const WC_ProjectileTargets* targets)
+{
+    const uint32_t cell_count = targets->cells_x * targets->cells_y;
+    if (cell_count + 1 > projectiles->cell_capacity)
+    {
+        projectiles->cell_offsets = wc_realloc(projectiles->cell_offsets, (cell_count + 1) * sizeof(uint32_t));
+        projectiles->cell_capacity = cell_count + 1;
+    }
+    uint32_t* offsets = projectiles->cell_offsets;
+    uint32_t* order = projectiles->order;
+    SDL_memset(offsets, 0, (cell_count + 1) * sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < projectiles->count; i++)
+    {
+        order[i] = projectile_cell(targets, projectiles->x[i], projectiles->y[i]);
+        offsets[order[i] + 1]++;
+    }
+    for (uint32_t c = 0; c < cell_count; c++)
+        offsets[c + 1] += offsets[c];
+    // Cell keys become destinations
+    for (uint32_t i = 0; i < projectiles->count; i++)
+        order[i] = offsets[order[i]]++;
+
+    // Every stream is scattered as raw 32-bit words into the spare block, one job per stream, and
+    // the spare block then takes over
+    char* block = (char*) projectiles->x;
+    ProjectileSortData data = {projectiles, block, projectiles->spare};
+    job_wait(job_parallel_for(PROJECTILE_STREAMS, 1, projectile_scatter_streams, &data));
+    projectile_bind(projectiles, projectiles->spare);
+    projectiles->spare = block;
+}
+
+void wc_projectile_hits_free(WC_ProjectileHits* hits)
+{
+    for (uint32_t i = 0; i < WC_PROJECTILE_MAX_WORKERS; i++)
+    {
+        wc_free(hits->lists[i]);
+        wc_free(hits->removed[i]);
+    }
+    wc_free(hits->merged);
+    wc_free(hits->removals);
+    SDL_memset(hits, 0, sizeof(*hits));
+}
+
+// Ballistic projectiles fall, homing ones blend their velocity towards the target at constant
+// speed. Both kinds share each batch; the select picks the result per lane.
+static void projectile_integrate(WC_Projectiles* projectiles, const WC_ProjectileTargets* targets, const uint32_t start,
+                                 const uint32_t end, const float delta_time)
+{
+    const wc_wide dt = wc_wide_set1(delta_time);
+    const wc_wide fall = wc_wide_set1(WC_PROJECTILE_GRAVITY * delta_time);
+    const wc_wide turn = wc_wide_set1(SDL_min(WC_PROJECTILE_TURN_RATE * delta_time, 1.0f));
+    const wc_wide epsilon = wc_wide_set1(1e-6f);
+    const wc_wide half = wc_wide_set1(0.5f);
+
+    for (uint32_t i = start; i < end; i += WC_WIDE_LANES)
+    {
+        // Gather the target positions; dead or missing targets leave the lane ballistic
+        float tx[WC_WIDE_LANES], ty[WC_WIDE_LANES], tz[WC_WIDE_LANES], homing[WC_WIDE_LANES];
+        for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+        {
+            const uint32_t unit = projectiles->target[i + lane];
+            const bool alive = unit < targets->count && targets->radius[unit] > 0.0f;
+            tx[lane] = alive ? targets->x[unit] : 0.0f;
+            ty[lane] = alive ? targets->y[unit] : 0.0f;
+            tz[lane] = alive ? targets->z[unit] : 0.0f;
+            homing[lane] = alive ? 1.0f : 0.0f;
+        }
+
+        const wc_wide3 position = {wc_wide_load(&projectiles->x[i]), wc_wide_load(&projectiles->y[i]), wc_wide_load(&projectiles->z[i])};
+        wc_wide3 velocity = {wc_wide_load(&projectiles->vx[i]), wc_wide_load(&projectiles->vy[i]), wc_wide_load(&projectiles->vz[i])};
+        wc_wide_store(&projectiles->px[i], position.x);
+        wc_wide_store(&projectiles->py[i], position.y);
+        wc_wide_store(&projectiles->pz[i], position.z);
+
+        const wc_wide3 to_target = {wc_wide_sub(wc_wide_load(tx), position.x), wc_wide_sub(wc_wide_load(ty), position.y),
+                                    wc_wide_sub(wc_wide_load(tz), position.z)};
+        const wc_wide speed = wc_wide_sqrt(wc_wide3_dot(velocity, velocity));
+        const wc_wide scale = wc_wide_div(speed, wc_wide_sqrt(wc_wide_max(wc_wide3_dot(to_target, to_target), epsilon)));
+        const wc_wide3 steered = {
+            wc_wide_madd(wc_wide_sub(wc_wide_mul(to_target.x, scale), velocity.x), turn, velocity.x),
+            wc_wide_madd(wc_wide_sub(wc_wide_mul(to_target.y, scale), velocity.y), turn, velocity.y),
+            wc_wide_madd(wc_wide_sub(wc_wide_mul(to_target.z, scale), velocity.z), turn, velocity.z),
+        };
+
+        const wc_wide mask = wc_wide_gt(wc_wide_load(homing), half);
+        velocity.x = wc_wide_select(mask, steered.x, velocity.x);
+        velocity.y = wc_wide_select(mask, steered.y, velocity.y);
+        velocity.z = wc_wide_select(mask, steered.z, wc_wide_sub(velocity.z, fall));
+
+        wc_wide_store(&projectiles->x[i], wc_wide_madd(velocity.x, dt, position.x));
+        wc_wide_store(&projectiles->y[i], wc_wide_madd(velocity.y, dt, position.y));
+        wc_wide_store(&projectiles->z[i], wc_wide_madd(velocity.z, dt, position.z));
+        wc_wide_store(&projectiles->vx[i], velocity.x);
+        wc_wide_store(&projectiles->vy[i], velocity.y);
+        wc_wide_store(&projectiles->vz[i], velocity.z);
+        wc_wide_store(&projectiles->lifetime[i], wc_wide_sub(wc_wide_load(&projectiles->lifetime[i]), dt));
+    }
+}
+
+typedef struct
+{
+    float t;
+    uint32_t slot;
+} ProjectileContact;
+
+static inline void projectile_consider(const WC_ProjectileTargets* targets, const uint32_t owner, const uint32_t slot, const float t,
+                                       ProjectileContact* best)
+{
+    if (targets->sorted_player[slot] != owner && t < best->t)
+    {
+        best->t = t;
+        best->slot = slot;
+    }
+}
+
+// Closest approach of the segment travelled this tick to each unit sphere in the cells around it.
+// Each row of cells is one contiguous run of the sorted unit arrays, tested a wc_wide at a time; the
+// earliest contact along the segment wins.
+static uint32_t projectile_hit_test(const WC_Projectiles* projectiles, const WC_ProjectileTargets* targets, const uint32_t i)
+{
+    const float x0 = projectiles->px[i], y0 = projectiles->py[i], z0 = projectiles->pz[i];
+    const float dx = projectiles->x[i] - x0, dy = projectiles->y[i] - y0, dz = projectiles->z[i] - z0;
+    const float length_sq = dx * dx + (dy * dy + dz * dz);
+    const float inv_length_sq = length_sq > 1e-12f ? 1.0f / length_sq : 0.0f;
+    const float radius = projectiles->radius[i];
+    const float reach = radius + targets->max_radius;
+    const uint32_t owner = projectiles->owner[i];
+
+    const float ix = targets->inv_cell_size;
+    const uint32_t cx0 = projectile_cell_coord(SDL_min(x0, x0 + dx) - reach - targets->origin_x, ix, targets->cells_x);
+    const uint32_t cx1 = projectile_cell_coord(SDL_max(x0, x0 + dx) + reach - targets->origin_x, ix, targets->cells_x);
+    const uint32_t cy0 = projectile_cell_coord(SDL_min(y0, y0 + dy) - reach - targets->origin_y, ix, targets->cells_y);
+    const uint32_t cy1 = projectile_cell_coord(SDL_max(y0, y0 + dy) + reach - targets->origin_y, ix, targets->cells_y);
+
+    const wc_wide3 origin = {wc_wide_set1(x0), wc_wide_set1(y0), wc_wide_set1(z0)};
+    const wc_wide3 direction = {wc_wide_set1(dx), wc_wide_set1(dy), wc_wide_set1(dz)};
+    const wc_wide wide_inv_length_sq = wc_wide_set1(inv_length_sq);
+    const wc_wide wide_radius = wc_wide_set1(radius);
+    const wc_wide zero = wc_wide_zero();
+    const wc_wide one = wc_wide_set1(1.0f);
+
+    ProjectileContact best = {2.0f, WC_PROJECTILE_NONE};
+    for (uint32_t cy = cy0; cy <= cy1; cy++)
+    {
+        const uint32_t row = cy * targets->cells_x;
+        uint32_t j = targets->cell_start[row + cx0];
+        const uint32_t run_end = targets->cell_start[row + cx1 + 1];
+
+        for (; j + WC_WIDE_LANES <= run_end; j += WC_WIDE_LANES)
+        {
+            const wc_wide3 offset = {wc_wide_sub(wc_wide_load(&targets->sorted_x[j]), origin.x),
+                                     wc_wide_sub(wc_wide_load(&targets->sorted_y[j]), origin.y),
+                                     wc_wide_sub(wc_wide_load(&targets->sorted_z[j]), origin.z)};
+            const wc_wide t = wc_wide_min(wc_wide_max(wc_wide_mul(wc_wide3_dot(offset, direction), wide_inv_length_sq), zero), one);
+            const wc_wide3 miss = {wc_wide_sub(offset.x, wc_wide_mul(direction.x, t)), wc_wide_sub(offset.y, wc_wide_mul(direction.y, t)),
+                                   wc_wide_sub(offset.z, wc_wide_mul(direction.z, t))};
+            const wc_wide reach_sum = wc_wide_add(wc_wide_load(&targets->sorted_radius[j]), wide_radius);
+            const uint32_t mask = wc_wide_mask_bits(wc_wide_ge(wc_wide_mul(reach_sum, reach_sum), wc_wide3_dot(miss, miss)));
+            if (!mask)
+                continue;
+
+            float ts[WC_WIDE_LANES];
+            wc_wide_store(ts, t);
+            for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+            {
+                if ((mask >> lane) & 1)
+                    projectile_consider(targets, owner, j + lane, ts[lane], &best);
+            }
+        }
+
+        for (; j < run_end; j++)
+        {
+            const float ox = targets->sorted_x[j] - x0, oy = targets->sorted_y[j] - y0, oz = targets->sorted_z[j] - z0;
+            const float t = SDL_min(SDL_max((ox * dx + (oy * dy + oz * dz)) * inv_length_sq, 0.0f), 1.0f);
+            const float mx = ox - dx * t, my = oy - dy * t, mz = oz - dz * t;
+            const float reach_sum = targets->sorted_radius[j] + radius;
+            if (reach_sum * reach_sum >= mx * mx + (my * my + mz * mz))
+                projectile_consider(targets, owner, j, t, &best);
+        }
+    }
+    return best.slot == WC_PROJECTILE_NONE ? WC_PROJECTILE_NONE : targets->sorted[best.slot];
+}
+
+// Wider batches fall back to one projectile at a time, since the union of their neighbourhoods
+// would test more units than the projectiles do alone
+#define PROJECTILE_BATCH_MAX_CELLS 9
+
+// A wc_wide of consecutive projectiles against the units around all of them, one unit broadcast per
+// iteration. Sorted by cell, the batch shares most of its neighbourhood, so a unit costs one wide
+// test for the whole batch instead of one scalar test per projectile. Returns false when the batch
+// is too spread out.
+static bool projectile_hit_test_batch(const WC_Projectiles* projectiles, const WC_ProjectileTargets* targets, const uint32_t i,
+                                      uint32_t units[WC_WIDE_LANES])
+{
+    const wc_wide3 origin = {wc_wide_load(&projectiles->px[i]), wc_wide_load(&projectiles->py[i]), wc_wide_load(&projectiles->pz[i])};
+    const wc_wide3 end = {wc_wide_load(&projectiles->x[i]), wc_wide_load(&projectiles->y[i]), wc_wide_load(&projectiles->z[i])};
+    const wc_wide3 direction = {wc_wide_sub(end.x, origin.x), wc_wide_sub(end.y, origin.y), wc_wide_sub(end.z, origin.z)};
+    const wc_wide radius = wc_wide_load(&projectiles->radius[i]);
+
+    float min_x[WC_WIDE_LANES], max_x[WC_WIDE_LANES], min_y[WC_WIDE_LANES], max_y[WC_WIDE_LANES], radii[WC_WIDE_LANES];
+    float length_sq[WC_WIDE_LANES];
+    wc_wide_store(min_x, wc_wide_min(origin.x, end.x));
+    wc_wide_store(max_x, wc_wide_max(origin.x, end.x));
+    wc_wide_store(min_y, wc_wide_min(origin.y, end.y));
+    wc_wide_store(max_y, wc_wide_max(origin.y, end.y));
+    wc_wide_store(radii, radius);
+    wc_wide_store(length_sq, wc_wide3_dot(direction, direction));
+
+    float lo_x = min_x[0], hi_x = max_x[0], lo_y = min_y[0], hi_y = max_y[0], reach = radii[0];
+    for (uint32_t lane = 1; lane < WC_WIDE_LANES; lane++)
+    {
+        lo_x = SDL_min(lo_x, min_x[lane]);
+        hi_x = SDL_max(hi_x, max_x[lane]);
+        lo_y = SDL_min(lo_y, min_y[lane]);
+        hi_y = SDL_max(hi_y, max_y[lane]);
+        reach = SDL_max(reach, radii[lane]);
+    }
+    reach += targets->max_radius;
+
+    const float ix = targets->inv_cell_size;
+    const uint32_t cx0 = projectile_cell_coord(lo_x - reach - targets->origin_x, ix, targets->cells_x);
+    const uint32_t cx1 = projectile_cell_coord(hi_x + reach - targets->origin_x, ix, targets->cells_x);
+    const uint32_t cy0 = projectile_cell_coord(lo_y - reach - targets->origin_y, ix, targets->cells_y);
+    const uint32_t cy1 = projectile_cell_coord(hi_y + reach - targets->origin_y, ix, targets->cells_y);
+    if ((cx1 - cx0 + 1) * (cy1 - cy0 + 1) > PROJECTILE_BATCH_MAX_CELLS)
+        return false;
+
+    float inv_length_sq[WC_WIDE_LANES];
+    ProjectileContact best[WC_WIDE_LANES];
+    for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+    {
+        inv_length_sq[lane] = length_sq[lane] > 1e-12f ? 1.0f / length_sq[lane] : 0.0f;
+        best[lane] = (ProjectileContact) {2.0f, WC_PROJECTILE_NONE};
+    }
+    const wc_wide wide_inv_length_sq = wc_wide_load(inv_length_sq);
+    const wc_wide zero = wc_wide_zero();
+    const wc_wide one = wc_wide_set1(1.0f);
+
+    for (uint32_t cy = cy0; cy <= cy1; cy++)
+    {
+        const uint32_t row = cy * targets->cells_x;
+        const uint32_t run_end = targets->cell_start[row + cx1 + 1];
+        for (uint32_t j = targets->cell_start[row + cx0]; j < run_end; j++)
+        {
+            const wc_wide3 offset = {wc_wide_sub(wc_wide_set1(targets->sorted_x[j]), origin.x),
+                                     wc_wide_sub(wc_wide_set1(targets->sorted_y[j]), origin.y),
+                                     wc_wide_sub(wc_wide_set1(targets->sorted_z[j]), origin.z)};
+            const wc_wide t = wc_wide_min(wc_wide_max(wc_wide_mul(wc_wide3_dot(offset, direction), wide_inv_length_sq), zero), one);
+            const wc_wide3 miss = {wc_wide_sub(offset.x, wc_wide_mul(direction.x, t)), wc_wide_sub(offset.y, wc_wide_mul(direction.y, t)),
+                                   wc_wide_sub(offset.z, wc_wide_mul(direction.z, t))};
+            const wc_wide reach_sum = wc_wide_add(wc_wide_set1(targets->sorted_radius[j]), radius);
+            const uint32_t mask = wc_wide_mask_bits(wc_wide_ge(wc_wide_mul(reach_sum, reach_sum), wc_wide3_dot(miss, miss)));
+            if (!mask)
+                continue;
+
+            float ts[WC_WIDE_LANES];
+            wc_wide_store(ts, t);
+            for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+            {
+                if ((mask >> lane) & 1)
+                    projectile_consider(targets, projectiles->owner[i + lane], j, ts[lane], &best[lane]);
+            }
+        }
+    }
+
+    for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+        units[lane] = best[lane].slot == WC_PROJECTILE_NONE ? WC_PROJECTILE_NONE : targets->sorted[best[lane].slot];
+    return true;
+}
+
+typedef struct
+{
+    WC_Projectiles* projectiles;
+    const WC_ProjectileTargets* targets;
+    WC_ProjectileHits* hits;
+    float delta_time;
+} ProjectileJobData;
+
+static void projectile_reserve(void** list, uint32_t* capacity, const uint32_t required, const size_t element_size)
+{
+    if (required <= *capacity)
+        return;
+    uint32_t grown = *capacity ? *capacity : WC_PROJECTILES_PER_JOB;
+    while (grown < required)
+        grown *= 2;
+    *list = wc_realloc(*list, grown * element_size);
+    *capacity = grown;
+}
+
+static void projectile_chunk(const u32 start, const u32 end, void* data)
+{
+    const ProjectileJobData* job = (const ProjectileJobData*) data;
+    WC_Projectiles* projectiles = job->projectiles;
+    WC_ProjectileHits* hits = job->hits;
+    const u32 worker = job_get_worker_index();
+    assert(worker < WC_PROJECTILE_MAX_WORKERS);
+
+    // Only the last chunk can end mid-batch; its spare lanes are padding
+    projectile_integrate(projectiles, job->targets, start, (uint32_t) war_align_up(end, WC_WIDE_LANES), job->delta_time);
+
+    // Only this worker touches its lists, so growing them here is race-free
+    projectile_reserve((void**) &hits->lists[worker], &hits->capacities[worker], hits->counts[worker] + (end - start),
+                       sizeof(WC_ProjectileHit));
+    projectile_reserve((void**) &hits->removed[worker], &hits->removed_capacities[worker], hits->removed_counts[worker] + (end - start),
+                       sizeof(uint32_t));
+
+    WC_ProjectileHit* list = hits->lists[worker];
+    uint32_t* removed = hits->removed[worker];
+    for (uint32_t i = start; i < end; i += WC_WIDE_LANES)
+    {
+        const uint32_t lanes = SDL_min(end - i, (uint32_t) WC_WIDE_LANES);
+        uint32_t units[WC_WIDE_LANES];
+        if (lanes < WC_WIDE_LANES || !projectile_hit_test_batch(projectiles, job->targets, i, units))
+        {
+            for (uint32_t lane = 0; lane < lanes; lane++)
+                units[lane] = projectile_hit_test(projectiles, job->targets, i + lane);
+        }
+
+        for (uint32_t lane = 0; lane < lanes; lane++)
+        {
+            const uint32_t projectile = i + lane;
+            if (units[lane] != WC_PROJECTILE_NONE)
+            {
+                list[hits->counts[worker]++] = (WC_ProjectileHit) {projectile, units[lane], projectiles->damage[projectile]};
+                removed[hits->removed_counts[worker]++] = projectile;
+            }
+            else if (projectiles->lifetime[projectile] <= 0.0f)
+            {
+                removed[hits->removed_counts[worker]++] = projectile;
+            }
+        }
+    }
+}
+
+static int compare_hits(const void* a, const void* b)
+{
+    const uint32_t pa = ((const WC_ProjectileHit*) a)->projectile;
+    const uint32_t pb = ((const WC_ProjectileHit*) b)->projectile;
+    return (pa > pb) - (pa < pb);
+}
+
+static int compare_indices_descending(const void* a, const void* b)
+{
+    const uint32_t ia = *(const uint32_t*) a;
+    const uint32_t ib = *(const uint32_t*) b;
+    return (ia < ib) - (ia > ib);
+}
+
+void wc_projectiles_update(WC_Projectiles* projectiles, const WC_ProjectileTargets* targets, const float delta_time,
+                           WC_ProjectileHits* hits)
+{
+    SDL_memset(hits->counts, 0, sizeof(hits->counts));
+    SDL_memset(hits->removed_counts, 0, sizeof(hits->removed_counts));
+    hits->count = 0;
+    if (projectiles->count == 0)
+        return;
+
+    ProjectileJobData data = {projectiles, targets, hits, delta_time};
+    job_wait(job_parallel_for(projectiles->count, WC_PROJECTILES_PER_JOB, projectile_chunk, &data));
+
+    uint32_t hit_total = 0;
+    uint32_t removed_total = 0;
+    for (uint32_t w = 0; w < WC_PROJECTILE_MAX_WORKERS; w++)
+    {
+        hit_total += hits->counts[w];
+        removed_total += hits->removed_counts[w];
+    }
+    if (removed_total == 0)
+        return;
+
+    projectile_reserve((void**) &hits->merged, &hits->capacity, hit_total, sizeof(WC_ProjectileHit));
+    projectile_reserve((void**) &hits->removals, &hits->removal_capacity, removed_total, sizeof(uint32_t));
+    uint32_t* removals = hits->removals;
+    removed_total = 0;
+    for (uint32_t w = 0; w < WC_PROJECTILE_MAX_WORKERS; w++)
+    {
+        SDL_memcpy(hits->merged + hits->count, hits->lists[w], hits->counts[w] * sizeof(WC_ProjectileHit));
+        hits->count += hits->counts[w];
+        SDL_memcpy(removals + removed_total, hits->removed[w], hits->removed_counts[w] * sizeof(uint32_t));
+        removed_total += hits->removed_counts[w];
+    }
+    SDL_qsort(hits->merged, hits->count, sizeof(WC_ProjectileHit), compare_hits);
+
+    // Back to front, so every projectile swapped into a hole has already been kept
+    SDL_qsort(removals, removed_total, sizeof(uint32_t), compare_indices_descending);
+    for (uint32_t i = 0; i < removed_total; i++)
+        wc_projectiles_remove(projectiles, removals[i]);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark
+
+static double projectile_elapsed_ms(const uint64_t begin)
+{
+    return (double) (SDL_GetPerformanceCounter() - begin) * 1000.0 / (double) SDL_GetPerformanceFrequency();
+}
+
+#define PROJECTILE_BENCHMARK_TICKS 16
+#define PROJECTILE_BENCHMARK_MAP 2000.0f
+#define PROJECTILE_SORT_INTERVAL 8
+
+void wc_projectile_benchmark(const uint32_t projectile_count, const uint32_t unit_count)
+{
+    WC_Projectiles projectiles;
+    WC_ProjectileTargets targets;
+    WC_ProjectileHits hits = {0};
+    if (wc_projectiles_init(&projectiles, projectile_count) != 0)
+        return;
+    const float half_map = PROJECTILE_BENCHMARK_MAP * 0.5f;
+    if (wc_projectile_targets_init(&targets, unit_count, -half_map, -half_map, PROJECTILE_BENCHMARK_MAP, PROJECTILE_BENCHMARK_MAP,
+                                   8.0f) != 0)
+    {
+        wc_projectiles_free(&projectiles);
+        return;
+    }
+
+    WC_Random random = wc_random_stream(0x50524f4a, 0, 0, 0);
+    wc_random_fill_range(&random, -half_map, half_map, targets.x, unit_count);
+    wc_random_fill_range(&random, -half_map, half_map, targets.y, unit_count);
+    wc_random_fill_below(&random, 4, targets.player, unit_count);
+    for (uint32_t i = 0; i < unit_count; i++)
+    {
+        targets.z[i] = 0.0f;
+        targets.radius[i] = 0.5f;
+    }
+    targets.count = unit_count;
+
+    // Volleys around random units, half of them homing in on that unit. Lifetimes outlast the run,
+    // so the count only drops through hits.
+    for (uint32_t i = 0; i < projectile_count; i++)
+    {
+        const uint32_t unit = wc_random_below(&random, unit_count);
+        const WC_ProjectileDesc desc = {
+            .x = targets.x[unit] + wc_random_range(&random, -40.0f, 40.0f),
+            .y = targets.y[unit] + wc_random_range(&random, -40.0f, 40.0f),
+            .z = wc_random_range(&random, 0.0f, 20.0f),
+            .vx = wc_random_range(&random, -30.0f, 30.0f),
+            .vy = wc_random_range(&random, -30.0f, 30.0f),
+            .vz = wc_random_range(&random, 0.0f, 10.0f),
+            .damage = 10.0f,
+            .radius = 0.1f,
+            .lifetime = 60.0f,
+            .target = i & 1 ? unit : WC_PROJECTILE_NONE,
+            .owner = 4,
+        };
+        wc_projectiles_spawn(&projectiles, &desc);
+    }
+
+    // The first sort moves everything; later ones only fix up what moved since
+    wc_projectile_targets_build(&targets);
+    uint64_t begin = SDL_GetPerformanceCounter();
+    wc_projectiles_sort(&projectiles, &targets);
+    const double first_sort_ms = projectile_elapsed_ms(begin);
+    // Warm up the per-worker lists once so the timed run measures steady-state ticks
+    wc_projectiles_update(&projectiles, &targets, 1.0f / 60.0f, &hits);
+
+    uint64_t hits_total = hits.count;
+    uint64_t updates = 0;
+    double sort_ms = 0.0;
+    const uint64_t run_begin = SDL_GetPerformanceCounter();
+    for (uint32_t tick = 1; tick <= PROJECTILE_BENCHMARK_TICKS; tick++)
+    {
+        updates += projectiles.count;
+        wc_projectile_targets_build(&targets);
+        if (tick % PROJECTILE_SORT_INTERVAL == 0)
+        {
+            begin = SDL_GetPerformanceCounter();
+            wc_projectiles_sort(&projectiles, &targets);
+            sort_ms += projectile_elapsed_ms(begin);
+        }
+        wc_projectiles_update(&projectiles, &targets, 1.0f / 60.0f, &hits);
+        hits_total += hits.count;
+    }
+    const double tick_ms = projectile_elapsed_ms(run_begin) / PROJECTILE_BENCHMARK_TICKS;
+    const uint32_t sorts = PROJECTILE_BENCHMARK_TICKS / PROJECTILE_SORT_INTERVAL;
+
+    SDL_Log("Projectile benchmark: %u projectiles, %u units, %u workers\n", projectile_count, unit_count, job_get_worker_count());
+    SDL_Log("  tick:  %.3f ms (%.1f M updates/s)\n", tick_ms, (double) updates / PROJECTILE_BENCHMARK_TICKS / (tick_ms * 1000.0));
+    SDL_Log("  sort:  %.3f ms first, %.3f ms every %u ticks after\n", first_sort_ms, sorts ? sort_ms / sorts : 0.0,
+            PROJECTILE_SORT_INTERVAL);
+    SDL_Log("  hits:  %llu, %u projectiles left\n", (unsigned long long) hits_total, projectiles.count);
+
+    wc_projectile_hits_free(&hits);
+    wc_projectile_targets_free(&targets);
+    wc_projectiles_free(&projectiles);
+}
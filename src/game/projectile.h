@@ -0,0 +1,139 @@
+#pragma once
+
+#include "../system/job.h"
+
+#include <stdint.h>
+
+// Job workers plus the main thread, which helps out while waiting on jobs
+#define WC_PROJECTILE_MAX_WORKERS (WC_JOB_MAX_WORKERS + 1)
+#define WC_PROJECTILES_PER_JOB 8192
+#define WC_PROJECTILE_NONE UINT32_MAX
+
+#define WC_PROJECTILE_GRAVITY 9.81f
+// Fraction of the way homing projectiles turn towards their target per second
+#define WC_PROJECTILE_TURN_RATE 6.0f
+
+// Projectiles in SoA layout so a full wc_wide of them is integrated per iteration. Removal swaps the
+// last projectile into the hole, so indices are only stable within a tick.
+typedef struct WC_Projectiles
+{
+    float* x;
+    float* y;
+    float* z;
+    float* vx;
+    float* vy;
+    float* vz;
+    // Position before the last step, the start of the swept segment tested for hits
+    float* px;
+    float* py;
+    float* pz;
+    float* damage;
+    float* radius;
+    float* lifetime;
+    uint32_t* target; // Unit to home in on, WC_PROJECTILE_NONE for ballistic
+    uint32_t* owner;  // Player id, projectiles pass through their own side
+    uint32_t count;
+    uint32_t capacity;
+
+    // Second set of streams and scratch for wc_projectiles_sort
+    void* spare;
+    uint32_t* order;
+    uint32_t* cell_offsets;
+    uint32_t cell_capacity;
+} WC_Projectiles;
+
+typedef struct WC_ProjectileDesc
+{
+    float x, y, z;
+    float vx, vy, vz;
+    float damage;
+    float radius;
+    float lifetime;
+    uint32_t target;
+    uint32_t owner;
+} WC_ProjectileDesc;
+
+// What projectiles see of the units, indexed by unit, plus a uniform grid over them. The caller
+// fills the unit arrays and count, then rebuilds the grid once per tick before updating.
+typedef struct WC_ProjectileTargets
+{
+    float* x;
+    float* y;
+    float* z;
+    float* radius; // Zero or less for dead units, which are neither hit nor homed in on
+    uint32_t* player;
+    uint32_t count;
+    uint32_t capacity;
+
+    // Grid cells in row-major order, so a row of neighbouring cells is one contiguous unit range
+    float origin_x;
+    float origin_y;
+    float inv_cell_size;
+    uint32_t cells_x;
+    uint32_t cells_y;
+    uint32_t* cell_start; // cells_x * cells_y + 1 offsets into the sorted arrays
+    float max_radius;
+
+    // Units sorted by cell, copied so the hit test streams positions instead of gathering them
+    uint32_t* sorted;
+    float* sorted_x;
+    float* sorted_y;
+    float* sorted_z;
+    float* sorted_radius;
+    uint32_t* sorted_player;
+} WC_ProjectileTargets;
+
+typedef struct WC_ProjectileHit
+{
+    uint32_t projectile; // Index before removal, the merge order
+    uint32_t unit;
+    float damage;
+} WC_ProjectileHit;
+
+// Hits and removals are collected per worker so chunks never contend, then merged in projectile
+// order: applying the hits gives the same result however the chunks were scheduled.
+typedef struct WC_ProjectileHits
+{
+    WC_ProjectileHit* lists[WC_PROJECTILE_MAX_WORKERS];
+    uint32_t counts[WC_PROJECTILE_MAX_WORKERS];
+    uint32_t capacities[WC_PROJECTILE_MAX_WORKERS];
+    uint32_t* removed[WC_PROJECTILE_MAX_WORKERS];
+    uint32_t removed_counts[WC_PROJECTILE_MAX_WORKERS];
+    uint32_t removed_capacities[WC_PROJECTILE_MAX_WORKERS];
+
+    // Merged hits of the last update, sorted by projectile
+    WC_ProjectileHit* merged;
+    uint32_t count;
+    uint32_t capacity;
+    // Scratch for sorting the removals back to front
+    uint32_t* removals;
+    uint32_t removal_capacity;
+} WC_ProjectileHits;
+
+int wc_projectiles_init(WC_Projectiles* projectiles, uint32_t capacity);
+void wc_projectiles_free(WC_Projectiles* projectiles);
+// Returns the new index, or WC_PROJECTILE_NONE when the pool is full
+uint32_t wc_projectiles_spawn(WC_Projectiles* projectiles, const WC_ProjectileDesc* desc);
+void wc_projectiles_remove(WC_Projectiles* projectiles, uint32_t index);
+
+// The grid covers [origin, origin + size) in x and y; units outside are clamped to the border cells
+int wc_projectile_targets_init(WC_ProjectileTargets* targets, uint32_t capacity, float origin_x, float origin_y, float width,
+                               float height, float cell_size);
+void wc_projectile_targets_free(WC_ProjectileTargets* targets);
+// Counting sort of the units into their cells, stable so equal distances resolve the same way
+void wc_projectile_targets_build(WC_ProjectileTargets* targets);
+
+// Reorders the projectiles by grid cell, so neighbouring projectiles test the same unit runs and the
+// hit test streams through memory. Spawns and swap-removes scatter the order again over time, so
+// call it every few ticks rather than every tick. Stable, so the order stays deterministic.
+void wc_projectiles_sort(WC_Projectiles* projectiles, const WC_ProjectileTargets* targets);
+
+void wc_projectile_hits_free(WC_ProjectileHits* hits);
+
+// Integrates, hit tests and removes spent projectiles on the job system, blocking until done.
+// hits->merged then holds this tick's hits for the caller to apply.
+void wc_projectiles_update(WC_Projectiles* projectiles, const WC_ProjectileTargets* targets, float delta_time,
+                           WC_ProjectileHits* hits);
+
+// Times updates of projectile_count projectiles, half of them homing, among unit_count units
+void wc_projectile_benchmark(uint32_t projectile_count, uint32_t unit_count);
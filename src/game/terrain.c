@@ -0,0 +1,244 @@
+#include "terrain.h"
+
+#include "../system/file.h"
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+
+#define TERRAIN_BLOCKS_PER_JOB 16
+// Keeps tile counts well inside 32 bits
+#define TERRAIN_MAX_TILES 16384
+
+static int terrain_alloc(WC_Terrain* terrain, const uint32_t tiles_x, const uint32_t tiles_y, const float origin_x, const float origin_y,
+                         const float tile_size)
+{
+    SDL_memset(terrain, 0, sizeof(*terrain));
+    if (tiles_x == 0 || tiles_y == 0 || tiles_x > TERRAIN_MAX_TILES || tiles_y > TERRAIN_MAX_TILES || !(tile_size > 0.0f))
+        return -1;
+
+    terrain->origin_x = origin_x;
+    terrain->origin_y = origin_y;
+    terrain->tile_size = tile_size;
+    terrain->inv_tile_size = 1.0f / tile_size;
+    terrain->tiles_x = tiles_x;
+    terrain->tiles_y = tiles_y;
+    terrain->blocks_x = (tiles_x + WC_TERRAIN_BLOCK_SIZE - 1) >> WC_TERRAIN_BLOCK_SHIFT;
+    terrain->blocks_y = (tiles_y + WC_TERRAIN_BLOCK_SIZE - 1) >> WC_TERRAIN_BLOCK_SHIFT;
+
+    const uint32_t block_count = terrain->blocks_x * terrain->blocks_y;
+    const size_t tile_count = (size_t) block_count * WC_TERRAIN_BLOCK_TILES;
+    terrain->height = wc_aligned_alloc(tile_count * sizeof(float), 64);
+    terrain->cost = wc_calloc(tile_count, sizeof(uint8_t));
+    terrain->occupancy = wc_calloc(tile_count, sizeof(uint8_t));
+    terrain->nav = wc_calloc(tile_count, sizeof(uint8_t));
+    terrain->block_dirty = wc_calloc(block_count, sizeof(uint8_t));
+    terrain->dirty_blocks = wc_malloc(block_count * sizeof(uint32_t));
+    if (!terrain->height || !terrain->cost || !terrain->occupancy || !terrain->nav || !terrain->block_dirty || !terrain->dirty_blocks)
+    {
+        wc_terrain_free(terrain);
+        return -1;
+    }
+    SDL_memset(terrain->height, 0, tile_count * sizeof(float));
+    return 0;
+}
+
+int wc_terrain_init(WC_Terrain* terrain, const uint32_t tiles_x, const uint32_t tiles_y, const float origin_x, const float origin_y,
+                    const float tile_size)
+{
+    if (terrain_alloc(terrain, tiles_x, tiles_y, origin_x, origin_y, tile_size) != 0)
+        return -1;
+
+    for (uint32_t y = 0; y < tiles_y; y++)
+    {
+        for (uint32_t x = 0; x < tiles_x; x++)
+        {
+            const uint32_t i = wc_terrain_index(terrain, x, y);
+            terrain->cost[i] = 1;
+            terrain->nav[i] = 1;
+        }
+    }
+    return 0;
+}
+
+typedef struct
+{
+    WC_Terrain* terrain;
+    const WC_TerrainFileTile* tiles;
+} TerrainLoadData;
+
+// A row of blocks per iteration: reads whole file rows, writes whole blocks
+static void terrain_swizzle_rows(const u32 start, const u32 end, void* data)
+{
+    const TerrainLoadData* load = (const TerrainLoadData*) data;
+    WC_Terrain* terrain = load->terrain;
+
+    for (uint32_t block_y = start; block_y < end; block_y++)
+    {
+        const uint32_t y_end = SDL_min((block_y + 1) << WC_TERRAIN_BLOCK_SHIFT, terrain->tiles_y);
+        for (uint32_t y = block_y << WC_TERRAIN_BLOCK_SHIFT; y < y_end; y++)
+        {
+            const WC_TerrainFileTile* row = load->tiles + (size_t) y * terrain->tiles_x;
+            for (uint32_t x = 0; x < terrain->tiles_x; x++)
+            {
+                const uint32_t i = wc_terrain_index(terrain, x, y);
+                terrain->height[i] = row[x].height;
+                terrain->cost[i] = row[x].cost;
+                terrain->nav[i] = row[x].cost;
+            }
+        }
+    }
+}
+
+int wc_terrain_load(WC_Terrain* terrain, const char* path)
+{
+    SDL_memset(terrain, 0, sizeof(*terrain));
+
+    WC_FileMapping file;
+    if (wc_file_map(path, &file) != 0)
+        return -1;
+
+    const WC_TerrainFileHeader* header = file.data;
+    if (file.size < sizeof(*header) || header->magic != WC_TERRAIN_FILE_MAGIC || header->version != WC_TERRAIN_FILE_VERSION ||
+        sizeof(*header) + (uint64_t) header->tiles_x * header->tiles_y * sizeof(WC_TerrainFileTile) > file.size ||
+        terrain_alloc(terrain, header->tiles_x, header->tiles_y, header->origin_x, header->origin_y, header->tile_size) != 0)
+    {
+        SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Invalid terrain map %s\n", path);
+        wc_file_unmap(&file);
+        return -1;
+    }
+
+    TerrainLoadData data = {terrain, (const WC_TerrainFileTile*) ((const uint8_t*) file.data + sizeof(*header))};
+    job_wait(job_parallel_for(terrain->blocks_y, 1, terrain_swizzle_rows, &data));
+    wc_file_unmap(&file);
+    return 0;
+}
+
+void wc_terrain_free(WC_Terrain* terrain)
+{
+    wc_aligned_free(terrain->height, 64);
+    wc_free(terrain->cost);
+    wc_free(terrain->occupancy);
+    wc_free(terrain->nav);
+    wc_free(terrain->block_dirty);
+    wc_free(terrain->dirty_blocks);
+    SDL_memset(terrain, 0, sizeof(*terrain));
+}
+
+static bool terrain_clip(const WC_Terrain* terrain, WC_TerrainRect* rect)
+{
+    if (rect->x >= terrain->tiles_x || rect->y >= terrain->tiles_y || rect->width == 0 || rect->height == 0)
+        return false;
+    rect->width = SDL_min(rect->width, terrain->tiles_x - rect->x);
+    rect->height = SDL_min(rect->height, terrain->tiles_y - rect->y);
+    return true;
+}
+
+static void terrain_mark(WC_Terrain* terrain, const WC_TerrainRect rect)
+{
+    const uint32_t last_x = (rect.x + rect.width - 1) >> WC_TERRAIN_BLOCK_SHIFT;
+    const uint32_t last_y = (rect.y + rect.height - 1) >> WC_TERRAIN_BLOCK_SHIFT;
+    for (uint32_t block_y = rect.y >> WC_TERRAIN_BLOCK_SHIFT; block_y <= last_y; block_y++)
+    {
+        for (uint32_t block_x = rect.x >> WC_TERRAIN_BLOCK_SHIFT; block_x <= last_x; block_x++)
+        {
+            const uint32_t block = block_y * terrain->blocks_x + block_x;
+            if (terrain->block_dirty[block])
+                continue;
+            terrain->block_dirty[block] = 1;
+            terrain->dirty_blocks[terrain->dirty_count++] = block;
+        }
+    }
+
+    if (terrain->pending_count < WC_TERRAIN_PENDING_CAPACITY)
+    {
+        terrain->pending[terrain->pending_count++] = rect;
+        return;
+    }
+    // Out of room: grow the last change to cover this one too
+    WC_TerrainRect* last = &terrain->pending[WC_TERRAIN_PENDING_CAPACITY - 1];
+    const uint32_t x0 = SDL_min(last->x, rect.x);
+    const uint32_t y0 = SDL_min(last->y, rect.y);
+    const uint32_t x1 = SDL_max(last->x + last->width, rect.x + rect.width);
+    const uint32_t y1 = SDL_max(last->y + last->height, rect.y + rect.height);
+    *last = (WC_TerrainRect) {x0, y0, x1 - x0, y1 - y0};
+}
+
+void wc_terrain_occupy(WC_Terrain* terrain, WC_TerrainRect rect)
+{
+    if (!terrain_clip(terrain, &rect))
+        return;
+    for (uint32_t y = rect.y; y < rect.y + rect.height; y++)
+    {
+        for (uint32_t x = rect.x; x < rect.x + rect.width; x++)
+        {
+            uint8_t* occupancy = &terrain->occupancy[wc_terrain_index(terrain, x, y)];
+            if (*occupancy < UINT8_MAX)
+                (*occupancy)++;
+        }
+    }
+    terrain_mark(terrain, rect);
+}
+
+void wc_terrain_vacate(WC_Terrain* terrain, WC_TerrainRect rect)
+{
+    if (!terrain_clip(terrain, &rect))
+        return;
+    for (uint32_t y = rect.y; y < rect.y + rect.height; y++)
+    {
+        for (uint32_t x = rect.x; x < rect.x + rect.width; x++)
+        {
+            uint8_t* occupancy = &terrain->occupancy[wc_terrain_index(terrain, x, y)];
+            if (*occupancy > 0)
+                (*occupancy)--;
+        }
+    }
+    terrain_mark(terrain, rect);
+}
+
+// Blocks are contiguous, so each one is a straight 64-tile pass
+static void terrain_rebuild_blocks(const u32 start, const u32 end, void* data)
+{
+    WC_Terrain* terrain = (WC_Terrain*) data;
+    for (uint32_t i = start; i < end; i++)
+    {
+        const size_t first = (size_t) terrain->dirty_blocks[i] * WC_TERRAIN_BLOCK_TILES;
+        const uint8_t* cost = terrain->cost + first;
+        const uint8_t* occupancy = terrain->occupancy + first;
+        uint8_t* nav = terrain->nav + first;
+        for (uint32_t t = 0; t < WC_TERRAIN_BLOCK_TILES; t++)
+            nav[t] = occupancy[t] ? 0 : cost[t];
+    }
+}
+
+void wc_terrain_update(WC_Terrain* terrain)
+{
+    if (terrain->dirty_count == 0)
+        return;
+
+    job_wait(job_parallel_for(terrain->dirty_count, TERRAIN_BLOCKS_PER_JOB, terrain_rebuild_blocks, terrain));
+    for (uint32_t i = 0; i < terrain->dirty_count; i++)
+        terrain->block_dirty[terrain->dirty_blocks[i]] = 0;
+    terrain->dirty_count = 0;
+
+    // Published only now, so readers never see a change before the grid has it
+    for (uint32_t i = 0; i < terrain->pending_count; i++)
+        terrain->feed[terrain->feed_head++ % WC_TERRAIN_FEED_CAPACITY] = terrain->pending[i];
+    terrain->pending_count = 0;
+}
+
+bool wc_terrain_next_change(const WC_Terrain* terrain, uint64_t* cursor, WC_TerrainRect* change)
+{
+    if (*cursor >= terrain->feed_head)
+        return false;
+    if (terrain->feed_head - *cursor > WC_TERRAIN_FEED_CAPACITY)
+    {
+        *change = (WC_TerrainRect) {0, 0, terrain->tiles_x, terrain->tiles_y};
+        *cursor = terrain->feed_head;
+        return true;
+    }
+    *change = terrain->feed[*cursor % WC_TERRAIN_FEED_CAPACITY];
+    (*cursor)++;
+    return true;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <stdint.h>
+
+// Layout of a .wcmap file, mapped whole at load. The header is followed by tiles_x * tiles_y tiles
+// in row-major order, which keeps map tools simple; the loader swizzles them into the tiled order.
+#define WC_TERRAIN_FILE_MAGIC 0x4D544357 // "WCTM"
+#define WC_TERRAIN_FILE_VERSION 1
+
+typedef struct WC_TerrainFileHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    float origin_x;
+    float origin_y;
+    float tile_size;
+    uint32_t reserved;
+} WC_TerrainFileHeader;
+
+typedef struct WC_TerrainFileTile
+{
+    float height;
+    uint8_t cost; // Movement cost multiplier, zero for impassable ground
+    uint8_t reserved[3];
+} WC_TerrainFileTile;
+
+// Tiles are stored in 8x8 blocks, blocks in row-major order and tiles in Morton order within a
+// block, so a tile's neighbours are almost always in the same or an adjacent cache line
+#define WC_TERRAIN_BLOCK_SHIFT 3
+#define WC_TERRAIN_BLOCK_SIZE (1u << WC_TERRAIN_BLOCK_SHIFT)
+#define WC_TERRAIN_BLOCK_TILES (WC_TERRAIN_BLOCK_SIZE * WC_TERRAIN_BLOCK_SIZE)
+
+// Changes kept for readers of the feed; one that falls further behind gets the whole map instead
+#define WC_TERRAIN_FEED_CAPACITY 256
+// Footprint changes collected between updates; more are merged into the last one
+#define WC_TERRAIN_PENDING_CAPACITY 64
+
+// A rectangle of tiles
+typedef struct WC_TerrainRect
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+} WC_TerrainRect;
+
+// The tile grid and the navigation grid derived from it. Ground comes from the map and never
+// changes; building footprints mark tiles occupied, and wc_terrain_update rebuilds the navigation
+// cost of the dirty blocks only, then reports the changed rectangles on the change feed.
+typedef struct WC_Terrain
+{
+    float origin_x;
+    float origin_y;
+    float tile_size;
+    float inv_tile_size;
+    uint32_t tiles_x;
+    uint32_t tiles_y;
+    uint32_t blocks_x;
+    uint32_t blocks_y;
+
+    // Per tile, in tiled order. Tiles in the padding of the last blocks are impassable.
+    float* height;
+    uint8_t* cost;      // From the map
+    uint8_t* occupancy; // Footprints covering the tile
+    uint8_t* nav;       // Cost when unoccupied, zero when blocked: what pathing and movement read
+
+    uint8_t* block_dirty;
+    uint32_t* dirty_blocks;
+    uint32_t dirty_count;
+    WC_TerrainRect pending[WC_TERRAIN_PENDING_CAPACITY];
+    uint32_t pending_count;
+
+    WC_TerrainRect feed[WC_TERRAIN_FEED_CAPACITY];
+    uint64_t feed_head; // Sequence number of the next change
+} WC_Terrain;
+
+// Flat open ground of unit cost
+int wc_terrain_init(WC_Terrain* terrain, uint32_t tiles_x, uint32_t tiles_y, float origin_x, float origin_y, float tile_size);
+// Maps a .wcmap file and swizzles it in on the job system. Returns non-zero if the file is missing
+// or invalid, leaving the terrain empty.
+int wc_terrain_load(WC_Terrain* terrain, const char* path);
+void wc_terrain_free(WC_Terrain* terrain);
+
+// Building footprints, clipped to the map. They take effect at the next update.
+void wc_terrain_occupy(WC_Terrain* terrain, WC_TerrainRect rect);
+void wc_terrain_vacate(WC_Terrain* terrain, WC_TerrainRect rect);
+
+// Rebuilds the navigation grid of the dirty blocks on the job system and publishes the pending
+// changes to the feed. Nothing to do is the common case and costs a branch.
+void wc_terrain_update(WC_Terrain* terrain);
+
+// Readers keep their own cursor, starting at feed_head once they have read the whole grid. Returns
+// false when the reader is up to date; a reader that fell a full feed behind gets the whole map as
+// one change.
+bool wc_terrain_next_change(const WC_Terrain* terrain, uint64_t* cursor, WC_TerrainRect* change);
+
+// World-space size of the map, which starts at the origin corner
+static inline float wc_terrain_width(const WC_Terrain* terrain)
+{
+    return (float) terrain->tiles_x * terrain->tile_size;
+}
+
+static inline float wc_terrain_depth(const WC_Terrain* terrain)
+{
+    return (float) terrain->tiles_y * terrain->tile_size;
+}
+
+// Interleaves the low three bits of v with zeros
+static inline uint32_t wc_terrain_spread(const uint32_t v)
+{
+    const uint32_t spread = (v | (v << 2)) & 0x13;
+    return (spread | (spread << 1)) & 0x15;
+}
+
+static inline uint32_t wc_terrain_index(const WC_Terrain* terrain, const uint32_t x, const uint32_t y)
+{
+    const uint32_t block = (y >> WC_TERRAIN_BLOCK_SHIFT) * terrain->blocks_x + (x >> WC_TERRAIN_BLOCK_SHIFT);
+    const uint32_t mask = WC_TERRAIN_BLOCK_SIZE - 1;
+    return block * WC_TERRAIN_BLOCK_TILES + (wc_terrain_spread(x & mask) | wc_terrain_spread(y & mask) << 1);
+}
+
+// Tile containing (x, y); false outside the map
+static inline bool wc_terrain_tile(const WC_Terrain* terrain, const float x, const float y, uint32_t* tx, uint32_t* ty)
+{
+    const float fx = (x - terrain->origin_x) * terrain->inv_tile_size;
+    const float fy = (y - terrain->origin_y) * terrain->inv_tile_size;
+    if (!(fx >= 0.0f && fy >= 0.0f && fx < (float) terrain->tiles_x && fy < (float) terrain->tiles_y))
+        return false;
+    *tx = (uint32_t) fx;
+    *ty = (uint32_t) fy;
+    return true;
+}
+
+// Off the map counts as blocked
+static inline bool wc_terrain_passable(const WC_Terrain* terrain, const float x, const float y)
+{
+    uint32_t tx, ty;
+    return wc_terrain_tile(terrain, x, y, &tx, &ty) && terrain->nav[wc_terrain_index(terrain, tx, ty)] != 0;
+}
+
+static inline float wc_terrain_height(const WC_Terrain* terrain, const float x, const float y)
+{
+    uint32_t tx, ty;
+    return wc_terrain_tile(terrain, x, y, &tx, &ty) ? terrain->height[wc_terrain_index(terrain, tx, ty)] : 0.0f;
+}
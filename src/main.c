@@ -1,11 +1,112 @@
 #include "system/app.h"
 #include "game/game.h"
+#include "game/projectile.h"
+#include "render/cull.h"
+#include "render/render.h"
+#include "system/job.h"
+#include "system/math.h"
 #include "system/profiler.h"
+#include "system/startup.h"
 
+#include <SDL3/SDL.h>
 #include <SDL3/SDL_main.h>
 
+// --offscreen [width height frames output]: renders without a window and writes the last frame,
+// for headless submission benchmarks and golden-image tests on software drivers
+static int run_offscreen(const int argc, char** argv)
+{
+	const uint32_t width = argc > 0 ? (uint32_t)SDL_atoi(argv[0]) : 1280;
+	const uint32_t height = argc > 1 ? (uint32_t)SDL_atoi(argv[1]) : 720;
+	const uint32_t frames = argc > 2 ? (uint32_t)SDL_atoi(argv[2]) : 1;
+	const char* output = argc > 3 ? argv[3] : "frame.png";
+	if (width == 0 || height == 0 || frames == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: --offscreen [width height frames output]\n");
+		return -1;
+	}
+
+	profiler_init();
+	job_system_init(0);
+	if (wc_render_init_offscreen(width, height) != 0)
+	{
+		job_system_shutdown();
+		return -1;
+	}
+
+	const uint64_t begin = SDL_GetPerformanceCounter();
+	for (uint32_t i = 0; i < frames; i++)
+	{
+		profiler_frame_start();
+		wc_render_draw();
+		profiler_frame_end();
+	}
+	const double ms = (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+	SDL_Log("Offscreen: %u frames at %ux%u, %.3f ms/frame\n", frames, width, height, ms / frames);
+
+	const int result = wc_render_capture(output);
+	wc_render_quit();
+	job_system_shutdown();
+	profiler_shutdown();
+	return result;
+}
+
+// --benchmark [units]: CPU kernels timed against their scalar references, no window or GPU needed
+static int run_benchmarks(const int argc, char** argv)
+{
+	const uint32_t units = argc > 0 ? (uint32_t)SDL_atoi(argv[0]) : 100000;
+	if (units == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Usage: --benchmark [units]\n");
+		return -1;
+	}
+
+	job_system_init(0);
+	const int result = wc_math_validate(10000);
+	wc_transform_benchmark(units);
+	wc_cull_benchmark(units);
+	// Ten projectiles in flight per unit, a million at the default size
+	wc_projectile_benchmark(units * 10, units);
+	job_system_shutdown();
+	return result;
+}
+
+static int startup_app(void* data)
+{
+	wc_app_init("Warcry", *(const WC_AppCallbacks*)data);
+	return wc_app_is_running() ? 0 : -1;
+}
+
+static int startup_game(void* data)
+{
+	(void)data;
+	return wc_game_init();
+}
+
+static int startup_render_device(void* data)
+{
+	(void)data;
+	return wc_render_init_device();
+}
+
+static int startup_render_swapchain(void* data)
+{
+	(void)data;
+	return wc_render_init_swapchain();
+}
+
+static int startup_render_pipelines(void* data)
+{
+	(void)data;
+	return wc_render_init_pipelines();
+}
+
 int main(int argc, char** argv)
 {
+	if (argc > 1 && SDL_strcmp(argv[1], "--offscreen") == 0)
+		return run_offscreen(argc - 2, argv + 2);
+	if (argc > 1 && SDL_strcmp(argv[1], "--benchmark") == 0)
+		return run_benchmarks(argc - 2, argv + 2);
+
 	const WC_AppCallbacks callbacks = {
 		.init = wc_game_init,
 		.update = wc_game_update,
@@ -14,10 +115,18 @@ int main(int argc, char** argv)
 	};
 
 	profiler_init();
-	wc_app_init("Warcry", callbacks);
+	job_system_init(0);
 
-	if (wc_game_init() != 0)
+	// The world is built on a worker from the first moment; window and Vulkan objects tied to it
+	// stay on the main thread, and pipelines compile on workers while the swapchain is created
+	const uint32_t app = wc_startup_add("app", startup_app, (void*)&callbacks, 0, true);
+	wc_startup_add("game", startup_game, NULL, 0, false);
+	const uint32_t device = wc_startup_add("render.device", startup_render_device, NULL, WC_STARTUP_AFTER(app), true);
+	wc_startup_add("render.swapchain", startup_render_swapchain, NULL, WC_STARTUP_AFTER(device), true);
+	wc_startup_add("render.pipelines", startup_render_pipelines, NULL, WC_STARTUP_AFTER(device), false);
+	if (wc_startup_run() != 0)
 	{
+		job_system_shutdown();
 		return -1;
 	}
 
@@ -25,10 +134,13 @@ int main(int argc, char** argv)
 	{
 		profiler_frame_start();
 		wc_app_update();
+		wc_render_draw();
 		profiler_frame_end();
 	}
 
+	wc_render_quit();
 	wc_app_quit();
+	job_system_shutdown();
 	profiler_shutdown();
 
 	return 0;
@@ -0,0 +1,226 @@
+#include "buffer.h"
+
+#include <SDL3/SDL.h>
+
+typedef struct
+{
+	VkDevice device;
+	VmaAllocator allocator;
+	VkQueue queue;
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+	VkFence fence; // Signaled while no batch is in flight
+	WC_Buffer staging;
+	VkDeviceSize stagingUsed;
+	bool recording;
+	uint64_t uploadedBytes;
+} BufferUploader;
+
+static BufferUploader s_uploader;
+
+VkResult wc_buffer_create(const VkDeviceSize size, const VkBufferUsageFlags usage, const WC_BufferMemory memory, WC_Buffer* buffer)
+{
+	SDL_memset(buffer, 0, sizeof(*buffer));
+	const VkBufferCreateInfo bufferInfo = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, .size = size, .usage = usage, .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+
+	VmaAllocationCreateInfo allocInfo = {.usage = VMA_MEMORY_USAGE_AUTO};
+	switch (memory)
+	{
+	case WC_BUFFER_MEMORY_STATIC:
+		allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		break;
+	case WC_BUFFER_MEMORY_DYNAMIC:
+		// With sequential writes and a device preference VMA takes DEVICE_LOCAL | HOST_VISIBLE
+		// first, so per-frame data lands in VRAM without a copy wherever the BAR allows it
+		allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		break;
+	case WC_BUFFER_MEMORY_STAGING:
+		allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		break;
+	case WC_BUFFER_MEMORY_READBACK:
+		allocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST;
+		allocInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+		break;
+	}
+
+	VmaAllocationInfo info;
+	const VkResult result = vmaCreateBuffer(s_uploader.allocator, &bufferInfo, &allocInfo, &buffer->buffer, &buffer->allocation, &info);
+	if (result != VK_SUCCESS)
+		return result;
+
+	VkMemoryPropertyFlags flags;
+	vmaGetAllocationMemoryProperties(s_uploader.allocator, buffer->allocation, &flags);
+	buffer->size = size;
+	buffer->mapped = info.pMappedData;
+	buffer->coherent = (flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+	buffer->deviceLocal = (flags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) != 0;
+	return VK_SUCCESS;
+}
+
+void wc_buffer_destroy(WC_Buffer* buffer)
+{
+	if (buffer->buffer == VK_NULL_HANDLE)
+		return;
+	vmaDestroyBuffer(s_uploader.allocator, buffer->buffer, buffer->allocation);
+	SDL_memset(buffer, 0, sizeof(*buffer));
+}
+
+void wc_buffer_flush(const WC_Buffer* buffer, const VkDeviceSize offset, const VkDeviceSize size)
+{
+	if (buffer->mapped && !buffer->coherent && size > 0)
+		vmaFlushAllocation(s_uploader.allocator, buffer->allocation, offset, size);
+}
+
+void wc_buffer_invalidate(const WC_Buffer* buffer, const VkDeviceSize offset, const VkDeviceSize size)
+{
+	if (buffer->mapped && !buffer->coherent && size > 0)
+		vmaInvalidateAllocation(s_uploader.allocator, buffer->allocation, offset, size);
+}
+
+int wc_buffer_init(VkDevice device, VmaAllocator allocator, VkQueue queue, const uint32_t queue_family)
+{
+	SDL_memset(&s_uploader, 0, sizeof(s_uploader));
+	s_uploader.device = device;
+	s_uploader.allocator = allocator;
+	s_uploader.queue = queue;
+
+	const VkCommandPoolCreateInfo poolInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+											  .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT |
+													   VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+											  .queueFamilyIndex = queue_family};
+	if (vkCreateCommandPool(device, &poolInfo, NULL, &s_uploader.commandPool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create buffer upload command pool\n");
+		return EXIT_FAILURE;
+	}
+
+	const VkCommandBufferAllocateInfo commandInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+													 .commandPool = s_uploader.commandPool,
+													 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+													 .commandBufferCount = 1};
+	const VkFenceCreateInfo fenceInfo = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+	if (vkAllocateCommandBuffers(device, &commandInfo, &s_uploader.commandBuffer) != VK_SUCCESS ||
+		vkCreateFence(device, &fenceInfo, NULL, &s_uploader.fence) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create buffer upload command buffer\n");
+		return EXIT_FAILURE;
+	}
+
+	if (wc_buffer_create(WC_BUFFER_STAGING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, WC_BUFFER_MEMORY_STAGING, &s_uploader.staging) !=
+		VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create buffer staging memory\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void wc_buffer_quit(void)
+{
+	if (s_uploader.fence != VK_NULL_HANDLE)
+		vkWaitForFences(s_uploader.device, 1, &s_uploader.fence, VK_TRUE, UINT64_MAX);
+	wc_buffer_destroy(&s_uploader.staging);
+	vkDestroyFence(s_uploader.device, s_uploader.fence, NULL);
+	vkDestroyCommandPool(s_uploader.device, s_uploader.commandPool, NULL);
+	SDL_memset(&s_uploader, 0, sizeof(s_uploader));
+}
+
+// Staging is reused per batch, so a new batch first waits for the previous one
+static void buffer_begin_batch(void)
+{
+	vkWaitForFences(s_uploader.device, 1, &s_uploader.fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(s_uploader.device, 1, &s_uploader.fence);
+	vkResetCommandBuffer(s_uploader.commandBuffer, 0);
+	const VkCommandBufferBeginInfo beginInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+												.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+	vkBeginCommandBuffer(s_uploader.commandBuffer, &beginInfo);
+	s_uploader.stagingUsed = 0;
+	s_uploader.recording = true;
+}
+
+void wc_buffer_upload(const WC_Buffer* buffer, const VkDeviceSize offset, const void* data, const VkDeviceSize size)
+{
+	if (buffer->mapped)
+	{
+		SDL_memcpy((uint8_t*)buffer->mapped + offset, data, size);
+		wc_buffer_flush(buffer, offset, size);
+		return;
+	}
+
+	const uint8_t* src = data;
+	VkDeviceSize done = 0;
+	while (done < size)
+	{
+		if (!s_uploader.recording)
+			buffer_begin_batch();
+		const VkDeviceSize chunk = SDL_min(size - done, WC_BUFFER_STAGING_SIZE - s_uploader.stagingUsed);
+		if (chunk == 0)
+		{
+			wc_buffer_submit_uploads();
+			continue;
+		}
+
+		SDL_memcpy((uint8_t*)s_uploader.staging.mapped + s_uploader.stagingUsed, src + done, chunk);
+		const VkBufferCopy region = {.srcOffset = s_uploader.stagingUsed, .dstOffset = offset + done, .size = chunk};
+		vkCmdCopyBuffer(s_uploader.commandBuffer, s_uploader.staging.buffer, buffer->buffer, 1, &region);
+		// Keep copy sources 16-byte aligned for the DMA engines
+		s_uploader.stagingUsed = SDL_min((s_uploader.stagingUsed + chunk + 15) & ~(VkDeviceSize)15, WC_BUFFER_STAGING_SIZE);
+		done += chunk;
+	}
+	s_uploader.uploadedBytes += size;
+}
+
+void wc_buffer_submit_uploads(void)
+{
+	if (!s_uploader.recording)
+		return;
+
+	// Copies finish before any later command on the queue reads the buffers, whatever the stage
+	const VkMemoryBarrier2 barrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2,
+									  .srcStageMask = VK_PIPELINE_STAGE_2_COPY_BIT,
+									  .srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT,
+									  .dstStageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT,
+									  .dstAccessMask = VK_ACCESS_2_MEMORY_READ_BIT};
+	const VkDependencyInfo dependency = {
+		.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO, .memoryBarrierCount = 1, .pMemoryBarriers = &barrier};
+	vkCmdPipelineBarrier2(s_uploader.commandBuffer, &dependency);
+	vkEndCommandBuffer(s_uploader.commandBuffer);
+	wc_buffer_flush(&s_uploader.staging, 0, s_uploader.stagingUsed);
+
+	const VkSubmitInfo submitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .commandBufferCount = 1, .pCommandBuffers = &s_uploader.commandBuffer};
+	vkQueueSubmit(s_uploader.queue, 1, &submitInfo, s_uploader.fence);
+	s_uploader.recording = false;
+}
+
+void wc_buffer_log_budget(void)
+{
+	const VkPhysicalDeviceMemoryProperties* properties;
+	vmaGetMemoryProperties(s_uploader.allocator, &properties);
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(s_uploader.allocator, budgets);
+
+	for (uint32_t heap = 0; heap < properties->memoryHeapCount; heap++)
+	{
+		// A heap is worth naming by the properties of its types: VRAM, VRAM the CPU can map, or system memory
+		VkMemoryPropertyFlags flags = 0;
+		for (uint32_t type = 0; type < properties->memoryTypeCount; type++)
+		{
+			if (properties->memoryTypes[type].heapIndex == heap)
+				flags |= properties->memoryTypes[type].propertyFlags;
+		}
+		const char* kind = "system";
+		if (properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			kind = (flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) ? "device, host visible" : "device";
+
+		const VmaBudget* budget = &budgets[heap];
+		SDL_Log("Memory heap %u (%s): %" SDL_PRIu64 " MiB used of %" SDL_PRIu64 " MiB budget, %" SDL_PRIu64
+				" MiB in %u allocations by this process\n",
+				heap, kind, budget->usage >> 20, budget->budget >> 20, budget->statistics.blockBytes >> 20,
+				budget->statistics.allocationCount);
+	}
+	SDL_Log("Buffer uploads: %" SDL_PRIu64 " KiB staged so far\n", s_uploader.uploadedBytes >> 10);
+}
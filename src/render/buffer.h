@@ -0,0 +1,55 @@
+#pragma once
+
+#include "allocator.h"
+
+// Staging for device-local uploads; larger uploads are split over several submissions
+#define WC_BUFFER_STAGING_SIZE (32ull * 1024 * 1024)
+
+// Where a buffer lives, expressed as how the CPU touches it. All kinds use VMA_MEMORY_USAGE_AUTO
+// with explicit host-access flags, so VMA picks the memory type per device.
+typedef enum WC_BufferMemory
+{
+	// Written once (or rarely) through staging, never mapped: device-local VRAM
+	WC_BUFFER_MEMORY_STATIC,
+	// Rewritten by the CPU every frame and read in place by the GPU: persistently mapped,
+	// device-local when a host-visible VRAM heap exists (ReBAR/SAM, UMA), system memory otherwise
+	WC_BUFFER_MEMORY_DYNAMIC,
+	// CPU writes, copied from by the GPU
+	WC_BUFFER_MEMORY_STAGING,
+	// GPU writes, CPU reads: cached system memory
+	WC_BUFFER_MEMORY_READBACK,
+} WC_BufferMemory;
+
+typedef struct WC_Buffer
+{
+	VkBuffer buffer;
+	VmaAllocation allocation;
+	VkDeviceSize size;
+	void* mapped; // NULL for static buffers
+	bool coherent;
+	bool deviceLocal;
+} WC_Buffer;
+
+// The uploader records copies on queue with its own command buffer and staging memory.
+int wc_buffer_init(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queue_family);
+void wc_buffer_quit(void);
+
+VkResult wc_buffer_create(VkDeviceSize size, VkBufferUsageFlags usage, WC_BufferMemory memory, WC_Buffer* buffer);
+void wc_buffer_destroy(WC_Buffer* buffer);
+
+// Makes CPU writes to a mapped buffer visible to the GPU; a no-op for coherent memory.
+void wc_buffer_flush(const WC_Buffer* buffer, VkDeviceSize offset, VkDeviceSize size);
+// Makes GPU writes visible to the CPU before reading a mapped buffer.
+void wc_buffer_invalidate(const WC_Buffer* buffer, VkDeviceSize offset, VkDeviceSize size);
+
+// Writes mapped buffers directly. Everything else is staged and copied by the next
+// wc_buffer_submit_uploads; the destination needs VK_BUFFER_USAGE_TRANSFER_DST_BIT. Blocks only
+// when staging is full and the previous batch is still in flight.
+void wc_buffer_upload(const WC_Buffer* buffer, VkDeviceSize offset, const void* data, VkDeviceSize size);
+// Submits the recorded copies without waiting. They end in a barrier, so any later submission to
+// the same queue sees the data.
+void wc_buffer_submit_uploads(void);
+
+// Logs usage against the budget of every heap (VK_EXT_memory_budget when enabled, otherwise
+// VMA's own allocation statistics against a heuristic budget).
+void wc_buffer_log_budget(void);
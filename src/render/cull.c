@@ -0,0 +1,263 @@
+#include "cull.h"
+
+#include "../system/job.h"
+#include "../system/math.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL_log.h>
+#include <SDL3/SDL_stdinc.h>
+#include <SDL3/SDL_timer.h>
+
+int wc_cull_spheres_init(WC_CullSpheres* spheres, const uint32_t capacity)
+{
+	// One block split four ways keeps the streams 32-byte aligned for aligned AVX loads
+	const size_t stream_size = war_align_up((u64)capacity * sizeof(float), 32);
+	float* block = wc_aligned_alloc(stream_size * 4, 32);
+	if (!block)
+		return -1;
+
+	spheres->x = block;
+	spheres->y = (float*)((char*)block + stream_size);
+	spheres->z = (float*)((char*)block + stream_size * 2);
+	spheres->radius = (float*)((char*)block + stream_size * 3);
+	spheres->count = 0;
+	spheres->capacity = capacity;
+	return 0;
+}
+
+void wc_cull_spheres_free(WC_CullSpheres* spheres)
+{
+	wc_aligned_free(spheres->x, 32);
+	SDL_memset(spheres, 0, sizeof(*spheres));
+}
+
+void wc_cull_result_free(WC_CullResult* result)
+{
+	for (uint32_t i = 0; i < WC_CULL_MAX_WORKERS; i++)
+	{
+		wc_free(result->indices[i]);
+	}
+	SDL_memset(result, 0, sizeof(*result));
+}
+
+uint32_t wc_cull_result_total(const WC_CullResult* result)
+{
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < WC_CULL_MAX_WORKERS; i++)
+	{
+		total += result->counts[i];
+	}
+	return total;
+}
+
+uint32_t wc_cull_result_gather(const WC_CullResult* result, uint32_t* out)
+{
+	uint32_t total = 0;
+	for (uint32_t i = 0; i < WC_CULL_MAX_WORKERS; i++)
+	{
+		if (result->counts[i] == 0)
+			continue;
+		SDL_memcpy(out + total, result->indices[i], result->counts[i] * sizeof(uint32_t));
+		total += result->counts[i];
+	}
+	return total;
+}
+
+void wc_cull_extract_planes(const float view_proj[16], float planes[24])
+{
+	wc_mat4 matrix;
+	wc_frustum frustum;
+	SDL_memcpy(matrix.m, view_proj, sizeof(matrix.m));
+	wc_frustum_from_matrix(&matrix, &frustum);
+	SDL_memcpy(planes, frustum.planes, sizeof(frustum.planes));
+}
+
+void wc_cull_frustum_from_planes(WC_Frustum* frustum, const float planes[24])
+{
+	for (int p = 0; p < 6; p++)
+	{
+		frustum->nx[p] = planes[p * 4 + 0];
+		frustum->ny[p] = planes[p * 4 + 1];
+		frustum->nz[p] = planes[p * 4 + 2];
+		frustum->d[p] = planes[p * 4 + 3];
+	}
+}
+
+uint32_t wc_cull_spheres_scalar(const WC_Frustum* frustum, const WC_CullSpheres* spheres, const uint32_t start, const uint32_t end,
+								uint32_t* out)
+{
+	uint32_t count = 0;
+	for (uint32_t i = start; i < end; i++)
+	{
+		const float x = spheres->x[i];
+		const float y = spheres->y[i];
+		const float z = spheres->z[i];
+		const float r = spheres->radius[i];
+
+		bool visible = true;
+		for (int p = 0; p < 6 && visible; p++)
+		{
+			const float distance = frustum->nx[p] * x + frustum->ny[p] * y + frustum->nz[p] * z + frustum->d[p];
+			visible = distance >= -r;
+		}
+
+		out[count] = i;
+		count += visible;
+	}
+	return count;
+}
+
+uint32_t wc_cull_spheres_simd(const WC_Frustum* frustum, const WC_CullSpheres* spheres, const uint32_t start, const uint32_t end,
+							  uint32_t* out)
+{
+	wc_wide_frustum planes;
+	for (int p = 0; p < 6; p++)
+	{
+		planes.nx[p] = wc_wide_set1(frustum->nx[p]);
+		planes.ny[p] = wc_wide_set1(frustum->ny[p]);
+		planes.nz[p] = wc_wide_set1(frustum->nz[p]);
+		planes.d[p] = wc_wide_set1(frustum->d[p]);
+	}
+
+	uint32_t count = 0;
+	uint32_t i = start;
+	const uint32_t simd_end = start + (end - start) / WC_WIDE_LANES * WC_WIDE_LANES;
+	for (; i < simd_end; i += WC_WIDE_LANES)
+	{
+		const wc_wide3 center = {wc_wide_load(&spheres->x[i]), wc_wide_load(&spheres->y[i]), wc_wide_load(&spheres->z[i])};
+		const wc_wide visible = wc_wide_frustum_test_spheres(&planes, center, wc_wide_load(&spheres->radius[i]));
+
+		// Branchless compaction: every lane writes its index, only visible lanes advance the cursor
+		const uint32_t mask = wc_wide_mask_bits(visible);
+		for (uint32_t lane = 0; lane < WC_WIDE_LANES; lane++)
+		{
+			out[count] = i + lane;
+			count += (mask >> lane) & 1;
+		}
+	}
+
+	return count + wc_cull_spheres_scalar(frustum, spheres, i, end, out + count);
+}
+
+typedef struct
+{
+	const WC_Frustum* frustum;
+	const WC_CullSpheres* spheres;
+	WC_CullResult* result;
+} CullJobData;
+
+static void cull_chunk(const u32 start, const u32 end, void* data)
+{
+	const CullJobData* job = (const CullJobData*)data;
+	WC_CullResult* result = job->result;
+	const u32 worker = job_get_worker_index();
+	assert(worker < WC_CULL_MAX_WORKERS);
+
+	// Only this worker touches its list, so growing it here is race-free
+	const uint32_t required = result->counts[worker] + (end - start);
+	if (required > result->capacities[worker])
+	{
+		uint32_t capacity = result->capacities[worker] ? result->capacities[worker] : WC_CULL_SPHERES_PER_JOB;
+		while (capacity < required)
+			capacity *= 2;
+		result->indices[worker] = wc_realloc(result->indices[worker], capacity * sizeof(uint32_t));
+		result->capacities[worker] = capacity;
+	}
+
+	result->counts[worker] +=
+		wc_cull_spheres_simd(job->frustum, job->spheres, start, end, result->indices[worker] + result->counts[worker]);
+}
+
+void wc_cull_spheres_parallel(const WC_Frustum* frustum, const WC_CullSpheres* spheres, WC_CullResult* result)
+{
+	SDL_memset(result->counts, 0, sizeof(result->counts));
+	if (spheres->count == 0)
+		return;
+
+	CullJobData data = {.frustum = frustum, .spheres = spheres, .result = result};
+	const JobHandle handle = job_parallel_for(spheres->count, WC_CULL_SPHERES_PER_JOB, cull_chunk, &data);
+	job_wait(handle);
+}
+
+static double cull_elapsed_ms(const uint64_t begin)
+{
+	return (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+static int cull_compare_indices(const void* a, const void* b)
+{
+	const uint32_t lhs = *(const uint32_t*)a;
+	const uint32_t rhs = *(const uint32_t*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+// Workers append in whatever order they took chunks, so the lists are merged and sorted before
+// comparing against the in-order scalar result
+static bool cull_result_matches(const WC_CullResult* result, const uint32_t* reference, const uint32_t reference_count,
+								uint32_t* scratch)
+{
+	if (wc_cull_result_total(result) != reference_count)
+		return false;
+
+	const uint32_t count = wc_cull_result_gather(result, scratch);
+	SDL_qsort(scratch, count, sizeof(uint32_t), cull_compare_indices);
+	return SDL_memcmp(reference, scratch, count * sizeof(uint32_t)) == 0;
+}
+
+void wc_cull_benchmark(const uint32_t instance_count)
+{
+	WC_CullSpheres spheres;
+	if (wc_cull_spheres_init(&spheres, instance_count) != 0)
+		return;
+
+	// Scatter spheres over a 2km square map so roughly a quarter lands inside the camera frustum
+	for (uint32_t i = 0; i < instance_count; i++)
+	{
+		spheres.x[i] = SDL_randf() * 2000.0f - 1000.0f;
+		spheres.y[i] = SDL_randf() * 20.0f;
+		spheres.z[i] = SDL_randf() * 2000.0f - 1000.0f;
+		spheres.radius[i] = 0.5f + SDL_randf() * 2.0f;
+	}
+	spheres.count = instance_count;
+
+	// Perspective camera at the origin looking down -z, 90 degree fov, near 0.1, far 1000
+	const float n = 0.1f;
+	const float f = 1000.0f;
+	const float view_proj[16] = {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, -1.0f, 0.0f, 0.0f,
+								 0.0f, 0.0f, f / (n - f), -1.0f, 0.0f, 0.0f, n * f / (n - f), 0.0f};
+	float planes[24];
+	WC_Frustum frustum;
+	wc_cull_extract_planes(view_proj, planes);
+	wc_cull_frustum_from_planes(&frustum, planes);
+
+	uint32_t* reference = wc_malloc(instance_count * sizeof(uint32_t));
+	uint32_t* simd = wc_malloc(instance_count * sizeof(uint32_t));
+	WC_CullResult result = {0};
+
+	uint64_t begin = SDL_GetPerformanceCounter();
+	const uint32_t scalar_count = wc_cull_spheres_scalar(&frustum, &spheres, 0, instance_count, reference);
+	const double scalar_ms = cull_elapsed_ms(begin);
+
+	begin = SDL_GetPerformanceCounter();
+	const uint32_t simd_count = wc_cull_spheres_simd(&frustum, &spheres, 0, instance_count, simd);
+	const double simd_ms = cull_elapsed_ms(begin);
+	const bool simd_matches = simd_count == scalar_count && SDL_memcmp(reference, simd, scalar_count * sizeof(uint32_t)) == 0;
+
+	// Warm up the per-worker lists once so the timed run measures steady-state frames
+	wc_cull_spheres_parallel(&frustum, &spheres, &result);
+	begin = SDL_GetPerformanceCounter();
+	wc_cull_spheres_parallel(&frustum, &spheres, &result);
+	const double parallel_ms = cull_elapsed_ms(begin);
+	// The SIMD list has been checked, so its buffer takes the merged parallel lists
+	const bool parallel_matches = cull_result_matches(&result, reference, scalar_count, simd);
+
+	SDL_Log("Cull benchmark: %u instances, %u visible\n", instance_count, scalar_count);
+	SDL_Log("  scalar:   %.3f ms\n", scalar_ms);
+	SDL_Log("  simd:     %.3f ms (%s)\n", simd_ms, simd_matches ? "matches" : "MISMATCH");
+	SDL_Log("  parallel: %.3f ms (%s)\n", parallel_ms, parallel_matches ? "matches" : "MISMATCH");
+
+	wc_cull_result_free(&result);
+	wc_free(simd);
+	wc_free(reference);
+	wc_cull_spheres_free(&spheres);
+}
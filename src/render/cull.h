@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../system/common.h"
+#include "../system/job.h"
+
+#include <stdint.h>
+
+// Job workers plus the main thread, which helps out while waiting on jobs
+#define WC_CULL_MAX_WORKERS (WC_JOB_MAX_WORKERS + 1)
+#define WC_CULL_SPHERES_PER_JOB 16384
+
+// Bounding spheres in SoA layout so a full wc_wide of them is tested per iteration
+typedef struct WC_CullSpheres
+{
+	float* x;
+	float* y;
+	float* z;
+	float* radius;
+	uint32_t count;
+	uint32_t capacity;
+} WC_CullSpheres;
+
+// Six planes (left, right, bottom, top, near, far) in SoA layout, normals pointing inwards
+typedef struct WC_Frustum
+{
+	float nx[6];
+	float ny[6];
+	float nz[6];
+	float d[6];
+} WC_Frustum;
+
+// Compacted visible indices, one list per worker so chunks never contend on a shared counter
+typedef struct WC_CullResult
+{
+	uint32_t* indices[WC_CULL_MAX_WORKERS];
+	uint32_t counts[WC_CULL_MAX_WORKERS];
+	uint32_t capacities[WC_CULL_MAX_WORKERS];
+} WC_CullResult;
+
+int wc_cull_spheres_init(WC_CullSpheres* spheres, uint32_t capacity);
+void wc_cull_spheres_free(WC_CullSpheres* spheres);
+
+void wc_cull_result_free(WC_CullResult* result);
+uint32_t wc_cull_result_total(const WC_CullResult* result);
+// Concatenates the per-worker lists into out, which must hold wc_cull_result_total() indices
+uint32_t wc_cull_result_gather(const WC_CullResult* result, uint32_t* out);
+
+// Extracts normalized planes from a column-major view-projection matrix with Vulkan [0, 1] depth.
+// planes is laid out as WC_GpuSceneData::frustumPlanes (xyz normal, w distance).
+void wc_cull_extract_planes(const float view_proj[16], float planes[24]);
+void wc_cull_frustum_from_planes(WC_Frustum* frustum, const float planes[24]);
+
+// Single-threaded kernels over [start, end). Return the number of indices written to out.
+uint32_t wc_cull_spheres_scalar(const WC_Frustum* frustum, const WC_CullSpheres* spheres, uint32_t start, uint32_t end, uint32_t* out);
+uint32_t wc_cull_spheres_simd(const WC_Frustum* frustum, const WC_CullSpheres* spheres, uint32_t start, uint32_t end, uint32_t* out);
+
+// Culls all spheres on the job system, blocking until done. Result lists are reused between calls.
+void wc_cull_spheres_parallel(const WC_Frustum* frustum, const WC_CullSpheres* spheres, WC_CullResult* result);
+
+// Times scalar, SIMD and parallel culling over instance_count random spheres and checks they agree
+void wc_cull_benchmark(uint32_t instance_count);
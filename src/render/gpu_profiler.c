@@ -0,0 +1,317 @@
+#include "gpu_profiler.h"
+
+#include "../system/memory.h"
+#include "../system/profiler.h"
+
+#include <SDL3/SDL.h>
+
+#define WC_GPU_PROFILER_MAX_STATISTICS 4
+
+typedef struct
+{
+	const char* names[WC_GPU_PROFILER_MAX_ZONES];
+	bool statistics[WC_GPU_PROFILER_MAX_ZONES];
+	bool closed[WC_GPU_PROFILER_MAX_ZONES];
+	uint32_t zoneCount;
+
+	uint64_t frame;
+	uint64_t submitTicks;
+	bool pending;
+} GpuProfilerSlot;
+
+typedef struct
+{
+	VkDevice device;
+	VkQueryPool timestamps;
+	VkQueryPool statistics;
+	GpuProfilerSlot* slots;
+	uint32_t slotCount;
+
+	double nsPerTimestamp;
+	uint64_t timestampMask;
+	double ticksPerNs;
+
+	VkQueryPipelineStatisticFlags statisticFlags;
+	const char* statisticNames[WC_GPU_PROFILER_MAX_STATISTICS];
+	uint32_t statisticCount;
+
+	bool calibrated;
+	VkTimeDomainEXT hostDomain;
+	uint64_t gpuCalibration;
+	uint64_t hostCalibration; // performance counter ticks
+	uint64_t lastCalibration;
+} GpuProfiler;
+
+static GpuProfiler s_gpu_profiler;
+
+// The host domain has to match SDL_GetPerformanceCounter: QueryPerformanceCounter on Windows,
+// CLOCK_MONOTONIC_RAW elsewhere
+static bool gpu_profiler_pick_domain(VkPhysicalDevice physical_device, VkTimeDomainEXT* host_domain)
+{
+	uint32_t count = 0;
+	if (vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physical_device, &count, NULL) != VK_SUCCESS || count == 0)
+		return false;
+
+	VkTimeDomainEXT* domains = wc_malloc(count * sizeof(VkTimeDomainEXT));
+	vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physical_device, &count, domains);
+
+#ifdef _WIN32
+	const VkTimeDomainEXT wanted = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+	const VkTimeDomainEXT wanted = VK_TIME_DOMAIN_CLOCK_MONOTONIC_RAW_EXT;
+#endif
+	bool device_domain = false;
+	bool host = false;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		device_domain |= domains[i] == VK_TIME_DOMAIN_DEVICE_EXT;
+		host |= domains[i] == wanted;
+	}
+	wc_free(domains);
+
+	*host_domain = wanted;
+	return device_domain && host;
+}
+
+static void gpu_profiler_calibrate(void)
+{
+	const VkCalibratedTimestampInfoEXT infos[2] = {
+		{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, .timeDomain = VK_TIME_DOMAIN_DEVICE_EXT},
+		{.sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT, .timeDomain = s_gpu_profiler.hostDomain},
+	};
+	uint64_t timestamps[2];
+	uint64_t deviation;
+	if (vkGetCalibratedTimestampsEXT(s_gpu_profiler.device, 2, infos, timestamps, &deviation) != VK_SUCCESS)
+	{
+		s_gpu_profiler.calibrated = false;
+		return;
+	}
+
+	s_gpu_profiler.gpuCalibration = timestamps[0] & s_gpu_profiler.timestampMask;
+	// QueryPerformanceCounter values already are performance counter ticks, the monotonic clock is in ns
+	s_gpu_profiler.hostCalibration = s_gpu_profiler.hostDomain == VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT
+										 ? timestamps[1]
+										 : (uint64_t)((double)timestamps[1] * s_gpu_profiler.ticksPerNs);
+	s_gpu_profiler.lastCalibration = SDL_GetTicks();
+}
+
+static uint64_t gpu_profiler_to_host(const uint64_t timestamp, const uint64_t reference, const uint64_t reference_ticks)
+{
+	// Signed, masked difference: the reference may be newer than the timestamp
+	int64_t delta = (int64_t)((timestamp - reference) & s_gpu_profiler.timestampMask);
+	if (s_gpu_profiler.timestampMask != UINT64_MAX && (uint64_t)delta > s_gpu_profiler.timestampMask / 2)
+		delta -= (int64_t)s_gpu_profiler.timestampMask + 1;
+	return reference_ticks + (uint64_t)(int64_t)((double)delta * s_gpu_profiler.nsPerTimestamp * s_gpu_profiler.ticksPerNs);
+}
+
+// Returns false while the GPU has not written every query of the slot yet
+static bool gpu_profiler_read(GpuProfilerSlot* slot, const uint32_t index)
+{
+	if (slot->zoneCount == 0)
+		return true;
+
+	uint64_t timestamps[WC_GPU_PROFILER_MAX_ZONES * 2][2];
+	const VkResult result = vkGetQueryPoolResults(s_gpu_profiler.device, s_gpu_profiler.timestamps, index * WC_GPU_PROFILER_MAX_ZONES * 2,
+												  slot->zoneCount * 2, sizeof(timestamps), timestamps, sizeof(timestamps[0]),
+												  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS)
+		return false;
+
+	// Each query writes its enabled counters plus availability; rows are sized for the most counters,
+	// so the batched read strides by row rather than by what one query writes
+	uint64_t statistics[WC_GPU_PROFILER_MAX_ZONES][WC_GPU_PROFILER_MAX_STATISTICS + 1];
+	const size_t size = (s_gpu_profiler.statisticCount + 1) * sizeof(uint64_t);
+	if (s_gpu_profiler.statistics != VK_NULL_HANDLE &&
+		vkGetQueryPoolResults(s_gpu_profiler.device, s_gpu_profiler.statistics, index * WC_GPU_PROFILER_MAX_ZONES, slot->zoneCount,
+							  sizeof(statistics), statistics, sizeof(statistics[0]),
+							  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) != VK_SUCCESS)
+	{
+		// Zones without statistics leave their query unavailable, so read what was written one by one
+		for (uint32_t zone = 0; zone < slot->zoneCount; zone++)
+		{
+			if (slot->statistics[zone] &&
+				vkGetQueryPoolResults(s_gpu_profiler.device, s_gpu_profiler.statistics, index * WC_GPU_PROFILER_MAX_ZONES + zone, 1,
+									  size, statistics[zone], size,
+									  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) != VK_SUCCESS)
+				return false;
+		}
+	}
+
+	if (s_gpu_profiler.calibrated && SDL_GetTicks() - s_gpu_profiler.lastCalibration >= WC_GPU_PROFILER_CALIBRATION_MS)
+		gpu_profiler_calibrate();
+
+	const uint64_t first = timestamps[0][0] & s_gpu_profiler.timestampMask;
+	for (uint32_t zone = 0; zone < slot->zoneCount; zone++)
+	{
+		if (!slot->closed[zone])
+			continue;
+
+		const uint64_t begin = timestamps[zone * 2][0] & s_gpu_profiler.timestampMask;
+		const uint64_t end = timestamps[zone * 2 + 1][0] & s_gpu_profiler.timestampMask;
+		const uint64_t reference = s_gpu_profiler.calibrated ? s_gpu_profiler.gpuCalibration : first;
+		const uint64_t referenceTicks = s_gpu_profiler.calibrated ? s_gpu_profiler.hostCalibration : slot->submitTicks;
+		profiler_submit_gpu_zone(slot->frame, slot->names[zone], gpu_profiler_to_host(begin, reference, referenceTicks),
+								 gpu_profiler_to_host(end, reference, referenceTicks));
+
+		if (!slot->statistics[zone])
+			continue;
+		for (uint32_t i = 0; i < s_gpu_profiler.statisticCount; i++)
+		{
+			profiler_submit_counter(slot->frame, slot->names[zone], s_gpu_profiler.statisticNames[i], statistics[zone][i]);
+		}
+	}
+	return true;
+}
+
+int wc_gpu_profiler_init(VkPhysicalDevice physical_device, VkDevice device, const uint32_t queue_family, const uint32_t slot_count,
+						 const bool calibrated, const bool statistics, const bool mesh_statistics)
+{
+	SDL_memset(&s_gpu_profiler, 0, sizeof(s_gpu_profiler));
+	s_gpu_profiler.device = device;
+	s_gpu_profiler.slotCount = slot_count;
+	s_gpu_profiler.slots = wc_calloc(slot_count, sizeof(GpuProfilerSlot));
+	s_gpu_profiler.ticksPerNs = (double)SDL_GetPerformanceFrequency() / 1e9;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+	s_gpu_profiler.nsPerTimestamp = properties.limits.timestampPeriod;
+
+	uint32_t familyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &familyCount, NULL);
+	VkQueueFamilyProperties* families = wc_malloc(familyCount * sizeof(VkQueueFamilyProperties));
+	vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &familyCount, families);
+	const uint32_t validBits = queue_family < familyCount ? families[queue_family].timestampValidBits : 0;
+	wc_free(families);
+
+	if (validBits == 0)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Queue family %u has no timestamps, GPU zones disabled\n", queue_family);
+		return EXIT_SUCCESS;
+	}
+	s_gpu_profiler.timestampMask = validBits >= 64 ? UINT64_MAX : (1ull << validBits) - 1;
+
+	VkQueryPoolCreateInfo poolInfo = {.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+	poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount = slot_count * WC_GPU_PROFILER_MAX_ZONES * 2;
+	if (vkCreateQueryPool(device, &poolInfo, NULL, &s_gpu_profiler.timestamps) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create timestamp query pool\n");
+		return EXIT_FAILURE;
+	}
+
+	if (statistics)
+	{
+		// Results come back in bit order, so the names are listed the same way
+		s_gpu_profiler.statisticFlags = VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT;
+		s_gpu_profiler.statisticNames[s_gpu_profiler.statisticCount++] = "primitives";
+		s_gpu_profiler.statisticFlags |= VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+		s_gpu_profiler.statisticNames[s_gpu_profiler.statisticCount++] = "fragment invocations";
+		if (mesh_statistics)
+		{
+			s_gpu_profiler.statisticFlags |= VK_QUERY_PIPELINE_STATISTIC_TASK_SHADER_INVOCATIONS_BIT_EXT;
+			s_gpu_profiler.statisticNames[s_gpu_profiler.statisticCount++] = "task invocations";
+			s_gpu_profiler.statisticFlags |= VK_QUERY_PIPELINE_STATISTIC_MESH_SHADER_INVOCATIONS_BIT_EXT;
+			s_gpu_profiler.statisticNames[s_gpu_profiler.statisticCount++] = "mesh invocations";
+		}
+
+		poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		poolInfo.queryCount = slot_count * WC_GPU_PROFILER_MAX_ZONES;
+		poolInfo.pipelineStatistics = s_gpu_profiler.statisticFlags;
+		if (vkCreateQueryPool(device, &poolInfo, NULL, &s_gpu_profiler.statistics) != VK_SUCCESS)
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Pipeline statistics unavailable\n");
+			s_gpu_profiler.statistics = VK_NULL_HANDLE;
+			s_gpu_profiler.statisticCount = 0;
+		}
+	}
+
+	s_gpu_profiler.calibrated = calibrated && gpu_profiler_pick_domain(physical_device, &s_gpu_profiler.hostDomain);
+	if (s_gpu_profiler.calibrated)
+		gpu_profiler_calibrate();
+	if (!s_gpu_profiler.calibrated)
+		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "No calibrated timestamps, GPU zones are placed at submit time\n");
+
+	return EXIT_SUCCESS;
+}
+
+void wc_gpu_profiler_quit(void)
+{
+	if (s_gpu_profiler.statistics != VK_NULL_HANDLE)
+		vkDestroyQueryPool(s_gpu_profiler.device, s_gpu_profiler.statistics, NULL);
+	if (s_gpu_profiler.timestamps != VK_NULL_HANDLE)
+		vkDestroyQueryPool(s_gpu_profiler.device, s_gpu_profiler.timestamps, NULL);
+	wc_free(s_gpu_profiler.slots);
+	SDL_memset(&s_gpu_profiler, 0, sizeof(s_gpu_profiler));
+}
+
+void wc_gpu_profiler_reset(VkCommandBuffer command_buffer, const uint32_t slot)
+{
+	if (s_gpu_profiler.timestamps == VK_NULL_HANDLE || slot >= s_gpu_profiler.slotCount)
+		return;
+
+	// Re-recording drops the zone names, so hand over whatever the last submission produced first
+	GpuProfilerSlot* record = &s_gpu_profiler.slots[slot];
+	if (record->pending)
+		gpu_profiler_read(record, slot);
+	SDL_memset(record, 0, sizeof(*record));
+
+	vkCmdResetQueryPool(command_buffer, s_gpu_profiler.timestamps, slot * WC_GPU_PROFILER_MAX_ZONES * 2, WC_GPU_PROFILER_MAX_ZONES * 2);
+	if (s_gpu_profiler.statistics != VK_NULL_HANDLE)
+		vkCmdResetQueryPool(command_buffer, s_gpu_profiler.statistics, slot * WC_GPU_PROFILER_MAX_ZONES, WC_GPU_PROFILER_MAX_ZONES);
+}
+
+uint32_t wc_gpu_profiler_begin(VkCommandBuffer command_buffer, const uint32_t slot, const char* name, const bool statistics)
+{
+	if (s_gpu_profiler.timestamps == VK_NULL_HANDLE || slot >= s_gpu_profiler.slotCount)
+		return WC_GPU_PROFILER_NONE;
+
+	GpuProfilerSlot* record = &s_gpu_profiler.slots[slot];
+	if (record->zoneCount >= WC_GPU_PROFILER_MAX_ZONES)
+		return WC_GPU_PROFILER_NONE;
+
+	const uint32_t zone = record->zoneCount++;
+	record->names[zone] = name;
+	record->statistics[zone] = statistics && s_gpu_profiler.statistics != VK_NULL_HANDLE;
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, s_gpu_profiler.timestamps,
+						(slot * WC_GPU_PROFILER_MAX_ZONES + zone) * 2);
+	if (record->statistics[zone])
+		vkCmdBeginQuery(command_buffer, s_gpu_profiler.statistics, slot * WC_GPU_PROFILER_MAX_ZONES + zone, 0);
+	return zone;
+}
+
+void wc_gpu_profiler_end(VkCommandBuffer command_buffer, const uint32_t slot, const uint32_t zone)
+{
+	if (zone == WC_GPU_PROFILER_NONE || slot >= s_gpu_profiler.slotCount)
+		return;
+
+	GpuProfilerSlot* record = &s_gpu_profiler.slots[slot];
+	if (record->statistics[zone])
+		vkCmdEndQuery(command_buffer, s_gpu_profiler.statistics, slot * WC_GPU_PROFILER_MAX_ZONES + zone);
+	vkCmdWriteTimestamp(command_buffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, s_gpu_profiler.timestamps,
+						(slot * WC_GPU_PROFILER_MAX_ZONES + zone) * 2 + 1);
+	record->closed[zone] = true;
+}
+
+void wc_gpu_profiler_submit(const uint32_t slot, const uint64_t frame)
+{
+	if (s_gpu_profiler.timestamps == VK_NULL_HANDLE || slot >= s_gpu_profiler.slotCount)
+		return;
+
+	GpuProfilerSlot* record = &s_gpu_profiler.slots[slot];
+	// Resubmitting means the previous run has finished; read it before the queries are reset
+	if (record->pending)
+		gpu_profiler_read(record, slot);
+	record->frame = frame;
+	record->submitTicks = SDL_GetPerformanceCounter();
+	record->pending = true;
+}
+
+void wc_gpu_profiler_collect(void)
+{
+	for (uint32_t i = 0; i < s_gpu_profiler.slotCount; i++)
+	{
+		GpuProfilerSlot* record = &s_gpu_profiler.slots[i];
+		if (record->pending && gpu_profiler_read(record, i))
+			record->pending = false;
+	}
+}
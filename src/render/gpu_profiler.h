@@ -0,0 +1,30 @@
+#pragma once
+
+#include <volk.h>
+
+// Zones per command buffer; each takes two timestamps and optionally one statistics query
+#define WC_GPU_PROFILER_MAX_ZONES 16
+#define WC_GPU_PROFILER_NONE UINT32_MAX
+// Calibrated clocks drift apart slowly; re-correlate them at this interval
+#define WC_GPU_PROFILER_CALIBRATION_MS 1000
+
+// One query range per slot, where a slot is a command buffer that is recorded once and submitted
+// many times. Results are read without waiting, a frame or more after submission, and handed to
+// the profiler on the CPU timeline: exact with VK_EXT_calibrated_timestamps, otherwise anchored to
+// the submit time. Statistics need the pipelineStatisticsQuery feature, task/mesh counts also
+// meshShaderQueries.
+int wc_gpu_profiler_init(VkPhysicalDevice physical_device, VkDevice device, uint32_t queue_family, uint32_t slot_count,
+						 bool calibrated, bool statistics, bool mesh_statistics);
+void wc_gpu_profiler_quit(void);
+
+// Recording: reset first (outside a render pass), then bracket passes with begin/end. Statistics
+// zones must begin and end on the same side of a render pass boundary.
+void wc_gpu_profiler_reset(VkCommandBuffer command_buffer, uint32_t slot);
+uint32_t wc_gpu_profiler_begin(VkCommandBuffer command_buffer, uint32_t slot, const char* name, bool statistics);
+void wc_gpu_profiler_end(VkCommandBuffer command_buffer, uint32_t slot, uint32_t zone);
+
+// Marks the slot as submitted for the given profiler frame. Call right before vkQueueSubmit: the
+// previous run's results are read here, before the re-submitted buffer resets its queries.
+void wc_gpu_profiler_submit(uint32_t slot, uint64_t frame);
+// Forwards every submitted slot whose results are available. Never blocks.
+void wc_gpu_profiler_collect(void);
@@ -0,0 +1,295 @@
+#include "meshlet.h"
+
+#include "../system/memory.h"
+
+#include <SDL3/SDL_stdinc.h>
+#include <math.h>
+
+#define MESHLET_NO_LOCAL 0xFF
+
+static const float* meshlet_position(const float* positions, const uint32_t vertex_stride, const uint32_t vertex)
+{
+	return (const float*)((const uint8_t*)positions + (size_t)vertex * vertex_stride);
+}
+
+static uint32_t meshlet_new_vertices(const uint8_t* local, const uint32_t* indices, const uint32_t triangle)
+{
+	return (local[indices[triangle * 3 + 0]] == MESHLET_NO_LOCAL) + (local[indices[triangle * 3 + 1]] == MESHLET_NO_LOCAL) +
+		   (local[indices[triangle * 3 + 2]] == MESHLET_NO_LOCAL);
+}
+
+// Picks the unemitted triangle around the given vertices that adds the fewest new vertices, preferring
+// triangles whose vertices have few remaining uses so they can be retired from the meshlet early
+static uint32_t meshlet_best_candidate(const uint32_t* candidates, const uint32_t candidate_count, const uint32_t* offsets,
+									   const uint32_t* adjacency, const uint32_t* live, const uint8_t* emitted, const uint8_t* local,
+									   const uint32_t* indices)
+{
+	uint32_t best = UINT32_MAX;
+	uint32_t best_new = UINT32_MAX;
+	uint32_t best_live = UINT32_MAX;
+
+	for (uint32_t c = 0; c < candidate_count; c++)
+	{
+		const uint32_t vertex = candidates[c];
+		for (uint32_t a = offsets[vertex]; a < offsets[vertex + 1]; a++)
+		{
+			const uint32_t triangle = adjacency[a];
+			if (emitted[triangle])
+				continue;
+
+			const uint32_t new_vertices = meshlet_new_vertices(local, indices, triangle);
+			const uint32_t live_sum =
+				live[indices[triangle * 3 + 0]] + live[indices[triangle * 3 + 1]] + live[indices[triangle * 3 + 2]];
+			if (new_vertices < best_new || (new_vertices == best_new && live_sum < best_live))
+			{
+				best = triangle;
+				best_new = new_vertices;
+				best_live = live_sum;
+			}
+		}
+	}
+	return best;
+}
+
+static void meshlet_compute_bounds(WC_GpuMeshlet* meshlet, const WC_MeshletData* data, const float* positions,
+								   const uint32_t vertex_stride)
+{
+	const uint32_t* vertices = data->vertices + meshlet->vertexOffset;
+	const uint8_t* triangles = data->triangles + meshlet->triangleOffset;
+
+	float min[3] = {INFINITY, INFINITY, INFINITY};
+	float max[3] = {-INFINITY, -INFINITY, -INFINITY};
+	for (uint32_t i = 0; i < meshlet->vertexCount; i++)
+	{
+		const float* p = meshlet_position(positions, vertex_stride, vertices[i]);
+		for (int k = 0; k < 3; k++)
+		{
+			min[k] = p[k] < min[k] ? p[k] : min[k];
+			max[k] = p[k] > max[k] ? p[k] : max[k];
+		}
+	}
+
+	const float center[3] = {(min[0] + max[0]) * 0.5f, (min[1] + max[1]) * 0.5f, (min[2] + max[2]) * 0.5f};
+	float radius_sq = 0.0f;
+	for (uint32_t i = 0; i < meshlet->vertexCount; i++)
+	{
+		const float* p = meshlet_position(positions, vertex_stride, vertices[i]);
+		const float dx = p[0] - center[0];
+		const float dy = p[1] - center[1];
+		const float dz = p[2] - center[2];
+		const float d_sq = dx * dx + dy * dy + dz * dz;
+		radius_sq = d_sq > radius_sq ? d_sq : radius_sq;
+	}
+
+	meshlet->boundingSphere[0] = center[0];
+	meshlet->boundingSphere[1] = center[1];
+	meshlet->boundingSphere[2] = center[2];
+	meshlet->boundingSphere[3] = sqrtf(radius_sq);
+
+	// Normal cone: average unit normal, widened to the least aligned triangle
+	float normals[WC_MESHLET_MAX_TRIANGLES][3];
+	uint32_t normal_count = 0;
+	float axis[3] = {0.0f, 0.0f, 0.0f};
+	for (uint32_t t = 0; t < meshlet->triangleCount; t++)
+	{
+		const float* p0 = meshlet_position(positions, vertex_stride, vertices[triangles[t * 3 + 0]]);
+		const float* p1 = meshlet_position(positions, vertex_stride, vertices[triangles[t * 3 + 1]]);
+		const float* p2 = meshlet_position(positions, vertex_stride, vertices[triangles[t * 3 + 2]]);
+		const float e0[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+		const float e1[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+		const float n[3] = {e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0]};
+		const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if (length <= 0.0f)
+			continue; // Degenerate triangles do not constrain the cone
+
+		for (int k = 0; k < 3; k++)
+		{
+			normals[normal_count][k] = n[k] / length;
+			axis[k] += normals[normal_count][k];
+		}
+		normal_count++;
+	}
+
+	const float axis_length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	meshlet->coneAxis[0] = 0.0f;
+	meshlet->coneAxis[1] = 0.0f;
+	meshlet->coneAxis[2] = 1.0f;
+	meshlet->coneCutoff = 1.0f;
+	if (normal_count == 0 || axis_length <= 0.0f)
+		return;
+
+	float min_dot = 1.0f;
+	for (int k = 0; k < 3; k++)
+	{
+		meshlet->coneAxis[k] = axis[k] / axis_length;
+	}
+	for (uint32_t i = 0; i < normal_count; i++)
+	{
+		const float d = normals[i][0] * meshlet->coneAxis[0] + normals[i][1] * meshlet->coneAxis[1] + normals[i][2] * meshlet->coneAxis[2];
+		min_dot = d < min_dot ? d : min_dot;
+	}
+
+	// A cone of 90 degrees or more always has some front-facing triangle, keep culling disabled
+	if (min_dot > 0.0f)
+		meshlet->coneCutoff = sqrtf(1.0f - min_dot * min_dot);
+}
+
+static void meshlet_finish(WC_MeshletData* out, WC_GpuMeshlet* current, uint8_t* local, const float* positions,
+						   const uint32_t vertex_stride)
+{
+	for (uint32_t i = 0; i < current->vertexCount; i++)
+	{
+		local[out->vertices[current->vertexOffset + i]] = MESHLET_NO_LOCAL;
+	}
+
+	meshlet_compute_bounds(current, out, positions, vertex_stride);
+	out->meshlets[out->meshletCount++] = *current;
+
+	// Pad so the next meshlet's triangles start on a 32-bit word the shader can load directly
+	uint32_t triangle_bytes = current->triangleCount * 3;
+	while (triangle_bytes & 3)
+	{
+		out->triangles[current->triangleOffset + triangle_bytes++] = 0;
+	}
+
+	out->vertexCount += current->vertexCount;
+	out->triangleByteCount += triangle_bytes;
+
+	*current = (WC_GpuMeshlet){.vertexOffset = out->vertexCount, .triangleOffset = out->triangleByteCount};
+}
+
+typedef struct
+{
+	uint32_t* live;
+	uint32_t* offsets;
+	uint32_t* fill;
+	uint32_t* adjacency;
+	uint8_t* emitted;
+	uint8_t* local;
+} MeshletScratch;
+
+static void meshlet_free_scratch(const MeshletScratch* scratch)
+{
+	wc_free(scratch->local);
+	wc_free(scratch->emitted);
+	wc_free(scratch->adjacency);
+	wc_free(scratch->fill);
+	wc_free(scratch->offsets);
+	wc_free(scratch->live);
+}
+
+int wc_meshlet_build(WC_MeshletData* out, const float* positions, const uint32_t vertex_count, const uint32_t vertex_stride,
+					 const uint32_t* indices, const uint32_t index_count)
+{
+	SDL_memset(out, 0, sizeof(*out));
+	if (index_count % 3 != 0)
+		return -1;
+
+	const uint32_t triangle_count = index_count / 3;
+	if (triangle_count == 0)
+		return 0;
+
+	// Vertex -> triangle adjacency in CSR form, plus the number of unemitted triangles per vertex
+	const MeshletScratch scratch = {
+		.live = wc_calloc(vertex_count, sizeof(uint32_t)),
+		.offsets = wc_malloc((vertex_count + 1) * sizeof(uint32_t)),
+		.fill = wc_malloc(vertex_count * sizeof(uint32_t)),
+		.adjacency = wc_malloc(index_count * sizeof(uint32_t)),
+		.emitted = wc_calloc(triangle_count, sizeof(uint8_t)),
+		.local = wc_malloc(vertex_count),
+	};
+	uint32_t* live = scratch.live;
+	uint32_t* offsets = scratch.offsets;
+	uint32_t* fill = scratch.fill;
+	uint32_t* adjacency = scratch.adjacency;
+	uint8_t* emitted = scratch.emitted;
+	uint8_t* local = scratch.local;
+	if (!live || !offsets || !fill || !adjacency || !emitted || !local)
+	{
+		meshlet_free_scratch(&scratch);
+		return -1;
+	}
+
+	for (uint32_t i = 0; i < index_count; i++)
+	{
+		if (indices[i] >= vertex_count)
+		{
+			meshlet_free_scratch(&scratch);
+			return -1;
+		}
+		live[indices[i]]++;
+	}
+	offsets[0] = 0;
+	for (uint32_t v = 0; v < vertex_count; v++)
+	{
+		offsets[v + 1] = offsets[v] + live[v];
+		fill[v] = offsets[v];
+	}
+	for (uint32_t i = 0; i < index_count; i++)
+	{
+		adjacency[fill[indices[i]]++] = i / 3;
+	}
+	SDL_memset(local, MESHLET_NO_LOCAL, vertex_count);
+
+	// A meshlet only closes on the vertex limit once it holds at least a third as many triangles
+	const uint32_t max_meshlets = triangle_count / (WC_MESHLET_MAX_VERTICES / 3) + 1;
+	out->meshlets = wc_malloc(max_meshlets * sizeof(WC_GpuMeshlet));
+	out->vertices = wc_malloc(index_count * sizeof(uint32_t));
+	out->triangles = wc_malloc(index_count + max_meshlets * 3);
+	if (!out->meshlets || !out->vertices || !out->triangles)
+	{
+		meshlet_free_scratch(&scratch);
+		wc_meshlet_free(out);
+		return -1;
+	}
+
+	WC_GpuMeshlet current = {0};
+	uint32_t cursor = 0;
+
+	for (uint32_t emitted_count = 0; emitted_count < triangle_count; emitted_count++)
+	{
+		// Grow around the vertices already in the meshlet; restart from the first unemitted triangle when isolated
+		uint32_t best = meshlet_best_candidate(out->vertices + current.vertexOffset, current.vertexCount, offsets, adjacency, live,
+											   emitted, local, indices);
+		if (best == UINT32_MAX)
+		{
+			while (emitted[cursor])
+				cursor++;
+			best = cursor;
+		}
+
+		if (current.vertexCount + meshlet_new_vertices(local, indices, best) > WC_MESHLET_MAX_VERTICES ||
+			current.triangleCount >= WC_MESHLET_MAX_TRIANGLES)
+		{
+			meshlet_finish(out, &current, local, positions, vertex_stride);
+		}
+
+		for (int k = 0; k < 3; k++)
+		{
+			const uint32_t vertex = indices[best * 3 + k];
+			if (local[vertex] == MESHLET_NO_LOCAL)
+			{
+				local[vertex] = (uint8_t)current.vertexCount;
+				out->vertices[current.vertexOffset + current.vertexCount++] = vertex;
+			}
+			out->triangles[current.triangleOffset + current.triangleCount * 3 + k] = local[vertex];
+			live[vertex]--;
+		}
+		current.triangleCount++;
+		emitted[best] = 1;
+	}
+
+	if (current.triangleCount > 0)
+		meshlet_finish(out, &current, local, positions, vertex_stride);
+
+	meshlet_free_scratch(&scratch);
+	return 0;
+}
+
+void wc_meshlet_free(WC_MeshletData* data)
+{
+	wc_free(data->triangles);
+	wc_free(data->vertices);
+	wc_free(data->meshlets);
+	SDL_memset(data, 0, sizeof(*data));
+}
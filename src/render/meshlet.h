@@ -0,0 +1,39 @@
+#pragma once
+
+#include <stdint.h>
+
+// Limits chosen for NVIDIA/AMD mesh shader sweet spots; must match the task/mesh shaders
+#define WC_MESHLET_MAX_VERTICES 64
+#define WC_MESHLET_MAX_TRIANGLES 124
+
+// Meshlet header as stored in the meshlet SSBO (std430 compatible, 48 bytes)
+typedef struct WC_GpuMeshlet
+{
+	uint32_t vertexOffset;   // First entry in the meshlet vertex buffer
+	uint32_t triangleOffset; // Byte offset in the meshlet triangle buffer, 4-byte aligned
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+	float boundingSphere[4]; // xyz center, w radius (mesh space)
+	float coneAxis[3];       // Average triangle normal
+	float coneCutoff;        // sin of the cone half-angle; 1 disables backface cluster culling
+} WC_GpuMeshlet;
+
+typedef struct WC_MeshletData
+{
+	WC_GpuMeshlet* meshlets;
+	uint32_t meshletCount;
+
+	// Mesh vertex indices referenced by each meshlet
+	uint32_t* vertices;
+	uint32_t vertexCount;
+
+	// Three meshlet-local vertex indices per triangle, each meshlet padded to 4 bytes
+	uint8_t* triangles;
+	uint32_t triangleByteCount;
+} WC_MeshletData;
+
+// Splits an indexed triangle list into meshlets, greedily growing each one with the triangle that
+// adds the fewest new vertices. positions points at the first vertex position, vertex_stride is in bytes.
+int wc_meshlet_build(WC_MeshletData* out, const float* positions, uint32_t vertex_count, uint32_t vertex_stride,
+					 const uint32_t* indices, uint32_t index_count);
+void wc_meshlet_free(WC_MeshletData* data);
@@ -0,0 +1,279 @@
+#include "pipeline.h"
+
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL.h>
+
+#define WC_PIPELINE_CACHE_MAGIC 0x43504357 // "WCPC"
+#define WC_PIPELINE_CACHE_VERSION 1
+
+typedef enum
+{
+	PIPELINE_STATE_IDLE = 0,
+	PIPELINE_STATE_COMPILING,
+	PIPELINE_STATE_READY,
+	PIPELINE_STATE_FAILED
+} PipelineState;
+
+typedef struct
+{
+	const char* name;
+	WC_PipelineCreateFunc create;
+	void* user_data;
+	uint32_t fallback;
+	VkPipeline pipeline;
+	JobHandle job;
+	SDL_AtomicInt state;
+} PipelineEntry;
+
+// Written in front of the driver blob so stale caches from another GPU/driver are rejected before
+// the driver sees them; some drivers do not validate their own header robustly
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vendorID;
+	uint32_t deviceID;
+	uint32_t driverVersion;
+	uint8_t uuid[VK_UUID_SIZE];
+	uint64_t dataSize;
+} PipelineCacheHeader;
+
+typedef struct
+{
+	VkDevice device;
+	VkPipelineCache cache;
+	PipelineCacheHeader header;
+	char path[512];
+
+	PipelineEntry entries[WC_MAX_PIPELINES];
+	uint32_t count;
+} PipelineManager;
+
+static PipelineManager s_pipelines;
+
+static void pipeline_compile_job(void* data)
+{
+	PipelineEntry* entry = data;
+	const uint64_t begin = SDL_GetPerformanceCounter();
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	const VkResult result = entry->create(s_pipelines.device, s_pipelines.cache, entry->user_data, &pipeline);
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Pipeline '%s' failed to compile (%d)\n", entry->name, result);
+		SDL_SetAtomicInt(&entry->state, PIPELINE_STATE_FAILED);
+		return;
+	}
+
+	entry->pipeline = pipeline;
+	// Publishing the state last makes the handle visible to readers that observe READY
+	SDL_SetAtomicInt(&entry->state, PIPELINE_STATE_READY);
+
+	const double ms = (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+	SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Pipeline '%s' compiled in %.2f ms\n", entry->name, ms);
+}
+
+static void pipeline_request(PipelineEntry* entry)
+{
+	if (!SDL_CompareAndSwapAtomicInt(&entry->state, PIPELINE_STATE_IDLE, PIPELINE_STATE_COMPILING))
+		return;
+
+	entry->job = job_create_with_flags(pipeline_compile_job, entry, JOB_FLAG_LARGE_STACK);
+	if (entry->job.value == INVALID_JOB_HANDLE.value)
+	{
+		// Job pool exhausted, compile inline rather than dropping the request
+		pipeline_compile_job(entry);
+		return;
+	}
+	job_run(entry->job);
+}
+
+static void pipeline_wait(PipelineEntry* entry)
+{
+	pipeline_request(entry);
+	while (SDL_GetAtomicInt(&entry->state) == PIPELINE_STATE_COMPILING)
+	{
+		job_wait(entry->job);
+	}
+}
+
+int wc_pipeline_init(VkPhysicalDevice physical_device, VkDevice device, const char* directory)
+{
+	SDL_memset(&s_pipelines, 0, sizeof(s_pipelines));
+	s_pipelines.device = device;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical_device, &properties);
+
+	PipelineCacheHeader* header = &s_pipelines.header;
+	header->magic = WC_PIPELINE_CACHE_MAGIC;
+	header->version = WC_PIPELINE_CACHE_VERSION;
+	header->vendorID = properties.vendorID;
+	header->deviceID = properties.deviceID;
+	header->driverVersion = properties.driverVersion;
+	SDL_memcpy(header->uuid, properties.pipelineCacheUUID, VK_UUID_SIZE);
+
+	char uuid[VK_UUID_SIZE * 2 + 1];
+	for (int i = 0; i < VK_UUID_SIZE; i++)
+	{
+		SDL_snprintf(&uuid[i * 2], 3, "%02x", properties.pipelineCacheUUID[i]);
+	}
+	SDL_snprintf(s_pipelines.path, sizeof(s_pipelines.path), "%spipelines_%s.bin", directory, uuid);
+
+	size_t file_size = 0;
+	uint8_t* file = SDL_LoadFile(s_pipelines.path, &file_size);
+
+	const void* initial_data = NULL;
+	size_t initial_size = 0;
+	if (file && file_size >= sizeof(PipelineCacheHeader))
+	{
+		const PipelineCacheHeader* stored = (const PipelineCacheHeader*)file;
+		if (stored->magic == header->magic && stored->version == header->version && stored->vendorID == header->vendorID &&
+			stored->deviceID == header->deviceID && stored->driverVersion == header->driverVersion &&
+			SDL_memcmp(stored->uuid, header->uuid, VK_UUID_SIZE) == 0 && stored->dataSize == file_size - sizeof(PipelineCacheHeader))
+		{
+			initial_data = file + sizeof(PipelineCacheHeader);
+			initial_size = stored->dataSize;
+		}
+		else
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Ignoring stale pipeline cache %s\n", s_pipelines.path);
+		}
+	}
+
+	VkPipelineCacheCreateInfo cacheInfo = {.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	cacheInfo.initialDataSize = initial_size;
+	cacheInfo.pInitialData = initial_data;
+	VkResult result = vkCreatePipelineCache(device, &cacheInfo, NULL, &s_pipelines.cache);
+	if (result != VK_SUCCESS && initial_data)
+	{
+		// Driver rejected the blob, start from an empty cache
+		cacheInfo.initialDataSize = 0;
+		cacheInfo.pInitialData = NULL;
+		result = vkCreatePipelineCache(device, &cacheInfo, NULL, &s_pipelines.cache);
+	}
+	SDL_free(file);
+
+	if (result != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create pipeline cache\n");
+		return EXIT_FAILURE;
+	}
+
+	SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Pipeline cache %s: %zu bytes loaded\n", s_pipelines.path, initial_size);
+	return EXIT_SUCCESS;
+}
+
+static void pipeline_save_cache(void)
+{
+	size_t data_size = 0;
+	if (vkGetPipelineCacheData(s_pipelines.device, s_pipelines.cache, &data_size, NULL) != VK_SUCCESS || data_size == 0)
+		return;
+
+	uint8_t* file = wc_malloc(sizeof(PipelineCacheHeader) + data_size);
+	if (vkGetPipelineCacheData(s_pipelines.device, s_pipelines.cache, &data_size, file + sizeof(PipelineCacheHeader)) == VK_SUCCESS)
+	{
+		PipelineCacheHeader header = s_pipelines.header;
+		header.dataSize = data_size;
+		SDL_memcpy(file, &header, sizeof(header));
+
+		// Write next to the real file and swap, so a crash mid-write never leaves a truncated cache
+		char temp_path[sizeof(s_pipelines.path) + 4];
+		SDL_snprintf(temp_path, sizeof(temp_path), "%s.tmp", s_pipelines.path);
+		if (!SDL_SaveFile(temp_path, file, sizeof(PipelineCacheHeader) + data_size) || !SDL_RenamePath(temp_path, s_pipelines.path))
+		{
+			SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to save pipeline cache %s: %s\n", s_pipelines.path, SDL_GetError());
+		}
+	}
+	wc_free(file);
+}
+
+void wc_pipeline_quit(void)
+{
+	wc_pipeline_wait_all();
+	pipeline_save_cache();
+
+	for (uint32_t i = 0; i < s_pipelines.count; i++)
+	{
+		if (s_pipelines.entries[i].pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(s_pipelines.device, s_pipelines.entries[i].pipeline, NULL);
+	}
+	vkDestroyPipelineCache(s_pipelines.device, s_pipelines.cache, NULL);
+	SDL_memset(&s_pipelines, 0, sizeof(s_pipelines));
+}
+
+uint32_t wc_pipeline_register(const char* name, const WC_PipelineCreateFunc create, void* user_data, const uint32_t fallback)
+{
+	if (s_pipelines.count >= WC_MAX_PIPELINES)
+		return WC_PIPELINE_NONE;
+
+	const uint32_t handle = s_pipelines.count++;
+	PipelineEntry* entry = &s_pipelines.entries[handle];
+	entry->name = name;
+	entry->create = create;
+	entry->user_data = user_data;
+	entry->fallback = fallback;
+	entry->pipeline = VK_NULL_HANDLE;
+	entry->job = INVALID_JOB_HANDLE;
+	SDL_SetAtomicInt(&entry->state, PIPELINE_STATE_IDLE);
+	return handle;
+}
+
+void wc_pipeline_compile_all(void)
+{
+	for (uint32_t i = 0; i < s_pipelines.count; i++)
+	{
+		pipeline_request(&s_pipelines.entries[i]);
+	}
+}
+
+void wc_pipeline_wait_all(void)
+{
+	for (uint32_t i = 0; i < s_pipelines.count; i++)
+	{
+		PipelineEntry* entry = &s_pipelines.entries[i];
+		while (SDL_GetAtomicInt(&entry->state) == PIPELINE_STATE_COMPILING)
+		{
+			job_wait(entry->job);
+		}
+	}
+}
+
+void wc_pipeline_rebuild_all(void)
+{
+	wc_pipeline_wait_all();
+	for (uint32_t i = 0; i < s_pipelines.count; i++)
+	{
+		PipelineEntry* entry = &s_pipelines.entries[i];
+		if (entry->pipeline != VK_NULL_HANDLE)
+			vkDestroyPipeline(s_pipelines.device, entry->pipeline, NULL);
+		entry->pipeline = VK_NULL_HANDLE;
+		SDL_SetAtomicInt(&entry->state, PIPELINE_STATE_IDLE);
+	}
+	wc_pipeline_compile_all();
+}
+
+VkPipeline wc_pipeline_get(const uint32_t handle)
+{
+	if (handle >= s_pipelines.count)
+		return VK_NULL_HANDLE;
+
+	PipelineEntry* entry = &s_pipelines.entries[handle];
+	const int state = SDL_GetAtomicInt(&entry->state);
+	if (WAR_LIKELY(state == PIPELINE_STATE_READY))
+		return entry->pipeline;
+	if (state == PIPELINE_STATE_FAILED)
+		return entry->fallback != WC_PIPELINE_NONE ? wc_pipeline_get(entry->fallback) : VK_NULL_HANDLE;
+
+	if (entry->fallback != WC_PIPELINE_NONE)
+	{
+		pipeline_request(entry);
+		return wc_pipeline_get(entry->fallback);
+	}
+
+	// Nothing to draw with in the meantime, so this first use has to wait
+	pipeline_wait(entry);
+	return SDL_GetAtomicInt(&entry->state) == PIPELINE_STATE_READY ? entry->pipeline : VK_NULL_HANDLE;
+}
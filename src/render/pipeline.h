@@ -0,0 +1,30 @@
+#pragma once
+
+#include <volk.h>
+
+#define WC_MAX_PIPELINES 256
+#define WC_PIPELINE_NONE UINT32_MAX
+
+// Builds one pipeline against the shared cache. Runs on a job worker, so it must only touch
+// thread-safe Vulkan entry points and its own user data.
+typedef VkResult (*WC_PipelineCreateFunc)(VkDevice device, VkPipelineCache cache, void* user_data, VkPipeline* pipeline);
+
+// Loads the on-disk cache for this driver (file name keyed by pipelineCacheUUID) from directory.
+int wc_pipeline_init(VkPhysicalDevice physical_device, VkDevice device, const char* directory);
+// Waits for in-flight compiles, writes the cache back to disk and destroys all pipelines.
+void wc_pipeline_quit(void);
+
+// Registers a pipeline without compiling it. While it is not ready, wc_pipeline_get returns the
+// fallback pipeline instead (WC_PIPELINE_NONE blocks until the pipeline itself is built).
+uint32_t wc_pipeline_register(const char* name, WC_PipelineCreateFunc create, void* user_data, uint32_t fallback);
+
+// Starts compiling every registered pipeline that has not been requested yet, one job each.
+void wc_pipeline_compile_all(void);
+void wc_pipeline_wait_all(void);
+// Destroys every pipeline and compiles them again, e.g. after shader modules were reloaded.
+// The GPU must be done with the old pipelines.
+void wc_pipeline_rebuild_all(void);
+
+// Returns the pipeline if built, otherwise kicks off its compile job and returns the fallback.
+// VK_NULL_HANDLE when the pipeline failed to compile and has no usable fallback.
+VkPipeline wc_pipeline_get(uint32_t handle);
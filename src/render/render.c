@@ -1,9 +1,17 @@
 #include "render.h"
 
 #include "../system/app.h"
+#include "../system/image.h"
 #include "../system/memory.h"
+#include "../system/profiler.h"
 #include "allocator.h"
+#include "buffer.h"
+#include "gpu_profiler.h"
+#include "pipeline.h"
+#include "render_graph.h"
 #include "resource.h"
+#include "shader.h"
+#include "texture.h"
 
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
@@ -22,6 +30,15 @@ typedef struct
 	uint32_t pad;
 } WC_GpuSceneData;
 
+// Push constants shared by the visibility task and mesh shaders
+typedef struct
+{
+	float viewProjMatrix[16];
+	float cameraPosition[4];
+	uint32_t instanceOffset;
+	uint32_t instanceCount;
+} WC_GpuDrawConstants;
+
 typedef struct
 {
 	// Render passes
@@ -95,25 +112,81 @@ static VkExtent2D swapchainExtent;
 static uint32_t swapchainImageCount;
 static VkImage* swapchainImages;
 static VkImageView* swapchainImageViews;
-static VkRenderPass renderPass;
-static VkFramebuffer* swapchainFramebuffers;
+
+// Render graph: rebuilt with the swapchain since transient sizes follow its extent
+#define WC_DEPTH_FORMAT VK_FORMAT_D32_SFLOAT
+// Instance index and meshlet/triangle IDs per pixel, see visibility.frag.glsl
+#define WC_VISIBILITY_FORMAT VK_FORMAT_R32G32_UINT
+// Resolve output; swapchain images cannot be storage images, so it is blitted to the backbuffer
+#define WC_RESOLVE_FORMAT VK_FORMAT_R16G16B16A16_SFLOAT
+#define WC_RESOLVE_GROUP_SIZE 8
+static uint32_t s_graph_backbuffer = WC_GRAPH_NONE;
+static uint32_t s_graph_visibility = WC_GRAPH_NONE;
+static uint32_t s_graph_color = WC_GRAPH_NONE;
 
 // Commands
 static VkCommandPool commandPool;
-static VkCommandBuffer* commandBuffers;
-
-// Descriptor and pipeline
-VkDescriptorSetLayout descriptorSetLayout;
-VkDescriptorPool descriptorPool;
-VkDescriptorSet descriptorSet;
+static VkCommandBuffer commandBuffers[WC_FRAMES_IN_FLIGHT];
+
+// Frame pacing: acquire semaphores and fences belong to a frame in flight, render-finished
+// semaphores to a swapchain image since presentation holds them until that image is reacquired
+static VkSemaphore s_image_available[WC_FRAMES_IN_FLIGHT];
+static VkFence s_frame_fences[WC_FRAMES_IN_FLIGHT];
+static VkSemaphore* s_render_finished;
+static uint32_t s_frame_slot;
+static uint64_t s_frame_count;
+
+// Swapchain recreation hands the old swapchain to the new one and keeps it, with its views and
+// semaphores, until every frame that may still use it has completed
+#define WC_MAX_RETIRED_SWAPCHAINS 4
+typedef struct WC_RetiredSwapchain
+{
+	VkSwapchainKHR swapchain;
+	VkImage* images;
+	VkImageView* imageViews;
+	VkSemaphore* renderFinished;
+	uint32_t imageCount;
+	uint64_t frame;
+} WC_RetiredSwapchain;
+static WC_RetiredSwapchain s_retired_swapchains[WC_MAX_RETIRED_SWAPCHAINS];
+static uint32_t s_retired_swapchain_count;
+static bool s_swapchain_dirty;
+static VkPresentModeKHR s_requested_present_mode = VK_PRESENT_MODE_FIFO_KHR;
+
+// Present-wait latency limiting (VK_KHR_present_id + VK_KHR_present_wait): with a limit of N the
+// CPU does not start a frame until the present N frames back is on screen. 0 disables it.
+#define WC_PRESENT_WAIT_TIMEOUT_NS 100000000ull
+static bool s_present_wait;
+static uint32_t s_frame_latency;
+static uint64_t s_present_id;
+
+// Offscreen mode: a single VMA image stands in for the swapchain and frames are read back on demand
+static bool s_offscreen;
+
+// Optional profiling support, detected at device creation
+static bool s_calibrated_timestamps;
+static bool s_pipeline_statistics;
+static bool s_mesh_shader_queries;
+// VK_EXT_memory_budget: VMA reports the driver's per-heap budget instead of estimating it
+static bool s_memory_budget;
+static VmaAllocation s_offscreen_allocation;
+static WC_Buffer s_readback;
+static VkFence s_offscreen_fence;
+static uint64_t s_offscreen_frames;
+
+// Pipeline
 VkPipelineLayout pipelineLayout;
-VkPipeline meshPipeline;
-
-// Buffers
-VkBuffer transformBuffer;
-VmaAllocation transformAlloc;
-VkBuffer visibilityBuffer;
-VmaAllocation visibilityAlloc;
+static uint32_t s_visibility_pipeline = WC_PIPELINE_NONE;
+static WC_GpuDrawConstants s_draw_constants;
+static uint32_t s_visibility_shaders[3] = {WC_SHADER_NONE, WC_SHADER_NONE, WC_SHADER_NONE};
+static uint32_t s_resolve_shader = WC_SHADER_NONE;
+static VkPipelineLayout s_resolve_layout;
+static uint32_t s_resolve_pipeline = WC_PIPELINE_NONE;
+// Shader hot reload polls source modification times at this interval
+#define WC_SHADER_RELOAD_INTERVAL_MS 250
+// maxTaskWorkGroupCount[1] guaranteed by VK_EXT_mesh_shader
+#define WC_MAX_DRAW_INSTANCES 65535u
+static uint64_t s_shader_reload_poll;
 
 const char* s_validation_layers[] = {"VK_LAYER_KHRONOS_validation"};
 #ifdef NDEBUG
@@ -122,7 +195,7 @@ const int s_enable_validation = 0;
 const int s_enable_validation = 1;
 #endif
 
-// Required device extensions
+// Required device extensions; the swapchain must stay first so offscreen mode can skip it
 const char* s_device_extensions[] = {VK_KHR_SWAPCHAIN_EXTENSION_NAME, VK_EXT_MESH_SHADER_EXTENSION_NAME,
 									 VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_KHR_BUFFER_DEVICE_ADDRESS_EXTENSION_NAME,
 									 VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME};
@@ -133,23 +206,19 @@ int createSurface(void);
 int pickPhysicalDevice(void);
 int createLogicalDevice(void);
 
-int createSwapchain(void);
+int createSwapchain(VkSwapchainKHR oldSwapchain);
+int createOffscreenTarget(uint32_t width, uint32_t height);
 int createImageViews(void);
-int createRenderPass(void);
-int createFramebuffers(void);
+static int buildRenderGraph(void);
+int createFrameSync(void);
+static int createRenderFinishedSemaphores(void);
 
-void createDescriptorSetLayout(void);
-void createDescriptorPool(void);
-void createDescriptorSet(void);
-void createPipeline(void);
-void updateDescriptorSet(void);
+static int createPipelineLayouts(VkPipelineLayout* visibility, VkPipelineLayout* resolve);
+int createPipeline(void);
 
 int createCommandPool(void);
 int createCommandBuffers(void);
-
-int createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VkBuffer* buffer,
-				 VmaAllocation* allocation);
-VkShaderModule loadShaderModule(VkDevice device, const char* filepath);
+static void recordCommandBuffer(uint32_t slot, uint32_t imageIndex);
 
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
 													VkDebugUtilsMessageTypeFlagsEXT messageType,
@@ -159,11 +228,17 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityF
 	return VK_FALSE;
 }
 
-int wc_render_init(void)
+static const char* const* getDeviceExtensions(uint32_t* count)
 {
-	int window_width, window_height;
-	wc_app_get_window_size(&window_width, &window_height);
+	const uint32_t skip = s_offscreen ? 1 : 0;
+	*count = sizeof(s_device_extensions) / sizeof(*s_device_extensions) - skip;
+	return s_device_extensions + skip;
+}
 
+// Everything that needs only the device: the window surface is made here because device
+// selection checks present support, the swapchain itself waits for initTargets
+static int initDevice(void)
+{
 	if (volkInitialize() != VK_SUCCESS)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize volk\n");
@@ -173,8 +248,10 @@ int wc_render_init(void)
 	createInstance();
 	volkLoadInstance(s_instance);
 	setupDebugMessenger();
-	createSurface();
-	pickPhysicalDevice();
+	if (!s_offscreen)
+		createSurface();
+	if (pickPhysicalDevice() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
 	createLogicalDevice();
 	volkLoadDevice(device);
 
@@ -183,75 +260,449 @@ int wc_render_init(void)
 	allocator_create_info.device = device;
 	allocator_create_info.instance = s_instance;
 	allocator_create_info.vulkanApiVersion = VK_API_VERSION_1_4;
+	if (s_memory_budget)
+		allocator_create_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
 	if (vmaCreateAllocator(&allocator_create_info, &allocator) != VK_SUCCESS)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create Vulkan memory allocator\n");
 		return EXIT_FAILURE;
 	}
 
-	createSwapchain();
-	createImageViews();
-	createRenderPass();
-	createFramebuffers();
+	if (wc_buffer_init(device, allocator, graphicsQueue, graphicsQueueFamilyIndex) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (wc_gpu_resource_init(device, allocator) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create bindless GPU resources\n");
+		return EXIT_FAILURE;
+	}
+	if (wc_texture_init(device, allocator, graphicsQueue, graphicsQueueFamilyIndex, WC_TEXTURE_DEFAULT_BUDGET) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	char shaderCacheDir[512];
+	SDL_snprintf(shaderCacheDir, sizeof(shaderCacheDir), "%sshadercache/", SDL_GetBasePath());
+	if (wc_shader_init(device, WC_SHADER_SOURCE_DIR, shaderCacheDir) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	if (wc_pipeline_init(physicalDevice, device, SDL_GetBasePath()) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	if (createFrameSync() != EXIT_SUCCESS || createCommandPool() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	// One query range per frame in flight, matching the command buffers
+	if (wc_gpu_profiler_init(physicalDevice, device, graphicsQueueFamilyIndex, WC_FRAMES_IN_FLIGHT, s_calibrated_timestamps,
+							 s_pipeline_statistics, s_mesh_shader_queries) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	return createCommandBuffers();
+}
+
+// Swapchain or offscreen target and the graph built around it
+static int initTargets(const uint32_t width, const uint32_t height)
+{
+	if (s_offscreen)
+	{
+		if (createOffscreenTarget(width, height) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+	else
+	{
+		if (createSwapchain(VK_NULL_HANDLE) != EXIT_SUCCESS || createRenderFinishedSemaphores() != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+	if (createImageViews() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+
+	wc_graph_init(device, allocator);
+	if (buildRenderGraph() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	wc_buffer_log_budget();
+	return EXIT_SUCCESS;
+}
+
+static int initRenderer(const uint32_t width, const uint32_t height)
+{
+	if (initDevice() != EXIT_SUCCESS || initTargets(width, height) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	return wc_render_init_pipelines();
+}
+
+static VkPresentModeKHR parsePresentMode(const char* value)
+{
+	if (SDL_strcasecmp(value, "mailbox") == 0)
+		return VK_PRESENT_MODE_MAILBOX_KHR;
+	if (SDL_strcasecmp(value, "immediate") == 0 || SDL_strcmp(value, "false") == 0 || SDL_strcmp(value, "0") == 0)
+		return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	return VK_PRESENT_MODE_FIFO_KHR;
+}
+
+int wc_render_init(void)
+{
+	if (wc_render_init_device() != EXIT_SUCCESS || wc_render_init_swapchain() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	return wc_render_init_pipelines();
+}
+
+int wc_render_init_device(void)
+{
+	// vsync = true/fifo, mailbox or false/immediate; frame_latency = present-wait limit, 0 for off
+	const wc_config* config = wc_app_get_config();
+	s_requested_present_mode = parsePresentMode(wc_config_get_str(config, "vsync", "fifo"));
+	s_frame_latency = (uint32_t)SDL_max(wc_config_get_int(config, "frame_latency", 0), 0);
+
+	s_offscreen = false;
+	return initDevice();
+}
+
+int wc_render_init_swapchain(void)
+{
+	int window_width, window_height;
+	wc_app_get_window_size(&window_width, &window_height);
+	return initTargets((uint32_t)window_width, (uint32_t)window_height);
+}
+
+// Only creates layouts and pipelines, which Vulkan allows from any thread while the main thread
+// builds the swapchain; waits for the compiles so startup timing covers them
+int wc_render_init_pipelines(void)
+{
+	if (createPipeline() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	wc_pipeline_wait_all();
+	return EXIT_SUCCESS;
+}
+
+int wc_render_init_offscreen(const uint32_t width, const uint32_t height)
+{
+	s_offscreen = true;
+	return initRenderer(width, height);
+}
+
+// Development hot reload: a stall is acceptable, so the device is drained before pipelines are
+// rebuilt from the new modules; command buffers pick them up when next recorded
+static void reloadShaders(void)
+{
+	const uint64_t now = SDL_GetTicks();
+	if (now - s_shader_reload_poll < WC_SHADER_RELOAD_INTERVAL_MS)
+		return;
+	s_shader_reload_poll = now;
+	if (!wc_shader_has_changes())
+		return;
+
+	vkDeviceWaitIdle(device);
+	wc_pipeline_wait_all();
+	if (wc_shader_reload_changed() == 0)
+		return;
+
+	// An edit may have changed a binding or the push constant block, so the layouts follow the new
+	// reflection. On failure the old pipelines and layouts stay in use.
+	VkPipelineLayout visibilityLayout;
+	VkPipelineLayout resolveLayout;
+	if (createPipelineLayouts(&visibilityLayout, &resolveLayout) != EXIT_SUCCESS)
+		return;
+	wc_shader_destroy_pipeline_layout(pipelineLayout);
+	wc_shader_destroy_pipeline_layout(s_resolve_layout);
+	pipelineLayout = visibilityLayout;
+	s_resolve_layout = resolveLayout;
+
+	wc_pipeline_rebuild_all();
+	wc_pipeline_wait_all();
+}
+
+void wc_render_set_camera(const float view_proj[16], const float position[3])
+{
+	SDL_memcpy(s_draw_constants.viewProjMatrix, view_proj, sizeof(s_draw_constants.viewProjMatrix));
+	s_draw_constants.cameraPosition[0] = position[0];
+	s_draw_constants.cameraPosition[1] = position[1];
+	s_draw_constants.cameraPosition[2] = position[2];
+	s_draw_constants.cameraPosition[3] = 1.0f;
+}
+
+void wc_render_set_present_mode(const WC_PresentMode mode)
+{
+	static const VkPresentModeKHR modes[] = {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_MAILBOX_KHR,
+											 VK_PRESENT_MODE_IMMEDIATE_KHR};
+	if (s_requested_present_mode == modes[mode])
+		return;
+	s_requested_present_mode = modes[mode];
+	s_swapchain_dirty = true;
+}
+
+static void destroySwapchainResources(const WC_RetiredSwapchain* retired)
+{
+	for (uint32_t i = 0; i < retired->imageCount; i++)
+	{
+		vkDestroyImageView(device, retired->imageViews[i], NULL);
+		vkDestroySemaphore(device, retired->renderFinished[i], NULL);
+	}
+	vkDestroySwapchainKHR(device, retired->swapchain, NULL);
+	wc_free(retired->imageViews);
+	wc_free(retired->renderFinished);
+	wc_free(retired->images);
+}
+
+// Presentation has no fence of its own, so a retired swapchain is released once WC_FRAMES_IN_FLIGHT
+// further frames have been fenced; by then its last present has long been consumed
+static void releaseRetiredSwapchains(const bool all)
+{
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < s_retired_swapchain_count; i++)
+	{
+		if (all || s_retired_swapchains[i].frame + WC_FRAMES_IN_FLIGHT <= s_frame_count)
+			destroySwapchainResources(&s_retired_swapchains[i]);
+		else
+			s_retired_swapchains[kept++] = s_retired_swapchains[i];
+	}
+	s_retired_swapchain_count = kept;
+	if (all || s_frame_count >= WC_FRAMES_IN_FLIGHT)
+		wc_graph_release(all ? UINT64_MAX : s_frame_count - WC_FRAMES_IN_FLIGHT);
+}
+
+// No vkDeviceWaitIdle: frames in flight keep rendering to the old images while the new swapchain
+// is built from them via oldSwapchain
+static int recreateSwapchain(void)
+{
+	int width, height;
+	SDL_GetWindowSizeInPixels(wc_app_get_window_handle(), &width, &height);
+	if (width == 0 || height == 0)
+		return EXIT_FAILURE; // Minimized: stay dirty and try again next frame
+
+	if (s_retired_swapchain_count == WC_MAX_RETIRED_SWAPCHAINS)
+	{
+		// Resized faster than frames retire; fence everything rather than grow the list
+		vkWaitForFences(device, WC_FRAMES_IN_FLIGHT, s_frame_fences, VK_TRUE, UINT64_MAX);
+		releaseRetiredSwapchains(true);
+	}
 
-	createDescriptorSetLayout();
-	createPipeline();
-	createDescriptorPool();
-	createDescriptorSet();
-	updateDescriptorSet();
+	WC_RetiredSwapchain* retired = &s_retired_swapchains[s_retired_swapchain_count++];
+	retired->swapchain = swapchain;
+	retired->images = swapchainImages;
+	retired->imageViews = swapchainImageViews;
+	retired->renderFinished = s_render_finished;
+	retired->imageCount = swapchainImageCount;
+	retired->frame = s_frame_count;
+
+	wc_graph_reset(s_frame_count);
+	if (createSwapchain(retired->swapchain) != EXIT_SUCCESS || createImageViews() != EXIT_SUCCESS ||
+		createRenderFinishedSemaphores() != EXIT_SUCCESS || buildRenderGraph() != EXIT_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Swapchain recreation failed\n");
+		return EXIT_FAILURE;
+	}
+	s_swapchain_dirty = false;
+	return EXIT_SUCCESS;
+}
 
-	createCommandPool();
-	createCommandBuffers();
+// Frames handed to the GPU so far. Resources retire by this count rather than by draw calls,
+// which return early without submitting while the swapchain is out of date.
+static uint64_t submittedFrames(void)
+{
+	return s_offscreen ? s_offscreen_frames : s_frame_count;
+}
 
-	return 0;
+// Caps queued frames at the configured latency so input is sampled as late as possible
+static void waitForPresent(void)
+{
+	if (!s_present_wait || s_frame_latency == 0 || s_present_id < s_frame_latency)
+		return;
+	const VkResult result = vkWaitForPresentKHR(device, swapchain, s_present_id - s_frame_latency + 1, WC_PRESENT_WAIT_TIMEOUT_NS);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		s_swapchain_dirty = true;
 }
 
 void wc_render_draw(void)
 {
+	reloadShaders();
+	wc_gpu_profiler_collect();
+	wc_gpu_resource_begin_frame(submittedFrames());
+	wc_texture_update(submittedFrames());
+	wc_buffer_submit_uploads();
+	wc_gpu_resource_flush_descriptors();
+
+	if (s_offscreen)
+	{
+		// No acquire or present: the single target is rendered and fenced so readback sees a finished frame
+		recordCommandBuffer(0, 0);
+		VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffers[0];
+		wc_gpu_profiler_submit(0, profiler_frame_index());
+		vkQueueSubmit(graphicsQueue, 1, &submitInfo, s_offscreen_fence);
+		vkWaitForFences(device, 1, &s_offscreen_fence, VK_TRUE, UINT64_MAX);
+		vkResetFences(device, 1, &s_offscreen_fence);
+		s_offscreen_frames++;
+		return;
+	}
+
+	if (wc_app_was_resized())
+		s_swapchain_dirty = true;
+	if (s_swapchain_dirty && recreateSwapchain() != EXIT_SUCCESS)
+		return;
+
+	const uint32_t slot = s_frame_slot;
 	uint32_t imageIndex;
-	vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, VK_NULL_HANDLE, VK_NULL_HANDLE, &imageIndex);
+	VkResult result = vkAcquireNextImageKHR(device, swapchain, UINT64_MAX, s_image_available[slot], VK_NULL_HANDLE, &imageIndex);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR)
+	{
+		// Nothing was signaled, so the semaphore and frame slot are reused as they are
+		s_swapchain_dirty = true;
+		return;
+	}
+	if (result == VK_SUBOPTIMAL_KHR)
+		s_swapchain_dirty = true;
+
+	recordCommandBuffer(slot, imageIndex);
+	// The backbuffer is first written by the blit at the end of the graph
+	const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 	VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submitInfo.waitSemaphoreCount = 1;
+	submitInfo.pWaitSemaphores = &s_image_available[slot];
+	submitInfo.pWaitDstStageMask = &waitStage;
 	submitInfo.commandBufferCount = 1;
-	submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
-	vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	submitInfo.pCommandBuffers = &commandBuffers[slot];
+	submitInfo.signalSemaphoreCount = 1;
+	submitInfo.pSignalSemaphores = &s_render_finished[imageIndex];
+	wc_gpu_profiler_submit(slot, profiler_frame_index());
+	vkResetFences(device, 1, &s_frame_fences[slot]);
+	vkQueueSubmit(graphicsQueue, 1, &submitInfo, s_frame_fences[slot]);
+
+	VkPresentIdKHR presentId = {.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR};
+	const uint64_t id = s_present_id + 1;
+	presentId.swapchainCount = 1;
+	presentId.pPresentIds = &id;
 	VkPresentInfoKHR presentInfo = {VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+	presentInfo.pNext = s_present_wait ? &presentId : NULL;
+	presentInfo.waitSemaphoreCount = 1;
+	presentInfo.pWaitSemaphores = &s_render_finished[imageIndex];
 	presentInfo.swapchainCount = 1;
 	presentInfo.pSwapchains = &swapchain;
 	presentInfo.pImageIndices = &imageIndex;
-	vkQueuePresentKHR(presentQueue, &presentInfo);
-	vkQueueWaitIdle(presentQueue);
+	result = vkQueuePresentKHR(presentQueue, &presentInfo);
+	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
+		s_swapchain_dirty = true;
+	if (result != VK_ERROR_OUT_OF_DATE_KHR)
+		s_present_id = id;
+
+	// Block on the slot the next frame reuses rather than the whole queue: the CPU may run
+	// WC_FRAMES_IN_FLIGHT - 1 frames ahead, and the next extract can write that slot's instance region
+	s_frame_count++;
+	s_frame_slot = (slot + 1) % WC_FRAMES_IN_FLIGHT;
+	vkWaitForFences(device, 1, &s_frame_fences[s_frame_slot], VK_TRUE, UINT64_MAX);
+	releaseRetiredSwapchains(false);
+	waitForPresent();
+}
+
+int wc_render_capture(const char* filename)
+{
+	if (!s_offscreen || s_offscreen_frames == 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Capture needs an offscreen renderer with a drawn frame\n");
+		return EXIT_FAILURE;
+	}
+
+	VkCommandBuffer commandBuffer;
+	VkCommandBufferAllocateInfo allocInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+	allocInfo.commandPool = commandPool;
+	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.commandBufferCount = 1;
+	if (vkAllocateCommandBuffers(device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+		return EXIT_FAILURE;
+
+	VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+
+	// The render graph leaves the target in TRANSFER_SRC_OPTIMAL
+	VkBufferImageCopy region = {0};
+	region.imageSubresource = (VkImageSubresourceLayers){VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.imageExtent = (VkExtent3D){swapchainExtent.width, swapchainExtent.height, 1};
+	vkCmdCopyImageToBuffer(commandBuffer, swapchainImages[0], VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, s_readback.buffer, 1, &region);
+
+	VkMemoryBarrier barrier = {.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, NULL, 0,
+						 NULL);
+	vkEndCommandBuffer(commandBuffer);
+
+	VkSubmitInfo submitInfo = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	vkQueueSubmit(graphicsQueue, 1, &submitInfo, s_offscreen_fence);
+	vkWaitForFences(device, 1, &s_offscreen_fence, VK_TRUE, UINT64_MAX);
+	vkResetFences(device, 1, &s_offscreen_fence);
+	vkFreeCommandBuffers(device, commandPool, 1, &commandBuffer);
+	wc_buffer_invalidate(&s_readback, 0, VK_WHOLE_SIZE);
+
+	// Target is BGRA, image files want RGBA
+	const uint32_t pixelCount = swapchainExtent.width * swapchainExtent.height;
+	const uint8_t* bgra = s_readback.mapped;
+	uint8_t* rgba = wc_malloc((size_t)pixelCount * 4);
+	for (uint32_t i = 0; i < pixelCount; i++)
+	{
+		rgba[i * 4 + 0] = bgra[i * 4 + 2];
+		rgba[i * 4 + 1] = bgra[i * 4 + 1];
+		rgba[i * 4 + 2] = bgra[i * 4 + 0];
+		rgba[i * 4 + 3] = bgra[i * 4 + 3];
+	}
+
+	const size_t length = SDL_strlen(filename);
+	const bool png = length >= 4 && SDL_strcasecmp(filename + length - 4, ".png") == 0;
+	const int result = png ? wc_image_write_png(filename, rgba, swapchainExtent.width, swapchainExtent.height)
+						   : wc_image_write_raw(filename, rgba, swapchainExtent.width, swapchainExtent.height);
+	wc_free(rgba);
+
+	if (result != 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to write capture %s\n", filename);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
 }
 
 void wc_render_quit(void)
 {
 	vkDeviceWaitIdle(device);
-	vmaDestroyBuffer(allocator, transformBuffer, transformAlloc);
-	vmaDestroyBuffer(allocator, visibilityBuffer, visibilityAlloc);
 
-	vkDestroyPipeline(device, meshPipeline, NULL);
-	vkDestroyPipelineLayout(device, pipelineLayout, NULL);
-	vkDestroyDescriptorPool(device, descriptorPool, NULL);
-	vkDestroyDescriptorSetLayout(device, descriptorSetLayout, NULL);
+	wc_pipeline_quit();
+	wc_shader_destroy_pipeline_layout(pipelineLayout);
+	wc_shader_destroy_pipeline_layout(s_resolve_layout);
+	wc_shader_quit();
+	wc_texture_quit();
+	wc_gpu_resource_quit();
 
-	vkFreeCommandBuffers(device, commandPool, swapchainImageCount, commandBuffers);
+	wc_gpu_profiler_quit();
+	vkFreeCommandBuffers(device, commandPool, WC_FRAMES_IN_FLIGHT, commandBuffers);
 	vkDestroyCommandPool(device, commandPool, NULL);
+	for (uint32_t i = 0; i < WC_FRAMES_IN_FLIGHT; i++)
+	{
+		vkDestroySemaphore(device, s_image_available[i], NULL);
+		vkDestroyFence(device, s_frame_fences[i], NULL);
+	}
 
+	wc_graph_quit();
 	for (uint32_t i = 0; i < swapchainImageCount; i++)
-	{
-		vkDestroyFramebuffer(device, swapchainFramebuffers[i], NULL);
 		vkDestroyImageView(device, swapchainImageViews[i], NULL);
-	}
-	wc_free(swapchainFramebuffers);
 	wc_free(swapchainImageViews);
-	wc_free(swapchainImages);
 
-	vkDestroyRenderPass(device, renderPass, NULL);
-	vkDestroySwapchainKHR(device, swapchain, NULL);
+	if (s_offscreen)
+	{
+		vkDestroyFence(device, s_offscreen_fence, NULL);
+		wc_buffer_destroy(&s_readback);
+		vmaDestroyImage(allocator, swapchainImages[0], s_offscreen_allocation);
+	}
+	else
+	{
+		releaseRetiredSwapchains(true);
+		for (uint32_t i = 0; i < swapchainImageCount; i++)
+			vkDestroySemaphore(device, s_render_finished[i], NULL);
+		wc_free(s_render_finished);
+		vkDestroySwapchainKHR(device, swapchain, NULL);
+	}
+	wc_free(swapchainImages);
+	wc_buffer_quit();
 	vmaDestroyAllocator(allocator);
 	vkDestroyDevice(device, NULL);
 	if (s_enable_validation)
 		vkDestroyDebugUtilsMessengerEXT(s_instance, debugMessenger, NULL);
-	vkDestroySurfaceKHR(s_instance, surface, NULL);
+	if (!s_offscreen)
+		vkDestroySurfaceKHR(s_instance, surface, NULL);
 	vkDestroyInstance(s_instance, NULL);
 }
 
@@ -265,10 +716,12 @@ int createInstance(void)
 	application_info.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 	application_info.apiVersion = VK_API_VERSION_1_4;
 
-	uint32_t required_instance_extension_count;
-	const char* const* required_instance_extensions = SDL_Vulkan_GetInstanceExtensions(&required_instance_extension_count);
+	// Offscreen rendering needs no WSI extensions, which is what lets it run without a display
+	uint32_t required_instance_extension_count = 0;
+	const char* const* required_instance_extensions =
+		s_offscreen ? NULL : SDL_Vulkan_GetInstanceExtensions(&required_instance_extension_count);
 
-	if (required_instance_extensions == NULL)
+	if (required_instance_extensions == NULL && !s_offscreen)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to get Vulkan instance extensions\n");
 		return EXIT_FAILURE;
@@ -285,8 +738,9 @@ int createInstance(void)
 		extensions[0] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
 		first_extension_index++;
 	}
-	SDL_memcpy(&extensions[first_extension_index], required_instance_extensions,
-			   required_instance_extension_count * sizeof(const char*));
+	if (required_instance_extension_count > 0)
+		SDL_memcpy(&extensions[first_extension_index], required_instance_extensions,
+				   required_instance_extension_count * sizeof(const char*));
 
 	VkInstanceCreateInfo instance_create_info = {.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO};
 	instance_create_info.pApplicationInfo = &application_info;
@@ -349,12 +803,14 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device)
 	vkEnumerateDeviceExtensionProperties(device, NULL, &extensionCount, NULL);
 	VkExtensionProperties* availableExtensions = wc_malloc(sizeof(VkExtensionProperties) * extensionCount);
 	vkEnumerateDeviceExtensionProperties(device, NULL, &extensionCount, availableExtensions);
-	for (size_t i = 0; i < sizeof(s_device_extensions) / sizeof(s_device_extensions[0]); i++)
+	uint32_t requiredCount;
+	const char* const* required = getDeviceExtensions(&requiredCount);
+	for (uint32_t i = 0; i < requiredCount; i++)
 	{
 		bool found = false;
 		for (uint32_t j = 0; j < extensionCount; j++)
 		{
-			if (SDL_strcmp(s_device_extensions[i], availableExtensions[j].extensionName) == 0)
+			if (SDL_strcmp(required[i], availableExtensions[j].extensionName) == 0)
 			{
 				found = true;
 				break;
@@ -370,6 +826,21 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device)
 	return true;
 }
 
+static bool hasDeviceExtension(VkPhysicalDevice device, const char* name)
+{
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(device, NULL, &extensionCount, NULL);
+	VkExtensionProperties* availableExtensions = wc_malloc(sizeof(VkExtensionProperties) * extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, NULL, &extensionCount, availableExtensions);
+	bool found = false;
+	for (uint32_t i = 0; i < extensionCount && !found; i++)
+	{
+		found = SDL_strcmp(name, availableExtensions[i].extensionName) == 0;
+	}
+	wc_free(availableExtensions);
+	return found;
+}
+
 WC_QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
 {
 	WC_QueueFamilyIndices indices = {.graphics_family = -1, .present_family = -1, .compute_family = -1, .transfer_family = -1};
@@ -385,7 +856,10 @@ WC_QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device)
 			indices.graphics_family = (int)i;
 		}
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		if (surface != VK_NULL_HANDLE)
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		else
+			presentSupport = (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) != 0; // Nothing is presented offscreen
 		if (presentSupport)
 		{
 			indices.present_family = (int)i;
@@ -401,8 +875,8 @@ bool isDeviceSuitable(VkPhysicalDevice device)
 {
 	WC_QueueFamilyIndices indices = findQueueFamilies(device);
 	bool extensionsSupported = checkDeviceExtensionSupport(device);
-	bool swapChainAdequate = false;
-	if (extensionsSupported)
+	bool swapChainAdequate = s_offscreen;
+	if (extensionsSupported && !s_offscreen)
 	{
 		uint32_t formatCount, presentModeCount;
 		vkGetPhysicalDeviceSurfaceFormatsKHR(device, surface, &formatCount, NULL);
@@ -470,16 +944,72 @@ int createLogicalDevice(void)
 		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
 	descriptorIndexing.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
 	descriptorIndexing.runtimeDescriptorArray = VK_TRUE;
+	descriptorIndexing.descriptorBindingPartiallyBound = VK_TRUE;
+	descriptorIndexing.descriptorBindingVariableDescriptorCount = VK_TRUE;
+	descriptorIndexing.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	descriptorIndexing.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+	// The render graph records with dynamic rendering and synchronization2 barriers
+	VkPhysicalDeviceVulkan13Features vulkan13 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES,
+												 .pNext = &descriptorIndexing};
+	vulkan13.dynamicRendering = VK_TRUE;
+	vulkan13.synchronization2 = VK_TRUE;
 	VkPhysicalDeviceMeshShaderFeaturesEXT meshFeatures = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT,
-														  .pNext = &descriptorIndexing};
+														  .pNext = &vulkan13};
 	meshFeatures.meshShader = VK_TRUE;
 	meshFeatures.taskShader = VK_TRUE;
 	VkPhysicalDeviceFeatures2 features2 = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &meshFeatures};
+
+	// Profiling and present-wait features are optional: enable what the device has
+	VkPhysicalDevicePresentWaitFeaturesKHR supportedPresentWait = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR};
+	VkPhysicalDevicePresentIdFeaturesKHR supportedPresentId = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+															   .pNext = &supportedPresentWait};
+	VkPhysicalDeviceMeshShaderFeaturesEXT supportedMesh = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT};
+	VkPhysicalDeviceFeatures2 supported = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &supportedMesh};
+	const bool presentWaitExtensions = !s_offscreen && hasDeviceExtension(physicalDevice, VK_KHR_PRESENT_ID_EXTENSION_NAME) &&
+									   hasDeviceExtension(physicalDevice, VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+	if (presentWaitExtensions)
+		supportedMesh.pNext = &supportedPresentId;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &supported);
+	s_pipeline_statistics = supported.features.pipelineStatisticsQuery == VK_TRUE;
+	s_mesh_shader_queries = s_pipeline_statistics && supportedMesh.meshShaderQueries == VK_TRUE;
+	features2.features.pipelineStatisticsQuery = s_pipeline_statistics;
+	meshFeatures.meshShaderQueries = s_mesh_shader_queries;
+	s_present_wait = presentWaitExtensions && supportedPresentId.presentId == VK_TRUE &&
+					 supportedPresentWait.presentWait == VK_TRUE;
+	VkPhysicalDevicePresentWaitFeaturesKHR presentWaitFeatures = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR, .presentWait = VK_TRUE};
+	VkPhysicalDevicePresentIdFeaturesKHR presentIdFeatures = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR,
+															  .pNext = &presentWaitFeatures,
+															  .presentId = VK_TRUE};
+	if (s_present_wait)
+	{
+		presentWaitFeatures.pNext = features2.pNext;
+		features2.pNext = &presentIdFeatures;
+	}
+
+	uint32_t requiredCount;
+	const char* const* required = getDeviceExtensions(&requiredCount);
+	const char* extensions[sizeof(s_device_extensions) / sizeof(*s_device_extensions) + 4];
+	SDL_memcpy(extensions, required, requiredCount * sizeof(*extensions));
+	uint32_t extensionCount = requiredCount;
+	s_calibrated_timestamps = hasDeviceExtension(physicalDevice, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	if (s_calibrated_timestamps)
+		extensions[extensionCount++] = VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME;
+	s_memory_budget = hasDeviceExtension(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+	if (s_memory_budget)
+		extensions[extensionCount++] = VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+	if (s_present_wait)
+	{
+		extensions[extensionCount++] = VK_KHR_PRESENT_ID_EXTENSION_NAME;
+		extensions[extensionCount++] = VK_KHR_PRESENT_WAIT_EXTENSION_NAME;
+	}
+
 	VkDeviceCreateInfo createInfo = {.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
 	createInfo.queueCreateInfoCount = queueCount;
 	createInfo.pQueueCreateInfos = queueCreateInfos;
-	createInfo.enabledExtensionCount = sizeof(s_device_extensions) / sizeof(*s_device_extensions);
-	createInfo.ppEnabledExtensionNames = s_device_extensions;
+	createInfo.enabledExtensionCount = extensionCount;
+	createInfo.ppEnabledExtensionNames = extensions;
 	if (s_enable_validation)
 	{
 		createInfo.enabledLayerCount = 1;
@@ -512,15 +1042,26 @@ static VkSurfaceFormatKHR chooseSwapSurfaceFormat(const VkSurfaceFormatKHR* avai
 	return availableFormats[0];
 }
 
-static VkPresentModeKHR chooseSwapPresentMode(const VkPresentModeKHR* availablePresentModes, uint32_t presentModeCount)
+static bool hasPresentMode(const VkPresentModeKHR* availablePresentModes, uint32_t presentModeCount, VkPresentModeKHR mode)
 {
 	for (uint32_t i = 0; i < presentModeCount; i++)
 	{
-		if (availablePresentModes[i] == VK_PRESENT_MODE_MAILBOX_KHR)
-		{
-			return availablePresentModes[i];
-		}
+		if (availablePresentModes[i] == mode)
+			return true;
 	}
+	return false;
+}
+
+// Unsupported requests degrade towards FIFO, the only mode every device has: immediate falls back
+// to mailbox first since both avoid waiting on vblank
+static VkPresentModeKHR chooseSwapPresentMode(const VkPresentModeKHR* availablePresentModes, uint32_t presentModeCount)
+{
+	if (s_requested_present_mode == VK_PRESENT_MODE_IMMEDIATE_KHR &&
+		hasPresentMode(availablePresentModes, presentModeCount, VK_PRESENT_MODE_IMMEDIATE_KHR))
+		return VK_PRESENT_MODE_IMMEDIATE_KHR;
+	if (s_requested_present_mode != VK_PRESENT_MODE_FIFO_KHR &&
+		hasPresentMode(availablePresentModes, presentModeCount, VK_PRESENT_MODE_MAILBOX_KHR))
+		return VK_PRESENT_MODE_MAILBOX_KHR;
 	return VK_PRESENT_MODE_FIFO_KHR;
 }
 
@@ -546,7 +1087,7 @@ static VkExtent2D chooseSwapExtent(const VkSurfaceCapabilitiesKHR capabilities)
 	return actual;
 }
 
-int createSwapchain(void)
+int createSwapchain(const VkSwapchainKHR oldSwapchain)
 {
 	VkSurfaceCapabilitiesKHR caps;
 	vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &caps);
@@ -595,7 +1136,12 @@ int createSwapchain(void)
 	ci.imageColorSpace = surfaceFormat.colorSpace;
 	ci.imageExtent = swapchainExtent;
 	ci.imageArrayLayers = 1;
-	ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	if (!(caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "swapchain images cannot be transfer destinations\n");
+		return EXIT_FAILURE;
+	}
+	ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
 	uint32_t qf[] = {graphicsQueueFamilyIndex, presentQueueFamilyIndex};
 	if (graphicsQueueFamilyIndex != presentQueueFamilyIndex)
 	{
@@ -609,7 +1155,7 @@ int createSwapchain(void)
 	ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
 	ci.presentMode = presentMode;
 	ci.clipped = VK_TRUE;
-	ci.oldSwapchain = VK_NULL_HANDLE;
+	ci.oldSwapchain = oldSwapchain;
 
 	if (vkCreateSwapchainKHR(device, &ci, NULL, &swapchain) != VK_SUCCESS)
 	{
@@ -623,6 +1169,49 @@ int createSwapchain(void)
 	return EXIT_SUCCESS;
 }
 
+int createOffscreenTarget(const uint32_t width, const uint32_t height)
+{
+	swapchainExtent = (VkExtent2D){width, height};
+	swapchainImageCount = 1;
+	swapchainImages = wc_malloc(sizeof(VkImage));
+
+	// Same format and usage as the swapchain path so the render graph is shared unchanged
+	VkImageCreateInfo imageInfo = {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = VK_FORMAT_B8G8R8A8_SRGB;
+	imageInfo.extent = (VkExtent3D){width, height, 1};
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	VmaAllocationCreateInfo imageAllocInfo = {};
+	imageAllocInfo.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE;
+	if (vmaCreateImage(allocator, &imageInfo, &imageAllocInfo, &swapchainImages[0], &s_offscreen_allocation, NULL) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "offscreen target creation failed\n");
+		return EXIT_FAILURE;
+	}
+
+	if (wc_buffer_create((VkDeviceSize)width * height * 4, VK_BUFFER_USAGE_TRANSFER_DST_BIT, WC_BUFFER_MEMORY_READBACK,
+						 &s_readback) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "readback buffer creation failed\n");
+		return EXIT_FAILURE;
+	}
+
+	VkFenceCreateInfo fenceInfo = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO};
+	if (vkCreateFence(device, &fenceInfo, NULL, &s_offscreen_fence) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "offscreen fence creation failed\n");
+		return EXIT_FAILURE;
+	}
+	s_offscreen_frames = 0;
+	return EXIT_SUCCESS;
+}
+
 int createImageViews(void)
 {
 	swapchainImageViews = wc_malloc(sizeof(VkImageView) * swapchainImageCount);
@@ -643,278 +1232,319 @@ int createImageViews(void)
 	return EXIT_SUCCESS;
 }
 
-int createRenderPass(void)
+int createCommandPool(void)
 {
-	VkAttachmentDescription colorAttachment = {0};
-	colorAttachment.format = VK_FORMAT_B8G8R8A8_SRGB;
-	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	VkAttachmentReference colorRef = {0};
-	colorRef.attachment = 0;
-	colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription subpass = {0};
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &colorRef;
-
-	VkRenderPassCreateInfo rpInfo = {.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
-	rpInfo.attachmentCount = 1;
-	rpInfo.pAttachments = &colorAttachment;
-	rpInfo.subpassCount = 1;
-	rpInfo.pSubpasses = &subpass;
-
-	if (vkCreateRenderPass(device, &rpInfo, NULL, &renderPass) != VK_SUCCESS)
+	VkCommandPoolCreateInfo poolInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
+	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+	poolInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
+	if (vkCreateCommandPool(device, &poolInfo, NULL, &commandPool) != VK_SUCCESS)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "render pass creation failed\n");
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "command pool creation failed\n");
 		return EXIT_FAILURE;
 	}
 	return EXIT_SUCCESS;
 }
 
-int createFramebuffers(void)
+int createFrameSync(void)
 {
-	swapchainFramebuffers = wc_malloc(sizeof(VkFramebuffer) * swapchainImageCount);
-	for (uint32_t i = 0; i < swapchainImageCount; i++)
+	VkSemaphoreCreateInfo semaphoreInfo = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+	// Signaled so the first wait on each slot returns immediately
+	VkFenceCreateInfo fenceInfo = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+	for (uint32_t i = 0; i < WC_FRAMES_IN_FLIGHT; i++)
 	{
-		VkImageView attachments[] = {swapchainImageViews[i]};
-		VkFramebufferCreateInfo fbInfo = {.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
-		fbInfo.renderPass = renderPass;
-		fbInfo.attachmentCount = 1;
-		fbInfo.pAttachments = attachments;
-		fbInfo.width = swapchainExtent.width;
-		fbInfo.height = swapchainExtent.height;
-		fbInfo.layers = 1;
-		if (vkCreateFramebuffer(device, &fbInfo, NULL, &swapchainFramebuffers[i]) != VK_SUCCESS)
+		if (vkCreateSemaphore(device, &semaphoreInfo, NULL, &s_image_available[i]) != VK_SUCCESS ||
+			vkCreateFence(device, &fenceInfo, NULL, &s_frame_fences[i]) != VK_SUCCESS)
 		{
-			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "framebuffer creation failed\n");
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "frame sync creation failed\n");
 			return EXIT_FAILURE;
 		}
 	}
+	s_frame_slot = 0;
+	s_frame_count = 0;
 	return EXIT_SUCCESS;
 }
 
-int createCommandPool(void)
+static int createRenderFinishedSemaphores(void)
 {
-	VkCommandPoolCreateInfo poolInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
-	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-	poolInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
-	if (vkCreateCommandPool(device, &poolInfo, NULL, &commandPool) != VK_SUCCESS)
+	s_render_finished = wc_malloc(sizeof(VkSemaphore) * swapchainImageCount);
+	VkSemaphoreCreateInfo semaphoreInfo = {.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+	for (uint32_t i = 0; i < swapchainImageCount; i++)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "command pool creation failed\n");
-		return EXIT_FAILURE;
+		if (vkCreateSemaphore(device, &semaphoreInfo, NULL, &s_render_finished[i]) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "semaphore creation failed\n");
+			return EXIT_FAILURE;
+		}
 	}
 	return EXIT_SUCCESS;
 }
 
 int createCommandBuffers(void)
 {
-	commandBuffers = wc_malloc(sizeof(VkCommandBuffer) * swapchainImageCount);
 	VkCommandBufferAllocateInfo allocInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
 	allocInfo.commandPool = commandPool;
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-	allocInfo.commandBufferCount = swapchainImageCount;
+	allocInfo.commandBufferCount = WC_FRAMES_IN_FLIGHT;
 	if (vkAllocateCommandBuffers(device, &allocInfo, commandBuffers) != VK_SUCCESS)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "command buffer allocation failed\n");
 		return EXIT_FAILURE;
 	}
+	return EXIT_SUCCESS;
+}
 
-	for (uint32_t i = 0; i < swapchainImageCount; i++)
+// Workgroup x covers 32 meshlets of the largest mesh, y is the instance; y is capped at 65535
+// so large ranges are split into several draws with their own offset
+static void recordVisibilityPass(VkCommandBuffer commandBuffer, void* userData)
+{
+	(void)userData;
+
+	uint32_t firstInstance, instanceCount;
+	wc_gpu_resource_get_instances(&firstInstance, &instanceCount);
+	const uint32_t meshletGroups = (wc_gpu_resource_get_max_meshlets() + 31) / 32;
+	if (meshletGroups == 0 || instanceCount == 0)
+		return;
+	// A pipeline that failed to compile (e.g. a broken shader edit) leaves the pass empty
+	const VkPipeline pipeline = wc_pipeline_get(s_visibility_pipeline);
+	if (pipeline == VK_NULL_HANDLE)
+		return;
+
+	const VkDescriptorSet bindlessSet = wc_gpu_resource_get_set();
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &bindlessSet, 0, NULL);
+	WC_GpuDrawConstants drawConstants = s_draw_constants;
+	for (uint32_t offset = 0; offset < instanceCount; offset += WC_MAX_DRAW_INSTANCES)
 	{
-		VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-		vkBeginCommandBuffer(commandBuffers[i], &beginInfo);
+		drawConstants.instanceOffset = firstInstance + offset;
+		drawConstants.instanceCount = SDL_min(instanceCount - offset, WC_MAX_DRAW_INSTANCES);
+		vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT, 0,
+						   sizeof(drawConstants), &drawConstants);
+		vkCmdDrawMeshTasksEXT(commandBuffer, meshletGroups, drawConstants.instanceCount, 1);
+	}
+}
 
-		VkRenderPassBeginInfo rpBegin = {VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
-		rpBegin.renderPass = renderPass;
-		rpBegin.framebuffer = swapchainFramebuffers[i];
-		rpBegin.renderArea.extent = swapchainExtent;
-		VkClearValue clear = {.color = {{0.1f, 0.1f, 0.1f, 1.0f}}};
-		rpBegin.clearValueCount = 1;
-		rpBegin.pClearValues = &clear;
-		vkCmdBeginRenderPass(commandBuffers[i], &rpBegin, VK_SUBPASS_CONTENTS_INLINE);
+// One invocation per pixel; set 1 (visibility IDs in, colour out) is pushed since its views
+// change with every graph rebuild
+static void recordResolvePass(VkCommandBuffer commandBuffer, void* userData)
+{
+	(void)userData;
 
-		vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline);
-		vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSet, 0,
-								NULL);
-		vkCmdDrawMeshTasksEXT(commandBuffers[i], 100, 1, 1);
+	const VkPipeline pipeline = wc_pipeline_get(s_resolve_pipeline);
+	if (pipeline == VK_NULL_HANDLE)
+		return;
 
-		vkCmdEndRenderPass(commandBuffers[i]);
-		vkEndCommandBuffer(commandBuffers[i]);
+	VkDescriptorImageInfo images[2] = {
+		{.imageView = wc_graph_get_view(s_graph_visibility), .imageLayout = VK_IMAGE_LAYOUT_GENERAL},
+		{.imageView = wc_graph_get_view(s_graph_color), .imageLayout = VK_IMAGE_LAYOUT_GENERAL}};
+	VkWriteDescriptorSet writes[2] = {};
+	for (uint32_t i = 0; i < 2; i++)
+	{
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+		writes[i].pImageInfo = &images[i];
 	}
 
-	return EXIT_SUCCESS;
+	const VkDescriptorSet bindlessSet = wc_gpu_resource_get_set();
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, s_resolve_layout, 0, 1, &bindlessSet, 0, NULL);
+	vkCmdPushDescriptorSetKHR(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, s_resolve_layout, WC_SHADER_PUSH_SET, 2, writes);
+	vkCmdPushConstants(commandBuffer, s_resolve_layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(s_draw_constants),
+					   &s_draw_constants);
+	vkCmdDispatch(commandBuffer, (swapchainExtent.width + WC_RESOLVE_GROUP_SIZE - 1) / WC_RESOLVE_GROUP_SIZE,
+				  (swapchainExtent.height + WC_RESOLVE_GROUP_SIZE - 1) / WC_RESOLVE_GROUP_SIZE, 1);
 }
 
-int createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage, VkBuffer* buffer,
-				 VmaAllocation* allocation)
+// Blit rather than copy: it converts the linear float colour to the sRGB backbuffer
+static void recordPresentPass(VkCommandBuffer commandBuffer, void* userData)
 {
-	VkBufferCreateInfo bufferInfo = {VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-	bufferInfo.size = size;
-	bufferInfo.usage = usage;
-	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-	VmaAllocationCreateInfo allocCreateInfo = {};
-	allocCreateInfo.usage = memoryUsage;
-	if (vmaCreateBuffer(allocator, &bufferInfo, &allocCreateInfo, buffer, allocation, NULL) != VK_SUCCESS)
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to allocate buffer\n");
-		return EXIT_FAILURE;
-	}
-	return EXIT_SUCCESS;
+	(void)userData;
+
+	VkImageBlit region = {};
+	region.srcSubresource = (VkImageSubresourceLayers){VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+	region.srcOffsets[1] = (VkOffset3D){(int32_t)swapchainExtent.width, (int32_t)swapchainExtent.height, 1};
+	region.dstSubresource = region.srcSubresource;
+	region.dstOffsets[1] = region.srcOffsets[1];
+	vkCmdBlitImage(commandBuffer, wc_graph_get_image(s_graph_color), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				   wc_graph_get_image(s_graph_backbuffer), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region, VK_FILTER_NEAREST);
 }
 
-// --- Descriptor + Pipeline setup ---
-void createDescriptorSetLayout(void)
+// Passes and their resources; barriers, attachments and transient memory follow from these.
+// Depth dies with the visibility pass, so the resolve output can reuse its memory.
+static int buildRenderGraph(void)
 {
-	VkDescriptorSetLayoutBinding bindings[2] = {};
-	// transforms
-	bindings[0].binding = 0;
-	bindings[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	bindings[0].descriptorCount = 1;
-	bindings[0].stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT;
-	// visibility
-	bindings[1].binding = 1;
-	bindings[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	bindings[1].descriptorCount = 1;
-	bindings[1].stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT;
+	const VkImageLayout finalLayout = s_offscreen ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	s_graph_backbuffer =
+		wc_graph_import_image("backbuffer", VK_FORMAT_B8G8R8A8_SRGB, swapchainExtent, VK_IMAGE_LAYOUT_UNDEFINED, finalLayout);
+	const uint32_t depth = wc_graph_create_image("depth", (WC_GraphImageDesc){WC_DEPTH_FORMAT, swapchainExtent});
+	s_graph_visibility = wc_graph_create_image("visibility", (WC_GraphImageDesc){WC_VISIBILITY_FORMAT, swapchainExtent});
+	s_graph_color = wc_graph_create_image("color", (WC_GraphImageDesc){WC_RESOLVE_FORMAT, swapchainExtent});
+
+	const VkClearValue clearIds = {.color = {.uint32 = {UINT32_MAX, UINT32_MAX, 0, 0}}};
+	const VkClearValue clearDepth = {.depthStencil = {1.0f, 0}};
+	const uint32_t visibility = wc_graph_add_pass("visibility", true, recordVisibilityPass, NULL);
+	wc_graph_use(visibility, s_graph_visibility, WC_GRAPH_COLOR_WRITE, &clearIds);
+	wc_graph_use(visibility, depth, WC_GRAPH_DEPTH_WRITE, &clearDepth);
+
+	const uint32_t resolve = wc_graph_add_pass("resolve", false, recordResolvePass, NULL);
+	wc_graph_use(resolve, s_graph_visibility, WC_GRAPH_STORAGE_READ, NULL);
+	wc_graph_use(resolve, s_graph_color, WC_GRAPH_STORAGE_WRITE, NULL);
+
+	const uint32_t present = wc_graph_add_pass("present", false, recordPresentPass, NULL);
+	wc_graph_use(present, s_graph_color, WC_GRAPH_TRANSFER_READ, NULL);
+	wc_graph_use(present, s_graph_backbuffer, WC_GRAPH_TRANSFER_WRITE, NULL);
+	return wc_graph_compile();
+}
 
-	VkDescriptorSetLayoutCreateInfo layoutInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
-	layoutInfo.bindingCount = 2;
-	layoutInfo.pBindings = bindings;
-	vkCreateDescriptorSetLayout(device, &layoutInfo, NULL, &descriptorSetLayout);
+// The instance range changes every frame, so the slot's buffer is re-recorded in wc_render_draw;
+// its previous submission has already completed
+static void recordCommandBuffer(const uint32_t slot, const uint32_t imageIndex)
+{
+	const VkCommandBuffer commandBuffer = commandBuffers[slot];
+	VkCommandBufferBeginInfo beginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	wc_gpu_profiler_reset(commandBuffer, slot);
+	// Timestamps only: the passes inside take the statistics queries, which cannot nest
+	const uint32_t frameZone = wc_gpu_profiler_begin(commandBuffer, slot, "frame", false);
+
+	wc_graph_set_image(s_graph_backbuffer, swapchainImages[imageIndex], swapchainImageViews[imageIndex]);
+	wc_graph_execute(commandBuffer, slot);
+
+	wc_gpu_profiler_end(commandBuffer, slot, frameZone);
+	vkEndCommandBuffer(commandBuffer);
 }
 
-void createPipeline(void)
+// --- Pipeline setup ---
+// Runs on a job worker; shader modules are owned by the shader system and already compiled
+static VkResult createVisibilityPipeline(VkDevice device, VkPipelineCache cache, void* userData, VkPipeline* pipeline)
 {
-	// Load mesh and fragment shaders (SPIR-V) -- assume functions loadShaderModule()
-	VkShaderModule meshSM = loadShaderModule(device, "mesh.spv");
-	VkShaderModule fragSM = loadShaderModule(device, "frag.spv");
+	(void)userData;
+
+	// Task shader culls meshlets per instance, mesh shader expands the survivors
+	VkShaderModule taskSM = wc_shader_get_module(s_visibility_shaders[0]);
+	VkShaderModule meshSM = wc_shader_get_module(s_visibility_shaders[1]);
+	VkShaderModule fragSM = wc_shader_get_module(s_visibility_shaders[2]);
+	if (taskSM == VK_NULL_HANDLE || meshSM == VK_NULL_HANDLE || fragSM == VK_NULL_HANDLE)
+		return VK_ERROR_INITIALIZATION_FAILED;
 
-	VkPipelineShaderStageCreateInfo stages[2] = {};
+	VkPipelineShaderStageCreateInfo stages[3] = {};
 	stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	stages[0].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
-	stages[0].module = meshSM;
+	stages[0].stage = VK_SHADER_STAGE_TASK_BIT_EXT;
+	stages[0].module = taskSM;
 	stages[0].pName = "main";
 	stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-	stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-	stages[1].module = fragSM;
+	stages[1].stage = VK_SHADER_STAGE_MESH_BIT_EXT;
+	stages[1].module = meshSM;
 	stages[1].pName = "main";
-
-	VkPipelineLayoutCreateInfo layoutInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
-	layoutInfo.setLayoutCount = 1;
-	layoutInfo.pSetLayouts = &descriptorSetLayout;
-	vkCreatePipelineLayout(device, &layoutInfo, NULL, &pipelineLayout);
+	stages[2].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	stages[2].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+	stages[2].module = fragSM;
+	stages[2].pName = "main";
+
+	// Dynamic rendering: attachment formats replace the render pass, viewport and scissor come from
+	// the render graph when it begins the pass
+	const VkFormat colorFormat = WC_VISIBILITY_FORMAT;
+	VkPipelineRenderingCreateInfo renderingInfo = {.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO};
+	renderingInfo.colorAttachmentCount = 1;
+	renderingInfo.pColorAttachmentFormats = &colorFormat;
+	renderingInfo.depthAttachmentFormat = WC_DEPTH_FORMAT;
+
+	VkPipelineViewportStateCreateInfo viewportState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
+	viewportState.viewportCount = 1;
+	viewportState.scissorCount = 1;
+	const VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+	VkPipelineDynamicStateCreateInfo dynamicState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO};
+	dynamicState.dynamicStateCount = 2;
+	dynamicState.pDynamicStates = dynamicStates;
+
+	VkPipelineRasterizationStateCreateInfo rasterState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
+	rasterState.polygonMode = VK_POLYGON_MODE_FILL;
+	rasterState.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterState.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	rasterState.lineWidth = 1.0f;
+	VkPipelineMultisampleStateCreateInfo multisampleState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
+	multisampleState.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+	VkPipelineDepthStencilStateCreateInfo depthState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
+	depthState.depthTestEnable = VK_TRUE;
+	depthState.depthWriteEnable = VK_TRUE;
+	depthState.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	// Integer IDs: no blending, and the target only has two channels
+	VkPipelineColorBlendAttachmentState blendAttachment = {.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT};
+	VkPipelineColorBlendStateCreateInfo blendState = {.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO};
+	blendState.attachmentCount = 1;
+	blendState.pAttachments = &blendAttachment;
 
 	VkGraphicsPipelineCreateInfo pipeInfo = {VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-	pipeInfo.stageCount = 2;
+	pipeInfo.pNext = &renderingInfo;
+	pipeInfo.stageCount = 3;
 	pipeInfo.pStages = stages;
-	pipeInfo.renderPass = renderPass;
+	pipeInfo.pViewportState = &viewportState;
+	pipeInfo.pRasterizationState = &rasterState;
+	pipeInfo.pMultisampleState = &multisampleState;
+	pipeInfo.pDepthStencilState = &depthState;
+	pipeInfo.pColorBlendState = &blendState;
+	pipeInfo.pDynamicState = &dynamicState;
 	pipeInfo.layout = pipelineLayout;
-	// other pipeline state (viewport, raster, blend) omitted for brevity
-	vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &pipeInfo, NULL, &meshPipeline);
-
-	vkDestroyShaderModule(device, meshSM, NULL);
-	vkDestroyShaderModule(device, fragSM, NULL);
+	return vkCreateGraphicsPipelines(device, cache, 1, &pipeInfo, NULL, pipeline);
 }
 
-void createDescriptorPool(void)
+static VkResult createResolvePipeline(VkDevice device, VkPipelineCache cache, void* userData, VkPipeline* pipeline)
 {
-	VkDescriptorPoolSize sizes[2] = {};
-	sizes[0].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	sizes[0].descriptorCount = 1;
-	sizes[1].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	sizes[1].descriptorCount = 1;
-
-	VkDescriptorPoolCreateInfo poolInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
-	poolInfo.maxSets = 1;
-	poolInfo.poolSizeCount = 2;
-	poolInfo.pPoolSizes = sizes;
-	vkCreateDescriptorPool(device, &poolInfo, NULL, &descriptorPool);
-}
-
-void createDescriptorSet(void)
-{
-	VkDescriptorSetAllocateInfo allocInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
-	allocInfo.descriptorPool = descriptorPool;
-	allocInfo.descriptorSetCount = 1;
-	allocInfo.pSetLayouts = &descriptorSetLayout;
-	vkAllocateDescriptorSets(device, &allocInfo, &descriptorSet);
-}
-
-void updateDescriptorSet(void)
-{
-	createBuffer(sizeof(float) * 16 * 100, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, &transformBuffer,
-				 &transformAlloc);
-	createBuffer(sizeof(uint32_t) * 100, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU, &visibilityBuffer,
-				 &visibilityAlloc);
-
-	VkDescriptorBufferInfo bufInfos[2] = {};
-	bufInfos[0].buffer = transformBuffer;
-	bufInfos[0].offset = 0;
-	bufInfos[0].range = VK_WHOLE_SIZE;
-	bufInfos[1].buffer = visibilityBuffer;
-	bufInfos[1].offset = 0;
-	bufInfos[1].range = VK_WHOLE_SIZE;
-
-	VkWriteDescriptorSet writes[2] = {};
-	writes[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	writes[0].dstSet = descriptorSet;
-	writes[0].dstBinding = 0;
-	writes[0].descriptorCount = 1;
-	writes[0].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	writes[0].pBufferInfo = &bufInfos[0];
-	writes[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	writes[1].dstSet = descriptorSet;
-	writes[1].dstBinding = 1;
-	writes[1].descriptorCount = 1;
-	writes[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	writes[1].pBufferInfo = &bufInfos[1];
-
-	vkUpdateDescriptorSets(device, 2, writes, 0, NULL);
+	(void)userData;
+
+	VkShaderModule computeSM = wc_shader_get_module(s_resolve_shader);
+	if (computeSM == VK_NULL_HANDLE)
+		return VK_ERROR_INITIALIZATION_FAILED;
+
+	VkComputePipelineCreateInfo pipeInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+	pipeInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipeInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipeInfo.stage.module = computeSM;
+	pipeInfo.stage.pName = "main";
+	pipeInfo.layout = s_resolve_layout;
+	return vkCreateComputePipelines(device, cache, 1, &pipeInfo, NULL, pipeline);
 }
 
-VkShaderModule loadShaderModule(VkDevice device, const char* filepath)
+static int createPipelineLayouts(VkPipelineLayout* visibility, VkPipelineLayout* resolve)
 {
-	FILE* file = fopen(filepath, "rb");
-	if (!file)
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open shader file: %s", filepath);
-		return VK_NULL_HANDLE;
-	}
-	fseek(file, 0, SEEK_END);
-	long size = ftell(file);
-	rewind(file);
-	// Size must be a multiple of 4
-	if (size % 4 != 0)
+	// Set 0 is the shared bindless set, push constants come from the task/mesh reflection
+	if (wc_shader_create_pipeline_layout(s_visibility_shaders, 3, wc_gpu_resource_get_layout(), visibility) != VK_SUCCESS)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader file size not aligned: %s", filepath);
-		return VK_NULL_HANDLE;
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create visibility pipeline layout\n");
+		return EXIT_FAILURE;
 	}
-	char* code = wc_malloc(size);
-	if (fread(code, 1, size, file) != size)
+
+	// Set 1 of the resolve layout is its push descriptor set
+	if (wc_shader_create_pipeline_layout(&s_resolve_shader, 1, wc_gpu_resource_get_layout(), resolve) != VK_SUCCESS)
 	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to read shader file: %s", filepath);
-		return VK_NULL_HANDLE;
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create resolve pipeline layout\n");
+		wc_shader_destroy_pipeline_layout(*visibility);
+		return EXIT_FAILURE;
 	}
-	fclose(file);
+	return EXIT_SUCCESS;
+}
 
-	VkShaderModuleCreateInfo createInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-	createInfo.codeSize = size;
-	createInfo.pCode = (const uint32_t*)code;
+int createPipeline(void)
+{
+	s_visibility_shaders[0] = wc_shader_register("visibility.task.glsl", VK_SHADER_STAGE_TASK_BIT_EXT, NULL, 0);
+	s_visibility_shaders[1] = wc_shader_register("visibility.mesh.glsl", VK_SHADER_STAGE_MESH_BIT_EXT, NULL, 0);
+	s_visibility_shaders[2] = wc_shader_register("visibility.frag.glsl", VK_SHADER_STAGE_FRAGMENT_BIT, NULL, 0);
+	s_resolve_shader = wc_shader_register("resolve.comp.glsl", VK_SHADER_STAGE_COMPUTE_BIT, NULL, 0);
+	// Shaders compile in parallel; the layout below needs their reflection, so wait for all of them
+	wc_shader_compile_all();
+	wc_shader_wait_all();
+
+	if (createPipelineLayouts(&pipelineLayout, &s_resolve_layout) != EXIT_SUCCESS)
+		return EXIT_FAILURE;
 
-	VkShaderModule shaderModule;
-	if (vkCreateShaderModule(device, &createInfo, NULL, &shaderModule) != VK_SUCCESS)
-	{
-		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader module from file: %s", filepath);
-		return VK_NULL_HANDLE;
-	}
+	// Every frame needs both and nothing cheaper produces the same output, so they have no fallback
+	// and are not left to lazy creation
+	s_visibility_pipeline = wc_pipeline_register("visibility", createVisibilityPipeline, NULL, WC_PIPELINE_NONE);
+	s_resolve_pipeline = wc_pipeline_register("resolve", createResolvePipeline, NULL, WC_PIPELINE_NONE);
 
-	wc_free(code);
-	return shaderModule;
+	// Kick every registered pipeline off in parallel now; command buffer recording waits on first use
+	wc_pipeline_compile_all();
+	return EXIT_SUCCESS;
 }
+
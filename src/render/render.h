@@ -2,14 +2,39 @@
 
 #include "types.h"
 
+#include <stdint.h>
+
 typedef struct WC_Vertex
 {
 	float x, y, z, w;
 	float screen_x, screen_y;
 } WC_Vertex;
 
+typedef enum WC_PresentMode
+{
+	WC_PRESENT_MODE_FIFO,	   // vsync, queues frames
+	WC_PRESENT_MODE_MAILBOX,   // vsync, newest frame replaces a queued one
+	WC_PRESENT_MODE_IMMEDIATE, // no vsync, may tear
+} WC_PresentMode;
+
+// Reads vsync (true/fifo, mailbox, false/immediate) and frame_latency from the app config. Runs the
+// three startup phases below in order.
 int wc_render_init(void);
+// Startup phases for the init task graph. Device and swapchain need the main thread (window
+// surface); pipelines only need the device and may run on a job alongside the swapchain.
+int wc_render_init_device(void);
+int wc_render_init_swapchain(void);
+int wc_render_init_pipelines(void);
+// Renders into a VMA image instead of a swapchain: no window, surface or WSI extensions, so it
+// runs on headless machines and software drivers such as lavapipe.
+int wc_render_init_offscreen(uint32_t width, uint32_t height);
+// Column-major view-projection used by the visibility pass for culling and projection
+void wc_render_set_camera(const float view_proj[16], const float position[3]);
+// Takes effect with the next frame through a swapchain recreation; unsupported modes fall back to FIFO
+void wc_render_set_present_mode(WC_PresentMode mode);
 void wc_render_draw(void);
+// Reads the last offscreen frame back and writes it as PNG (.png) or raw RGBA8 (anything else).
+int wc_render_capture(const char* filename);
 void wc_render_quit(void);
 
 VkInstance wc_render_get_instance(void);
@@ -0,0 +1,729 @@
+#include "render_graph.h"
+
+#include "gpu_profiler.h"
+
+#include <SDL3/SDL.h>
+
+#define WC_GRAPH_MAX_BARRIERS (WC_GRAPH_MAX_PASSES * WC_GRAPH_MAX_PASS_USES + WC_GRAPH_MAX_RESOURCES)
+#define WC_GRAPH_MAX_RETIRED 4
+
+typedef struct
+{
+	VkPipelineStageFlags2 stage;
+	VkAccessFlags2 access;
+	VkImageLayout layout;
+	VkImageUsageFlags usage;
+	bool write;
+} GraphAccessInfo;
+
+static const GraphAccessInfo s_access_info[] = {
+	[WC_GRAPH_COLOR_WRITE] = {VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+							  VK_ACCESS_2_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+							  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, true},
+	[WC_GRAPH_DEPTH_WRITE] = {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+							  VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+							  VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, true},
+	[WC_GRAPH_DEPTH_READ] = {VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+							 VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_IMAGE_LAYOUT_DEPTH_READ_ONLY_OPTIMAL,
+							 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT, false},
+	[WC_GRAPH_SAMPLED] = {VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+						  VK_ACCESS_2_SHADER_SAMPLED_READ_BIT, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						  VK_IMAGE_USAGE_SAMPLED_BIT, false},
+	[WC_GRAPH_STORAGE_READ] = {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT,
+							   VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, false},
+	[WC_GRAPH_STORAGE_WRITE] = {VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+								VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT,
+								VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT, true},
+	[WC_GRAPH_INDIRECT_READ] = {VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT,
+								VK_IMAGE_LAYOUT_UNDEFINED, 0, false},
+	// Copies, blits and clears alike
+	[WC_GRAPH_TRANSFER_READ] = {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT,
+								VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT, false},
+	[WC_GRAPH_TRANSFER_WRITE] = {VK_PIPELINE_STAGE_2_ALL_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT,
+								 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT, true},
+};
+
+typedef struct
+{
+	uint32_t resource;
+	WC_GraphAccess access;
+	bool clear;
+	VkClearValue clearValue;
+} GraphUse;
+
+typedef struct
+{
+	const char* name;
+	bool graphics;
+	WC_GraphExecuteFn execute;
+	void* userData;
+	GraphUse uses[WC_GRAPH_MAX_PASS_USES];
+	uint32_t useCount;
+
+	uint32_t barrierFirst;
+	uint32_t barrierCount;
+	VkExtent2D renderArea;
+} GraphPass;
+
+typedef struct
+{
+	const char* name;
+	bool isImage;
+	bool imported;
+	VkFormat format;
+	VkExtent2D extent;
+	VkImageLayout initialLayout;
+	VkImageLayout finalLayout;
+	VkImageUsageFlags usage;
+
+	VkImage image;
+	VkImageView view;
+	VkBuffer buffer;
+
+	uint32_t firstPass;
+	uint32_t lastPass;
+	uint32_t block;
+	uint32_t firstBarrier;
+	VkMemoryRequirements requirements;
+} GraphResource;
+
+// Sync state of a resource while walking the passes: the last write, and the reads since then
+typedef struct
+{
+	VkImageLayout layout;
+	VkPipelineStageFlags2 writeStage;
+	VkAccessFlags2 writeAccess;
+	VkPipelineStageFlags2 readStages;
+	VkAccessFlags2 readAccess;
+} GraphState;
+
+typedef struct
+{
+	uint32_t resource;
+	VkPipelineStageFlags2 srcStage;
+	VkAccessFlags2 srcAccess;
+	VkPipelineStageFlags2 dstStage;
+	VkAccessFlags2 dstAccess;
+	VkImageLayout oldLayout;
+	VkImageLayout newLayout;
+} GraphBarrier;
+
+typedef struct
+{
+	VmaAllocation allocation;
+	VkMemoryRequirements requirements;
+	VkPipelineStageFlags2 lastStages; // Of every member, for the next frame's first use
+	VkAccessFlags2 lastWrites;
+} GraphBlock;
+
+// Transients of a replaced graph, kept until the frames recorded with it have completed
+typedef struct
+{
+	VkImage images[WC_GRAPH_MAX_RESOURCES];
+	VkImageView views[WC_GRAPH_MAX_RESOURCES];
+	uint32_t imageCount;
+	VmaAllocation allocations[WC_GRAPH_MAX_RESOURCES];
+	uint32_t allocationCount;
+	uint64_t frame;
+} GraphRetired;
+
+typedef struct
+{
+	VkDevice device;
+	VmaAllocator allocator;
+
+	GraphPass passes[WC_GRAPH_MAX_PASSES];
+	uint32_t passCount;
+	GraphResource resources[WC_GRAPH_MAX_RESOURCES];
+	uint32_t resourceCount;
+
+	GraphBarrier barriers[WC_GRAPH_MAX_BARRIERS];
+	uint32_t barrierCount;
+	uint32_t finalBarrierFirst;
+	uint32_t finalBarrierCount;
+
+	GraphBlock blocks[WC_GRAPH_MAX_RESOURCES];
+	uint32_t blockCount;
+	VkDeviceSize allocatedBytes;
+	VkDeviceSize unaliasedBytes;
+	bool compiled;
+
+	GraphRetired retired[WC_GRAPH_MAX_RETIRED];
+	uint32_t retiredCount;
+} RenderGraph;
+
+static RenderGraph s_graph;
+
+static bool graph_is_depth(const VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+		   format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+int wc_graph_init(VkDevice device, VmaAllocator allocator)
+{
+	SDL_memset(&s_graph, 0, sizeof(s_graph));
+	s_graph.device = device;
+	s_graph.allocator = allocator;
+	return EXIT_SUCCESS;
+}
+
+void wc_graph_quit(void)
+{
+	wc_graph_reset(0);
+	wc_graph_release(UINT64_MAX);
+}
+
+static void graph_destroy_retired(const GraphRetired* retired)
+{
+	for (uint32_t i = 0; i < retired->imageCount; i++)
+	{
+		vkDestroyImageView(s_graph.device, retired->views[i], NULL);
+		vkDestroyImage(s_graph.device, retired->images[i], NULL);
+	}
+	for (uint32_t i = 0; i < retired->allocationCount; i++)
+		vmaFreeMemory(s_graph.allocator, retired->allocations[i]);
+}
+
+void wc_graph_reset(const uint64_t frame)
+{
+	// The renderer releases at least as often as it resets, so running out means a missed release
+	if (s_graph.retiredCount == WC_GRAPH_MAX_RETIRED)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph retirement list full, freeing the oldest early\n");
+		graph_destroy_retired(&s_graph.retired[0]);
+		SDL_memmove(s_graph.retired, s_graph.retired + 1, (WC_GRAPH_MAX_RETIRED - 1) * sizeof(*s_graph.retired));
+		s_graph.retiredCount--;
+	}
+
+	GraphRetired* retired = &s_graph.retired[s_graph.retiredCount++];
+	retired->frame = frame;
+	retired->imageCount = 0;
+	retired->allocationCount = 0;
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		const GraphResource* resource = &s_graph.resources[i];
+		if (resource->imported || resource->image == VK_NULL_HANDLE)
+			continue;
+		retired->images[retired->imageCount] = resource->image;
+		retired->views[retired->imageCount++] = resource->view;
+	}
+	for (uint32_t i = 0; i < s_graph.blockCount; i++)
+		retired->allocations[retired->allocationCount++] = s_graph.blocks[i].allocation;
+
+	s_graph.passCount = 0;
+	s_graph.resourceCount = 0;
+	s_graph.barrierCount = 0;
+	s_graph.finalBarrierCount = 0;
+	s_graph.blockCount = 0;
+	s_graph.allocatedBytes = 0;
+	s_graph.unaliasedBytes = 0;
+	s_graph.compiled = false;
+}
+
+void wc_graph_release(const uint64_t completed_frame)
+{
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < s_graph.retiredCount; i++)
+	{
+		if (s_graph.retired[i].frame <= completed_frame)
+			graph_destroy_retired(&s_graph.retired[i]);
+		else
+			s_graph.retired[kept++] = s_graph.retired[i];
+	}
+	s_graph.retiredCount = kept;
+}
+
+static uint32_t graph_add_resource(const char* name, const bool is_image, const bool imported)
+{
+	if (s_graph.resourceCount == WC_GRAPH_MAX_RESOURCES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph resource limit reached (%s)\n", name);
+		return WC_GRAPH_NONE;
+	}
+	GraphResource* resource = &s_graph.resources[s_graph.resourceCount];
+	SDL_memset(resource, 0, sizeof(*resource));
+	resource->name = name;
+	resource->isImage = is_image;
+	resource->imported = imported;
+	resource->firstPass = WC_GRAPH_NONE;
+	resource->block = WC_GRAPH_NONE;
+	resource->firstBarrier = WC_GRAPH_NONE;
+	return s_graph.resourceCount++;
+}
+
+uint32_t wc_graph_import_image(const char* name, const VkFormat format, const VkExtent2D extent,
+							   const VkImageLayout initial_layout, const VkImageLayout final_layout)
+{
+	const uint32_t index = graph_add_resource(name, true, true);
+	if (index == WC_GRAPH_NONE)
+		return WC_GRAPH_NONE;
+	GraphResource* resource = &s_graph.resources[index];
+	resource->format = format;
+	resource->extent = extent;
+	resource->initialLayout = initial_layout;
+	resource->finalLayout = final_layout;
+	return index;
+}
+
+uint32_t wc_graph_import_buffer(const char* name)
+{
+	return graph_add_resource(name, false, true);
+}
+
+uint32_t wc_graph_create_image(const char* name, const WC_GraphImageDesc desc)
+{
+	const uint32_t index = graph_add_resource(name, true, false);
+	if (index == WC_GRAPH_NONE)
+		return WC_GRAPH_NONE;
+	GraphResource* resource = &s_graph.resources[index];
+	resource->format = desc.format;
+	resource->extent = desc.extent;
+	resource->initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	resource->finalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	return index;
+}
+
+uint32_t wc_graph_add_pass(const char* name, const bool graphics, const WC_GraphExecuteFn execute, void* user_data)
+{
+	if (s_graph.passCount == WC_GRAPH_MAX_PASSES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph pass limit reached (%s)\n", name);
+		return WC_GRAPH_NONE;
+	}
+	GraphPass* pass = &s_graph.passes[s_graph.passCount];
+	SDL_memset(pass, 0, sizeof(*pass));
+	pass->name = name;
+	pass->graphics = graphics;
+	pass->execute = execute;
+	pass->userData = user_data;
+	return s_graph.passCount++;
+}
+
+void wc_graph_use(const uint32_t pass, const uint32_t resource, const WC_GraphAccess access, const VkClearValue* clear)
+{
+	if (pass >= s_graph.passCount || resource >= s_graph.resourceCount)
+		return;
+	GraphPass* graphPass = &s_graph.passes[pass];
+	if (graphPass->useCount == WC_GRAPH_MAX_PASS_USES)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph pass %s uses too many resources\n", graphPass->name);
+		return;
+	}
+	GraphUse* use = &graphPass->uses[graphPass->useCount++];
+	use->resource = resource;
+	use->access = access;
+	use->clear = clear != NULL;
+	if (clear)
+		use->clearValue = *clear;
+}
+
+static GraphBarrier* graph_push_barrier(const uint32_t resource, const GraphState* state, const GraphAccessInfo* info)
+{
+	GraphBarrier* barrier = &s_graph.barriers[s_graph.barrierCount++];
+	barrier->resource = resource;
+	barrier->srcStage = state->writeStage | state->readStages;
+	barrier->srcAccess = state->writeAccess; // Write-after-read only needs the execution dependency
+	barrier->dstStage = info->stage;
+	barrier->dstAccess = info->access;
+	barrier->oldLayout = state->layout;
+	barrier->newLayout = s_graph.resources[resource].isImage ? info->layout : VK_IMAGE_LAYOUT_UNDEFINED;
+	return barrier;
+}
+
+// Walks the passes in order and records the minimal barrier per use: writes and layout changes
+// always get one, reads only when the last write is not yet visible to their stage and access
+static void graph_build_barriers(void)
+{
+	GraphState states[WC_GRAPH_MAX_RESOURCES] = {0};
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+		states[i].layout = s_graph.resources[i].initialLayout;
+
+	for (uint32_t p = 0; p < s_graph.passCount; p++)
+	{
+		GraphPass* pass = &s_graph.passes[p];
+		pass->barrierFirst = s_graph.barrierCount;
+		for (uint32_t u = 0; u < pass->useCount; u++)
+		{
+			const GraphUse* use = &pass->uses[u];
+			GraphResource* resource = &s_graph.resources[use->resource];
+			GraphState* state = &states[use->resource];
+			const GraphAccessInfo* info = &s_access_info[use->access];
+
+			// Entry: imported resources are synchronized by semaphores or fences, so the first barrier
+			// only has to chain with its own stage (the acquire semaphore wait for swapchain images)
+			const bool first = resource->firstPass == p;
+			if (first)
+			{
+				state->writeStage = info->stage;
+				state->writeAccess = 0;
+			}
+
+			const bool layoutChange = resource->isImage && state->layout != info->layout;
+			if (info->write || layoutChange)
+			{
+				const GraphBarrier* barrier = graph_push_barrier(use->resource, state, info);
+				if (first && !resource->imported)
+					resource->firstBarrier = (uint32_t)(barrier - s_graph.barriers);
+				state->layout = info->layout;
+				state->writeStage = info->write ? info->stage : 0;
+				state->writeAccess = info->write ? info->access : 0;
+				state->readStages = info->write ? 0 : info->stage;
+				state->readAccess = info->write ? 0 : info->access;
+			}
+			else
+			{
+				const bool visible =
+					(state->readStages & info->stage) == info->stage && (state->readAccess & info->access) == info->access;
+				if (state->writeAccess != 0 && !visible)
+				{
+					GraphState writeOnly = *state;
+					writeOnly.readStages = 0;
+					graph_push_barrier(use->resource, &writeOnly, info);
+				}
+				state->readStages |= info->stage;
+				state->readAccess |= info->access;
+			}
+		}
+		pass->barrierCount = s_graph.barrierCount - pass->barrierFirst;
+	}
+
+	// Exit: imported images are handed back in their final layout, transients remember their last
+	// stages so the next frame's first use (possibly by another alias) waits on them
+	s_graph.finalBarrierFirst = s_graph.barrierCount;
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		GraphResource* resource = &s_graph.resources[i];
+		const GraphState* state = &states[i];
+		if (resource->firstPass == WC_GRAPH_NONE)
+			continue;
+		if (!resource->imported)
+		{
+			GraphBlock* block = &s_graph.blocks[resource->block];
+			block->lastStages |= state->writeStage | state->readStages;
+			block->lastWrites |= state->writeAccess;
+			continue;
+		}
+		if (!resource->isImage || resource->finalLayout == state->layout)
+			continue;
+		GraphBarrier* barrier = &s_graph.barriers[s_graph.barrierCount++];
+		barrier->resource = i;
+		barrier->srcStage = state->writeStage | state->readStages;
+		barrier->srcAccess = state->writeAccess;
+		barrier->dstStage = VK_PIPELINE_STAGE_2_NONE;
+		barrier->dstAccess = 0;
+		barrier->oldLayout = state->layout;
+		barrier->newLayout = resource->finalLayout;
+	}
+	s_graph.finalBarrierCount = s_graph.barrierCount - s_graph.finalBarrierFirst;
+
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		const GraphResource* resource = &s_graph.resources[i];
+		if (resource->firstBarrier == WC_GRAPH_NONE)
+			continue;
+		GraphBarrier* barrier = &s_graph.barriers[resource->firstBarrier];
+		barrier->srcStage |= s_graph.blocks[resource->block].lastStages;
+		barrier->srcAccess = s_graph.blocks[resource->block].lastWrites;
+		barrier->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED; // Contents of an aliased image are never kept
+	}
+}
+
+static int compare_size(const void* a, const void* b)
+{
+	const VkDeviceSize lhs = s_graph.resources[*(const uint32_t*)a].requirements.size;
+	const VkDeviceSize rhs = s_graph.resources[*(const uint32_t*)b].requirements.size;
+	return (lhs < rhs) - (lhs > rhs);
+}
+
+// Greedy interval packing, largest first: a transient joins the first block whose members are
+// all dead before its first pass or born after its last one
+static int graph_alias_transients(void)
+{
+	uint32_t order[WC_GRAPH_MAX_RESOURCES];
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		const GraphResource* resource = &s_graph.resources[i];
+		if (!resource->imported && resource->firstPass != WC_GRAPH_NONE)
+			order[count++] = i;
+	}
+	SDL_qsort(order, count, sizeof(*order), compare_size);
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		GraphResource* resource = &s_graph.resources[order[i]];
+		s_graph.unaliasedBytes += resource->requirements.size;
+		for (uint32_t b = 0; b < s_graph.blockCount && resource->block == WC_GRAPH_NONE; b++)
+		{
+			if ((s_graph.blocks[b].requirements.memoryTypeBits & resource->requirements.memoryTypeBits) == 0)
+				continue;
+			bool overlaps = false;
+			for (uint32_t j = 0; j < i && !overlaps; j++)
+			{
+				const GraphResource* other = &s_graph.resources[order[j]];
+				overlaps = other->block == b && other->firstPass <= resource->lastPass && resource->firstPass <= other->lastPass;
+			}
+			if (!overlaps)
+				resource->block = b;
+		}
+		if (resource->block == WC_GRAPH_NONE)
+		{
+			resource->block = s_graph.blockCount++;
+			s_graph.blocks[resource->block] = (GraphBlock){.requirements = resource->requirements};
+		}
+		VkMemoryRequirements* requirements = &s_graph.blocks[resource->block].requirements;
+		requirements->size = SDL_max(requirements->size, resource->requirements.size);
+		requirements->alignment = SDL_max(requirements->alignment, resource->requirements.alignment);
+		requirements->memoryTypeBits &= resource->requirements.memoryTypeBits;
+	}
+
+	VmaAllocationCreateInfo allocInfo = {0};
+	allocInfo.requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	for (uint32_t b = 0; b < s_graph.blockCount; b++)
+	{
+		GraphBlock* block = &s_graph.blocks[b];
+		if (vmaAllocateMemory(s_graph.allocator, &block->requirements, &allocInfo, &block->allocation, NULL) != VK_SUCCESS)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph transient allocation failed\n");
+			return EXIT_FAILURE;
+		}
+		s_graph.allocatedBytes += block->requirements.size;
+	}
+	return EXIT_SUCCESS;
+}
+
+static int graph_create_transient(GraphResource* resource)
+{
+	VkImageCreateInfo imageInfo = {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = resource->format;
+	imageInfo.extent = (VkExtent3D){resource->extent.width, resource->extent.height, 1};
+	imageInfo.mipLevels = 1;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = resource->usage;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (vkCreateImage(s_graph.device, &imageInfo, NULL, &resource->image) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph image %s creation failed\n", resource->name);
+		return EXIT_FAILURE;
+	}
+	vkGetImageMemoryRequirements(s_graph.device, resource->image, &resource->requirements);
+	return EXIT_SUCCESS;
+}
+
+static int graph_create_view(GraphResource* resource)
+{
+	VkImageViewCreateInfo viewInfo = {.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+	viewInfo.image = resource->image;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = resource->format;
+	viewInfo.subresourceRange.aspectMask = graph_is_depth(resource->format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (vkCreateImageView(s_graph.device, &viewInfo, NULL, &resource->view) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Render graph view %s creation failed\n", resource->name);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+int wc_graph_compile(void)
+{
+	for (uint32_t p = 0; p < s_graph.passCount; p++)
+	{
+		GraphPass* pass = &s_graph.passes[p];
+		for (uint32_t u = 0; u < pass->useCount; u++)
+		{
+			GraphResource* resource = &s_graph.resources[pass->uses[u].resource];
+			if (resource->firstPass == WC_GRAPH_NONE)
+				resource->firstPass = p;
+			resource->lastPass = p;
+			resource->usage |= s_access_info[pass->uses[u].access].usage;
+
+			const WC_GraphAccess access = pass->uses[u].access;
+			const bool attachment = access == WC_GRAPH_COLOR_WRITE || access == WC_GRAPH_DEPTH_WRITE || access == WC_GRAPH_DEPTH_READ;
+			if (pass->graphics && attachment && pass->renderArea.width == 0)
+				pass->renderArea = resource->extent;
+		}
+	}
+
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		GraphResource* resource = &s_graph.resources[i];
+		if (!resource->imported && resource->firstPass != WC_GRAPH_NONE && graph_create_transient(resource) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+	if (graph_alias_transients() != EXIT_SUCCESS)
+		return EXIT_FAILURE;
+	for (uint32_t i = 0; i < s_graph.resourceCount; i++)
+	{
+		GraphResource* resource = &s_graph.resources[i];
+		if (resource->imported || resource->firstPass == WC_GRAPH_NONE)
+			continue;
+		if (vmaBindImageMemory(s_graph.allocator, s_graph.blocks[resource->block].allocation, resource->image) != VK_SUCCESS ||
+			graph_create_view(resource) != EXIT_SUCCESS)
+			return EXIT_FAILURE;
+	}
+
+	graph_build_barriers();
+	s_graph.compiled = true;
+	SDL_Log("Render graph: %u passes, %u barriers, transient memory %" SDL_PRIu64 " KiB (%" SDL_PRIu64 " KiB unaliased)\n",
+			s_graph.passCount, s_graph.barrierCount, (uint64_t)s_graph.allocatedBytes / 1024,
+			(uint64_t)s_graph.unaliasedBytes / 1024);
+	return EXIT_SUCCESS;
+}
+
+void wc_graph_set_image(const uint32_t resource, VkImage image, VkImageView view)
+{
+	if (resource >= s_graph.resourceCount)
+		return;
+	s_graph.resources[resource].image = image;
+	s_graph.resources[resource].view = view;
+}
+
+void wc_graph_set_buffer(const uint32_t resource, VkBuffer buffer)
+{
+	if (resource >= s_graph.resourceCount)
+		return;
+	s_graph.resources[resource].buffer = buffer;
+}
+
+VkImage wc_graph_get_image(const uint32_t resource)
+{
+	return resource < s_graph.resourceCount ? s_graph.resources[resource].image : VK_NULL_HANDLE;
+}
+
+VkImageView wc_graph_get_view(const uint32_t resource)
+{
+	return resource < s_graph.resourceCount ? s_graph.resources[resource].view : VK_NULL_HANDLE;
+}
+
+static void graph_emit_barriers(VkCommandBuffer command_buffer, const uint32_t first, const uint32_t count)
+{
+	if (count == 0)
+		return;
+
+	VkImageMemoryBarrier2 imageBarriers[WC_GRAPH_MAX_PASS_USES + WC_GRAPH_MAX_RESOURCES];
+	VkBufferMemoryBarrier2 bufferBarriers[WC_GRAPH_MAX_PASS_USES + WC_GRAPH_MAX_RESOURCES];
+	uint32_t imageCount = 0;
+	uint32_t bufferCount = 0;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const GraphBarrier* barrier = &s_graph.barriers[i];
+		const GraphResource* resource = &s_graph.resources[barrier->resource];
+		if (resource->isImage)
+		{
+			VkImageMemoryBarrier2* image = &imageBarriers[imageCount++];
+			*image = (VkImageMemoryBarrier2){.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2};
+			image->srcStageMask = barrier->srcStage;
+			image->srcAccessMask = barrier->srcAccess;
+			image->dstStageMask = barrier->dstStage;
+			image->dstAccessMask = barrier->dstAccess;
+			image->oldLayout = barrier->oldLayout;
+			image->newLayout = barrier->newLayout;
+			image->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			image->image = resource->image;
+			image->subresourceRange.aspectMask =
+				graph_is_depth(resource->format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+			image->subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			image->subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+		}
+		else
+		{
+			VkBufferMemoryBarrier2* buffer = &bufferBarriers[bufferCount++];
+			*buffer = (VkBufferMemoryBarrier2){.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2};
+			buffer->srcStageMask = barrier->srcStage;
+			buffer->srcAccessMask = barrier->srcAccess;
+			buffer->dstStageMask = barrier->dstStage;
+			buffer->dstAccessMask = barrier->dstAccess;
+			buffer->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			buffer->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			buffer->buffer = resource->buffer;
+			buffer->size = VK_WHOLE_SIZE;
+		}
+	}
+
+	VkDependencyInfo dependency = {.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO};
+	dependency.imageMemoryBarrierCount = imageCount;
+	dependency.pImageMemoryBarriers = imageBarriers;
+	dependency.bufferMemoryBarrierCount = bufferCount;
+	dependency.pBufferMemoryBarriers = bufferBarriers;
+	vkCmdPipelineBarrier2(command_buffer, &dependency);
+}
+
+static void graph_begin_rendering(VkCommandBuffer command_buffer, const uint32_t index)
+{
+	const GraphPass* pass = &s_graph.passes[index];
+	VkRenderingAttachmentInfo colors[WC_GRAPH_MAX_PASS_USES];
+	VkRenderingAttachmentInfo depth = {.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+	uint32_t colorCount = 0;
+	bool hasDepth = false;
+	for (uint32_t u = 0; u < pass->useCount; u++)
+	{
+		const GraphUse* use = &pass->uses[u];
+		if (use->access != WC_GRAPH_COLOR_WRITE && use->access != WC_GRAPH_DEPTH_WRITE && use->access != WC_GRAPH_DEPTH_READ)
+			continue;
+
+		const GraphResource* resource = &s_graph.resources[use->resource];
+		VkRenderingAttachmentInfo* attachment = use->access == WC_GRAPH_COLOR_WRITE ? &colors[colorCount++] : &depth;
+		*attachment = (VkRenderingAttachmentInfo){.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO};
+		attachment->imageView = resource->view;
+		attachment->imageLayout = s_access_info[use->access].layout;
+		// A transient holds nothing before its first pass and nobody reads it after its last, so
+		// tilers can skip both the load and the store
+		const bool transient = !resource->imported;
+		if (use->clear)
+			attachment->loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		else
+			attachment->loadOp = transient && resource->firstPass == index ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+		attachment->storeOp = transient && resource->lastPass == index ? VK_ATTACHMENT_STORE_OP_DONT_CARE : VK_ATTACHMENT_STORE_OP_STORE;
+		attachment->clearValue = use->clearValue;
+		hasDepth |= use->access != WC_GRAPH_COLOR_WRITE;
+	}
+
+	VkRenderingInfo renderingInfo = {.sType = VK_STRUCTURE_TYPE_RENDERING_INFO};
+	renderingInfo.renderArea.extent = pass->renderArea;
+	renderingInfo.layerCount = 1;
+	renderingInfo.colorAttachmentCount = colorCount;
+	renderingInfo.pColorAttachments = colors;
+	renderingInfo.pDepthAttachment = hasDepth ? &depth : NULL;
+	vkCmdBeginRendering(command_buffer, &renderingInfo);
+
+	const VkViewport viewport = {0.0f, 0.0f, (float)pass->renderArea.width, (float)pass->renderArea.height, 0.0f, 1.0f};
+	const VkRect2D scissor = {{0, 0}, pass->renderArea};
+	vkCmdSetViewport(command_buffer, 0, 1, &viewport);
+	vkCmdSetScissor(command_buffer, 0, 1, &scissor);
+}
+
+void wc_graph_execute(VkCommandBuffer command_buffer, const uint32_t profiler_slot)
+{
+	if (!s_graph.compiled)
+		return;
+
+	for (uint32_t p = 0; p < s_graph.passCount; p++)
+	{
+		const GraphPass* pass = &s_graph.passes[p];
+		graph_emit_barriers(command_buffer, pass->barrierFirst, pass->barrierCount);
+		// Opened outside the rendering scope so statistics queries never straddle it
+		const uint32_t zone = wc_gpu_profiler_begin(command_buffer, profiler_slot, pass->name, pass->graphics);
+		if (pass->graphics)
+			graph_begin_rendering(command_buffer, p);
+		if (pass->execute)
+			pass->execute(command_buffer, pass->userData);
+		if (pass->graphics)
+			vkCmdEndRendering(command_buffer);
+		wc_gpu_profiler_end(command_buffer, profiler_slot, zone);
+	}
+	graph_emit_barriers(command_buffer, s_graph.finalBarrierFirst, s_graph.finalBarrierCount);
+}
+
+void wc_graph_get_memory(VkDeviceSize* allocated, VkDeviceSize* unaliased)
+{
+	*allocated = s_graph.allocatedBytes;
+	*unaliased = s_graph.unaliasedBytes;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include "allocator.h"
+
+#define WC_GRAPH_MAX_PASSES 32
+#define WC_GRAPH_MAX_RESOURCES 32
+#define WC_GRAPH_MAX_PASS_USES 8
+#define WC_GRAPH_NONE UINT32_MAX
+
+// How a pass touches a resource. Each maps to one stage/access/layout triple, so barriers are
+// derived from these alone.
+typedef enum WC_GraphAccess
+{
+	WC_GRAPH_COLOR_WRITE,
+	WC_GRAPH_DEPTH_WRITE,
+	WC_GRAPH_DEPTH_READ,
+	WC_GRAPH_SAMPLED,		// fragment or compute shader read through a sampler
+	WC_GRAPH_STORAGE_READ,	// compute shader storage image/buffer read
+	WC_GRAPH_STORAGE_WRITE, // compute shader storage image/buffer write
+	WC_GRAPH_INDIRECT_READ, // draw/dispatch indirect arguments
+	WC_GRAPH_TRANSFER_READ,
+	WC_GRAPH_TRANSFER_WRITE,
+} WC_GraphAccess;
+
+typedef void (*WC_GraphExecuteFn)(VkCommandBuffer command_buffer, void* user_data);
+
+// Transient images live only inside the graph: their memory comes from VMA and is shared by
+// transients whose pass ranges do not overlap. Usage flags are derived from the declared accesses.
+typedef struct WC_GraphImageDesc
+{
+	VkFormat format;
+	VkExtent2D extent;
+} WC_GraphImageDesc;
+
+// The graph is declared and compiled once (again after a resize), then executed every frame:
+// barriers, attachments and aliasing are all resolved at compile time, so execution only walks
+// precomputed arrays. Passes run in declaration order.
+int wc_graph_init(VkDevice device, VmaAllocator allocator);
+void wc_graph_quit(void);
+
+// Drops all passes so the graph can be declared again. Transient images and memory stay alive,
+// tagged with frame, until wc_graph_release is given a completed frame at or past it.
+void wc_graph_reset(uint64_t frame);
+void wc_graph_release(uint64_t completed_frame);
+
+// External images keep their handles outside the graph and may change per frame (swapchain).
+// They enter each frame in initial_layout and are left in final_layout.
+uint32_t wc_graph_import_image(const char* name, VkFormat format, VkExtent2D extent, VkImageLayout initial_layout,
+							   VkImageLayout final_layout);
+uint32_t wc_graph_import_buffer(const char* name);
+uint32_t wc_graph_create_image(const char* name, WC_GraphImageDesc desc);
+
+// Graphics passes get dynamic rendering begun and ended around execute, using their colour and
+// depth writes as attachments. Attachments with a clear value are cleared, transients without one
+// start undefined, everything else is loaded.
+uint32_t wc_graph_add_pass(const char* name, bool graphics, WC_GraphExecuteFn execute, void* user_data);
+void wc_graph_use(uint32_t pass, uint32_t resource, WC_GraphAccess access, const VkClearValue* clear);
+
+int wc_graph_compile(void);
+
+// Per-frame handles for imported resources, set before execute
+void wc_graph_set_image(uint32_t resource, VkImage image, VkImageView view);
+void wc_graph_set_buffer(uint32_t resource, VkBuffer buffer);
+VkImage wc_graph_get_image(uint32_t resource);
+VkImageView wc_graph_get_view(uint32_t resource);
+
+// Every pass gets a GPU profiler zone in profiler_slot under its name, with pipeline statistics
+// for graphics passes. Pass WC_GPU_PROFILER_NONE to record without zones.
+void wc_graph_execute(VkCommandBuffer command_buffer, uint32_t profiler_slot);
+
+// Transient memory actually allocated vs. what one allocation per image would have cost
+void wc_graph_get_memory(VkDeviceSize* allocated, VkDeviceSize* unaliased);
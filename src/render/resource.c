@@ -1,16 +1,12 @@
 #include "resource.h"
 
+#include "buffer.h"
+#include "meshlet.h"
+
+#include <SDL3/SDL.h>
 #include <vk_mem_alloc.h>
 #include <volk.h>
 
-struct WC_Buffer
-{
-	VkBuffer buffer;
-	VkBufferView bufferView;
-	VkDescriptorBufferInfo descriptorBuffer;
-	VmaAllocation allocation;
-};
-
 struct WC_Texture
 {
 	VkImage image;
@@ -20,6 +16,12 @@ struct WC_Texture
 	VmaAllocation allocation;
 };
 
+typedef struct
+{
+	uint32_t slot;
+	uint64_t frame;
+} WC_RetiredSlot;
+
 struct WC_GpuResources
 {
 	// Descriptor pool and set for bindless resources
@@ -28,29 +30,56 @@ struct WC_GpuResources
 	VkDescriptorSet bindlessSet;
 
 	// Global buffers
-	VkBuffer meshDataBuffer;
-	VmaAllocation meshDataAllocation;
-	VkBuffer materialDataBuffer;
-	VmaAllocation materialDataAllocation;
-	VkBuffer instanceBuffer;
-	VmaAllocation instanceAllocation;
+	WC_Buffer meshDataBuffer;
+	WC_Buffer materialDataBuffer;
+	WC_Buffer instanceBuffer;
+	WC_GpuInstance* instanceData; // Persistently mapped, WC_FRAMES_IN_FLIGHT regions of WC_MAX_INSTANCES
+	uint32_t instanceRegion;
+	uint32_t instanceFirst;
+	uint32_t instanceCount;
 
 	// Vertex and index buffers (single large buffers for all meshes)
-	VkBuffer vertexBuffer;
-	VmaAllocation vertexAllocation;
-	VkBuffer indexBuffer;
-	VmaAllocation indexAllocation;
+	WC_Buffer vertexBuffer;
+	WC_Buffer indexBuffer;
+
+	// Meshlet headers, vertex remap and packed triangles for task/mesh shader cluster culling
+	WC_Buffer meshletBuffer;
+	WC_Buffer meshletVertexBuffer;
+	WC_Buffer meshletTriangleBuffer;
 
 	// Indirect draw buffer
-	VkBuffer indirectBuffer;
-	VmaAllocation indirectAllocation;
+	WC_Buffer indirectBuffer;
+
+	// Bindless texture slots: free stack, slots waiting for in-flight frames to retire, and
+	// writes queued for the next flush (one pending image info per slot, last write wins). A slot
+	// is live from add to remove, which keeps it off the free and retire lists more than once.
+	uint32_t freeSlots[WC_MAX_BINDLESS_RESOURCES];
+	uint32_t freeSlotCount;
+	uint8_t liveSlots[WC_MAX_BINDLESS_RESOURCES];
+	WC_RetiredSlot retiredSlots[WC_MAX_BINDLESS_RESOURCES];
+	uint32_t retiredHead;
+	uint32_t retiredCount;
+	VkDescriptorImageInfo pendingImages[WC_MAX_BINDLESS_RESOURCES];
+	uint8_t pendingQueued[WC_MAX_BINDLESS_RESOURCES];
+	uint32_t pendingSlots[WC_MAX_BINDLESS_RESOURCES];
+	uint32_t pendingCount;
+	uint32_t dirtyBuffers; // One bit per storage buffer binding
+
+	// Scratch for building the single vkUpdateDescriptorSets call
+	VkDescriptorImageInfo flushImages[WC_MAX_BINDLESS_RESOURCES];
+	VkWriteDescriptorSet flushWrites[WC_MAX_BINDLESS_RESOURCES + WC_BINDING_TEXTURES];
 
 	// Counters
+	uint64_t frame;
 	uint32_t meshCount;
 	uint32_t materialCount;
 	uint32_t textureCount;
 	uint32_t currentVertexOffset;
 	uint32_t currentIndexOffset;
+	uint32_t currentMeshletOffset;
+	uint32_t currentMeshletVertexOffset;
+	uint32_t currentMeshletTriangleOffset;
+	uint32_t maxMeshletCount;
 
 	// Vulkan context
 	VkDevice device;
@@ -59,17 +88,6 @@ struct WC_GpuResources
 
 static WC_GpuResources s_resources;
 
-static VkResult wc_create_buffer(VmaAllocator allocator, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memoryUsage,
-								 VkBuffer* buffer, VmaAllocation* allocation)
-{
-	const VkBufferCreateInfo bufferInfo = {
-		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO, .size = size, .usage = usage, .sharingMode = VK_SHARING_MODE_EXCLUSIVE};
-
-	const VmaAllocationCreateInfo allocInfo = {.usage = memoryUsage};
-
-	return vmaCreateBuffer(allocator, &bufferInfo, &allocInfo, buffer, allocation, NULL);
-}
-
 int wc_gpu_resource_init(VkDevice device, VmaAllocator allocator)
 {
 	s_resources.device = device;
@@ -79,6 +97,22 @@ int wc_gpu_resource_init(VkDevice device, VmaAllocator allocator)
 	s_resources.textureCount = 0;
 	s_resources.currentVertexOffset = 0;
 	s_resources.currentIndexOffset = 0;
+	s_resources.currentMeshletOffset = 0;
+	s_resources.currentMeshletVertexOffset = 0;
+	s_resources.currentMeshletTriangleOffset = 0;
+	s_resources.frame = 0;
+	s_resources.retiredHead = 0;
+	s_resources.retiredCount = 0;
+	s_resources.pendingCount = 0;
+	SDL_memset(s_resources.pendingQueued, 0, sizeof(s_resources.pendingQueued));
+	SDL_memset(s_resources.liveSlots, 0, sizeof(s_resources.liveSlots));
+
+	// Stack the slots in reverse so fresh allocations come out ascending and flush as contiguous runs
+	s_resources.freeSlotCount = WC_MAX_BINDLESS_RESOURCES;
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES; i++)
+	{
+		s_resources.freeSlots[i] = WC_MAX_BINDLESS_RESOURCES - 1 - i;
+	}
 
 	// Create descriptor pool for bindless resources
 	VkDescriptorPoolSize poolSizes[] = {
@@ -99,55 +133,61 @@ int wc_gpu_resource_init(VkDevice device, VmaAllocator allocator)
 		return result;
 
 	// Create bindless descriptor set layout
-	VkDescriptorSetLayoutBinding bindings[] = {// Mesh data buffer
-											   {.binding = 0,
-												.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-												.descriptorCount = 1,
-												.stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_FRAGMENT_BIT},
-											   // Material data buffer
-											   {.binding = 1,
-												.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-												.descriptorCount = 1,
-												.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT},
-											   // Instance data buffer
-											   {.binding = 2,
-												.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-												.descriptorCount = 1,
-												.stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT},
-											   // Vertex buffer
-											   {.binding = 3,
-												.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-												.descriptorCount = 1,
-												.stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT},
-											   // Index buffer
-											   {.binding = 4,
-												.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-												.descriptorCount = 1,
-												.stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT},
-											   // Bindless textures
-											   {.binding = 5,
-												.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-												.descriptorCount = WC_MAX_BINDLESS_RESOURCES,
-												.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT}};
-
-	VkDescriptorBindingFlags bindingFlags[] = {0,
-											   0,
-											   0,
-											   0,
-											   0,
-											   VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
-												   VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
-												   VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT};
+	const VkShaderStageFlags geometryStages = VK_SHADER_STAGE_TASK_BIT_EXT | VK_SHADER_STAGE_MESH_BIT_EXT;
+	// The visibility resolve refetches triangles from compute
+	const VkShaderStageFlags resolveStages = VK_SHADER_STAGE_MESH_BIT_EXT | VK_SHADER_STAGE_COMPUTE_BIT;
+	VkDescriptorSetLayoutBinding bindings[WC_BINDING_COUNT] = {
+		{.binding = WC_BINDING_MESH_DATA,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = geometryStages | VK_SHADER_STAGE_FRAGMENT_BIT | VK_SHADER_STAGE_COMPUTE_BIT},
+		{.binding = WC_BINDING_MATERIAL_DATA,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT},
+		{.binding = WC_BINDING_INSTANCE_DATA,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = geometryStages | VK_SHADER_STAGE_COMPUTE_BIT},
+		{.binding = WC_BINDING_VERTICES,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = resolveStages},
+		{.binding = WC_BINDING_INDICES,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = VK_SHADER_STAGE_MESH_BIT_EXT},
+		{.binding = WC_BINDING_MESHLETS,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = geometryStages | VK_SHADER_STAGE_COMPUTE_BIT},
+		{.binding = WC_BINDING_MESHLET_VERTICES,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = resolveStages},
+		{.binding = WC_BINDING_MESHLET_TRIANGLES,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+		 .descriptorCount = 1,
+		 .stageFlags = resolveStages},
+		{.binding = WC_BINDING_TEXTURES,
+		 .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+		 .descriptorCount = WC_MAX_BINDLESS_RESOURCES,
+		 .stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT}};
+
+	VkDescriptorBindingFlags bindingFlags[WC_BINDING_COUNT] = {0};
+	bindingFlags[WC_BINDING_TEXTURES] = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT |
+										VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT |
+										VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
 
 	VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = {
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
-		.bindingCount = 6,
+		.bindingCount = WC_BINDING_COUNT,
 		.pBindingFlags = bindingFlags};
 
 	VkDescriptorSetLayoutCreateInfo layoutInfo = {.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
 												  .pNext = &bindingFlagsInfo,
 												  .flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
-												  .bindingCount = 6,
+												  .bindingCount = WC_BINDING_COUNT,
 												  .pBindings = bindings};
 
 	result = vkCreateDescriptorSetLayout(device, &layoutInfo, NULL, &s_resources.bindlessLayout);
@@ -173,59 +213,82 @@ int wc_gpu_resource_init(VkDevice device, VmaAllocator allocator)
 	// Create buffers
 	const VkDeviceSize meshDataSize = sizeof(WC_GpuMeshData) * WC_MAX_MESHES;
 	const VkDeviceSize materialDataSize = sizeof(WC_GpuMaterialData) * WC_MAX_MATERIALS;
-	const VkDeviceSize instanceSize = sizeof(WC_GpuInstanceData) * 100000; // Support 100k instances
+	const VkDeviceSize instanceSize = sizeof(WC_GpuInstance) * WC_MAX_INSTANCES * WC_FRAMES_IN_FLIGHT;
 	const VkDeviceSize vertexSize = 1024 * 1024 * 1024;					   // 1GB for vertices
 	const VkDeviceSize indexSize = 512 * 1024 * 1024;					   // 512MB for indices
 	const VkDeviceSize indirectSize = sizeof(VkDrawIndexedIndirectCommand) * 100000;
+	const VkDeviceSize meshletSize = sizeof(WC_GpuMeshlet) * WC_MAX_MESHLETS;
+	const VkDeviceSize meshletVertexSize = sizeof(uint32_t) * WC_MAX_MESHLETS * WC_MESHLET_MAX_VERTICES / 2; // ~0.5 fill on average
+	const VkDeviceSize meshletTriangleSize = WC_MAX_MESHLETS * WC_MESHLET_MAX_TRIANGLES * 3 / 2;
+
+	// Static data is device-local and only written through staging (wc_buffer_upload)
+	const VkBufferUsageFlags storage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	result = wc_buffer_create(meshDataSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.meshDataBuffer);
+	if (result != VK_SUCCESS)
+		return result;
+
+	result = wc_buffer_create(materialDataSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.materialDataBuffer);
+	if (result != VK_SUCCESS)
+		return result;
 
-	result = wc_create_buffer(allocator, meshDataSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-							  VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.meshDataBuffer, &s_resources.meshDataAllocation);
+	// Rewritten every frame by the CPU: mapped for the buffer's lifetime and read in place by the
+	// shaders, straight from VRAM when the device exposes it to the host
+	result = wc_buffer_create(instanceSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, WC_BUFFER_MEMORY_DYNAMIC,
+							  &s_resources.instanceBuffer);
+	if (result != VK_SUCCESS)
+		return result;
+	s_resources.instanceData = s_resources.instanceBuffer.mapped;
+	s_resources.instanceRegion = 0;
+	s_resources.instanceFirst = 0;
+	s_resources.instanceCount = 0;
+	s_resources.maxMeshletCount = 0;
+	SDL_Log("Instance buffer in %s memory\n", s_resources.instanceBuffer.deviceLocal ? "device-local" : "system");
+
+	result = wc_buffer_create(vertexSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.vertexBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = wc_create_buffer(allocator, materialDataSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-							  VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.materialDataBuffer, &s_resources.materialDataAllocation);
+	result = wc_buffer_create(indexSize, storage | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, WC_BUFFER_MEMORY_STATIC,
+							  &s_resources.indexBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = wc_create_buffer(allocator, instanceSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-							  VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.instanceBuffer, &s_resources.instanceAllocation);
+	result = wc_buffer_create(indirectSize, storage | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT, WC_BUFFER_MEMORY_STATIC,
+							  &s_resources.indirectBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = wc_create_buffer(allocator, vertexSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-							  VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.vertexBuffer, &s_resources.vertexAllocation);
+	result = wc_buffer_create(meshletSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.meshletBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	result =
-		wc_create_buffer(allocator, indexSize,
-						 VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-						 VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.indexBuffer, &s_resources.indexAllocation);
+	result = wc_buffer_create(meshletVertexSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.meshletVertexBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	result = wc_create_buffer(allocator, indirectSize,
-							  VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT |
-								  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-							  VMA_MEMORY_USAGE_GPU_ONLY, &s_resources.indirectBuffer, &s_resources.indirectAllocation);
+	result = wc_buffer_create(meshletTriangleSize, storage, WC_BUFFER_MEMORY_STATIC, &s_resources.meshletTriangleBuffer);
 	if (result != VK_SUCCESS)
 		return result;
 
-	// Update initial descriptors for buffers
+	// Write the initial buffer descriptors
 	wc_gpu_resource_update_descriptors();
+	wc_gpu_resource_flush_descriptors();
 
 	return VK_SUCCESS;
 }
 
 void wc_gpu_resource_quit()
 {
-	vmaDestroyBuffer(s_resources.allocator, s_resources.indirectBuffer, s_resources.indirectAllocation);
-	vmaDestroyBuffer(s_resources.allocator, s_resources.indexBuffer, s_resources.indexAllocation);
-	vmaDestroyBuffer(s_resources.allocator, s_resources.vertexBuffer, s_resources.vertexAllocation);
-	vmaDestroyBuffer(s_resources.allocator, s_resources.instanceBuffer, s_resources.instanceAllocation);
-	vmaDestroyBuffer(s_resources.allocator, s_resources.materialDataBuffer, s_resources.materialDataAllocation);
-	vmaDestroyBuffer(s_resources.allocator, s_resources.meshDataBuffer, s_resources.meshDataAllocation);
+	wc_buffer_destroy(&s_resources.meshletTriangleBuffer);
+	wc_buffer_destroy(&s_resources.meshletVertexBuffer);
+	wc_buffer_destroy(&s_resources.meshletBuffer);
+	wc_buffer_destroy(&s_resources.indirectBuffer);
+	wc_buffer_destroy(&s_resources.indexBuffer);
+	wc_buffer_destroy(&s_resources.vertexBuffer);
+	wc_buffer_destroy(&s_resources.instanceBuffer);
+	s_resources.instanceData = NULL;
+	wc_buffer_destroy(&s_resources.materialDataBuffer);
+	wc_buffer_destroy(&s_resources.meshDataBuffer);
 	vkDestroyDescriptorSetLayout(s_resources.device, s_resources.bindlessLayout, NULL);
 	vkDestroyDescriptorPool(s_resources.device, s_resources.descriptorPool, NULL);
 }
@@ -238,98 +301,346 @@ uint32_t wc_gpu_resource_add_mesh(const float* vertices, uint32_t vertexCount, u
 		return UINT32_MAX;
 	}
 
-	uint32_t meshIndex = s_resources.meshCount++;
-
-	// Create staging buffer and copy vertex/index data
-	VkDeviceSize vertexSize = vertexCount * vertexStride;
-	VkDeviceSize indexSize = indexCount * sizeof(uint32_t);
+	// Split into meshlets up front so the task shader can cull clusters instead of whole meshes
+	WC_MeshletData meshlets;
+	if (wc_meshlet_build(&meshlets, vertices, vertexCount, vertexStride, indices, indexCount) != 0)
+	{
+		return UINT32_MAX;
+	}
+	// The vertex and triangle buffers are sized for average fill, so dense meshes can run out of
+	// them well before the meshlet limit; uploads are not bounds checked, so check every buffer here
+	const VkDeviceSize meshletVertexEnd =
+		((VkDeviceSize)s_resources.currentMeshletVertexOffset + meshlets.vertexCount) * sizeof(uint32_t);
+	const VkDeviceSize meshletTriangleEnd = (VkDeviceSize)s_resources.currentMeshletTriangleOffset + meshlets.triangleByteCount;
+	if (s_resources.currentMeshletOffset + meshlets.meshletCount > WC_MAX_MESHLETS ||
+		meshletVertexEnd > s_resources.meshletVertexBuffer.size || meshletTriangleEnd > s_resources.meshletTriangleBuffer.size)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Meshlet buffers are full, mesh with %u meshlets rejected\n",
+					 meshlets.meshletCount);
+		wc_meshlet_free(&meshlets);
+		return UINT32_MAX;
+	}
 
-	VkBuffer stagingBuffer;
-	VmaAllocation stagingAllocation;
-	wc_create_buffer(s_resources.allocator, vertexSize + indexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
-					 &stagingBuffer, &stagingAllocation);
+	// Rebase meshlet offsets from this mesh onto the shared meshlet buffers
+	for (uint32_t i = 0; i < meshlets.meshletCount; i++)
+	{
+		meshlets.meshlets[i].vertexOffset += s_resources.currentMeshletVertexOffset;
+		meshlets.meshlets[i].triangleOffset += s_resources.currentMeshletTriangleOffset;
+	}
 
-	// Map and copy data
-	void* data;
-	vmaMapMemory(s_resources.allocator, stagingAllocation, &data);
-	memcpy(data, vertices, vertexSize);
-	memcpy((uint8_t*)data + vertexSize, indices, indexSize);
-	vmaUnmapMemory(s_resources.allocator, stagingAllocation);
+	uint32_t meshIndex = s_resources.meshCount++;
 
-	// Copy to GPU buffers (you'll need to record and submit command buffer)
-	// This is simplified - in practice you'd batch these transfers
+	const VkDeviceSize vertexSize = (VkDeviceSize)vertexCount * vertexStride;
+	const VkDeviceSize indexSize = indexCount * sizeof(uint32_t);
+	const VkDeviceSize meshletSize = meshlets.meshletCount * sizeof(WC_GpuMeshlet);
+	const VkDeviceSize meshletVertexSize = meshlets.vertexCount * sizeof(uint32_t);
+	const VkDeviceSize meshletTriangleSize = meshlets.triangleByteCount;
+
+	// Copies are batched in the uploader and submitted with the next frame
+	wc_buffer_upload(&s_resources.vertexBuffer, s_resources.currentVertexOffset * sizeof(uint32_t), vertices, vertexSize);
+	wc_buffer_upload(&s_resources.indexBuffer, s_resources.currentIndexOffset * sizeof(uint32_t), indices, indexSize);
+	wc_buffer_upload(&s_resources.meshletBuffer, s_resources.currentMeshletOffset * sizeof(WC_GpuMeshlet), meshlets.meshlets,
+					 meshletSize);
+	wc_buffer_upload(&s_resources.meshletVertexBuffer, s_resources.currentMeshletVertexOffset * sizeof(uint32_t),
+					 meshlets.vertices, meshletVertexSize);
+	wc_buffer_upload(&s_resources.meshletTriangleBuffer, s_resources.currentMeshletTriangleOffset, meshlets.triangles,
+					 meshletTriangleSize);
 
-	// Update mesh data
 	WC_GpuMeshData meshData = {.vertexOffset = s_resources.currentVertexOffset,
 							   .vertexCount = vertexCount,
+							   .vertexStride = vertexStride / sizeof(uint32_t),
 							   .indexOffset = s_resources.currentIndexOffset,
 							   .indexCount = indexCount,
-							   .materialIndex = materialIndex};
+							   .materialIndex = materialIndex,
+							   .meshletOffset = s_resources.currentMeshletOffset,
+							   .meshletCount = meshlets.meshletCount};
 	memcpy(meshData.boundingSphere, boundingSphere, sizeof(float) * 4);
+	wc_buffer_upload(&s_resources.meshDataBuffer, meshIndex * sizeof(WC_GpuMeshData), &meshData, sizeof(meshData));
 
-	// Upload mesh data (simplified - needs staging)
-	void* meshDataPtr;
-	vmaMapMemory(s_resources.allocator, s_resources.meshDataAllocation, &meshDataPtr);
-	memcpy((WC_GpuMeshData*)meshDataPtr + meshIndex, &meshData, sizeof(WC_GpuMeshData));
-	vmaUnmapMemory(s_resources.allocator, s_resources.meshDataAllocation);
-
-	s_resources.currentVertexOffset += vertexCount;
+	s_resources.currentVertexOffset += (uint32_t)(vertexSize / sizeof(uint32_t));
 	s_resources.currentIndexOffset += indexCount;
+	s_resources.currentMeshletOffset += meshlets.meshletCount;
+	s_resources.maxMeshletCount = SDL_max(s_resources.maxMeshletCount, meshlets.meshletCount);
+	s_resources.currentMeshletVertexOffset += meshlets.vertexCount;
+	s_resources.currentMeshletTriangleOffset += meshlets.triangleByteCount;
 
-	vmaDestroyBuffer(s_resources.allocator, stagingBuffer, stagingAllocation);
+	wc_meshlet_free(&meshlets);
 
 	return meshIndex;
 }
 
+static void queue_texture_write(const uint32_t slot, VkImageView imageView, VkSampler sampler)
+{
+	s_resources.pendingImages[slot] = (VkDescriptorImageInfo){
+		.sampler = sampler, .imageView = imageView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	if (!s_resources.pendingQueued[slot])
+	{
+		s_resources.pendingQueued[slot] = 1;
+		s_resources.pendingSlots[s_resources.pendingCount++] = slot;
+	}
+}
+
 uint32_t wc_gpu_resource_add_texture(VkImageView imageView, VkSampler sampler)
 {
-	if (s_resources.textureCount >= WC_MAX_BINDLESS_RESOURCES)
+	if (s_resources.freeSlotCount == 0)
 	{
 		return UINT32_MAX;
 	}
 
-	uint32_t textureIndex = s_resources.textureCount++;
+	const uint32_t textureIndex = s_resources.freeSlots[--s_resources.freeSlotCount];
+	s_resources.liveSlots[textureIndex] = 1;
+	s_resources.textureCount++;
+	queue_texture_write(textureIndex, imageView, sampler);
 
-	VkDescriptorImageInfo imageInfo = {
-		.sampler = sampler, .imageView = imageView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	return textureIndex;
+}
 
-	VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-								  .dstSet = s_resources.bindlessSet,
-								  .dstBinding = 5,
-								  .dstArrayElement = textureIndex,
-								  .descriptorCount = 1,
-								  .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-								  .pImageInfo = &imageInfo};
+void wc_gpu_resource_set_texture(const uint32_t textureIndex, VkImageView imageView, VkSampler sampler)
+{
+	if (textureIndex >= WC_MAX_BINDLESS_RESOURCES || !s_resources.liveSlots[textureIndex])
+	{
+		return;
+	}
 
-	vkUpdateDescriptorSets(s_resources.device, 1, &write, 0, NULL);
+	queue_texture_write(textureIndex, imageView, sampler);
+}
 
-	return textureIndex;
+void wc_gpu_resource_remove_texture(const uint32_t textureIndex)
+{
+	if (textureIndex >= WC_MAX_BINDLESS_RESOURCES || !s_resources.liveSlots[textureIndex])
+	{
+		return;
+	}
+	s_resources.liveSlots[textureIndex] = 0;
+
+	// A write queued for a slot that never reached the GPU can be dropped outright
+	if (s_resources.pendingQueued[textureIndex])
+	{
+		s_resources.pendingImages[textureIndex].imageView = VK_NULL_HANDLE;
+	}
+
+	const uint32_t tail = (s_resources.retiredHead + s_resources.retiredCount) % WC_MAX_BINDLESS_RESOURCES;
+	s_resources.retiredSlots[tail] = (WC_RetiredSlot){.slot = textureIndex, .frame = s_resources.frame};
+	s_resources.retiredCount++;
+	s_resources.textureCount--;
 }
 
-void wc_gpu_resource_update_descriptors()
+WC_GpuInstance* wc_gpu_resource_map_instances(uint32_t* first_instance)
+{
+	*first_instance = s_resources.instanceRegion * WC_MAX_INSTANCES;
+	return s_resources.instanceData ? s_resources.instanceData + *first_instance : NULL;
+}
+
+void wc_gpu_resource_commit_instances(const uint32_t count)
+{
+	if (!s_resources.instanceData)
+		return;
+
+	const uint32_t first = s_resources.instanceRegion * WC_MAX_INSTANCES;
+	s_resources.instanceFirst = first;
+	s_resources.instanceCount = SDL_min(count, WC_MAX_INSTANCES);
+	wc_buffer_flush(&s_resources.instanceBuffer, first * sizeof(WC_GpuInstance), s_resources.instanceCount * sizeof(WC_GpuInstance));
+	// The next frame writes the other region while this one is read by the GPU
+	s_resources.instanceRegion = (s_resources.instanceRegion + 1) % WC_FRAMES_IN_FLIGHT;
+}
+
+void wc_gpu_resource_get_instances(uint32_t* first_instance, uint32_t* count)
 {
-	VkDescriptorBufferInfo bufferInfos[5] = {// Mesh data
-											 {.buffer = s_resources.meshDataBuffer, .offset = 0, .range = VK_WHOLE_SIZE},
-											 // Material data
-											 {.buffer = s_resources.materialDataBuffer, .offset = 0, .range = VK_WHOLE_SIZE},
-											 // Instance data
-											 {.buffer = s_resources.instanceBuffer, .offset = 0, .range = VK_WHOLE_SIZE},
-											 // Vertex buffer
-											 {.buffer = s_resources.vertexBuffer, .offset = 0, .range = VK_WHOLE_SIZE},
-											 // Index buffer
-											 {.buffer = s_resources.indexBuffer, .offset = 0, .range = VK_WHOLE_SIZE}};
-
-	VkWriteDescriptorSet writes[5];
-	for (uint32_t i = 0; i < 5; i++)
+	*first_instance = s_resources.instanceFirst;
+	*count = s_resources.instanceCount;
+}
+
+uint32_t wc_gpu_resource_get_max_meshlets(void)
+{
+	return s_resources.maxMeshletCount;
+}
+
+void wc_gpu_resource_begin_frame(const uint64_t frame)
+{
+	s_resources.frame = frame;
+
+	// Frames complete in order, so the oldest retirement is always at the head
+	while (s_resources.retiredCount > 0)
+	{
+		const WC_RetiredSlot* retired = &s_resources.retiredSlots[s_resources.retiredHead];
+		if (retired->frame + WC_FRAMES_IN_FLIGHT > s_resources.frame)
+			break;
+
+		s_resources.freeSlots[s_resources.freeSlotCount++] = retired->slot;
+		s_resources.retiredHead = (s_resources.retiredHead + 1) % WC_MAX_BINDLESS_RESOURCES;
+		s_resources.retiredCount--;
+	}
+}
+
+static int compare_slots(const void* a, const void* b)
+{
+	const uint32_t lhs = *(const uint32_t*)a;
+	const uint32_t rhs = *(const uint32_t*)b;
+	return (lhs > rhs) - (lhs < rhs);
+}
+
+void wc_gpu_resource_flush_descriptors(void)
+{
+	VkDescriptorBufferInfo bufferInfos[WC_BINDING_TEXTURES] = {
+		{.buffer = s_resources.meshDataBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.materialDataBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.instanceBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.vertexBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.indexBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.meshletBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.meshletVertexBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE},
+		{.buffer = s_resources.meshletTriangleBuffer.buffer, .offset = 0, .range = VK_WHOLE_SIZE}};
+
+	VkWriteDescriptorSet* writes = s_resources.flushWrites;
+	uint32_t writeCount = 0;
+
+	for (uint32_t i = 0; i < WC_BINDING_TEXTURES; i++)
 	{
-		writes[i] = (VkWriteDescriptorSet){.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-										   .dstSet = s_resources.bindlessSet,
-										   .dstBinding = i,
-										   .dstArrayElement = 0,
-										   .descriptorCount = 1,
-										   .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
-										   .pBufferInfo = &bufferInfos[i]};
+		if (!(s_resources.dirtyBuffers & (1u << i)))
+			continue;
+
+		writes[writeCount++] = (VkWriteDescriptorSet){.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+													  .dstSet = s_resources.bindlessSet,
+													  .dstBinding = i,
+													  .dstArrayElement = 0,
+													  .descriptorCount = 1,
+													  .descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
+													  .pBufferInfo = &bufferInfos[i]};
 	}
+	s_resources.dirtyBuffers = 0;
 
-	vkUpdateDescriptorSets(s_resources.device, 5, writes, 0, NULL);
+	// Slots usually come off the free stack in order; only sort when they did not
+	uint32_t* slots = s_resources.pendingSlots;
+	const uint32_t pendingCount = s_resources.pendingCount;
+	for (uint32_t i = 1; i < pendingCount; i++)
+	{
+		if (slots[i] < slots[i - 1])
+		{
+			SDL_qsort(slots, pendingCount, sizeof(uint32_t), compare_slots);
+			break;
+		}
+	}
+
+	// Coalesce adjacent slots into one write per contiguous run of array elements
+	uint32_t imageCount = 0;
+	VkWriteDescriptorSet* run = NULL;
+	for (uint32_t i = 0; i < pendingCount; i++)
+	{
+		const uint32_t slot = slots[i];
+		s_resources.pendingQueued[slot] = 0;
+		if (s_resources.pendingImages[slot].imageView == VK_NULL_HANDLE)
+		{
+			run = NULL; // Removed before it was ever written
+			continue;
+		}
+
+		if (run && run->dstArrayElement + run->descriptorCount == slot)
+		{
+			run->descriptorCount++;
+		}
+		else
+		{
+			run = &writes[writeCount++];
+			*run = (VkWriteDescriptorSet){.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+										  .dstSet = s_resources.bindlessSet,
+										  .dstBinding = WC_BINDING_TEXTURES,
+										  .dstArrayElement = slot,
+										  .descriptorCount = 1,
+										  .descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+										  .pImageInfo = &s_resources.flushImages[imageCount]};
+		}
+		s_resources.flushImages[imageCount++] = s_resources.pendingImages[slot];
+	}
+	s_resources.pendingCount = 0;
+
+	if (writeCount > 0)
+	{
+		vkUpdateDescriptorSets(s_resources.device, writeCount, writes, 0, NULL);
+	}
+}
+
+static double resource_elapsed_ms(const uint64_t begin)
+{
+	return (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+}
+
+void wc_gpu_resource_benchmark_descriptors(VkImageView imageView, VkSampler sampler)
+{
+	if (s_resources.pendingCount > 0 || s_resources.freeSlotCount < WC_MAX_BINDLESS_RESOURCES)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Descriptor benchmark needs an empty texture table\n");
+		return;
+	}
+
+	// Old path: one vkUpdateDescriptorSets call per texture
+	uint64_t begin = SDL_GetPerformanceCounter();
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES; i++)
+	{
+		const VkDescriptorImageInfo imageInfo = {
+			.sampler = sampler, .imageView = imageView, .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+		const VkWriteDescriptorSet write = {.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+											.dstSet = s_resources.bindlessSet,
+											.dstBinding = WC_BINDING_TEXTURES,
+											.dstArrayElement = i,
+											.descriptorCount = 1,
+											.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+											.pImageInfo = &imageInfo};
+		vkUpdateDescriptorSets(s_resources.device, 1, &write, 0, NULL);
+	}
+	const double immediate_ms = resource_elapsed_ms(begin);
+
+	// Queued path: allocate every slot, then a single batched flush
+	begin = SDL_GetPerformanceCounter();
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES; i++)
+	{
+		wc_gpu_resource_add_texture(imageView, sampler);
+	}
+	const double queue_ms = resource_elapsed_ms(begin);
+
+	begin = SDL_GetPerformanceCounter();
+	wc_gpu_resource_flush_descriptors();
+	const double flush_ms = resource_elapsed_ms(begin);
+
+	// Churn: retire every other slot and refill them once the frames in flight have passed. The
+	// benchmark steps the frame counter itself and puts it back when done.
+	const uint64_t frame = s_resources.frame;
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES; i += 2)
+	{
+		wc_gpu_resource_remove_texture(i);
+	}
+	wc_gpu_resource_begin_frame(s_resources.frame + WC_FRAMES_IN_FLIGHT);
+	begin = SDL_GetPerformanceCounter();
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES / 2; i++)
+	{
+		wc_gpu_resource_add_texture(imageView, sampler);
+	}
+	wc_gpu_resource_flush_descriptors();
+	const double churn_ms = resource_elapsed_ms(begin);
+
+	SDL_Log("Descriptor benchmark: %u textures\n", WC_MAX_BINDLESS_RESOURCES);
+	SDL_Log("  immediate:     %.3f ms\n", immediate_ms);
+	SDL_Log("  queue + flush: %.3f ms + %.3f ms\n", queue_ms, flush_ms);
+	SDL_Log("  churn (half):  %.3f ms\n", churn_ms);
+
+	for (uint32_t i = 0; i < WC_MAX_BINDLESS_RESOURCES; i++)
+	{
+		wc_gpu_resource_remove_texture(i);
+	}
+	wc_gpu_resource_begin_frame(s_resources.frame + WC_FRAMES_IN_FLIGHT);
+	s_resources.frame = frame;
+}
+
+VkDescriptorSetLayout wc_gpu_resource_get_layout(void)
+{
+	return s_resources.bindlessLayout;
+}
+
+VkDescriptorSet wc_gpu_resource_get_set(void)
+{
+	return s_resources.bindlessSet;
+}
+
+void wc_gpu_resource_update_descriptors()
+{
+	s_resources.dirtyBuffers = (1u << WC_BINDING_TEXTURES) - 1;
 }
@@ -6,18 +6,38 @@
 #define WC_MAX_BINDLESS_RESOURCES 16384
 #define WC_MAX_MESHES 4096
 #define WC_MAX_MATERIALS 1024
+#define WC_MAX_MESHLETS (1024 * 1024)
+#define WC_FRAMES_IN_FLIGHT 2
+#define WC_MAX_INSTANCES 100000
+
+// Bindings of the bindless descriptor set shared by all shaders (set 0)
+typedef enum WC_BindlessBinding
+{
+	WC_BINDING_MESH_DATA = 0,
+	WC_BINDING_MATERIAL_DATA = 1,
+	WC_BINDING_INSTANCE_DATA = 2,
+	WC_BINDING_VERTICES = 3,
+	WC_BINDING_INDICES = 4,
+	WC_BINDING_MESHLETS = 5,
+	WC_BINDING_MESHLET_VERTICES = 6,
+	WC_BINDING_MESHLET_TRIANGLES = 7,
+	WC_BINDING_TEXTURES = 8, // Variable-count array, must stay the last binding
+	WC_BINDING_COUNT
+} WC_BindlessBinding;
 
-typedef struct WC_Buffer WC_Buffer;
 typedef struct WC_Texture WC_Texture;
 typedef struct WC_GpuResources WC_GpuResources;
 
 // Mesh data stored in GPU buffers
 typedef struct {
-	uint32_t vertexOffset;
+	uint32_t vertexOffset; // In 32-bit words, vertices have different strides
 	uint32_t vertexCount;
+	uint32_t vertexStride; // In 32-bit words, position is the first three floats
 	uint32_t indexOffset;
 	uint32_t indexCount;
 	uint32_t materialIndex;
+	uint32_t meshletOffset;
+	uint32_t meshletCount;
 	float boundingSphere[4]; // xyz center, w radius
 } WC_GpuMeshData;
 
@@ -29,13 +49,41 @@ typedef struct {
 	uint32_t pad;
 } WC_GpuMaterialData;
 
-// Instance data for draw indirect
+// Per-instance data, decoded into a transform by the task and mesh shaders. Units stand upright
+// (yaw around +Z) and scale uniformly, so 20 bytes replace a 4x4 matrix plus padding (80 bytes).
 typedef struct {
-	float transform[16]; // 4x4 matrix
-	uint32_t meshIndex;
-	uint32_t instanceID;
-	uint32_t pad[2];
-} WC_GpuInstanceData;
+	float position[3];
+	uint32_t yawScale;	 // Low 16 bits: yaw in 1/65536 turns, high 16 bits: scale as half float
+	uint32_t meshPlayer; // Low 16 bits: mesh index, bits 16-23: player color index, bits 24-31: flags
+} WC_GpuInstance;
+
+static inline uint32_t wc_gpu_float_to_half(const float value)
+{
+	const union {
+		float f;
+		uint32_t u;
+	} bits = {.f = value};
+	const uint32_t sign = (bits.u >> 16) & 0x8000;
+	const int32_t exponent = (int32_t)((bits.u >> 23) & 0xFF) - 127 + 15;
+	const uint32_t mantissa = bits.u & 0x7FFFFF;
+	if (exponent <= 0)
+		return sign; // Too small to matter for a scale, flush to zero
+	if (exponent >= 31)
+		return sign | 0x7C00;
+	// Rounding may carry into the exponent, which is the correctly rounded result
+	return sign | (((uint32_t)exponent << 10) + ((mantissa + 0x1000) >> 13));
+}
+
+static inline WC_GpuInstance wc_gpu_instance_pack(const float x, const float y, const float z, const float yaw, const float scale,
+												  const uint32_t mesh, const uint32_t player)
+{
+	const uint32_t turns = (uint32_t)(int32_t)(yaw * (65536.0f / 6.28318530718f)) & 0xFFFF;
+	return (WC_GpuInstance){
+		.position = {x, y, z},
+		.yawScale = turns | wc_gpu_float_to_half(scale) << 16,
+		.meshPlayer = (mesh & 0xFFFF) | (player & 0xFF) << 16,
+	};
+}
 
 int wc_gpu_resource_init(VkDevice device, VmaAllocator allocator);
 void wc_gpu_resource_quit();
@@ -49,6 +97,37 @@ uint32_t wc_gpu_resource_add_mesh(
 	uint32_t materialIndex,
 	const float* boundingSphere
 );
+// Texture slots come from a free list; the descriptor write is queued until the next flush.
 uint32_t wc_gpu_resource_add_texture(VkImageView imageView, VkSampler sampler);
+// Points a live slot at a new view. Update-after-bind only allows this for slots no pending
+// command buffer uses; to swap what frames in flight sample, add a new slot and remove the old one.
+void wc_gpu_resource_set_texture(uint32_t textureIndex, VkImageView imageView, VkSampler sampler);
+// The slot is only handed out again once WC_FRAMES_IN_FLIGHT frames have been submitted since removal.
+// Removing a slot that is not live (never added, or already removed) does nothing.
+void wc_gpu_resource_remove_texture(uint32_t textureIndex);
+
+VkDescriptorSetLayout wc_gpu_resource_get_layout(void);
+VkDescriptorSet wc_gpu_resource_get_set(void);
+
+// Recycles slots no in-flight frame can still reference. frame counts frames submitted to the GPU
+// so far, not draw calls, since a draw can return without submitting, e.g. while minimized.
+void wc_gpu_resource_begin_frame(uint64_t frame);
+// Writes all queued texture and buffer descriptors in a single vkUpdateDescriptorSets call.
+void wc_gpu_resource_flush_descriptors(void);
+// Marks every storage buffer binding dirty, e.g. after a buffer was recreated.
+void wc_gpu_resource_update_descriptors(void);
+
+// Instances live in a persistently mapped buffer with one region per frame in flight, so the CPU
+// writes frame N+1 while the GPU reads frame N. The region may be write-combined memory: write it
+// sequentially and never read it back. Returns NULL before init; first_instance is the index of
+// the region's first element as seen by the shaders.
+WC_GpuInstance* wc_gpu_resource_map_instances(uint32_t* first_instance);
+// Publishes the instances written since the last map for the next draw and moves on to the next
+// region; call once per frame. Flushes the range when the memory is not host coherent.
+void wc_gpu_resource_commit_instances(uint32_t count);
+void wc_gpu_resource_get_instances(uint32_t* first_instance, uint32_t* count);
+// Meshlets of the largest mesh, which sizes the task shader dispatch; 0 while no mesh is loaded.
+uint32_t wc_gpu_resource_get_max_meshlets(void);
 
-void wc_gpu_resource_update_descriptors(void);
\ No newline at end of file
+// Times per-texture updates against the queued path for a full table. Needs an empty texture table.
+void wc_gpu_resource_benchmark_descriptors(VkImageView imageView, VkSampler sampler);
\ No newline at end of file
@@ -1,5 +1,832 @@
-//
-// Created by jerem on 2025-07-22.
-//
-
 #include "shader.h"
+#include "shader_pack.h"
+
+#include "../system/file.h"
+#include "../system/job.h"
+#include "../system/memory.h"
+
+#include <SDL3/SDL.h>
+#include <glslang/Include/glslang_c_interface.h>
+#include <glslang/Public/resource_limits_c.h>
+#include <spirv_cross_c.h>
+
+#define WC_SHADER_CACHE_MAGIC 0x48534357 // "WCSH"
+// Bump when the compile options or the cache layout change so old entries miss
+#define WC_SHADER_CACHE_VERSION 1
+#define WC_SHADER_MAX_DEFINE_LENGTH 64
+
+typedef struct
+{
+	char path[WC_SHADER_MAX_PATH];
+	uint64_t hash;
+	SDL_Time modifyTime;
+} ShaderDependency;
+
+typedef struct
+{
+	char name[WC_SHADER_MAX_PATH];
+	VkShaderStageFlagBits stage;
+	char defines[WC_SHADER_MAX_DEFINES][WC_SHADER_MAX_DEFINE_LENGTH];
+	uint32_t defineCount;
+
+	VkShaderModule module;
+	WC_ShaderReflection reflection;
+
+	// Written by the compile job, swapped in on the calling thread once the job is done. Dependency
+	// 0 is the source itself, the rest are its includes.
+	VkShaderModule compiled;
+	WC_ShaderReflection compiledReflection;
+	ShaderDependency dependencies[WC_SHADER_MAX_DEPENDENCIES];
+	uint32_t dependencyCount;
+	bool fromCache;
+
+	JobHandle job;
+	bool pending;
+} ShaderEntry;
+
+// Cache file: header, dependency records, then the SPIR-V words
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t stage;
+	uint32_t dependencyCount;
+	uint32_t spirvSize;
+	uint32_t reserved;
+} ShaderCacheHeader;
+
+typedef struct
+{
+	uint64_t hash;
+	char path[WC_SHADER_MAX_PATH];
+} ShaderCacheDependency;
+
+typedef struct
+{
+	VkDevice device;
+	char sourceDir[WC_SHADER_MAX_PATH];
+	char cacheDir[WC_SHADER_MAX_PATH];
+	// Build-time SPIR-V for every shader and permutation, used when sources are not available
+	WC_FileMapping pack;
+
+	ShaderEntry entries[WC_MAX_SHADERS];
+	uint32_t count;
+
+	// Set layouts built from reflection for sets other than the shared bindless one, each tagged
+	// with the pipeline layout it was created for so that layout can release them
+	VkDescriptorSetLayout setLayouts[WC_MAX_SHADERS];
+	VkPipelineLayout setLayoutOwners[WC_MAX_SHADERS];
+	uint32_t setLayoutCount;
+} ShaderSystem;
+
+static ShaderSystem s_shaders;
+
+static uint64_t shader_hash(uint64_t hash, const void* data, const size_t size)
+{
+	// FNV-1a, only used to key and validate cache entries
+	const uint8_t* bytes = data;
+	for (size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
+
+#define SHADER_HASH_SEED 0xcbf29ce484222325ull
+
+static ShaderDependency* shader_add_dependency(ShaderEntry* entry, const char* path, const void* data, const size_t size)
+{
+	if (entry->dependencyCount >= WC_SHADER_MAX_DEPENDENCIES)
+		return NULL;
+
+	ShaderDependency* dependency = &entry->dependencies[entry->dependencyCount++];
+	SDL_strlcpy(dependency->path, path, sizeof(dependency->path));
+	dependency->hash = shader_hash(SHADER_HASH_SEED, data, size);
+
+	SDL_PathInfo info;
+	dependency->modifyTime = SDL_GetPathInfo(path, &info) ? info.modify_time : 0;
+	return dependency;
+}
+
+static glslang_stage_t shader_glslang_stage(const VkShaderStageFlagBits stage)
+{
+	switch (stage)
+	{
+	case VK_SHADER_STAGE_VERTEX_BIT:
+		return GLSLANG_STAGE_VERTEX;
+	case VK_SHADER_STAGE_FRAGMENT_BIT:
+		return GLSLANG_STAGE_FRAGMENT;
+	case VK_SHADER_STAGE_COMPUTE_BIT:
+		return GLSLANG_STAGE_COMPUTE;
+	case VK_SHADER_STAGE_TASK_BIT_EXT:
+		return GLSLANG_STAGE_TASK;
+	case VK_SHADER_STAGE_MESH_BIT_EXT:
+		return GLSLANG_STAGE_MESH;
+	default:
+		return GLSLANG_STAGE_COUNT;
+	}
+}
+
+// --- Includes ---
+// Includes resolve against the source directory and are recorded as dependencies, so the cache
+// validates them and hot reload watches them
+
+static glsl_include_result_t* shader_include(void* context, const char* header_name, const char* includer_name,
+											 size_t include_depth)
+{
+	(void)includer_name;
+	(void)include_depth;
+
+	ShaderEntry* entry = context;
+	glsl_include_result_t* result = wc_calloc(1, sizeof(*result));
+
+	char path[WC_SHADER_MAX_PATH];
+	SDL_snprintf(path, sizeof(path), "%s%s", s_shaders.sourceDir, header_name);
+	size_t size = 0;
+	char* data = SDL_LoadFile(path, &size);
+	if (!data)
+		return result; // empty result makes glslang report the missing include
+
+	const ShaderDependency* dependency = shader_add_dependency(entry, path, data, size);
+	result->header_name = dependency ? dependency->path : header_name;
+	result->header_data = data;
+	result->header_length = size;
+	return result;
+}
+
+static int shader_free_include(void* context, glsl_include_result_t* result)
+{
+	(void)context;
+	SDL_free((void*)result->header_data);
+	wc_free(result);
+	return 0;
+}
+
+static uint32_t* shader_compile_glsl(ShaderEntry* entry, const char* source, size_t* spirvSize)
+{
+	// Defines go in through the preamble so line numbers in errors still match the file
+	char preamble[WC_SHADER_MAX_DEFINES * (WC_SHADER_MAX_DEFINE_LENGTH + 10)] = "";
+	for (uint32_t i = 0; i < entry->defineCount; i++)
+	{
+		char define[WC_SHADER_MAX_DEFINE_LENGTH];
+		SDL_strlcpy(define, entry->defines[i], sizeof(define));
+		char* value = SDL_strchr(define, '=');
+		if (value)
+			*value++ = ' ';
+		SDL_strlcat(preamble, "#define ", sizeof(preamble));
+		SDL_strlcat(preamble, define, sizeof(preamble));
+		SDL_strlcat(preamble, "\n", sizeof(preamble));
+	}
+
+	const glslang_stage_t stage = shader_glslang_stage(entry->stage);
+	const glslang_input_t input = {
+		.language = GLSLANG_SOURCE_GLSL,
+		.stage = stage,
+		.client = GLSLANG_CLIENT_VULKAN,
+		.client_version = GLSLANG_TARGET_VULKAN_1_3,
+		.target_language = GLSLANG_TARGET_SPV,
+		.target_language_version = GLSLANG_TARGET_SPV_1_6,
+		.code = source,
+		.default_version = 460,
+		.default_profile = GLSLANG_NO_PROFILE,
+		.messages = GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT,
+		.resource = glslang_default_resource(),
+		.callbacks =
+			{
+				.include_system = shader_include,
+				.include_local = shader_include,
+				.free_include_result = shader_free_include,
+			},
+		.callbacks_ctx = entry,
+	};
+
+	uint32_t* spirv = NULL;
+	glslang_shader_t* shader = glslang_shader_create(&input);
+	glslang_program_t* program = glslang_program_create();
+	glslang_shader_set_preamble(shader, preamble);
+
+	if (!glslang_shader_preprocess(shader, &input) || !glslang_shader_parse(shader, &input))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader '%s' failed to compile:\n%s\n", entry->name,
+					 glslang_shader_get_info_log(shader));
+		goto cleanup;
+	}
+
+	glslang_program_add_shader(program, shader);
+	if (!glslang_program_link(program, GLSLANG_MSG_SPV_RULES_BIT | GLSLANG_MSG_VULKAN_RULES_BIT))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader '%s' failed to link:\n%s\n", entry->name,
+					 glslang_program_get_info_log(program));
+		goto cleanup;
+	}
+
+	glslang_program_SPIRV_generate(program, stage);
+	const size_t words = glslang_program_SPIRV_get_size(program);
+	spirv = wc_malloc(words * sizeof(uint32_t));
+	glslang_program_SPIRV_get(program, spirv);
+	*spirvSize = words * sizeof(uint32_t);
+
+	const char* messages = glslang_program_SPIRV_get_messages(program);
+	if (messages && messages[0])
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Shader '%s': %s\n", entry->name, messages);
+
+cleanup:
+	glslang_program_delete(program);
+	glslang_shader_delete(shader);
+	return spirv;
+}
+
+// --- Disk cache ---
+
+static uint64_t shader_cache_key(const ShaderEntry* entry, const char* source, const size_t sourceSize)
+{
+	const uint32_t version = WC_SHADER_CACHE_VERSION;
+	uint64_t key = shader_hash(SHADER_HASH_SEED, &version, sizeof(version));
+	key = shader_hash(key, &entry->stage, sizeof(entry->stage));
+	for (uint32_t i = 0; i < entry->defineCount; i++)
+	{
+		key = shader_hash(key, entry->defines[i], SDL_strlen(entry->defines[i]) + 1);
+	}
+	return shader_hash(key, source, sourceSize);
+}
+
+static void shader_cache_path(char* path, const size_t size, const uint64_t key)
+{
+	SDL_snprintf(path, size, "%s%016" SDL_PRIx64 ".spv", s_shaders.cacheDir, key);
+}
+
+// Returns the cached SPIR-V if every include still hashes the same; the source itself is part of
+// the key. Fills the entry's include dependencies on a hit.
+static uint32_t* shader_cache_load(ShaderEntry* entry, const uint64_t key, size_t* spirvSize)
+{
+	char path[WC_SHADER_MAX_PATH];
+	shader_cache_path(path, sizeof(path), key);
+
+	size_t fileSize = 0;
+	uint8_t* file = SDL_LoadFile(path, &fileSize);
+	if (!file)
+		return NULL;
+
+	ShaderCacheHeader header;
+	if (fileSize < sizeof(header))
+		goto miss;
+	SDL_memcpy(&header, file, sizeof(header));
+
+	const size_t dependencyBytes = (size_t)header.dependencyCount * sizeof(ShaderCacheDependency);
+	if (header.magic != WC_SHADER_CACHE_MAGIC || header.version != WC_SHADER_CACHE_VERSION ||
+		header.stage != (uint32_t)entry->stage || header.dependencyCount > WC_SHADER_MAX_DEPENDENCIES ||
+		header.spirvSize % sizeof(uint32_t) != 0 || fileSize != sizeof(header) + dependencyBytes + header.spirvSize)
+		goto miss;
+
+	const uint32_t sourceDependencies = entry->dependencyCount;
+	for (uint32_t i = 0; i < header.dependencyCount; i++)
+	{
+		ShaderCacheDependency stored;
+		SDL_memcpy(&stored, file + sizeof(header) + i * sizeof(stored), sizeof(stored));
+		stored.path[sizeof(stored.path) - 1] = '\0';
+
+		size_t size = 0;
+		void* data = SDL_LoadFile(stored.path, &size);
+		const uint64_t hash = data ? shader_hash(SHADER_HASH_SEED, data, size) : 0;
+		SDL_free(data);
+		if (!data || hash != stored.hash)
+		{
+			entry->dependencyCount = sourceDependencies;
+			goto miss;
+		}
+
+		ShaderDependency* dependency = &entry->dependencies[entry->dependencyCount++];
+		SDL_strlcpy(dependency->path, stored.path, sizeof(dependency->path));
+		dependency->hash = hash;
+		SDL_PathInfo info;
+		dependency->modifyTime = SDL_GetPathInfo(stored.path, &info) ? info.modify_time : 0;
+	}
+
+	uint32_t* spirv = wc_malloc(header.spirvSize);
+	SDL_memcpy(spirv, file + sizeof(header) + dependencyBytes, header.spirvSize);
+	*spirvSize = header.spirvSize;
+	SDL_free(file);
+	return spirv;
+
+miss:
+	SDL_free(file);
+	return NULL;
+}
+
+static void shader_cache_store(const ShaderEntry* entry, const uint64_t key, const uint32_t* spirv, const size_t spirvSize)
+{
+	// Dependency 0 is the source, already covered by the key
+	const uint32_t includeCount = entry->dependencyCount - 1;
+	const size_t dependencyBytes = includeCount * sizeof(ShaderCacheDependency);
+	const size_t fileSize = sizeof(ShaderCacheHeader) + dependencyBytes + spirvSize;
+	uint8_t* file = wc_calloc(1, fileSize);
+
+	const ShaderCacheHeader header = {
+		.magic = WC_SHADER_CACHE_MAGIC,
+		.version = WC_SHADER_CACHE_VERSION,
+		.stage = (uint32_t)entry->stage,
+		.dependencyCount = includeCount,
+		.spirvSize = (uint32_t)spirvSize,
+	};
+	SDL_memcpy(file, &header, sizeof(header));
+	for (uint32_t i = 0; i < includeCount; i++)
+	{
+		ShaderCacheDependency stored = {.hash = entry->dependencies[i + 1].hash};
+		SDL_strlcpy(stored.path, entry->dependencies[i + 1].path, sizeof(stored.path));
+		SDL_memcpy(file + sizeof(header) + i * sizeof(stored), &stored, sizeof(stored));
+	}
+	SDL_memcpy(file + sizeof(header) + dependencyBytes, spirv, spirvSize);
+
+	// Several jobs write at once, but every key has its own file and temporary
+	char path[WC_SHADER_MAX_PATH];
+	char tempPath[WC_SHADER_MAX_PATH + 4];
+	shader_cache_path(path, sizeof(path), key);
+	SDL_snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+	if (!SDL_SaveFile(tempPath, file, fileSize) || !SDL_RenamePath(tempPath, path))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Failed to write shader cache %s: %s\n", path, SDL_GetError());
+	}
+	wc_free(file);
+}
+
+// --- Reflection ---
+
+static void shader_reflect_resources(spvc_compiler compiler, spvc_resources resources, const spvc_resource_type resourceType,
+									 const VkDescriptorType descriptorType, WC_ShaderReflection* reflection)
+{
+	const spvc_reflected_resource* list = NULL;
+	size_t count = 0;
+	spvc_resources_get_resource_list_for_type(resources, resourceType, &list, &count);
+
+	for (size_t i = 0; i < count && reflection->bindingCount < WC_SHADER_MAX_BINDINGS; i++)
+	{
+		WC_ShaderBinding* binding = &reflection->bindings[reflection->bindingCount++];
+		binding->set = spvc_compiler_get_decoration(compiler, list[i].id, SpvDecorationDescriptorSet);
+		binding->binding = spvc_compiler_get_decoration(compiler, list[i].id, SpvDecorationBinding);
+		binding->type = descriptorType;
+		binding->count = 1;
+
+		const spvc_type type = spvc_compiler_get_type_handle(compiler, list[i].type_id);
+		if (spvc_type_get_num_array_dimensions(type) > 0)
+		{
+			// A zero-sized outer dimension is a runtime array (bindless)
+			binding->count = spvc_type_get_array_dimension(type, 0);
+		}
+	}
+}
+
+static bool shader_reflect(const uint32_t* spirv, const size_t spirvSize, const VkShaderStageFlagBits stage,
+						   WC_ShaderReflection* reflection)
+{
+	SDL_memset(reflection, 0, sizeof(*reflection));
+	reflection->stage = stage;
+
+	spvc_context context = NULL;
+	if (spvc_context_create(&context) != SPVC_SUCCESS)
+		return false;
+
+	spvc_parsed_ir ir = NULL;
+	spvc_compiler compiler = NULL;
+	spvc_resources resources = NULL;
+	if (spvc_context_parse_spirv(context, spirv, spirvSize / sizeof(uint32_t), &ir) != SPVC_SUCCESS ||
+		spvc_context_create_compiler(context, SPVC_BACKEND_NONE, ir, SPVC_CAPTURE_MODE_TAKE_OWNERSHIP, &compiler) != SPVC_SUCCESS ||
+		spvc_compiler_create_shader_resources(compiler, &resources) != SPVC_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader reflection failed: %s\n", spvc_context_get_last_error_string(context));
+		spvc_context_destroy(context);
+		return false;
+	}
+
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_UNIFORM_BUFFER, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, reflection);
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_STORAGE_BUFFER, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, reflection);
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_SAMPLED_IMAGE, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
+							 reflection);
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_SEPARATE_IMAGE, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, reflection);
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_SEPARATE_SAMPLERS, VK_DESCRIPTOR_TYPE_SAMPLER, reflection);
+	shader_reflect_resources(compiler, resources, SPVC_RESOURCE_TYPE_STORAGE_IMAGE, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, reflection);
+
+	const spvc_reflected_resource* pushConstants = NULL;
+	size_t pushConstantCount = 0;
+	spvc_resources_get_resource_list_for_type(resources, SPVC_RESOURCE_TYPE_PUSH_CONSTANT, &pushConstants, &pushConstantCount);
+	if (pushConstantCount > 0)
+	{
+		size_t size = 0;
+		const spvc_type type = spvc_compiler_get_type_handle(compiler, pushConstants[0].base_type_id);
+		spvc_compiler_get_declared_struct_size(compiler, type, &size);
+		reflection->pushConstantSize = (uint32_t)size;
+	}
+
+	spvc_context_destroy(context);
+	return true;
+}
+
+// --- Compilation ---
+
+static void shader_finish(ShaderEntry* entry, const uint32_t* spirv, const size_t spirvSize)
+{
+	if (!shader_reflect(spirv, spirvSize, entry->stage, &entry->compiledReflection))
+		return;
+
+	VkShaderModuleCreateInfo createInfo = {VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+	createInfo.codeSize = spirvSize;
+	createInfo.pCode = spirv;
+	if (vkCreateShaderModule(s_shaders.device, &createInfo, NULL, &entry->compiled) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create shader module '%s'\n", entry->name);
+		entry->compiled = VK_NULL_HANDLE;
+	}
+}
+
+static bool shader_pack_valid(void)
+{
+	const WC_FileMapping* pack = &s_shaders.pack;
+	if (!pack->data || pack->size < sizeof(WC_ShaderPackHeader))
+		return false;
+
+	const WC_ShaderPackHeader* header = pack->data;
+	return header->magic == WC_SHADER_PACK_MAGIC && header->version == WC_SHADER_PACK_VERSION &&
+		   sizeof(WC_ShaderPackHeader) + (size_t)header->count * sizeof(WC_ShaderPackEntry) <= pack->size;
+}
+
+// Shipped builds carry no sources: use the SPIR-V compiled at build time, straight out of the mapped pack
+static void shader_load_prebuilt(ShaderEntry* entry)
+{
+	// Same naming as add_shader in CompileShaders.cmake
+	char name[WC_SHADER_PACK_NAME_LENGTH];
+	SDL_strlcpy(name, entry->name, sizeof(name));
+	for (uint32_t i = 0; i < entry->defineCount; i++)
+	{
+		SDL_strlcat(name, "+", sizeof(name));
+		SDL_strlcat(name, entry->defines[i], sizeof(name));
+	}
+
+	if (shader_pack_valid())
+	{
+		const uint8_t* pack = s_shaders.pack.data;
+		const WC_ShaderPackHeader* header = (const WC_ShaderPackHeader*)pack;
+		const WC_ShaderPackEntry* entries = (const WC_ShaderPackEntry*)(pack + sizeof(*header));
+		for (uint32_t i = 0; i < header->count; i++)
+		{
+			if (SDL_strncmp(entries[i].name, name, sizeof(entries[i].name)) != 0)
+				continue;
+			if ((uint64_t)entries[i].offset + entries[i].size > s_shaders.pack.size || entries[i].offset % sizeof(uint32_t) != 0)
+				break;
+			shader_finish(entry, (const uint32_t*)(pack + entries[i].offset), entries[i].size);
+			return;
+		}
+	}
+	SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "No source or prebuilt SPIR-V for shader '%s'\n", name);
+}
+
+static void shader_compile_job(void* data)
+{
+	ShaderEntry* entry = data;
+	const uint64_t begin = SDL_GetPerformanceCounter();
+	entry->compiled = VK_NULL_HANDLE;
+	entry->dependencyCount = 0;
+	entry->fromCache = false;
+
+	char path[WC_SHADER_MAX_PATH];
+	SDL_snprintf(path, sizeof(path), "%s%s", s_shaders.sourceDir, entry->name);
+	size_t sourceSize = 0;
+	char* source = SDL_LoadFile(path, &sourceSize);
+	if (!source)
+	{
+		shader_load_prebuilt(entry);
+		return;
+	}
+	shader_add_dependency(entry, path, source, sourceSize);
+
+	const uint64_t key = shader_cache_key(entry, source, sourceSize);
+	size_t spirvSize = 0;
+	uint32_t* spirv = shader_cache_load(entry, key, &spirvSize);
+	entry->fromCache = spirv != NULL;
+	if (!spirv)
+	{
+		spirv = shader_compile_glsl(entry, source, &spirvSize);
+		if (spirv)
+			shader_cache_store(entry, key, spirv, spirvSize);
+	}
+	SDL_free(source);
+
+	if (spirv)
+	{
+		shader_finish(entry, spirv, spirvSize);
+		wc_free(spirv);
+	}
+
+	const double ms = (double)(SDL_GetPerformanceCounter() - begin) * 1000.0 / (double)SDL_GetPerformanceFrequency();
+	SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "Shader '%s' %s in %.2f ms\n", entry->name,
+				 entry->fromCache ? "loaded from cache" : "compiled", ms);
+}
+
+static void shader_request(ShaderEntry* entry)
+{
+	entry->pending = true;
+	entry->job = job_create_with_flags(shader_compile_job, entry, JOB_FLAG_LARGE_STACK);
+	if (entry->job.value == INVALID_JOB_HANDLE.value)
+	{
+		// Job pool exhausted, compile inline rather than dropping the request
+		shader_compile_job(entry);
+		return;
+	}
+	job_run(entry->job);
+}
+
+// Swaps in the job's result on the owning thread; a failed compile keeps the previous module
+static bool shader_commit(ShaderEntry* entry)
+{
+	if (!entry->pending)
+		return false;
+
+	if (entry->job.value != INVALID_JOB_HANDLE.value)
+		job_wait(entry->job);
+	entry->pending = false;
+	entry->job = INVALID_JOB_HANDLE;
+
+	if (entry->compiled == VK_NULL_HANDLE)
+		return false;
+
+	if (entry->module != VK_NULL_HANDLE)
+		vkDestroyShaderModule(s_shaders.device, entry->module, NULL);
+	entry->module = entry->compiled;
+	entry->reflection = entry->compiledReflection;
+	entry->compiled = VK_NULL_HANDLE;
+	return true;
+}
+
+int wc_shader_init(VkDevice device, const char* source_dir, const char* cache_dir)
+{
+	SDL_memset(&s_shaders, 0, sizeof(s_shaders));
+	s_shaders.device = device;
+	SDL_strlcpy(s_shaders.sourceDir, source_dir, sizeof(s_shaders.sourceDir));
+	SDL_strlcpy(s_shaders.cacheDir, cache_dir, sizeof(s_shaders.cacheDir));
+
+	if (!SDL_CreateDirectory(cache_dir))
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Shader cache directory %s unavailable: %s\n", cache_dir, SDL_GetError());
+	}
+
+	char packPath[WC_SHADER_MAX_PATH];
+	SDL_snprintf(packPath, sizeof(packPath), "%sshaders.pak", SDL_GetBasePath());
+	if (wc_file_map(packPath, &s_shaders.pack) != 0 || !shader_pack_valid())
+	{
+		SDL_LogDebug(SDL_LOG_CATEGORY_APPLICATION, "No usable shader pack at %s, shaders need sources\n", packPath);
+		wc_file_unmap(&s_shaders.pack);
+	}
+
+	if (!glslang_initialize_process())
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to initialize glslang\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
+
+void wc_shader_quit(void)
+{
+	wc_shader_wait_all();
+
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		if (s_shaders.entries[i].module != VK_NULL_HANDLE)
+			vkDestroyShaderModule(s_shaders.device, s_shaders.entries[i].module, NULL);
+	}
+	for (uint32_t i = 0; i < s_shaders.setLayoutCount; i++)
+	{
+		vkDestroyDescriptorSetLayout(s_shaders.device, s_shaders.setLayouts[i], NULL);
+	}
+	glslang_finalize_process();
+	wc_file_unmap(&s_shaders.pack);
+	SDL_memset(&s_shaders, 0, sizeof(s_shaders));
+}
+
+uint32_t wc_shader_register(const char* name, const VkShaderStageFlagBits stage, const char* const* defines, const uint32_t define_count)
+{
+	if (s_shaders.count >= WC_MAX_SHADERS || define_count > WC_SHADER_MAX_DEFINES ||
+		shader_glslang_stage(stage) == GLSLANG_STAGE_COUNT)
+		return WC_SHADER_NONE;
+
+	const uint32_t handle = s_shaders.count++;
+	ShaderEntry* entry = &s_shaders.entries[handle];
+	SDL_memset(entry, 0, sizeof(*entry));
+	SDL_strlcpy(entry->name, name, sizeof(entry->name));
+	entry->stage = stage;
+	entry->defineCount = define_count;
+	for (uint32_t i = 0; i < define_count; i++)
+	{
+		SDL_strlcpy(entry->defines[i], defines[i], sizeof(entry->defines[i]));
+	}
+	entry->job = INVALID_JOB_HANDLE;
+	return handle;
+}
+
+void wc_shader_compile_all(void)
+{
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		ShaderEntry* entry = &s_shaders.entries[i];
+		if (entry->module == VK_NULL_HANDLE && !entry->pending)
+			shader_request(entry);
+	}
+}
+
+void wc_shader_wait_all(void)
+{
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		shader_commit(&s_shaders.entries[i]);
+	}
+}
+
+VkShaderModule wc_shader_get_module(const uint32_t shader)
+{
+	return shader < s_shaders.count ? s_shaders.entries[shader].module : VK_NULL_HANDLE;
+}
+
+const WC_ShaderReflection* wc_shader_get_reflection(const uint32_t shader)
+{
+	return shader < s_shaders.count ? &s_shaders.entries[shader].reflection : NULL;
+}
+
+VkResult wc_shader_create_pipeline_layout(const uint32_t* shaders, const uint32_t count, VkDescriptorSetLayout set0,
+										  VkPipelineLayout* layout)
+{
+	VkDescriptorSetLayoutBinding bindings[WC_SHADER_MAX_SETS][WC_SHADER_MAX_BINDINGS];
+	uint32_t bindingCounts[WC_SHADER_MAX_SETS] = {0};
+	uint32_t setCount = set0 != VK_NULL_HANDLE ? 1 : 0;
+	VkPushConstantRange pushConstants = {0};
+
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const WC_ShaderReflection* reflection = wc_shader_get_reflection(shaders[i]);
+		if (!reflection)
+			return VK_ERROR_INITIALIZATION_FAILED;
+
+		// Every stage declares the same block, so one range covering the largest serves them all
+		if (reflection->pushConstantSize > 0)
+		{
+			pushConstants.stageFlags |= reflection->stage;
+			pushConstants.size = SDL_max(pushConstants.size, reflection->pushConstantSize);
+		}
+
+		for (uint32_t b = 0; b < reflection->bindingCount; b++)
+		{
+			const WC_ShaderBinding* binding = &reflection->bindings[b];
+			if (binding->set >= WC_SHADER_MAX_SETS)
+			{
+				SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Shader '%s' uses descriptor set %u, limit is %d\n",
+							 s_shaders.entries[shaders[i]].name, binding->set, WC_SHADER_MAX_SETS);
+				return VK_ERROR_INITIALIZATION_FAILED;
+			}
+			setCount = SDL_max(setCount, binding->set + 1);
+			if (binding->set == 0 && set0 != VK_NULL_HANDLE)
+				continue;
+
+			VkDescriptorSetLayoutBinding* merged = NULL;
+			for (uint32_t m = 0; m < bindingCounts[binding->set]; m++)
+			{
+				if (bindings[binding->set][m].binding == binding->binding)
+					merged = &bindings[binding->set][m];
+			}
+			if (merged)
+			{
+				if (merged->descriptorType != binding->type)
+				{
+					SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Descriptor set %u binding %u has conflicting types across stages\n",
+								 binding->set, binding->binding);
+					return VK_ERROR_INITIALIZATION_FAILED;
+				}
+				merged->stageFlags |= reflection->stage;
+				merged->descriptorCount = SDL_max(merged->descriptorCount, binding->count);
+				continue;
+			}
+			if (bindingCounts[binding->set] >= WC_SHADER_MAX_BINDINGS)
+				return VK_ERROR_INITIALIZATION_FAILED;
+
+			merged = &bindings[binding->set][bindingCounts[binding->set]++];
+			*merged = (VkDescriptorSetLayoutBinding){0};
+			merged->binding = binding->binding;
+			merged->descriptorType = binding->type;
+			// Runtime arrays outside the bindless set get a single descriptor
+			merged->descriptorCount = SDL_max(binding->count, 1u);
+			merged->stageFlags = reflection->stage;
+		}
+	}
+
+	const uint32_t firstOwned = s_shaders.setLayoutCount;
+	VkDescriptorSetLayout setLayouts[WC_SHADER_MAX_SETS];
+	VkResult result = VK_SUCCESS;
+	for (uint32_t set = 0; set < setCount && result == VK_SUCCESS; set++)
+	{
+		if (set == 0 && set0 != VK_NULL_HANDLE)
+		{
+			setLayouts[0] = set0;
+			continue;
+		}
+		if (s_shaders.setLayoutCount >= WC_MAX_SHADERS)
+		{
+			result = VK_ERROR_TOO_MANY_OBJECTS;
+			break;
+		}
+
+		// Unused sets below the highest one still need a (empty) layout. Set 1 holds per-pass
+		// resources (render graph images) and is pushed with the commands instead of allocated.
+		VkDescriptorSetLayoutCreateInfo setInfo = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+		setInfo.flags = set == WC_SHADER_PUSH_SET ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR : 0;
+		setInfo.bindingCount = bindingCounts[set];
+		setInfo.pBindings = bindings[set];
+		result = vkCreateDescriptorSetLayout(s_shaders.device, &setInfo, NULL, &setLayouts[set]);
+		if (result == VK_SUCCESS)
+			s_shaders.setLayouts[s_shaders.setLayoutCount++] = setLayouts[set];
+	}
+
+	if (result == VK_SUCCESS)
+	{
+		VkPipelineLayoutCreateInfo layoutInfo = {VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+		layoutInfo.setLayoutCount = setCount;
+		layoutInfo.pSetLayouts = setLayouts;
+		layoutInfo.pushConstantRangeCount = pushConstants.size > 0 ? 1 : 0;
+		layoutInfo.pPushConstantRanges = &pushConstants;
+		result = vkCreatePipelineLayout(s_shaders.device, &layoutInfo, NULL, layout);
+	}
+
+	// The set layouts created above live exactly as long as the pipeline layout that uses them
+	if (result != VK_SUCCESS)
+	{
+		while (s_shaders.setLayoutCount > firstOwned)
+			vkDestroyDescriptorSetLayout(s_shaders.device, s_shaders.setLayouts[--s_shaders.setLayoutCount], NULL);
+		return result;
+	}
+	for (uint32_t i = firstOwned; i < s_shaders.setLayoutCount; i++)
+		s_shaders.setLayoutOwners[i] = *layout;
+	return VK_SUCCESS;
+}
+
+void wc_shader_destroy_pipeline_layout(const VkPipelineLayout layout)
+{
+	if (layout == VK_NULL_HANDLE)
+		return;
+
+	vkDestroyPipelineLayout(s_shaders.device, layout, NULL);
+	for (uint32_t i = 0; i < s_shaders.setLayoutCount;)
+	{
+		if (s_shaders.setLayoutOwners[i] != layout)
+		{
+			i++;
+			continue;
+		}
+		vkDestroyDescriptorSetLayout(s_shaders.device, s_shaders.setLayouts[i], NULL);
+		s_shaders.setLayoutCount--;
+		s_shaders.setLayouts[i] = s_shaders.setLayouts[s_shaders.setLayoutCount];
+		s_shaders.setLayoutOwners[i] = s_shaders.setLayoutOwners[s_shaders.setLayoutCount];
+	}
+}
+
+// --- Hot reload ---
+
+static bool shader_is_stale(const ShaderEntry* entry)
+{
+	for (uint32_t i = 0; i < entry->dependencyCount; i++)
+	{
+		SDL_PathInfo info;
+		if (SDL_GetPathInfo(entry->dependencies[i].path, &info) && info.modify_time != entry->dependencies[i].modifyTime)
+			return true;
+	}
+	return false;
+}
+
+bool wc_shader_has_changes(void)
+{
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		if (shader_is_stale(&s_shaders.entries[i]))
+			return true;
+	}
+	return false;
+}
+
+uint32_t wc_shader_reload_changed(void)
+{
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		ShaderEntry* entry = &s_shaders.entries[i];
+		if (!entry->pending && shader_is_stale(entry))
+			shader_request(entry);
+	}
+
+	uint32_t reloaded = 0;
+	for (uint32_t i = 0; i < s_shaders.count; i++)
+	{
+		ShaderEntry* entry = &s_shaders.entries[i];
+		if (!entry->pending)
+			continue;
+		if (shader_commit(entry))
+		{
+			SDL_Log("Reloaded shader '%s'\n", entry->name);
+			reloaded++;
+		}
+	}
+	return reloaded;
+}
@@ -1,2 +1,60 @@
 #pragma once
 
+#include <volk.h>
+
+#define WC_MAX_SHADERS 256
+#define WC_SHADER_NONE UINT32_MAX
+#define WC_SHADER_MAX_DEFINES 8
+#define WC_SHADER_MAX_DEPENDENCIES 16
+#define WC_SHADER_MAX_BINDINGS 32
+#define WC_SHADER_MAX_SETS 4
+#define WC_SHADER_PUSH_SET 1
+#define WC_SHADER_MAX_PATH 256
+
+typedef struct WC_ShaderBinding
+{
+	uint32_t set;
+	uint32_t binding;
+	VkDescriptorType type;
+	uint32_t count; // 0 for runtime-sized arrays
+} WC_ShaderBinding;
+
+// Resource interface of one stage, read back from its SPIR-V
+typedef struct WC_ShaderReflection
+{
+	VkShaderStageFlagBits stage;
+	WC_ShaderBinding bindings[WC_SHADER_MAX_BINDINGS];
+	uint32_t bindingCount;
+	uint32_t pushConstantSize;
+} WC_ShaderReflection;
+
+// source_dir holds the GLSL sources (hot reload watches it), cache_dir receives compiled SPIR-V.
+// Without sources, shaders come from the prebuilt shaders.pak next to the executable.
+int wc_shader_init(VkDevice device, const char* source_dir, const char* cache_dir);
+void wc_shader_quit(void);
+
+// name is relative to source_dir. Defines are "NAME" or "NAME=VALUE"; each permutation is its own shader.
+uint32_t wc_shader_register(const char* name, VkShaderStageFlagBits stage, const char* const* defines, uint32_t define_count);
+// Compiles every registered shader without a module, one job each, reusing cached SPIR-V when the
+// source, its includes and the defines are unchanged.
+void wc_shader_compile_all(void);
+void wc_shader_wait_all(void);
+
+VkShaderModule wc_shader_get_module(uint32_t shader);
+const WC_ShaderReflection* wc_shader_get_reflection(uint32_t shader);
+
+// Merges the reflected bindings and push constants of the given stages into a pipeline layout.
+// set0 replaces set 0 when not VK_NULL_HANDLE (the shared bindless set); other set layouts are
+// created from reflection and owned by the shader system. WC_SHADER_PUSH_SET is created as a push
+// descriptor set, written with vkCmdPushDescriptorSetKHR.
+VkResult wc_shader_create_pipeline_layout(const uint32_t* shaders, uint32_t count, VkDescriptorSetLayout set0,
+										  VkPipelineLayout* layout);
+// Destroys a layout from wc_shader_create_pipeline_layout together with the set layouts made for it.
+// Nothing may still be using it.
+void wc_shader_destroy_pipeline_layout(VkPipelineLayout layout);
+
+// Cheap modification-time check over every source and include.
+bool wc_shader_has_changes(void);
+// Recompiles changed shaders in parallel and swaps in the new modules; returns how many were
+// replaced. Old modules are destroyed, so no pipeline creation may be using them.
+uint32_t wc_shader_reload_changed(void);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+// Layout of shaders.pak, written by the shader_pack build tool and mapped whole at startup.
+// The header is followed by the entry table, then every module's SPIR-V at a 4-byte aligned offset.
+#define WC_SHADER_PACK_MAGIC 0x50534357 // "WCSP"
+#define WC_SHADER_PACK_VERSION 1
+#define WC_SHADER_PACK_NAME_LENGTH 120
+
+typedef struct WC_ShaderPackHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t count;
+	uint32_t reserved;
+} WC_ShaderPackHeader;
+
+// name is the source file name plus "+DEFINE" per permutation define, e.g. "visibility.task.glsl+ALPHA_TEST"
+typedef struct WC_ShaderPackEntry
+{
+	char name[WC_SHADER_PACK_NAME_LENGTH];
+	uint32_t offset;
+	uint32_t size;
+} WC_ShaderPackEntry;
@@ -0,0 +1,882 @@
+#include "texture.h"
+
+#include "../system/memory.h"
+#include "allocator.h"
+#include "resource.h"
+
+#include <SDL3/SDL.h>
+#include <float.h>
+#include <math.h>
+
+#define TEXTURE_MAX_IO_REQUESTS 64
+#define TEXTURE_MAX_PATH 256
+#define TEXTURE_LEVEL_NONE UINT32_MAX
+#define TEXTURE_READ_TAIL UINT32_MAX
+
+typedef enum
+{
+	TEXTURE_STATE_HEADER_PENDING = 0,
+	TEXTURE_STATE_LOADED,
+	TEXTURE_STATE_FAILED
+} TextureState;
+
+typedef struct
+{
+	char path[TEXTURE_MAX_PATH];
+	TextureState state;
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint64_t levelSizes[WC_TEXTURE_MAX_LEVELS];
+	uint32_t tailLevel;		 // Finest level of the mip tail, never evicted
+	uint32_t finestLevel;	 // Finest level that fits in staging
+	uint32_t residentLevel;	 // Finest level on the GPU, levelCount while only the placeholder is bound
+	uint32_t requestedLevel; // Level of the read or upload in flight
+	uint32_t slot;
+	float distance;
+
+	VkImage image;
+	VkImageView view;
+	VmaAllocation allocation;
+	uint64_t bytes;
+} StreamTexture;
+
+typedef struct
+{
+	uint32_t texture;
+	uint32_t firstLevel;
+} IoRequest;
+
+// Levels firstLevel..levelCount-1 of one file, packed back to back in data
+typedef struct
+{
+	uint32_t texture;
+	int status;
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint64_t levelSizes[WC_TEXTURE_MAX_LEVELS];
+	uint64_t levelOffsets[WC_TEXTURE_MAX_LEVELS];
+	uint32_t firstLevel;
+	uint8_t* data;
+	uint64_t size;
+} IoResult;
+
+typedef struct
+{
+	uint32_t texture;
+	uint32_t firstLevel;
+	VkImage image;
+	VkImageView view;
+	VmaAllocation allocation;
+	uint64_t bytes;
+} UploadItem;
+
+typedef struct
+{
+	VkImage image;
+	VkImageView view;
+	VmaAllocation allocation;
+	uint64_t frame;
+} RetiredImage;
+
+typedef struct
+{
+	VkDevice device;
+	VmaAllocator allocator;
+	VkQueue queue;
+	uint64_t budget;
+	uint64_t frame;
+
+	StreamTexture textures[WC_MAX_TEXTURES];
+	uint32_t count;
+	uint64_t residentBytes;
+
+	// I/O thread: requests in, results out, both rings guarded by one mutex. At most
+	// TEXTURE_MAX_IO_REQUESTS reads are outstanding, so neither ring can overflow.
+	SDL_Thread* ioThread;
+	SDL_Mutex* ioMutex;
+	SDL_Condition* ioCondition;
+	bool ioQuit;
+	IoRequest requests[TEXTURE_MAX_IO_REQUESTS];
+	uint32_t requestHead;
+	uint32_t requestCount;
+	IoResult results[TEXTURE_MAX_IO_REQUESTS];
+	uint32_t resultHead;
+	uint32_t resultCount;
+	uint32_t ioInFlight;
+
+	// Results taken off the I/O thread that have not fit into an upload batch yet
+	IoResult ready[TEXTURE_MAX_IO_REQUESTS];
+	uint32_t readyCount;
+
+	// One upload batch in flight at a time, fenced on the render queue
+	VkCommandPool commandPool;
+	VkCommandBuffer commandBuffer;
+	VkFence fence;
+	VkBuffer stagingBuffer;
+	VmaAllocation stagingAllocation;
+	uint8_t* staging;
+	UploadItem uploads[TEXTURE_MAX_IO_REQUESTS];
+	uint32_t uploadCount;
+	bool uploadPending;
+
+	RetiredImage retired[WC_MAX_TEXTURES];
+	uint32_t retiredCount;
+
+	VkSampler sampler;
+	VkImage placeholderImage;
+	VkImageView placeholderView;
+	VmaAllocation placeholderAllocation;
+} TextureStreamer;
+
+static TextureStreamer s_streamer;
+
+// KTX2 file layout, see the Khronos KTX 2.0 specification
+static const uint8_t s_ktx2_identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+typedef struct
+{
+	uint8_t identifier[12];
+	uint32_t vkFormat;
+	uint32_t typeSize;
+	uint32_t pixelWidth;
+	uint32_t pixelHeight;
+	uint32_t pixelDepth;
+	uint32_t layerCount;
+	uint32_t faceCount;
+	uint32_t levelCount;
+	uint32_t supercompressionScheme;
+	uint32_t dfdByteOffset;
+	uint32_t dfdByteLength;
+	uint32_t kvdByteOffset;
+	uint32_t kvdByteLength;
+	uint64_t sgdByteOffset;
+	uint64_t sgdByteLength;
+} Ktx2Header;
+
+typedef struct
+{
+	uint64_t byteOffset;
+	uint64_t byteLength;
+	uint64_t uncompressedByteLength;
+} Ktx2Level;
+
+static uint64_t texture_align(const uint64_t value)
+{
+	// Satisfies the copy offset rules for every block size up to 16 bytes
+	return (value + 15) & ~15ull;
+}
+
+static void texture_read(const uint32_t texture, const char* path, const uint32_t first_level, IoResult* result)
+{
+	*result = (IoResult){.texture = texture, .status = -1};
+
+	SDL_IOStream* io = SDL_IOFromFile(path, "rb");
+	if (!io)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to open texture %s: %s\n", path, SDL_GetError());
+		return;
+	}
+
+	Ktx2Header header;
+	Ktx2Level levels[WC_TEXTURE_MAX_LEVELS];
+	if (SDL_ReadIO(io, &header, sizeof(header)) != sizeof(header) ||
+		SDL_memcmp(header.identifier, s_ktx2_identifier, sizeof(s_ktx2_identifier)) != 0)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Texture %s is not a KTX2 file\n", path);
+		SDL_CloseIO(io);
+		return;
+	}
+
+	const uint32_t level_count = header.levelCount ? header.levelCount : 1;
+	if (header.vkFormat == VK_FORMAT_UNDEFINED || header.supercompressionScheme != 0 || header.pixelDepth > 1 ||
+		header.layerCount > 1 || header.faceCount != 1 || level_count > WC_TEXTURE_MAX_LEVELS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Texture %s: only uncompressed-container 2D KTX2 is supported\n", path);
+		SDL_CloseIO(io);
+		return;
+	}
+	if (SDL_ReadIO(io, levels, level_count * sizeof(Ktx2Level)) != level_count * sizeof(Ktx2Level))
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Texture %s: truncated level index\n", path);
+		SDL_CloseIO(io);
+		return;
+	}
+
+	result->format = (VkFormat)header.vkFormat;
+	result->width = header.pixelWidth;
+	result->height = header.pixelHeight ? header.pixelHeight : 1;
+	result->levelCount = level_count;
+	for (uint32_t level = 0; level < level_count; level++)
+	{
+		result->levelSizes[level] = levels[level].byteLength;
+	}
+
+	// The first read of a texture only brings in the tail, the finest level still under the tail size
+	uint32_t first = first_level;
+	if (first == TEXTURE_READ_TAIL)
+	{
+		first = level_count - 1;
+		while (first > 0 && levels[first - 1].byteLength <= WC_TEXTURE_TAIL_BYTES)
+			first--;
+	}
+	result->firstLevel = first;
+
+	uint64_t size = 0;
+	for (uint32_t level = first; level < level_count; level++)
+	{
+		result->levelOffsets[level] = size;
+		size = texture_align(size + levels[level].byteLength);
+	}
+
+	result->data = wc_malloc(size);
+	result->size = size;
+	for (uint32_t level = first; level < level_count; level++)
+	{
+		if (SDL_SeekIO(io, (Sint64)levels[level].byteOffset, SDL_IO_SEEK_SET) < 0 ||
+			SDL_ReadIO(io, result->data + result->levelOffsets[level], levels[level].byteLength) != levels[level].byteLength)
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Texture %s: failed to read level %u\n", path, level);
+			wc_free(result->data);
+			result->data = NULL;
+			SDL_CloseIO(io);
+			return;
+		}
+	}
+
+	SDL_CloseIO(io);
+	result->status = 0;
+}
+
+// Blocking file reads live on their own thread so they never stall job workers
+static int texture_io_thread(void* data)
+{
+	(void)data;
+	for (;;)
+	{
+		SDL_LockMutex(s_streamer.ioMutex);
+		while (s_streamer.requestCount == 0 && !s_streamer.ioQuit)
+		{
+			SDL_WaitCondition(s_streamer.ioCondition, s_streamer.ioMutex);
+		}
+		if (s_streamer.ioQuit)
+		{
+			SDL_UnlockMutex(s_streamer.ioMutex);
+			return 0;
+		}
+		const IoRequest request = s_streamer.requests[s_streamer.requestHead];
+		s_streamer.requestHead = (s_streamer.requestHead + 1) % TEXTURE_MAX_IO_REQUESTS;
+		s_streamer.requestCount--;
+		SDL_UnlockMutex(s_streamer.ioMutex);
+
+		// The path is written once before the first request and never changes afterwards
+		IoResult result;
+		texture_read(request.texture, s_streamer.textures[request.texture].path, request.firstLevel, &result);
+
+		SDL_LockMutex(s_streamer.ioMutex);
+		s_streamer.results[(s_streamer.resultHead + s_streamer.resultCount) % TEXTURE_MAX_IO_REQUESTS] = result;
+		s_streamer.resultCount++;
+		SDL_UnlockMutex(s_streamer.ioMutex);
+	}
+}
+
+static void texture_request(StreamTexture* texture, const uint32_t first_level)
+{
+	texture->requestedLevel = first_level;
+	s_streamer.ioInFlight++;
+
+	SDL_LockMutex(s_streamer.ioMutex);
+	s_streamer.requests[(s_streamer.requestHead + s_streamer.requestCount) % TEXTURE_MAX_IO_REQUESTS] =
+		(IoRequest){.texture = (uint32_t)(texture - s_streamer.textures), .firstLevel = first_level};
+	s_streamer.requestCount++;
+	SDL_SignalCondition(s_streamer.ioCondition);
+	SDL_UnlockMutex(s_streamer.ioMutex);
+}
+
+static VkResult texture_create_image(const VkFormat format, const uint32_t width, const uint32_t height, const uint32_t levels,
+									 VkImage* image, VkImageView* view, VmaAllocation* allocation, uint64_t* bytes)
+{
+	const VkImageCreateInfo imageInfo = {.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+										 .imageType = VK_IMAGE_TYPE_2D,
+										 .format = format,
+										 .extent = {width, height, 1},
+										 .mipLevels = levels,
+										 .arrayLayers = 1,
+										 .samples = VK_SAMPLE_COUNT_1_BIT,
+										 .tiling = VK_IMAGE_TILING_OPTIMAL,
+										 .usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+										 .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+										 .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED};
+	const VmaAllocationCreateInfo allocInfo = {.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE};
+
+	VmaAllocationInfo info;
+	VkResult result = vmaCreateImage(s_streamer.allocator, &imageInfo, &allocInfo, image, allocation, &info);
+	if (result != VK_SUCCESS)
+		return result;
+
+	const VkImageViewCreateInfo viewInfo = {.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+											.image = *image,
+											.viewType = VK_IMAGE_VIEW_TYPE_2D,
+											.format = format,
+											.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1}};
+	result = vkCreateImageView(s_streamer.device, &viewInfo, NULL, view);
+	if (result != VK_SUCCESS)
+	{
+		vmaDestroyImage(s_streamer.allocator, *image, *allocation);
+		return result;
+	}
+
+	*bytes = info.size;
+	return VK_SUCCESS;
+}
+
+static void texture_record_upload(const VkImage image, const uint32_t levels, const uint64_t staging_offset,
+								  const uint64_t* level_offsets, const uint32_t width, const uint32_t height)
+{
+	VkImageMemoryBarrier barrier = {.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+									.srcAccessMask = 0,
+									.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+									.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+									.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+									.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+									.image = image,
+									.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1}};
+	vkCmdPipelineBarrier(s_streamer.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, NULL,
+						 0, NULL, 1, &barrier);
+
+	VkBufferImageCopy regions[WC_TEXTURE_MAX_LEVELS];
+	for (uint32_t level = 0; level < levels; level++)
+	{
+		const uint32_t level_width = width >> level;
+		const uint32_t level_height = height >> level;
+		regions[level] = (VkBufferImageCopy){.bufferOffset = staging_offset + level_offsets[level],
+											 .imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1},
+											 .imageExtent = {level_width ? level_width : 1, level_height ? level_height : 1, 1}};
+	}
+	vkCmdCopyBufferToImage(s_streamer.commandBuffer, s_streamer.stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, levels,
+						   regions);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	vkCmdPipelineBarrier(s_streamer.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0,
+						 NULL, 0, NULL, 1, &barrier);
+}
+
+static void texture_destroy_image(const VkImage image, const VkImageView view, const VmaAllocation allocation)
+{
+	if (image == VK_NULL_HANDLE)
+		return;
+	vkDestroyImageView(s_streamer.device, view, NULL);
+	vmaDestroyImage(s_streamer.allocator, image, allocation);
+}
+
+static void texture_retire(const VkImage image, const VkImageView view, const VmaAllocation allocation)
+{
+	if (image == VK_NULL_HANDLE)
+		return;
+	s_streamer.retired[s_streamer.retiredCount++] =
+		(RetiredImage){.image = image, .view = view, .allocation = allocation, .frame = s_streamer.frame};
+}
+
+static void texture_destroy_retired(const bool all)
+{
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < s_streamer.retiredCount; i++)
+	{
+		RetiredImage* retired = &s_streamer.retired[i];
+		if (!all && retired->frame + WC_FRAMES_IN_FLIGHT > s_streamer.frame)
+		{
+			s_streamer.retired[kept++] = *retired;
+			continue;
+		}
+		texture_destroy_image(retired->image, retired->view, retired->allocation);
+	}
+	s_streamer.retiredCount = kept;
+}
+
+static VkResult texture_begin_commands(void)
+{
+	vkResetCommandPool(s_streamer.device, s_streamer.commandPool, 0);
+	const VkCommandBufferBeginInfo beginInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+												.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT};
+	return vkBeginCommandBuffer(s_streamer.commandBuffer, &beginInfo);
+}
+
+static VkResult texture_submit_commands(void)
+{
+	VkResult result = vkEndCommandBuffer(s_streamer.commandBuffer);
+	if (result != VK_SUCCESS)
+		return result;
+
+	vkResetFences(s_streamer.device, 1, &s_streamer.fence);
+	const VkSubmitInfo submitInfo = {
+		.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO, .commandBufferCount = 1, .pCommandBuffers = &s_streamer.commandBuffer};
+	return vkQueueSubmit(s_streamer.queue, 1, &submitInfo, s_streamer.fence);
+}
+
+static int texture_create_placeholder(void)
+{
+	uint64_t bytes;
+	if (texture_create_image(VK_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, &s_streamer.placeholderImage, &s_streamer.placeholderView,
+							 &s_streamer.placeholderAllocation, &bytes) != VK_SUCCESS)
+		return EXIT_FAILURE;
+
+	const uint8_t grey[4] = {128, 128, 128, 255};
+	SDL_memcpy(s_streamer.staging, grey, sizeof(grey));
+	const uint64_t offsets[1] = {0};
+
+	if (texture_begin_commands() != VK_SUCCESS)
+		return EXIT_FAILURE;
+	texture_record_upload(s_streamer.placeholderImage, 1, 0, offsets, 1, 1);
+	if (texture_submit_commands() != VK_SUCCESS)
+		return EXIT_FAILURE;
+
+	vkWaitForFences(s_streamer.device, 1, &s_streamer.fence, VK_TRUE, UINT64_MAX);
+	return EXIT_SUCCESS;
+}
+
+int wc_texture_init(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queue_family, uint64_t budget_bytes)
+{
+	SDL_memset(&s_streamer, 0, sizeof(s_streamer));
+	s_streamer.device = device;
+	s_streamer.allocator = allocator;
+	s_streamer.queue = queue;
+	s_streamer.budget = budget_bytes;
+
+	const VkCommandPoolCreateInfo poolInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+											  .flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+											  .queueFamilyIndex = queue_family};
+	if (vkCreateCommandPool(device, &poolInfo, NULL, &s_streamer.commandPool) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture upload command pool\n");
+		return EXIT_FAILURE;
+	}
+
+	const VkCommandBufferAllocateInfo commandInfo = {.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+													 .commandPool = s_streamer.commandPool,
+													 .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+													 .commandBufferCount = 1};
+	const VkFenceCreateInfo fenceInfo = {.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, .flags = VK_FENCE_CREATE_SIGNALED_BIT};
+	if (vkAllocateCommandBuffers(device, &commandInfo, &s_streamer.commandBuffer) != VK_SUCCESS ||
+		vkCreateFence(device, &fenceInfo, NULL, &s_streamer.fence) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture upload command buffer\n");
+		return EXIT_FAILURE;
+	}
+
+	const VkBufferCreateInfo stagingInfo = {.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+											.size = WC_TEXTURE_STAGING_SIZE,
+											.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+											.sharingMode = VK_SHARING_MODE_EXCLUSIVE};
+	const VmaAllocationCreateInfo stagingAllocInfo = {
+		.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+		.usage = VMA_MEMORY_USAGE_AUTO_PREFER_HOST,
+		.requiredFlags = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT}; // Uploads are never flushed
+	VmaAllocationInfo stagingAllocation;
+	if (vmaCreateBuffer(allocator, &stagingInfo, &stagingAllocInfo, &s_streamer.stagingBuffer, &s_streamer.stagingAllocation,
+						&stagingAllocation) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture staging buffer\n");
+		return EXIT_FAILURE;
+	}
+	s_streamer.staging = stagingAllocation.pMappedData;
+
+	const VkSamplerCreateInfo samplerInfo = {.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+											 .magFilter = VK_FILTER_LINEAR,
+											 .minFilter = VK_FILTER_LINEAR,
+											 .mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR,
+											 .addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+											 .addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+											 .addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT,
+											 .maxLod = VK_LOD_CLAMP_NONE};
+	if (vkCreateSampler(device, &samplerInfo, NULL, &s_streamer.sampler) != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create texture sampler\n");
+		return EXIT_FAILURE;
+	}
+
+	if (texture_create_placeholder() != EXIT_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to create placeholder texture\n");
+		return EXIT_FAILURE;
+	}
+
+	s_streamer.ioMutex = SDL_CreateMutex();
+	s_streamer.ioCondition = SDL_CreateCondition();
+	s_streamer.ioThread = SDL_CreateThread(texture_io_thread, "texture_io", NULL);
+	if (!s_streamer.ioMutex || !s_streamer.ioCondition || !s_streamer.ioThread)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to start texture I/O thread: %s\n", SDL_GetError());
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void wc_texture_quit(void)
+{
+	if (s_streamer.ioThread)
+	{
+		SDL_LockMutex(s_streamer.ioMutex);
+		s_streamer.ioQuit = true;
+		SDL_BroadcastCondition(s_streamer.ioCondition);
+		SDL_UnlockMutex(s_streamer.ioMutex);
+		SDL_WaitThread(s_streamer.ioThread, NULL);
+	}
+	SDL_DestroyCondition(s_streamer.ioCondition);
+	SDL_DestroyMutex(s_streamer.ioMutex);
+
+	for (uint32_t i = 0; i < s_streamer.resultCount; i++)
+	{
+		wc_free(s_streamer.results[(s_streamer.resultHead + i) % TEXTURE_MAX_IO_REQUESTS].data);
+	}
+	for (uint32_t i = 0; i < s_streamer.readyCount; i++)
+	{
+		wc_free(s_streamer.ready[i].data);
+	}
+
+	vkWaitForFences(s_streamer.device, 1, &s_streamer.fence, VK_TRUE, UINT64_MAX);
+	texture_destroy_retired(true);
+	for (uint32_t i = 0; i < s_streamer.uploadCount; i++)
+	{
+		texture_destroy_image(s_streamer.uploads[i].image, s_streamer.uploads[i].view, s_streamer.uploads[i].allocation);
+	}
+	for (uint32_t i = 0; i < s_streamer.count; i++)
+	{
+		StreamTexture* texture = &s_streamer.textures[i];
+		texture_destroy_image(texture->image, texture->view, texture->allocation);
+	}
+	texture_destroy_image(s_streamer.placeholderImage, s_streamer.placeholderView, s_streamer.placeholderAllocation);
+
+	vkDestroySampler(s_streamer.device, s_streamer.sampler, NULL);
+	vmaDestroyBuffer(s_streamer.allocator, s_streamer.stagingBuffer, s_streamer.stagingAllocation);
+	vkDestroyFence(s_streamer.device, s_streamer.fence, NULL);
+	vkDestroyCommandPool(s_streamer.device, s_streamer.commandPool, NULL);
+	SDL_memset(&s_streamer, 0, sizeof(s_streamer));
+}
+
+uint32_t wc_texture_load(const char* path)
+{
+	if (s_streamer.count >= WC_MAX_TEXTURES || SDL_strlen(path) >= TEXTURE_MAX_PATH)
+		return WC_TEXTURE_NONE;
+
+	const uint32_t slot = wc_gpu_resource_add_texture(s_streamer.placeholderView, s_streamer.sampler);
+	if (slot == UINT32_MAX)
+		return WC_TEXTURE_NONE;
+
+	const uint32_t handle = s_streamer.count++;
+	StreamTexture* texture = &s_streamer.textures[handle];
+	SDL_memset(texture, 0, sizeof(*texture));
+	SDL_strlcpy(texture->path, path, sizeof(texture->path));
+	texture->state = TEXTURE_STATE_HEADER_PENDING;
+	texture->residentLevel = TEXTURE_LEVEL_NONE;
+	texture->requestedLevel = TEXTURE_LEVEL_NONE;
+	texture->slot = slot;
+	texture->distance = FLT_MAX;
+
+	// The tail read goes out immediately, ahead of the budgeted detail reads
+	if (s_streamer.ioInFlight < TEXTURE_MAX_IO_REQUESTS)
+		texture_request(texture, TEXTURE_READ_TAIL);
+
+	return handle;
+}
+
+uint32_t wc_texture_get_index(const uint32_t texture)
+{
+	return texture < s_streamer.count ? s_streamer.textures[texture].slot : UINT32_MAX;
+}
+
+void wc_texture_set_distance(const uint32_t texture, const float distance)
+{
+	if (texture >= s_streamer.count)
+		return;
+	StreamTexture* entry = &s_streamer.textures[texture];
+	entry->distance = distance < entry->distance ? distance : entry->distance;
+}
+
+uint64_t wc_texture_get_resident_bytes(void)
+{
+	return s_streamer.residentBytes;
+}
+
+static uint32_t texture_desired_level(const StreamTexture* texture)
+{
+	uint32_t level = 0;
+	if (texture->distance > WC_TEXTURE_FULL_DETAIL_DISTANCE)
+	{
+		const float steps = log2f(texture->distance / WC_TEXTURE_FULL_DETAIL_DISTANCE);
+		level = steps >= (float)texture->tailLevel ? texture->tailLevel : (uint32_t)steps;
+	}
+	return level < texture->finestLevel ? texture->finestLevel : level;
+}
+
+static uint64_t texture_chain_bytes(const StreamTexture* texture, const uint32_t first_level)
+{
+	uint64_t bytes = 0;
+	for (uint32_t level = first_level; level < texture->levelCount; level++)
+	{
+		bytes += texture->levelSizes[level];
+	}
+	return bytes;
+}
+
+static void texture_finish_uploads(void)
+{
+	if (!s_streamer.uploadPending || vkGetFenceStatus(s_streamer.device, s_streamer.fence) != VK_SUCCESS)
+		return;
+
+	for (uint32_t i = 0; i < s_streamer.uploadCount; i++)
+	{
+		const UploadItem* upload = &s_streamer.uploads[i];
+		StreamTexture* texture = &s_streamer.textures[upload->texture];
+		texture->requestedLevel = TEXTURE_LEVEL_NONE;
+
+		// Frames in flight may sample the current slot, and a descriptor they use must not be
+		// rewritten, so the new view gets a slot of its own. The upload is fenced and never
+		// referenced, so without a free slot it is dropped and requested again later.
+		const uint32_t slot = wc_gpu_resource_add_texture(upload->view, s_streamer.sampler);
+		if (slot == UINT32_MAX)
+		{
+			texture_destroy_image(upload->image, upload->view, upload->allocation);
+			continue;
+		}
+		wc_gpu_resource_remove_texture(texture->slot);
+		texture->slot = slot;
+
+		// The old image may still be sampled by frames in flight, keep it alive until they retire
+		texture_retire(texture->image, texture->view, texture->allocation);
+		s_streamer.residentBytes -= texture->bytes;
+
+		texture->image = upload->image;
+		texture->view = upload->view;
+		texture->allocation = upload->allocation;
+		texture->bytes = upload->bytes;
+		texture->residentLevel = upload->firstLevel;
+		s_streamer.residentBytes += upload->bytes;
+	}
+	s_streamer.uploadCount = 0;
+	s_streamer.uploadPending = false;
+}
+
+static void texture_collect_results(void)
+{
+	SDL_LockMutex(s_streamer.ioMutex);
+	while (s_streamer.resultCount > 0)
+	{
+		s_streamer.ready[s_streamer.readyCount++] = s_streamer.results[s_streamer.resultHead];
+		s_streamer.resultHead = (s_streamer.resultHead + 1) % TEXTURE_MAX_IO_REQUESTS;
+		s_streamer.resultCount--;
+	}
+	SDL_UnlockMutex(s_streamer.ioMutex);
+}
+
+// Returns false when the result has to wait for the next batch
+static bool texture_stage_result(IoResult* result, uint64_t* staging_used)
+{
+	StreamTexture* texture = &s_streamer.textures[result->texture];
+	if (result->status != 0)
+	{
+		texture->requestedLevel = TEXTURE_LEVEL_NONE;
+		if (texture->state == TEXTURE_STATE_HEADER_PENDING)
+			texture->state = TEXTURE_STATE_FAILED;
+		else
+			texture->finestLevel = texture->residentLevel; // Do not keep retrying a level that cannot be read
+		return true;
+	}
+
+	if (texture->state == TEXTURE_STATE_HEADER_PENDING)
+	{
+		texture->state = TEXTURE_STATE_LOADED;
+		texture->format = result->format;
+		texture->width = result->width;
+		texture->height = result->height;
+		texture->levelCount = result->levelCount;
+		SDL_memcpy(texture->levelSizes, result->levelSizes, sizeof(texture->levelSizes));
+		texture->tailLevel = result->firstLevel;
+		texture->residentLevel = result->levelCount;
+
+		// Levels whose chain cannot fit in one staging batch are never requested
+		texture->finestLevel = 0;
+		while (texture->finestLevel < texture->tailLevel && texture_chain_bytes(texture, texture->finestLevel) > WC_TEXTURE_STAGING_SIZE)
+			texture->finestLevel++;
+	}
+
+	if (result->size > WC_TEXTURE_STAGING_SIZE)
+	{
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Texture %s: level %u does not fit in staging\n", texture->path, result->firstLevel);
+		texture->requestedLevel = TEXTURE_LEVEL_NONE;
+		texture->finestLevel = SDL_min(result->firstLevel + 1, texture->tailLevel);
+		return true;
+	}
+	if (*staging_used + result->size > WC_TEXTURE_STAGING_SIZE)
+		return false;
+
+	const uint32_t levels = result->levelCount - result->firstLevel;
+	const uint32_t width = SDL_max(result->width >> result->firstLevel, 1u);
+	const uint32_t height = SDL_max(result->height >> result->firstLevel, 1u);
+	UploadItem upload = {.texture = result->texture, .firstLevel = result->firstLevel};
+	if (texture_create_image(result->format, width, height, levels, &upload.image, &upload.view, &upload.allocation, &upload.bytes) !=
+		VK_SUCCESS)
+	{
+		// Out of device memory or unsupported format; keep what is resident
+		SDL_LogWarn(SDL_LOG_CATEGORY_APPLICATION, "Texture %s: failed to create image for level %u\n", texture->path,
+					result->firstLevel);
+		texture->requestedLevel = TEXTURE_LEVEL_NONE;
+		texture->finestLevel = SDL_min(result->firstLevel + 1, texture->tailLevel);
+		return true;
+	}
+
+	SDL_memcpy(s_streamer.staging + *staging_used, result->data, result->size);
+	texture_record_upload(upload.image, levels, *staging_used, result->levelOffsets + result->firstLevel, width, height);
+	*staging_used += result->size;
+	s_streamer.uploads[s_streamer.uploadCount++] = upload;
+	return true;
+}
+
+static void texture_submit_uploads(void)
+{
+	if (s_streamer.uploadPending || s_streamer.readyCount == 0)
+		return;
+	if (texture_begin_commands() != VK_SUCCESS)
+		return;
+
+	uint64_t staging_used = 0;
+	uint32_t kept = 0;
+	for (uint32_t i = 0; i < s_streamer.readyCount; i++)
+	{
+		IoResult* result = &s_streamer.ready[i];
+		if (!texture_stage_result(result, &staging_used))
+		{
+			s_streamer.ready[kept++] = *result;
+			continue;
+		}
+		wc_free(result->data);
+		s_streamer.ioInFlight--;
+	}
+	s_streamer.readyCount = kept;
+
+	if (s_streamer.uploadCount == 0)
+	{
+		vkEndCommandBuffer(s_streamer.commandBuffer);
+		return;
+	}
+	if (texture_submit_commands() != VK_SUCCESS)
+	{
+		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to submit texture uploads\n");
+		return;
+	}
+	s_streamer.uploadPending = true;
+}
+
+static uint64_t texture_budget(void)
+{
+	// Never plan past what VMA reports the device-local heaps can still take
+	VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+	vmaGetHeapBudgets(s_streamer.allocator, budgets);
+	const VkPhysicalDeviceMemoryProperties* properties;
+	vmaGetMemoryProperties(s_streamer.allocator, &properties);
+
+	uint64_t headroom = 0;
+	for (uint32_t heap = 0; heap < properties->memoryHeapCount; heap++)
+	{
+		if (!(properties->memoryHeaps[heap].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT))
+			continue;
+		if (budgets[heap].budget > budgets[heap].usage)
+			headroom += budgets[heap].budget - budgets[heap].usage;
+	}
+	return SDL_min(s_streamer.budget, s_streamer.residentBytes + headroom);
+}
+
+typedef struct
+{
+	uint32_t texture;
+	uint32_t deficit; // Levels between resident and desired
+	uint32_t desired; // Taken before the distance is reset for the next frame
+	float distance;
+} StreamCandidate;
+
+static int compare_candidates(const void* a, const void* b)
+{
+	const StreamCandidate* lhs = a;
+	const StreamCandidate* rhs = b;
+	if (lhs->deficit != rhs->deficit)
+		return lhs->deficit > rhs->deficit ? -1 : 1;
+	return (lhs->distance > rhs->distance) - (lhs->distance < rhs->distance);
+}
+
+static void texture_schedule_reads(void)
+{
+	static StreamCandidate upgrades[WC_MAX_TEXTURES];
+	static StreamCandidate evictions[WC_MAX_TEXTURES];
+	uint32_t upgrade_count = 0;
+	uint32_t eviction_count = 0;
+
+	for (uint32_t i = 0; i < s_streamer.count; i++)
+	{
+		StreamTexture* texture = &s_streamer.textures[i];
+		if (texture->state == TEXTURE_STATE_HEADER_PENDING && texture->requestedLevel == TEXTURE_LEVEL_NONE &&
+			s_streamer.ioInFlight < TEXTURE_MAX_IO_REQUESTS)
+		{
+			texture_request(texture, TEXTURE_READ_TAIL); // Registered while the I/O queue was full
+			continue;
+		}
+		if (texture->state != TEXTURE_STATE_LOADED || texture->requestedLevel != TEXTURE_LEVEL_NONE)
+		{
+			texture->distance = FLT_MAX;
+			continue;
+		}
+
+		const uint32_t desired = texture_desired_level(texture);
+		if (desired < texture->residentLevel)
+			upgrades[upgrade_count++] = (StreamCandidate){i, texture->residentLevel - desired, desired, texture->distance};
+		else if (desired > texture->residentLevel)
+			evictions[eviction_count++] = (StreamCandidate){i, desired - texture->residentLevel, desired, texture->distance};
+		texture->distance = FLT_MAX;
+	}
+
+	const uint64_t budget = texture_budget();
+	int64_t available = (int64_t)budget - (int64_t)s_streamer.residentBytes;
+
+	// Over budget: shrink the most over-detailed textures first, farthest among equals
+	if (available < 0 && eviction_count > 0)
+	{
+		SDL_qsort(evictions, eviction_count, sizeof(StreamCandidate), compare_candidates);
+		for (uint32_t i = 0; i < eviction_count && available < 0 && s_streamer.ioInFlight < TEXTURE_MAX_IO_REQUESTS; i++)
+		{
+			StreamTexture* texture = &s_streamer.textures[evictions[i].texture];
+			const uint32_t level = evictions[i].desired;
+			available += (int64_t)(texture_chain_bytes(texture, texture->residentLevel) - texture_chain_bytes(texture, level));
+			texture_request(texture, level);
+		}
+	}
+
+	// One level per read so every texture sharpens progressively instead of waiting on its full chain
+	SDL_qsort(upgrades, upgrade_count, sizeof(StreamCandidate), compare_candidates);
+	for (uint32_t i = 0; i < upgrade_count && s_streamer.ioInFlight < TEXTURE_MAX_IO_REQUESTS; i++)
+	{
+		StreamTexture* texture = &s_streamer.textures[upgrades[i].texture];
+		const uint32_t level = texture->residentLevel - 1;
+		const int64_t cost = (int64_t)texture->levelSizes[level];
+		if (cost > available)
+			continue;
+		available -= cost;
+		texture_request(texture, level);
+	}
+}
+
+void wc_texture_update(const uint64_t frame)
+{
+	s_streamer.frame = frame;
+
+	texture_finish_uploads();
+	texture_destroy_retired(false);
+	texture_collect_results();
+	texture_submit_uploads();
+	texture_schedule_reads();
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "types.h"
+
+#include <volk.h>
+
+#define WC_MAX_TEXTURES 4096
+#define WC_TEXTURE_NONE UINT32_MAX
+#define WC_TEXTURE_MAX_LEVELS 16
+
+// Levels at or below this size form the mip tail that is read as soon as a texture is loaded
+#define WC_TEXTURE_TAIL_BYTES (64 * 1024)
+// Upload staging per batch; levels larger than this are never streamed
+#define WC_TEXTURE_STAGING_SIZE (64ull * 1024 * 1024)
+#define WC_TEXTURE_DEFAULT_BUDGET (512ull * 1024 * 1024)
+// Below this camera distance level 0 is wanted, every doubling of distance drops one level
+#define WC_TEXTURE_FULL_DETAIL_DISTANCE 16.0f
+
+// Starts the streaming I/O thread and creates the placeholder every texture shows until its
+// mip tail arrives. budget_bytes caps device memory used by streamed textures.
+int wc_texture_init(VkDevice device, VmaAllocator allocator, VkQueue queue, uint32_t queue_family, uint64_t budget_bytes);
+void wc_texture_quit(void);
+
+// Registers a KTX2 file (uncompressed container, BC or plain formats) and queues its mip tail.
+// Returns immediately; the texture samples the placeholder until data is resident.
+uint32_t wc_texture_load(const char* path);
+// Bindless slot for shaders. Each streamed upgrade moves the texture to a new slot, so read it
+// every frame rather than caching it.
+uint32_t wc_texture_get_index(uint32_t texture);
+
+// Reports where the texture was seen this frame; the closest report of the frame wins.
+void wc_texture_set_distance(uint32_t texture, float distance);
+
+// Retires finished uploads, submits new ones and issues reads for the textures that most need
+// detail within the budget. Call once per frame on the render thread before flushing descriptors.
+// frame counts frames submitted to the GPU so far; replaced images are destroyed by it.
+void wc_texture_update(uint64_t frame);
+uint64_t wc_texture_get_resident_bytes(void);
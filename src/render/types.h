@@ -8,5 +8,7 @@ VK_DEFINE_HANDLE(VkDevice)
 VK_DEFINE_HANDLE(VmaAllocator)
 VK_DEFINE_HANDLE(VkImageView)
 VK_DEFINE_HANDLE(VkSampler)
+VK_DEFINE_HANDLE(VkDescriptorSetLayout)
+VK_DEFINE_HANDLE(VkDescriptorSet)
 
 #undef VK_DEFINE_HANDLE
\ No newline at end of file
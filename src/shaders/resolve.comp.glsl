@@ -0,0 +1,166 @@
+#version 460
+
+// Visibility buffer resolve: one invocation per pixel fetches the triangle named by the IDs,
+// reconstructs its attributes at the pixel and shades it once, however many triangles were
+// rasterized underneath
+layout(local_size_x = 8, local_size_y = 8, local_size_z = 1) in;
+
+struct MeshData
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint vertexStride;
+    uint indexOffset;
+    uint indexCount;
+    uint materialIndex;
+    uint meshletOffset;
+    uint meshletCount;
+    vec4 boundingSphere;
+};
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+    vec4 boundingSphere;
+    vec3 coneAxis;
+    float coneCutoff;
+};
+
+// Compact instance, see WC_GpuInstance: scalar members keep the std430 stride at 20 bytes
+struct Instance
+{
+    float x, y, z;
+    uint yawScale;   // yaw in 1/65536 turns | half-float scale << 16
+    uint meshPlayer; // mesh index | player color << 16 | flags << 24
+};
+
+layout(binding = 0, set = 0, std430) readonly buffer MeshDataBuffer {
+    MeshData meshes[];
+};
+
+layout(binding = 2, set = 0, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout(binding = 3, set = 0, std430) readonly buffer VertexBuffer {
+    float vertices[];
+};
+
+layout(binding = 5, set = 0, std430) readonly buffer MeshletBuffer {
+    Meshlet meshlets[];
+};
+
+layout(binding = 6, set = 0, std430) readonly buffer MeshletVertexBuffer {
+    uint meshletVertices[];
+};
+
+layout(binding = 7, set = 0, std430) readonly buffer MeshletTriangleBuffer {
+    uint meshletTriangles[]; // Packed 8-bit local indices
+};
+
+// Set 1 is pushed per dispatch
+layout(binding = 0, set = 1, rg32ui) uniform readonly uimage2D visibilityImage;
+layout(binding = 1, set = 1, rgba16f) uniform writeonly image2D colorImage;
+
+layout(push_constant) uniform DrawConstants {
+    mat4 viewProj;
+    vec4 cameraPosition;
+    uint instanceOffset;
+    uint instanceCount;
+} pc;
+
+const uint EMPTY_PIXEL = 0xFFFFFFFFu;
+const vec3 BACKGROUND = vec3(0.1);
+const vec3 SUN_DIRECTION = vec3(0.40825, 0.40825, 0.81650);
+
+const vec3 PLAYER_COLORS[8] = vec3[](
+    vec3(0.80, 0.10, 0.08), vec3(0.08, 0.25, 0.85), vec3(0.10, 0.60, 0.12), vec3(0.85, 0.70, 0.05),
+    vec3(0.55, 0.12, 0.70), vec3(0.05, 0.60, 0.65), vec3(0.85, 0.40, 0.05), vec3(0.60, 0.60, 0.60));
+
+float instanceScale(Instance instance)
+{
+    return unpackHalf2x16(instance.yawScale >> 16).x;
+}
+
+// Upright rotation around +Z, uniform scale, then translation
+mat4 instanceTransform(Instance instance)
+{
+    float yaw = float(instance.yawScale & 0xFFFFu) * (6.28318530718 / 65536.0);
+    float scale = instanceScale(instance);
+    float c = cos(yaw) * scale;
+    float s = sin(yaw) * scale;
+    return mat4(vec4(c, s, 0.0, 0.0), vec4(-s, c, 0.0, 0.0), vec4(0.0, 0.0, scale, 0.0), vec4(instance.x, instance.y, instance.z, 1.0));
+}
+
+uint loadTriangleByte(uint byteOffset)
+{
+    return (meshletTriangles[byteOffset >> 2] >> ((byteOffset & 3) * 8)) & 0xFF;
+}
+
+vec3 loadPosition(MeshData mesh, Meshlet meshlet, uint localVertex)
+{
+    uint vertex = meshletVertices[meshlet.vertexOffset + localVertex];
+    uint base = mesh.vertexOffset + vertex * mesh.vertexStride;
+    return vec3(vertices[base], vertices[base + 1], vertices[base + 2]);
+}
+
+// Perspective-correct barycentrics of an NDC position inside a clip-space triangle, the same
+// weights the rasterizer would have interpolated with
+vec3 computeBarycentrics(vec4 c0, vec4 c1, vec4 c2, vec2 ndc)
+{
+    vec3 invW = 1.0 / vec3(c0.w, c1.w, c2.w);
+    vec2 p0 = c0.xy * invW.x;
+    vec2 p1 = c1.xy * invW.y;
+    vec2 p2 = c2.xy * invW.z;
+
+    float invDet = 1.0 / determinant(mat2(p2 - p1, p0 - p1));
+    vec3 ddx = vec3(p1.y - p2.y, p2.y - p0.y, p0.y - p1.y) * invDet * invW;
+    vec3 ddy = vec3(p2.x - p1.x, p0.x - p2.x, p1.x - p0.x) * invDet * invW;
+
+    vec2 delta = ndc - p0;
+    vec3 weights = vec3(invW.x, 0.0, 0.0) + delta.x * ddx + delta.y * ddy;
+    return weights / (weights.x + weights.y + weights.z);
+}
+
+void main()
+{
+    ivec2 pixel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(colorImage);
+    if (pixel.x >= size.x || pixel.y >= size.y) {
+        return;
+    }
+
+    uvec2 ids = imageLoad(visibilityImage, pixel).xy;
+    if (ids.x == EMPTY_PIXEL) {
+        imageStore(colorImage, pixel, vec4(BACKGROUND, 1.0));
+        return;
+    }
+
+    Instance instance = instances[ids.x];
+    MeshData mesh = meshes[instance.meshPlayer & 0xFFFFu];
+    Meshlet meshlet = meshlets[ids.y >> 7];
+    uint offset = meshlet.triangleOffset + (ids.y & 0x7Fu) * 3;
+
+    mat4 transform = instanceTransform(instance);
+    vec3 p0 = (transform * vec4(loadPosition(mesh, meshlet, loadTriangleByte(offset)), 1.0)).xyz;
+    vec3 p1 = (transform * vec4(loadPosition(mesh, meshlet, loadTriangleByte(offset + 1)), 1.0)).xyz;
+    vec3 p2 = (transform * vec4(loadPosition(mesh, meshlet, loadTriangleByte(offset + 2)), 1.0)).xyz;
+
+    vec2 ndc = (vec2(pixel) + 0.5) / vec2(size) * 2.0 - 1.0;
+    vec3 barycentrics = computeBarycentrics(pc.viewProj * vec4(p0, 1.0), pc.viewProj * vec4(p1, 1.0), pc.viewProj * vec4(p2, 1.0), ndc);
+    vec3 position = p0 * barycentrics.x + p1 * barycentrics.y + p2 * barycentrics.z;
+
+    // Only positions are stored, so shading uses the face normal; front faces are counter-clockwise
+    vec3 normal = normalize(cross(p1 - p0, p2 - p0));
+    vec3 albedo = PLAYER_COLORS[(instance.meshPlayer >> 16) & 7u];
+    float diffuse = max(dot(normal, SUN_DIRECTION), 0.0);
+    float sky = 0.5 + 0.5 * normal.z;
+
+    // Distance haze towards the background keeps far blobs readable
+    float haze = clamp(distance(position, pc.cameraPosition.xyz) / 400.0, 0.0, 1.0);
+    vec3 color = albedo * (0.25 * sky + 0.75 * diffuse);
+    imageStore(colorImage, pixel, vec4(mix(color, BACKGROUND, haze * haze), 1.0));
+}
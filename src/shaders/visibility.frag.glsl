@@ -1,9 +1,12 @@
-#version 450
+#version 460
+#extension GL_EXT_mesh_shader : require
 
-layout(location = 0) in vec3 fragColor;
-layout(location = 0) out vec4 outColor;
+// x: instance index, y: meshlet index << 7 | triangle (max_primitives 124 fits in 7 bits).
+// Cleared to ~0u where nothing was drawn; resolve.comp.glsl rebuilds everything else.
+layout(location = 0) perprimitiveEXT flat in uvec2 primitiveIds;
+layout(location = 0) out uvec2 outVisibility;
 
 void main()
 {
-    outColor = vec4(fragColor, 1.0);
-}
\ No newline at end of file
+    outVisibility = primitiveIds;
+}
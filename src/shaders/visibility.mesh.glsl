@@ -1,70 +1,126 @@
-#version 450
+#version 460
 #extension GL_EXT_mesh_shader : require
 
 layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
-layout(triangles, max_vertices = 64, max_primitives = 126) out;
+layout(triangles, max_vertices = 64, max_primitives = 124) out;
 
-// Descriptor bindings
-layout(binding = 0, set = 0) readonly buffer TransformBuffer {
-    mat4 transforms[];
-} transformBuffer;
+struct MeshData
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint vertexStride;
+    uint indexOffset;
+    uint indexCount;
+    uint materialIndex;
+    uint meshletOffset;
+    uint meshletCount;
+    vec4 boundingSphere;
+};
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+    vec4 boundingSphere;
+    vec3 coneAxis;
+    float coneCutoff;
+};
+
+// Compact instance, see WC_GpuInstance: scalar members keep the std430 stride at 20 bytes
+struct Instance
+{
+    float x, y, z;
+    uint yawScale;   // yaw in 1/65536 turns | half-float scale << 16
+    uint meshPlayer; // mesh index | player color << 16 | flags << 24
+};
+
+// Descriptor bindings (bindless set, see WC_BindlessBinding)
+layout(binding = 0, set = 0, std430) readonly buffer MeshDataBuffer {
+    MeshData meshes[];
+};
 
-layout(binding = 1, set = 0) readonly buffer VisibilityBuffer {
-    uint visibility[];
-} visibilityBuffer;
+layout(binding = 2, set = 0, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
 
-// Push constants or uniforms
-layout(push_constant) uniform PushConstants {
+layout(binding = 3, set = 0, std430) readonly buffer VertexBuffer {
+    float vertices[];
+};
+
+layout(binding = 5, set = 0, std430) readonly buffer MeshletBuffer {
+    Meshlet meshlets[];
+};
+
+layout(binding = 6, set = 0, std430) readonly buffer MeshletVertexBuffer {
+    uint meshletVertices[];
+};
+
+layout(binding = 7, set = 0, std430) readonly buffer MeshletTriangleBuffer {
+    uint meshletTriangles[]; // Packed 8-bit local indices
+};
+
+layout(push_constant) uniform DrawConstants {
     mat4 viewProj;
+    vec4 cameraPosition;
+    uint instanceOffset;
+    uint instanceCount;
 } pc;
 
-// Output to fragment shader
-layout(location = 0) out vec3 fragColor[];
+struct TaskPayload
+{
+    uint instanceIndex;
+    uint meshletIndices[32];
+};
+
+taskPayloadSharedEXT TaskPayload payload;
+
+float instanceScale(Instance instance)
+{
+    return unpackHalf2x16(instance.yawScale >> 16).x;
+}
+
+// Upright rotation around +Z, uniform scale, then translation
+mat4 instanceTransform(Instance instance)
+{
+    float yaw = float(instance.yawScale & 0xFFFFu) * (6.28318530718 / 65536.0);
+    float scale = instanceScale(instance);
+    float c = cos(yaw) * scale;
+    float s = sin(yaw) * scale;
+    return mat4(vec4(c, s, 0.0, 0.0), vec4(-s, c, 0.0, 0.0), vec4(0.0, 0.0, scale, 0.0), vec4(instance.x, instance.y, instance.z, 1.0));
+}
+
+// Visibility buffer IDs, see visibility.frag.glsl
+layout(location = 0) perprimitiveEXT flat out uvec2 primitiveIds[];
+
+uint loadTriangleByte(uint byteOffset)
+{
+    return (meshletTriangles[byteOffset >> 2] >> ((byteOffset & 3) * 8)) & 0xFF;
+}
 
 void main()
 {
-    uint meshletIndex = gl_WorkGroupID.x;
+    uint meshletIndex = payload.meshletIndices[gl_WorkGroupID.x];
+    Meshlet meshlet = meshlets[meshletIndex];
+    Instance instance = instances[payload.instanceIndex];
+    MeshData mesh = meshes[instance.meshPlayer & 0xFFFFu];
 
-    // Check visibility
-    if (visibilityBuffer.visibility[meshletIndex] == 0) {
-        SetMeshOutputsEXT(0, 0);
-        return;
-    }
+    mat4 mvp = pc.viewProj * instanceTransform(instance);
+
+    SetMeshOutputsEXT(meshlet.vertexCount, meshlet.triangleCount);
+
+    for (uint i = gl_LocalInvocationIndex; i < meshlet.vertexCount; i += 32) {
+        uint vertex = meshletVertices[meshlet.vertexOffset + i];
+        uint base = mesh.vertexOffset + vertex * mesh.vertexStride;
+        vec3 position = vec3(vertices[base], vertices[base + 1], vertices[base + 2]);
 
-    // Simple cube generation for demonstration
-    vec3 vertices[8] = vec3[](
-        vec3(-0.5, -0.5, -0.5),
-        vec3( 0.5, -0.5, -0.5),
-        vec3( 0.5,  0.5, -0.5),
-        vec3(-0.5,  0.5, -0.5),
-        vec3(-0.5, -0.5,  0.5),
-        vec3( 0.5, -0.5,  0.5),
-        vec3( 0.5,  0.5,  0.5),
-        vec3(-0.5,  0.5,  0.5)
-    );
-
-    // Define cube faces (12 triangles)
-    uvec3 indices[12] = uvec3[](
-        uvec3(0, 1, 2), uvec3(2, 3, 0),  // Front
-        uvec3(1, 5, 6), uvec3(6, 2, 1),  // Right
-        uvec3(5, 4, 7), uvec3(7, 6, 5),  // Back
-        uvec3(4, 0, 3), uvec3(3, 7, 4),  // Left
-        uvec3(3, 2, 6), uvec3(6, 7, 3),  // Top
-        uvec3(4, 5, 1), uvec3(1, 0, 4)   // Bottom
-    );
-
-    mat4 mvp = pc.viewProj * transformBuffer.transforms[meshletIndex];
-
-    // Output vertices
-    SetMeshOutputsEXT(8, 12);
-
-    for (uint i = 0; i < 8; ++i) {
-        gl_MeshVerticesEXT[i].gl_Position = mvp * vec4(vertices[i], 1.0);
-        fragColor[i] = vertices[i] + 0.5; // Simple color based on position
+        gl_MeshVerticesEXT[i].gl_Position = mvp * vec4(position, 1.0);
     }
 
-    // Output primitives
-    for (uint i = 0; i < 12; ++i) {
-        gl_PrimitiveTriangleIndicesEXT[i] = indices[i];
+    for (uint i = gl_LocalInvocationIndex; i < meshlet.triangleCount; i += 32) {
+        uint offset = meshlet.triangleOffset + i * 3;
+        gl_PrimitiveTriangleIndicesEXT[i] = uvec3(loadTriangleByte(offset), loadTriangleByte(offset + 1), loadTriangleByte(offset + 2));
+        primitiveIds[i] = uvec2(payload.instanceIndex, (meshletIndex << 7) | i);
     }
-}
\ No newline at end of file
+}
@@ -0,0 +1,143 @@
+#version 460
+#extension GL_EXT_mesh_shader : require
+
+// One invocation per meshlet, one workgroup row per instance
+layout(local_size_x = 32, local_size_y = 1, local_size_z = 1) in;
+
+struct MeshData
+{
+    uint vertexOffset;
+    uint vertexCount;
+    uint vertexStride;
+    uint indexOffset;
+    uint indexCount;
+    uint materialIndex;
+    uint meshletOffset;
+    uint meshletCount;
+    vec4 boundingSphere;
+};
+
+struct Meshlet
+{
+    uint vertexOffset;
+    uint triangleOffset;
+    uint vertexCount;
+    uint triangleCount;
+    vec4 boundingSphere;
+    vec3 coneAxis;
+    float coneCutoff;
+};
+
+// Compact instance, see WC_GpuInstance: scalar members keep the std430 stride at 20 bytes
+struct Instance
+{
+    float x, y, z;
+    uint yawScale;   // yaw in 1/65536 turns | half-float scale << 16
+    uint meshPlayer; // mesh index | player color << 16 | flags << 24
+};
+
+layout(binding = 0, set = 0, std430) readonly buffer MeshDataBuffer {
+    MeshData meshes[];
+};
+
+layout(binding = 2, set = 0, std430) readonly buffer InstanceBuffer {
+    Instance instances[];
+};
+
+layout(binding = 5, set = 0, std430) readonly buffer MeshletBuffer {
+    Meshlet meshlets[];
+};
+
+layout(push_constant) uniform DrawConstants {
+    mat4 viewProj;
+    vec4 cameraPosition;
+    uint instanceOffset;
+    uint instanceCount;
+} pc;
+
+struct TaskPayload
+{
+    uint instanceIndex;
+    uint meshletIndices[32];
+};
+
+taskPayloadSharedEXT TaskPayload payload;
+
+float instanceScale(Instance instance)
+{
+    return unpackHalf2x16(instance.yawScale >> 16).x;
+}
+
+// Upright rotation around +Z, uniform scale, then translation
+mat4 instanceTransform(Instance instance)
+{
+    float yaw = float(instance.yawScale & 0xFFFFu) * (6.28318530718 / 65536.0);
+    float scale = instanceScale(instance);
+    float c = cos(yaw) * scale;
+    float s = sin(yaw) * scale;
+    return mat4(vec4(c, s, 0.0, 0.0), vec4(-s, c, 0.0, 0.0), vec4(0.0, 0.0, scale, 0.0), vec4(instance.x, instance.y, instance.z, 1.0));
+}
+
+shared uint visibleCount;
+
+bool sphereInFrustum(vec3 center, float radius)
+{
+    // Gribb-Hartmann planes from the rows of viewProj, Vulkan [0, 1] depth
+    mat4 m = transpose(pc.viewProj);
+    vec4 planes[6] = vec4[](m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[2], m[3] - m[2]);
+
+    for (int i = 0; i < 6; ++i) {
+        vec4 plane = planes[i] / length(planes[i].xyz);
+        if (dot(plane.xyz, center) + plane.w < -radius) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void main()
+{
+    uint instanceIndex = pc.instanceOffset + gl_WorkGroupID.y;
+    uint localMeshlet = gl_WorkGroupID.x * 32 + gl_LocalInvocationIndex;
+
+    if (gl_LocalInvocationIndex == 0) {
+        visibleCount = 0;
+        payload.instanceIndex = instanceIndex;
+    }
+    barrier();
+
+    bool visible = false;
+    uint meshletIndex = 0;
+    if (gl_WorkGroupID.y < pc.instanceCount) {
+        Instance instance = instances[instanceIndex];
+        MeshData mesh = meshes[instance.meshPlayer & 0xFFFFu];
+
+        if (localMeshlet < mesh.meshletCount) {
+            meshletIndex = mesh.meshletOffset + localMeshlet;
+            Meshlet meshlet = meshlets[meshletIndex];
+
+            // Uniform scale is stored directly, no need to measure the matrix axes
+            mat4 transform = instanceTransform(instance);
+            mat3 rotationScale = mat3(transform);
+            vec3 center = (transform * vec4(meshlet.boundingSphere.xyz, 1.0)).xyz;
+            float radius = meshlet.boundingSphere.w * instanceScale(instance);
+
+            visible = sphereInFrustum(center, radius);
+
+            // Normal cone: the whole cluster faces away from the camera
+            vec3 axis = normalize(rotationScale * meshlet.coneAxis);
+            vec3 toCenter = center - pc.cameraPosition.xyz;
+            if (visible && dot(toCenter, axis) >= meshlet.coneCutoff * length(toCenter) + radius) {
+                visible = false;
+            }
+        }
+    }
+
+    if (visible) {
+        uint slot = atomicAdd(visibleCount, 1);
+        payload.meshletIndices[slot] = meshletIndex;
+    }
+    barrier();
+
+    EmitMeshTasksEXT(visibleCount, 1, 1);
+}
@@ -2,6 +2,7 @@
 
 #include "config.h"
 #include "input.h"
+#include "profiler.h"
 
 #include <SDL3/SDL.h>
 
@@ -69,6 +70,8 @@ typedef struct WC_App
 
 	WC_AppCallbacks callbacks;
 
+	wc_config config;
+
 	bool running;
 } WC_App;
 
@@ -403,8 +406,8 @@ void wc_app_init(const char* window_title, const WC_AppCallbacks callbacks)
 		return;
 	}
 
-	wc_config config = {0};
-	if (wc_config_load(&config, "settings.cfg") != 0)
+	wc_config* config = &s_app.config;
+	if (wc_config_load(config, "settings.cfg") != 0)
 	{
 		SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Failed to load settings.cfg\n");
 		return;
@@ -416,9 +419,9 @@ void wc_app_init(const char* window_title, const WC_AppCallbacks callbacks)
 	s_app.time.tick_previous = SDL_GetPerformanceCounter() - (uint64_t)(WC_FIXED_TIMESTEP * s_app.time.tick_frequency);
 	s_app.time.accumulator = 0.0;
 
-	const int resolution_x = wc_config_get_int(&config, "resolution_x", 1280);
-	const int resolution_y = wc_config_get_int(&config, "resolution_y", 720);
-	const bool fullscreen = wc_config_get_int(&config, "fullscreen", false);
+	const int resolution_x = wc_config_get_int(config, "resolution_x", 1280);
+	const int resolution_y = wc_config_get_int(config, "resolution_y", 720);
+	const bool fullscreen = wc_config_get_int(config, "fullscreen", false);
 
 	uint32_t window_flags = SDL_WINDOW_HIGH_PIXEL_DENSITY;
 	window_flags |= SDL_WINDOW_VULKAN;
@@ -456,6 +459,9 @@ bool wc_app_is_running()
 
 static void wc_handle_events()
 {
+	// Window flags report changes since the previous frame
+	s_app.window.resized = false;
+
 	SDL_Event event;
 	while (SDL_PollEvent(&event))
 	{
@@ -463,6 +469,8 @@ static void wc_handle_events()
 		{
 			case SDL_EVENT_QUIT:
 				s_app.running = false;
+				break;
+
 			case SDL_EVENT_WINDOW_RESIZED:
 				s_app.window.resized = true;
 				s_app.window.width = event.window.data1;
@@ -641,8 +649,11 @@ void wc_app_update()
 		s_app.time.accumulator = WC_MAX_ACCUMULATOR;
 	}
 
+	const uint32_t events_zone = profiler_zone_begin("events");
 	wc_handle_events();
+	profiler_zone_end(events_zone);
 
+	const uint32_t update_zone = profiler_zone_begin("update");
 	while (s_app.time.accumulator >= WC_FIXED_TIMESTEP)
 	{
 		// Update the game logic with a fixed, constant delta time.
@@ -652,10 +663,13 @@ void wc_app_update()
 		// Decrease the accumulator by the fixed step amount.
 		s_app.time.accumulator -= WC_FIXED_TIMESTEP;
 	}
+	profiler_zone_end(update_zone);
 
+	const uint32_t render_zone = profiler_zone_begin("render");
 	const double interpolant = s_app.time.accumulator / WC_FIXED_TIMESTEP;
 	if (s_app.callbacks.render != NULL)
 		s_app.callbacks.render(interpolant);
+	profiler_zone_end(render_zone);
 }
 
 void* wc_app_get_window_handle()
@@ -663,6 +677,16 @@ void* wc_app_get_window_handle()
 	return s_app.window.handle;
 }
 
+const wc_config* wc_app_get_config()
+{
+	return &s_app.config;
+}
+
+bool wc_app_was_resized()
+{
+	return s_app.window.resized;
+}
+
 void wc_app_get_window_size(int* width, int* height)
 {
 	WC_ASSERT(s_app.window.handle);
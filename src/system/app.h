@@ -1,5 +1,7 @@
 #pragma once
 
+#include "config.h"
+
 #include <stdbool.h>
 
 typedef struct WC_AppCallbacks
@@ -27,6 +29,9 @@ void wc_app_update();
 
 int wc_app_draw();
 
+// Settings loaded from settings.cfg at init
+const wc_config* wc_app_get_config();
+
 void* wc_app_get_window_handle();
 
 void wc_app_get_window_size(int* width, int* height);
@@ -5,15 +5,22 @@
 
 int wc_config_load(wc_config* config, const char* filename)
 {
-	SDL_IOStream* file = SDL_IOFromFile(filename, "r");
-	if (!file)
+	size_t size;
+	char* data = SDL_LoadFile(filename, &size);
+	if (!data)
 		return -1;
 
-	char line[WC_MAX_KEY_LENGTH + WC_MAX_VALUE_LENGTH + 2]; // Key + '=' + Value + '\0'
 	config->count = 0;
 
-	while (SDL_ReadIO(file, line, sizeof(line)))
+	// SDL_LoadFile null-terminates, so lines can be split in place
+	char* next = data;
+	while (next && *next && config->count < WC_MAX_CONFIG_ENTRIES)
 	{
+		char* line = next;
+		next = SDL_strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+
 		char* eq = SDL_strchr(line, '=');
 		if (!eq)
 			continue; // Skip malformed lines
@@ -24,18 +31,19 @@ int wc_config_load(wc_config* config, const char* filename)
 		char* key_trim = line;
 		while (*key_trim == ' ' || *key_trim == '\t')
 			key_trim++;
-		char* key_end = key_trim + SDL_strlen(key_trim) - 1;
-		while (key_end > key_trim && (*key_end == ' ' || *key_end == '\t' || *key_end == '\n'))
+		// End pointers are exclusive, so an empty key or value never steps before its start
+		char* key_end = key_trim + SDL_strlen(key_trim);
+		while (key_end > key_trim && (key_end[-1] == ' ' || key_end[-1] == '\t' || key_end[-1] == '\r'))
 			key_end--;
-		*(key_end + 1) = '\0';
+		*key_end = '\0';
 
 		char* val_trim = eq + 1;
 		while (*val_trim == ' ' || *val_trim == '\t')
 			val_trim++;
-		char* val_end = val_trim + SDL_strlen(val_trim) - 1;
-		while (val_end > val_trim && (*val_end == ' ' || *val_end == '\t' || *val_end == '\n'))
+		char* val_end = val_trim + SDL_strlen(val_trim);
+		while (val_end > val_trim && (val_end[-1] == ' ' || val_end[-1] == '\t' || val_end[-1] == '\r'))
 			val_end--;
-		*(val_end + 1) = '\0';
+		*val_end = '\0';
 
 		if (SDL_strlen(key_trim) >= WC_MAX_KEY_LENGTH || SDL_strlen(val_trim) >= WC_MAX_VALUE_LENGTH)
 		{
@@ -47,7 +55,7 @@ int wc_config_load(wc_config* config, const char* filename)
 		config->count++;
 	}
 
-	SDL_CloseIO(file);
+	SDL_free(data);
 	return 0;
 }
 
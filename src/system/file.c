@@ -0,0 +1,77 @@
+#include "file.h"
+
+#include <SDL3/SDL_stdinc.h>
+
+#ifdef _WIN32
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+int wc_file_map(const char* path, WC_FileMapping* mapping)
+{
+	SDL_memset(mapping, 0, sizeof(*mapping));
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return -1;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return -1;
+	}
+
+	// The view keeps the section alive, so neither handle is needed once it exists
+	HANDLE section = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!section)
+		return -1;
+	const void* data = MapViewOfFile(section, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(section);
+	if (!data)
+		return -1;
+
+	mapping->data = data;
+	mapping->size = (size_t)size.QuadPart;
+#else
+	const int file = open(path, O_RDONLY);
+	if (file < 0)
+		return -1;
+
+	struct stat info;
+	if (fstat(file, &info) != 0 || info.st_size == 0)
+	{
+		close(file);
+		return -1;
+	}
+
+	void* data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+		return -1;
+
+	mapping->data = data;
+	mapping->size = (size_t)info.st_size;
+#endif
+	return 0;
+}
+
+void wc_file_unmap(WC_FileMapping* mapping)
+{
+	if (!mapping->data)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapping->data);
+#else
+	munmap((void*)mapping->data, mapping->size);
+#endif
+	SDL_memset(mapping, 0, sizeof(*mapping));
+}
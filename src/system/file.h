@@ -0,0 +1,15 @@
+#pragma once
+
+#include <stddef.h>
+
+// Read-only view of a whole file. The OS pages it in on demand, so large archives cost no copy
+// and no allocation up front.
+typedef struct WC_FileMapping
+{
+	const void* data;
+	size_t size;
+} WC_FileMapping;
+
+// Returns non-zero on failure (missing file, empty file or mapping error).
+int wc_file_map(const char* path, WC_FileMapping* mapping);
+void wc_file_unmap(WC_FileMapping* mapping);
@@ -0,0 +1,136 @@
+#include "image.h"
+
+#include "memory.h"
+
+#include <SDL3/SDL_endian.h>
+#include <SDL3/SDL_iostream.h>
+#include <SDL3/SDL_stdinc.h>
+
+#define WC_DEFLATE_STORED_MAX 65535
+
+static uint32_t s_crc_table[256];
+
+static void wc_crc_init(void)
+{
+	if (s_crc_table[1] != 0)
+		return;
+	for (uint32_t n = 0; n < 256; n++)
+	{
+		uint32_t c = n;
+		for (int k = 0; k < 8; k++)
+			c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+		s_crc_table[n] = c;
+	}
+}
+
+static uint32_t wc_crc_update(uint32_t crc, const uint8_t* data, const size_t size)
+{
+	for (size_t i = 0; i < size; i++)
+		crc = s_crc_table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	return crc;
+}
+
+static bool wc_png_write_chunk(SDL_IOStream* file, const char type[4], const uint8_t* data, const uint32_t size)
+{
+	uint32_t crc = wc_crc_update(0xFFFFFFFFu, (const uint8_t*)type, 4);
+	crc = wc_crc_update(crc, data, size) ^ 0xFFFFFFFFu;
+
+	return SDL_WriteU32BE(file, size) && SDL_WriteIO(file, type, 4) == 4 && (size == 0 || SDL_WriteIO(file, data, size) == size) &&
+		   SDL_WriteU32BE(file, crc);
+}
+
+int wc_image_write_png(const char* filename, const uint8_t* rgba, const uint32_t width, const uint32_t height)
+{
+	wc_crc_init();
+
+	// Each scanline gets a filter byte (0 = none) in front of its pixels
+	const size_t row_size = (size_t)width * 4 + 1;
+	const size_t raw_size = row_size * height;
+	const size_t block_count = raw_size / WC_DEFLATE_STORED_MAX + 1;
+	const size_t zlib_size = 2 + block_count * 5 + raw_size + 4;
+	if (zlib_size > UINT32_MAX)
+		return -1;
+
+	uint8_t* zlib = wc_malloc(zlib_size);
+	if (!zlib)
+		return -1;
+
+	// zlib header for deflate with a 32K window and no preset dictionary
+	size_t out = 0;
+	zlib[out++] = 0x78;
+	zlib[out++] = 0x01;
+
+	uint32_t adler_a = 1;
+	uint32_t adler_b = 0;
+	size_t row = 0;
+	size_t column = 0;
+	size_t remaining = raw_size;
+	while (true)
+	{
+		const uint32_t block = (uint32_t)SDL_min(remaining, (size_t)WC_DEFLATE_STORED_MAX);
+		remaining -= block;
+		zlib[out++] = remaining == 0 ? 1 : 0; // BFINAL, BTYPE = stored
+		zlib[out++] = (uint8_t)(block & 0xFF);
+		zlib[out++] = (uint8_t)(block >> 8);
+		zlib[out++] = (uint8_t)(~block & 0xFF);
+		zlib[out++] = (uint8_t)((~block >> 8) & 0xFF);
+
+		for (uint32_t i = 0; i < block; i++)
+		{
+			const uint8_t value = column == 0 ? 0 : rgba[row * width * 4 + column - 1];
+			zlib[out++] = value;
+			adler_a = (adler_a + value) % 65521;
+			adler_b = (adler_b + adler_a) % 65521;
+			if (++column == row_size)
+			{
+				column = 0;
+				row++;
+			}
+		}
+
+		if (remaining == 0)
+			break;
+	}
+
+	const uint32_t adler = (adler_b << 16) | adler_a;
+	zlib[out++] = (uint8_t)(adler >> 24);
+	zlib[out++] = (uint8_t)(adler >> 16);
+	zlib[out++] = (uint8_t)(adler >> 8);
+	zlib[out++] = (uint8_t)adler;
+
+	uint8_t header[13];
+	const uint32_t be_width = SDL_Swap32BE(width);
+	const uint32_t be_height = SDL_Swap32BE(height);
+	SDL_memcpy(header, &be_width, 4);
+	SDL_memcpy(header + 4, &be_height, 4);
+	header[8] = 8;	// Bit depth
+	header[9] = 6;	// Colour type RGBA
+	header[10] = 0; // Deflate
+	header[11] = 0; // Adaptive filtering
+	header[12] = 0; // No interlace
+
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+	int result = -1;
+	SDL_IOStream* file = SDL_IOFromFile(filename, "wb");
+	if (file)
+	{
+		if (SDL_WriteIO(file, signature, sizeof(signature)) == sizeof(signature) &&
+			wc_png_write_chunk(file, "IHDR", header, sizeof(header)) && wc_png_write_chunk(file, "IDAT", zlib, (uint32_t)out) &&
+			wc_png_write_chunk(file, "IEND", NULL, 0))
+		{
+			result = 0;
+		}
+		if (!SDL_CloseIO(file))
+			result = -1;
+	}
+
+	wc_free(zlib);
+	return result;
+}
+
+int wc_image_write_raw(const char* filename, const uint8_t* rgba, const uint32_t width, const uint32_t height)
+{
+	const size_t size = (size_t)width * height * 4;
+	return SDL_SaveFile(filename, rgba, size) ? 0 : -1;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// Writes 8-bit RGBA pixels, rows top to bottom with no padding. PNG output uses stored
+// (uncompressed) deflate blocks: larger files, but no compression dependency and byte-exact
+// output for golden-image comparisons. Both return non-zero on failure.
+int wc_image_write_png(const char* filename, const uint8_t* rgba, uint32_t width, uint32_t height);
+int wc_image_write_raw(const char* filename, const uint8_t* rgba, uint32_t width, uint32_t height);
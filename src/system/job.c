@@ -7,7 +7,6 @@
 
 // Configuration
 #define MAX_JOB_COUNT 4096
-#define MAX_WORKER_THREADS 16
 #define CACHE_LINE_SIZE 64
 #define JOB_QUEUE_SIZE 256
 #define LARGE_FIBER_BIT 0x80000000
@@ -110,7 +109,7 @@ typedef struct
 // Job system state
 typedef struct
 {
-    WorkerThread workers[MAX_WORKER_THREADS];
+    WorkerThread workers[WC_JOB_MAX_WORKERS];
     u32 worker_count;
 
     // Global job pool with free list
@@ -688,12 +687,12 @@ bool job_system_init(u32 worker_count)
     SYSTEM_INFO sys_info;
     GetSystemInfo(&sys_info);
 
-    if (worker_count == 0 || worker_count > MAX_WORKER_THREADS)
+    if (worker_count == 0 || worker_count > WC_JOB_MAX_WORKERS)
     {
         worker_count = sys_info.dwNumberOfProcessors;
-        if (worker_count > MAX_WORKER_THREADS)
+        if (worker_count > WC_JOB_MAX_WORKERS)
         {
-            worker_count = MAX_WORKER_THREADS;
+            worker_count = WC_JOB_MAX_WORKERS;
         }
     }
 
@@ -986,6 +985,17 @@ void job_batch_wait(JobBatch* batch)
     }
 }
 
+u32 job_get_worker_index(void)
+{
+    WorkerThread* worker = get_current_worker();
+    return worker ? worker->worker_index : g_job_system.worker_count;
+}
+
+u32 job_get_worker_count(void)
+{
+    return g_job_system.worker_count;
+}
+
 // Parallel for implementation
 typedef struct
 {
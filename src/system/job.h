@@ -30,6 +30,9 @@ typedef struct
 
 #define INVALID_JOB_HANDLE ((JobHandle) {0})
 
+// Most worker threads job_system_init starts; larger requests are clamped
+#define WC_JOB_MAX_WORKERS 16
+
 typedef void (*JobFunc)(void* data);
 
 // Initialize job system
@@ -53,5 +56,10 @@ void job_batch_add(JobBatch* batch, JobHandle job);
 void job_batch_run(JobBatch* batch, JobPriority priority);
 void job_batch_wait(JobBatch* batch);
 
+// Worker identification. Returns the calling worker's index, or job_get_worker_count() on the main thread,
+// so callers can size per-worker scratch as job_get_worker_count() + 1.
+u32 job_get_worker_index(void);
+u32 job_get_worker_count(void);
+
 // Helper for parallel for loops
 JobHandle job_parallel_for(u32 count, u32 batch_size, void (*func)(u32 start, u32 end, void* data), void* data);
\ No newline at end of file
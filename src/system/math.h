@@ -1,5 +1,32 @@
 #pragma once
 
+#include <math.h>
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// Backend picked at compile time from the target flags. Defining WC_MATH_SCALAR forces the plain C
+// reference path everywhere, which is what the SIMD paths are checked against.
+#if !defined(WC_MATH_SCALAR)
+    #if defined(__AVX2__)
+        #define WC_MATH_AVX2 1
+        #define WC_MATH_SSE 1
+        #include <immintrin.h>
+    #elif defined(__SSE2__) || defined(_M_X64)
+        #define WC_MATH_SSE 1
+        #include <emmintrin.h>
+    #elif defined(__ARM_NEON) || defined(_M_ARM64)
+        #define WC_MATH_NEON 1
+        #include <arm_neon.h>
+    #else
+        #define WC_MATH_SCALAR 1
+    #endif
+#endif
+
+#define WC_PI 3.14159265358979323846f
+#define WC_TWO_PI 6.28318530717958647692f
+#define WC_HALF_PI 1.57079632679489661923f
+
 typedef struct wc_float2 {
     float x, y;
 } wc_float2;
@@ -12,6 +39,448 @@ typedef struct wc_float4 {
     float x, y, z, w;
 } wc_float4;
 
+// Unit quaternion, xyz the vector part
+typedef wc_float4 wc_quat;
+
+// Column-major like the shaders: m[column * 4 + row], translation in m[12..14]
+typedef struct wc_mat4 {
+    alignas(16) float m[16];
+} wc_mat4;
+
+// Row-major affine 3x4, the layout of VkTransformMatrixKHR: translation in m[3], m[7], m[11]
+typedef struct wc_mat3x4 {
+    float m[12];
+} wc_mat3x4;
+
 typedef struct wc_aabb {
     wc_float3 min, max;
-} wc_aabb;
\ No newline at end of file
+} wc_aabb;
+
+typedef struct wc_sphere {
+    wc_float3 center;
+    float radius;
+} wc_sphere;
+
+// Left, right, bottom, top, near, far; xyz the inward normal, w the distance
+typedef struct wc_frustum {
+    wc_float4 planes[6];
+} wc_frustum;
+
+//-------------------------------------------------------------------------------------------------
+// Vectors
+
+static inline wc_float2 wc_float2_add(const wc_float2 a, const wc_float2 b) { return (wc_float2) {a.x + b.x, a.y + b.y}; }
+static inline wc_float2 wc_float2_sub(const wc_float2 a, const wc_float2 b) { return (wc_float2) {a.x - b.x, a.y - b.y}; }
+static inline wc_float2 wc_float2_scale(const wc_float2 a, const float s) { return (wc_float2) {a.x * s, a.y * s}; }
+static inline float wc_float2_dot(const wc_float2 a, const wc_float2 b) { return a.x * b.x + a.y * b.y; }
+static inline float wc_float2_length(const wc_float2 a) { return sqrtf(wc_float2_dot(a, a)); }
+
+static inline wc_float3 wc_float3_add(const wc_float3 a, const wc_float3 b) { return (wc_float3) {a.x + b.x, a.y + b.y, a.z + b.z}; }
+static inline wc_float3 wc_float3_sub(const wc_float3 a, const wc_float3 b) { return (wc_float3) {a.x - b.x, a.y - b.y, a.z - b.z}; }
+static inline wc_float3 wc_float3_mul(const wc_float3 a, const wc_float3 b) { return (wc_float3) {a.x * b.x, a.y * b.y, a.z * b.z}; }
+static inline wc_float3 wc_float3_scale(const wc_float3 a, const float s) { return (wc_float3) {a.x * s, a.y * s, a.z * s}; }
+static inline float wc_float3_dot(const wc_float3 a, const wc_float3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+static inline float wc_float3_length(const wc_float3 a) { return sqrtf(wc_float3_dot(a, a)); }
+
+static inline wc_float3 wc_float3_cross(const wc_float3 a, const wc_float3 b)
+{
+    return (wc_float3) {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+}
+
+static inline wc_float3 wc_float3_min(const wc_float3 a, const wc_float3 b)
+{
+    return (wc_float3) {fminf(a.x, b.x), fminf(a.y, b.y), fminf(a.z, b.z)};
+}
+
+static inline wc_float3 wc_float3_max(const wc_float3 a, const wc_float3 b)
+{
+    return (wc_float3) {fmaxf(a.x, b.x), fmaxf(a.y, b.y), fmaxf(a.z, b.z)};
+}
+
+static inline wc_float3 wc_float3_lerp(const wc_float3 a, const wc_float3 b, const float t)
+{
+    return (wc_float3) {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t};
+}
+
+// Zero vectors stay zero
+static inline wc_float3 wc_float3_normalize(const wc_float3 a)
+{
+    const float length = wc_float3_length(a);
+    return length > 0.0f ? wc_float3_scale(a, 1.0f / length) : a;
+}
+
+static inline float wc_float4_dot(const wc_float4 a, const wc_float4 b) { return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w; }
+
+// a * b + c, fused exactly when wc_wide_madd is, so scalar code rounds like the wide lanes. Never
+// calls fmaf without hardware FMA behind it.
+static inline float wc_madd(const float a, const float b, const float c)
+{
+#if (defined(WC_MATH_AVX2) && (defined(__FMA__) || defined(_MSC_VER))) || defined(WC_MATH_NEON)
+    return fmaf(a, b, c);
+#else
+    return a * b + c;
+#endif
+}
+
+//-------------------------------------------------------------------------------------------------
+// Approximations
+
+// About 23 bits: the hardware estimate refined by Newton-Raphson
+static inline float wc_rsqrt(const float x)
+{
+#if defined(WC_MATH_SSE)
+    const __m128 v = _mm_set_ss(x);
+    const __m128 r = _mm_rsqrt_ss(v);
+    const __m128 rr = _mm_mul_ss(_mm_mul_ss(v, r), r);
+    return _mm_cvtss_f32(_mm_mul_ss(_mm_mul_ss(_mm_set_ss(0.5f), r), _mm_sub_ss(_mm_set_ss(3.0f), rr)));
+#elif defined(WC_MATH_NEON)
+    float r = vrsqrtes_f32(x);
+    r *= vrsqrtss_f32(x * r, r);
+    return r * vrsqrtss_f32(x * r, r);
+#else
+    return 1.0f / sqrtf(x);
+#endif
+}
+
+// Absolute error around 1e-6 for |x| up to 1e4 radians. The same reduction, polynomials and
+// multiply-adds as wc_wide_sincos, so within one build it matches the wide lanes and the result
+// does not depend on the C library like sinf/cosf. Builds with and without FMA can differ in the
+// last bit or so.
+void wc_sincos(float x, float* s, float* c);
+
+//-------------------------------------------------------------------------------------------------
+// Wide SoA lanes: eight floats with AVX2, four with SSE and NEON. Comparisons return lane masks
+// (all bits set or clear) for wc_wide_select, wc_wide_and and wc_wide_mask_bits.
+
+#if defined(WC_MATH_AVX2)
+    #define WC_WIDE_LANES 8
+typedef __m256 wc_wide;
+
+static inline wc_wide wc_wide_load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void wc_wide_store(float* p, const wc_wide a) { _mm256_storeu_ps(p, a); }
+static inline wc_wide wc_wide_set1(const float a) { return _mm256_set1_ps(a); }
+static inline wc_wide wc_wide_add(const wc_wide a, const wc_wide b) { return _mm256_add_ps(a, b); }
+static inline wc_wide wc_wide_sub(const wc_wide a, const wc_wide b) { return _mm256_sub_ps(a, b); }
+static inline wc_wide wc_wide_mul(const wc_wide a, const wc_wide b) { return _mm256_mul_ps(a, b); }
+static inline wc_wide wc_wide_div(const wc_wide a, const wc_wide b) { return _mm256_div_ps(a, b); }
+static inline wc_wide wc_wide_min(const wc_wide a, const wc_wide b) { return _mm256_min_ps(a, b); }
+static inline wc_wide wc_wide_max(const wc_wide a, const wc_wide b) { return _mm256_max_ps(a, b); }
+static inline wc_wide wc_wide_sqrt(const wc_wide a) { return _mm256_sqrt_ps(a); }
+static inline wc_wide wc_wide_abs(const wc_wide a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+static inline wc_wide wc_wide_round(const wc_wide a) { return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+static inline wc_wide wc_wide_lt(const wc_wide a, const wc_wide b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline wc_wide wc_wide_gt(const wc_wide a, const wc_wide b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline wc_wide wc_wide_ge(const wc_wide a, const wc_wide b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+static inline wc_wide wc_wide_and(const wc_wide a, const wc_wide b) { return _mm256_and_ps(a, b); }
+static inline wc_wide wc_wide_or(const wc_wide a, const wc_wide b) { return _mm256_or_ps(a, b); }
+static inline wc_wide wc_wide_select(const wc_wide mask, const wc_wide a, const wc_wide b) { return _mm256_blendv_ps(b, a, mask); }
+static inline uint32_t wc_wide_mask_bits(const wc_wide mask) { return (uint32_t) _mm256_movemask_ps(mask); }
+
+// a * b + c
+static inline wc_wide wc_wide_madd(const wc_wide a, const wc_wide b, const wc_wide c)
+{
+    #if defined(__FMA__) || defined(_MSC_VER)
+    return _mm256_fmadd_ps(a, b, c);
+    #else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+    #endif
+}
+
+static inline wc_wide wc_wide_rsqrt(const wc_wide a)
+{
+    const wc_wide r = _mm256_rsqrt_ps(a);
+    const wc_wide rr = _mm256_mul_ps(_mm256_mul_ps(a, r), r);
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), r), _mm256_sub_ps(_mm256_set1_ps(3.0f), rr));
+}
+
+#elif defined(WC_MATH_SSE)
+    #define WC_WIDE_LANES 4
+typedef __m128 wc_wide;
+
+static inline wc_wide wc_wide_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void wc_wide_store(float* p, const wc_wide a) { _mm_storeu_ps(p, a); }
+static inline wc_wide wc_wide_set1(const float a) { return _mm_set1_ps(a); }
+static inline wc_wide wc_wide_add(const wc_wide a, const wc_wide b) { return _mm_add_ps(a, b); }
+static inline wc_wide wc_wide_sub(const wc_wide a, const wc_wide b) { return _mm_sub_ps(a, b); }
+static inline wc_wide wc_wide_mul(const wc_wide a, const wc_wide b) { return _mm_mul_ps(a, b); }
+static inline wc_wide wc_wide_div(const wc_wide a, const wc_wide b) { return _mm_div_ps(a, b); }
+static inline wc_wide wc_wide_madd(const wc_wide a, const wc_wide b, const wc_wide c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+static inline wc_wide wc_wide_min(const wc_wide a, const wc_wide b) { return _mm_min_ps(a, b); }
+static inline wc_wide wc_wide_max(const wc_wide a, const wc_wide b) { return _mm_max_ps(a, b); }
+static inline wc_wide wc_wide_sqrt(const wc_wide a) { return _mm_sqrt_ps(a); }
+static inline wc_wide wc_wide_abs(const wc_wide a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+// SSE2 has no float rounding; the conversion rounds to nearest even, valid below 2^31
+static inline wc_wide wc_wide_round(const wc_wide a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+static inline wc_wide wc_wide_lt(const wc_wide a, const wc_wide b) { return _mm_cmplt_ps(a, b); }
+static inline wc_wide wc_wide_gt(const wc_wide a, const wc_wide b) { return _mm_cmpgt_ps(a, b); }
+static inline wc_wide wc_wide_ge(const wc_wide a, const wc_wide b) { return _mm_cmpge_ps(a, b); }
+static inline wc_wide wc_wide_and(const wc_wide a, const wc_wide b) { return _mm_and_ps(a, b); }
+static inline wc_wide wc_wide_or(const wc_wide a, const wc_wide b) { return _mm_or_ps(a, b); }
+static inline uint32_t wc_wide_mask_bits(const wc_wide mask) { return (uint32_t) _mm_movemask_ps(mask); }
+
+static inline wc_wide wc_wide_select(const wc_wide mask, const wc_wide a, const wc_wide b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+static inline wc_wide wc_wide_rsqrt(const wc_wide a)
+{
+    const wc_wide r = _mm_rsqrt_ps(a);
+    const wc_wide rr = _mm_mul_ps(_mm_mul_ps(a, r), r);
+    return _mm_mul_ps(_mm_mul_ps(_mm_set1_ps(0.5f), r), _mm_sub_ps(_mm_set1_ps(3.0f), rr));
+}
+
+#elif defined(WC_MATH_NEON)
+    #define WC_WIDE_LANES 4
+typedef float32x4_t wc_wide;
+
+static inline wc_wide wc_wide_load(const float* p) { return vld1q_f32(p); }
+static inline void wc_wide_store(float* p, const wc_wide a) { vst1q_f32(p, a); }
+static inline wc_wide wc_wide_set1(const float a) { return vdupq_n_f32(a); }
+static inline wc_wide wc_wide_add(const wc_wide a, const wc_wide b) { return vaddq_f32(a, b); }
+static inline wc_wide wc_wide_sub(const wc_wide a, const wc_wide b) { return vsubq_f32(a, b); }
+static inline wc_wide wc_wide_mul(const wc_wide a, const wc_wide b) { return vmulq_f32(a, b); }
+static inline wc_wide wc_wide_div(const wc_wide a, const wc_wide b) { return vdivq_f32(a, b); }
+static inline wc_wide wc_wide_madd(const wc_wide a, const wc_wide b, const wc_wide c) { return vfmaq_f32(c, a, b); }
+static inline wc_wide wc_wide_min(const wc_wide a, const wc_wide b) { return vminq_f32(a, b); }
+static inline wc_wide wc_wide_max(const wc_wide a, const wc_wide b) { return vmaxq_f32(a, b); }
+static inline wc_wide wc_wide_sqrt(const wc_wide a) { return vsqrtq_f32(a); }
+static inline wc_wide wc_wide_abs(const wc_wide a) { return vabsq_f32(a); }
+static inline wc_wide wc_wide_round(const wc_wide a) { return vrndnq_f32(a); }
+static inline wc_wide wc_wide_lt(const wc_wide a, const wc_wide b) { return vreinterpretq_f32_u32(vcltq_f32(a, b)); }
+static inline wc_wide wc_wide_gt(const wc_wide a, const wc_wide b) { return vreinterpretq_f32_u32(vcgtq_f32(a, b)); }
+static inline wc_wide wc_wide_ge(const wc_wide a, const wc_wide b) { return vreinterpretq_f32_u32(vcgeq_f32(a, b)); }
+
+static inline wc_wide wc_wide_and(const wc_wide a, const wc_wide b)
+{
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+static inline wc_wide wc_wide_or(const wc_wide a, const wc_wide b)
+{
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(a), vreinterpretq_u32_f32(b)));
+}
+
+static inline wc_wide wc_wide_select(const wc_wide mask, const wc_wide a, const wc_wide b)
+{
+    return vbslq_f32(vreinterpretq_u32_f32(mask), a, b);
+}
+
+static inline uint32_t wc_wide_mask_bits(const wc_wide mask)
+{
+    static const int32_t shifts[4] = {0, 1, 2, 3};
+    const uint32x4_t bits = vshrq_n_u32(vreinterpretq_u32_f32(mask), 31);
+    return vaddvq_u32(vshlq_u32(bits, vld1q_s32(shifts)));
+}
+
+// The NEON estimate has only 8 bits, so it takes two refinement steps
+static inline wc_wide wc_wide_rsqrt(const wc_wide a)
+{
+    wc_wide r = vrsqrteq_f32(a);
+    r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+    return vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a, r), r));
+}
+
+#else
+    #define WC_WIDE_LANES 4
+typedef union wc_wide {
+    float f[4];
+    uint32_t u[4];
+} wc_wide;
+
+    #define WC_WIDE_SCALAR_OP(expression)                                                                                              \
+        wc_wide r;                                                                                                                     \
+        for (int i = 0; i < 4; i++)                                                                                                    \
+            expression;                                                                                                                \
+        return r
+
+static inline wc_wide wc_wide_load(const float* p) { WC_WIDE_SCALAR_OP(r.f[i] = p[i]); }
+static inline void wc_wide_store(float* p, const wc_wide a) { for (int i = 0; i < 4; i++) p[i] = a.f[i]; }
+static inline wc_wide wc_wide_set1(const float a) { WC_WIDE_SCALAR_OP(r.f[i] = a); }
+static inline wc_wide wc_wide_add(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] + b.f[i]); }
+static inline wc_wide wc_wide_sub(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] - b.f[i]); }
+static inline wc_wide wc_wide_mul(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] * b.f[i]); }
+static inline wc_wide wc_wide_div(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] / b.f[i]); }
+static inline wc_wide wc_wide_madd(const wc_wide a, const wc_wide b, const wc_wide c) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] * b.f[i] + c.f[i]); }
+static inline wc_wide wc_wide_min(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] < b.f[i] ? a.f[i] : b.f[i]); }
+static inline wc_wide wc_wide_max(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.f[i] = a.f[i] > b.f[i] ? a.f[i] : b.f[i]); }
+static inline wc_wide wc_wide_sqrt(const wc_wide a) { WC_WIDE_SCALAR_OP(r.f[i] = sqrtf(a.f[i])); }
+static inline wc_wide wc_wide_rsqrt(const wc_wide a) { WC_WIDE_SCALAR_OP(r.f[i] = 1.0f / sqrtf(a.f[i])); }
+static inline wc_wide wc_wide_abs(const wc_wide a) { WC_WIDE_SCALAR_OP(r.f[i] = fabsf(a.f[i])); }
+static inline wc_wide wc_wide_round(const wc_wide a) { WC_WIDE_SCALAR_OP(r.f[i] = nearbyintf(a.f[i])); }
+static inline wc_wide wc_wide_lt(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = a.f[i] < b.f[i] ? ~0u : 0u); }
+static inline wc_wide wc_wide_gt(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = a.f[i] > b.f[i] ? ~0u : 0u); }
+static inline wc_wide wc_wide_ge(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = a.f[i] >= b.f[i] ? ~0u : 0u); }
+static inline wc_wide wc_wide_and(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = a.u[i] & b.u[i]); }
+static inline wc_wide wc_wide_or(const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = a.u[i] | b.u[i]); }
+static inline wc_wide wc_wide_select(const wc_wide mask, const wc_wide a, const wc_wide b) { WC_WIDE_SCALAR_OP(r.u[i] = (mask.u[i] & a.u[i]) | (~mask.u[i] & b.u[i])); }
+
+static inline uint32_t wc_wide_mask_bits(const wc_wide mask)
+{
+    uint32_t bits = 0;
+    for (int i = 0; i < 4; i++)
+        bits |= (mask.u[i] >> 31) << i;
+    return bits;
+}
+
+    #undef WC_WIDE_SCALAR_OP
+#endif
+
+typedef struct wc_wide3 {
+    wc_wide x, y, z;
+} wc_wide3;
+
+static inline wc_wide wc_wide_zero(void) { return wc_wide_set1(0.0f); }
+static inline wc_wide wc_wide_neg(const wc_wide a) { return wc_wide_sub(wc_wide_zero(), a); }
+
+static inline wc_wide wc_wide3_dot(const wc_wide3 a, const wc_wide3 b)
+{
+    return wc_wide_madd(a.x, b.x, wc_wide_madd(a.y, b.y, wc_wide_mul(a.z, b.z)));
+}
+
+// Folds x onto [-pi/2, pi/2], where Taylor polynomials of degree 11 and 12 stay below 1e-7. Whole
+// turns are removed in two parts (Cody-Waite): the high part has few enough bits that
+// turns * high is exact below 2^16 turns.
+static inline void wc_wide_sincos(const wc_wide x, wc_wide* s, wc_wide* c)
+{
+    const wc_wide turns = wc_wide_round(wc_wide_mul(x, wc_wide_set1(1.0f / WC_TWO_PI)));
+    wc_wide r = wc_wide_madd(turns, wc_wide_set1(-6.28125f), x);
+    r = wc_wide_madd(turns, wc_wide_set1(-1.9353071795864769e-3f), r);
+
+    // sin(pi - r) = sin(r) while cos(pi - r) = -cos(r)
+    const wc_wide above = wc_wide_gt(r, wc_wide_set1(WC_HALF_PI));
+    const wc_wide below = wc_wide_lt(r, wc_wide_set1(-WC_HALF_PI));
+    r = wc_wide_select(above, wc_wide_sub(wc_wide_set1(WC_PI), r), r);
+    r = wc_wide_select(below, wc_wide_sub(wc_wide_set1(-WC_PI), r), r);
+    const wc_wide cos_sign = wc_wide_select(wc_wide_or(above, below), wc_wide_set1(-1.0f), wc_wide_set1(1.0f));
+
+    const wc_wide r2 = wc_wide_mul(r, r);
+    wc_wide sp = wc_wide_madd(r2, wc_wide_set1(-1.0f / 39916800.0f), wc_wide_set1(1.0f / 362880.0f));
+    sp = wc_wide_madd(r2, sp, wc_wide_set1(-1.0f / 5040.0f));
+    sp = wc_wide_madd(r2, sp, wc_wide_set1(1.0f / 120.0f));
+    sp = wc_wide_madd(r2, sp, wc_wide_set1(-1.0f / 6.0f));
+    sp = wc_wide_madd(r2, sp, wc_wide_set1(1.0f));
+    *s = wc_wide_mul(r, sp);
+
+    wc_wide cp = wc_wide_madd(r2, wc_wide_set1(1.0f / 479001600.0f), wc_wide_set1(-1.0f / 3628800.0f));
+    cp = wc_wide_madd(r2, cp, wc_wide_set1(1.0f / 40320.0f));
+    cp = wc_wide_madd(r2, cp, wc_wide_set1(-1.0f / 720.0f));
+    cp = wc_wide_madd(r2, cp, wc_wide_set1(1.0f / 24.0f));
+    cp = wc_wide_madd(r2, cp, wc_wide_set1(-0.5f));
+    cp = wc_wide_madd(r2, cp, wc_wide_set1(1.0f));
+    *c = wc_wide_mul(cos_sign, cp);
+}
+
+// Frustum planes broadcast once per batch, so a test costs no shuffles
+typedef struct wc_wide_frustum {
+    wc_wide nx[6], ny[6], nz[6], d[6];
+} wc_wide_frustum;
+
+void wc_wide_frustum_init(const wc_frustum* frustum, wc_wide_frustum* wide);
+
+// Lane mask of the spheres at least partially inside all six planes
+static inline wc_wide wc_wide_frustum_test_spheres(const wc_wide_frustum* frustum, const wc_wide3 center, const wc_wide radius)
+{
+    const wc_wide neg_radius = wc_wide_neg(radius);
+    wc_wide inside = wc_wide_ge(wc_wide_zero(), wc_wide_zero());
+    for (int p = 0; p < 6; p++)
+    {
+        wc_wide distance = wc_wide_madd(frustum->nx[p], center.x, frustum->d[p]);
+        distance = wc_wide_madd(frustum->ny[p], center.y, distance);
+        distance = wc_wide_madd(frustum->nz[p], center.z, distance);
+        inside = wc_wide_and(inside, wc_wide_ge(distance, neg_radius));
+    }
+    return inside;
+}
+
+//-------------------------------------------------------------------------------------------------
+// Quaternions
+
+static inline wc_quat wc_quat_identity(void) { return (wc_quat) {0.0f, 0.0f, 0.0f, 1.0f}; }
+
+wc_quat wc_quat_from_axis_angle(wc_float3 axis, float angle);
+wc_quat wc_quat_mul(wc_quat a, wc_quat b);
+wc_quat wc_quat_normalize(wc_quat q);
+wc_float3 wc_quat_rotate(wc_quat q, wc_float3 v);
+// Shortest-path normalized lerp, good enough for the small per-tick steps of unit facing
+wc_quat wc_quat_nlerp(wc_quat a, wc_quat b, float t);
+wc_quat wc_quat_slerp(wc_quat a, wc_quat b, float t);
+
+//-------------------------------------------------------------------------------------------------
+// Matrices. Outputs may alias inputs.
+
+void wc_mat4_identity(wc_mat4* out);
+void wc_mat4_mul(const wc_mat4* a, const wc_mat4* b, wc_mat4* out);
+void wc_mat4_transpose(const wc_mat4* m, wc_mat4* out);
+// Returns false and leaves out untouched for singular matrices
+bool wc_mat4_inverse(const wc_mat4* m, wc_mat4* out);
+wc_float4 wc_mat4_transform(const wc_mat4* m, wc_float4 v);
+// w = 1, no perspective divide
+wc_float3 wc_mat4_transform_point(const wc_mat4* m, wc_float3 p);
+
+void wc_mat4_translation(wc_float3 t, wc_mat4* out);
+void wc_mat4_scale(wc_float3 s, wc_mat4* out);
+// Units turn around +Z, the same yaw convention as the instance transform in the shaders
+void wc_mat4_rotation_z(float angle, wc_mat4* out);
+void wc_mat4_from_trs(wc_float3 translation, wc_quat rotation, wc_float3 scale, wc_mat4* out);
+// Right-handed view looking down -Z; Vulkan clip space with Y down and depth in [0, 1]
+void wc_mat4_look_at(wc_float3 eye, wc_float3 target, wc_float3 up, wc_mat4* out);
+void wc_mat4_perspective(float fov_y, float aspect, float near_plane, float far_plane, wc_mat4* out);
+
+//-------------------------------------------------------------------------------------------------
+// Batch transforms
+
+// Unit transforms in SoA layout: position, yaw in radians around +Z and uniform scale
+typedef struct wc_transform_soa {
+    const float* x;
+    const float* y;
+    const float* z;
+    const float* yaw;
+    const float* scale;
+    uint32_t count;
+} wc_transform_soa;
+
+// Builds one matrix per unit, WC_WIDE_LANES at a time. Output is written with non-temporal stores
+// meant for mapped, write-combined GPU memory: keep it 32-byte aligned for mat4 and 16-byte aligned
+// for mat3x4, otherwise regular stores are used.
+void wc_transform_build_mat4(const wc_transform_soa* transforms, wc_mat4* out);
+void wc_transform_build_mat3x4(const wc_transform_soa* transforms, wc_mat3x4* out);
+// Per-unit reference the batch paths are checked against
+void wc_transform_build_mat4_scalar(const wc_transform_soa* transforms, wc_mat4* out);
+
+// Times scalar and batch construction over count random units and checks they agree
+void wc_transform_benchmark(uint32_t count);
+
+//-------------------------------------------------------------------------------------------------
+// Bounds
+
+static inline bool wc_aabb_overlaps(const wc_aabb* a, const wc_aabb* b)
+{
+    return a->min.x <= b->max.x && a->max.x >= b->min.x && a->min.y <= b->max.y && a->max.y >= b->min.y &&
+           a->min.z <= b->max.z && a->max.z >= b->min.z;
+}
+
+static inline bool wc_aabb_contains(const wc_aabb* a, const wc_float3 p)
+{
+    return p.x >= a->min.x && p.x <= a->max.x && p.y >= a->min.y && p.y <= a->max.y && p.z >= a->min.z && p.z <= a->max.z;
+}
+
+static inline bool wc_sphere_overlaps(const wc_sphere* a, const wc_sphere* b)
+{
+    const wc_float3 d = wc_float3_sub(a->center, b->center);
+    const float r = a->radius + b->radius;
+    return wc_float3_dot(d, d) <= r * r;
+}
+
+bool wc_aabb_sphere_overlaps(const wc_aabb* a, const wc_sphere* s);
+// Bounds of the transformed box, from the matrix columns rather than eight corner transforms
+wc_aabb wc_aabb_transform(const wc_mat4* m, const wc_aabb* a);
+
+// Gribb-Hartmann extraction from a column-major view-projection with [0, 1] depth, normalized
+void wc_frustum_from_matrix(const wc_mat4* view_proj, wc_frustum* out);
+bool wc_frustum_test_sphere(const wc_frustum* frustum, const wc_sphere* s);
+bool wc_frustum_test_aabb(const wc_frustum* frustum, const wc_aabb* a);
+
+// Runs every SIMD path against the scalar reference on random inputs and logs the largest
+// differences. Returns non-zero when one is out of tolerance.
+int wc_math_validate(uint32_t iterations);
@@ -0,0 +1,157 @@
+#include "profiler.h"
+
+#include <SDL3/SDL.h>
+
+#define PROFILER_ZONE_NONE UINT32_MAX
+
+typedef struct
+{
+	const char* name;
+	uint64_t begin;
+	uint64_t end;
+	bool gpu;
+} ProfilerZone;
+
+typedef struct
+{
+	const char* zone;
+	const char* name;
+	uint64_t value;
+} ProfilerCounter;
+
+typedef struct
+{
+	uint64_t index;
+	uint64_t begin;
+	uint64_t end;
+	ProfilerZone zones[PROFILER_MAX_ZONES];
+	uint32_t zoneCount;
+	ProfilerCounter counters[PROFILER_MAX_COUNTERS];
+	uint32_t counterCount;
+} ProfilerFrame;
+
+typedef struct
+{
+	ProfilerFrame frames[PROFILER_FRAME_HISTORY];
+	uint64_t frameIndex;
+	uint64_t lastReport;
+	double msPerTick;
+	bool initialized;
+} Profiler;
+
+static Profiler s_profiler;
+
+static ProfilerFrame* profiler_find_frame(const uint64_t frame)
+{
+	ProfilerFrame* record = &s_profiler.frames[frame % PROFILER_FRAME_HISTORY];
+	return s_profiler.initialized && record->index == frame ? record : NULL;
+}
+
+static void profiler_report(const ProfilerFrame* frame)
+{
+	SDL_Log("Frame %" SDL_PRIu64 ": %.2f ms\n", frame->index, (double)(frame->end - frame->begin) * s_profiler.msPerTick);
+
+	// Zones are listed in submission order: CPU zones as they closed, GPU zones as they were read back
+	for (uint32_t i = 0; i < frame->zoneCount; i++)
+	{
+		const ProfilerZone* zone = &frame->zones[i];
+		if (zone->end == 0)
+			continue;
+		const double start = ((double)zone->begin - (double)frame->begin) * s_profiler.msPerTick;
+		SDL_Log("  %s %-24s %8.3f ms  @ %+.3f ms\n", zone->gpu ? "GPU" : "CPU", zone->name,
+				(double)(zone->end - zone->begin) * s_profiler.msPerTick, start);
+	}
+	for (uint32_t i = 0; i < frame->counterCount; i++)
+	{
+		const ProfilerCounter* counter = &frame->counters[i];
+		SDL_Log("  GPU %s %s: %" SDL_PRIu64 "\n", counter->zone, counter->name, counter->value);
+	}
+}
+
+void profiler_init(void)
+{
+	SDL_memset(&s_profiler, 0, sizeof(s_profiler));
+	for (uint32_t i = 0; i < PROFILER_FRAME_HISTORY; i++)
+	{
+		s_profiler.frames[i].index = UINT64_MAX;
+	}
+	s_profiler.msPerTick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	s_profiler.lastReport = SDL_GetTicks();
+	s_profiler.initialized = true;
+}
+
+void profiler_shutdown(void)
+{
+	SDL_memset(&s_profiler, 0, sizeof(s_profiler));
+}
+
+void profiler_frame_start(void)
+{
+	ProfilerFrame* frame = &s_profiler.frames[s_profiler.frameIndex % PROFILER_FRAME_HISTORY];
+	frame->index = s_profiler.frameIndex;
+	frame->begin = SDL_GetPerformanceCounter();
+	frame->end = 0;
+	frame->zoneCount = 0;
+	frame->counterCount = 0;
+}
+
+void profiler_frame_end(void)
+{
+	if (!s_profiler.initialized)
+		return;
+
+	s_profiler.frames[s_profiler.frameIndex % PROFILER_FRAME_HISTORY].end = SDL_GetPerformanceCounter();
+	s_profiler.frameIndex++;
+
+	const uint64_t now = SDL_GetTicks();
+	if (now - s_profiler.lastReport < PROFILER_REPORT_INTERVAL_MS)
+		return;
+
+	// The next frame_start reuses this record, so it is as complete as it will ever be
+	const ProfilerFrame* oldest = profiler_find_frame(s_profiler.frameIndex - PROFILER_FRAME_HISTORY);
+	if (s_profiler.frameIndex >= PROFILER_FRAME_HISTORY && oldest)
+	{
+		profiler_report(oldest);
+		s_profiler.lastReport = now;
+	}
+}
+
+uint64_t profiler_frame_index(void)
+{
+	return s_profiler.frameIndex;
+}
+
+uint32_t profiler_zone_begin(const char* name)
+{
+	ProfilerFrame* frame = profiler_find_frame(s_profiler.frameIndex);
+	if (!frame || frame->zoneCount >= PROFILER_MAX_ZONES)
+		return PROFILER_ZONE_NONE;
+
+	const uint32_t zone = frame->zoneCount++;
+	frame->zones[zone] = (ProfilerZone){.name = name, .begin = SDL_GetPerformanceCounter()};
+	return zone;
+}
+
+void profiler_zone_end(const uint32_t zone)
+{
+	ProfilerFrame* frame = profiler_find_frame(s_profiler.frameIndex);
+	if (!frame || zone >= frame->zoneCount)
+		return;
+	frame->zones[zone].end = SDL_GetPerformanceCounter();
+}
+
+void profiler_submit_gpu_zone(const uint64_t frame, const char* name, const uint64_t begin, const uint64_t end)
+{
+	ProfilerFrame* record = profiler_find_frame(frame);
+	if (!record || record->zoneCount >= PROFILER_MAX_ZONES)
+		return;
+	record->zones[record->zoneCount++] = (ProfilerZone){.name = name, .begin = begin, .end = SDL_max(begin, end), .gpu = true};
+}
+
+void profiler_submit_counter(const uint64_t frame, const char* zone, const char* name, const uint64_t value)
+{
+	ProfilerFrame* record = profiler_find_frame(frame);
+	if (!record || record->counterCount >= PROFILER_MAX_COUNTERS)
+		return;
+	record->counters[record->counterCount++] = (ProfilerCounter){.zone = zone, .name = name, .value = value};
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#define PROFILER_MAX_ZONES 64
+#define PROFILER_MAX_COUNTERS 32
+// Frames kept open for late results; GPU queries are read back a few frames after submission
+#define PROFILER_FRAME_HISTORY 8
+#define PROFILER_REPORT_INTERVAL_MS 1000
+
+// Per-frame timing report of CPU zones, GPU zones and GPU counters. Times are in
+// SDL_GetPerformanceCounter ticks so GPU results placed on the CPU timeline line up with CPU zones.
+// Names must outlive the profiler (string literals). Main thread only.
+void profiler_init(void);
+void profiler_shutdown(void);
+
+void profiler_frame_start(void);
+// Closes the frame and, once per report interval, logs the oldest frame still held, which has had
+// PROFILER_FRAME_HISTORY - 1 frames for its GPU results to arrive.
+void profiler_frame_end(void);
+uint64_t profiler_frame_index(void);
+
+uint32_t profiler_zone_begin(const char* name);
+void profiler_zone_end(uint32_t zone);
+
+// Results for an earlier frame; dropped if the frame has already left the history.
+void profiler_submit_gpu_zone(uint64_t frame, const char* name, uint64_t begin, uint64_t end);
+void profiler_submit_counter(uint64_t frame, const char* zone, const char* name, uint64_t value);
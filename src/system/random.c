@@ -0,0 +1,217 @@
+#include "random.h"
+
+// For the SIMD backend selection
+#include "math.h"
+
+// Low-bias 32-bit integer hash (Wellons): a bijection, so distinct counters never collide
+static inline uint32_t random_mix(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+static inline uint32_t random_hash(const uint32_t key[2], const uint32_t counter)
+{
+	return random_mix(random_mix(counter ^ key[0]) + key[1]);
+}
+
+static uint64_t random_splitmix(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15ull;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+	return x ^ (x >> 31);
+}
+
+static WC_Random random_from_key(const uint64_t key)
+{
+	return (WC_Random){{(uint32_t)key, (uint32_t)(key >> 32)}, 0};
+}
+
+WC_Random wc_random_stream(const uint64_t seed, const uint32_t system, const uint32_t chunk, const uint64_t tick)
+{
+	uint64_t key = random_splitmix(seed);
+	key = random_splitmix(key ^ ((uint64_t)system << 32 | chunk));
+	key = random_splitmix(key ^ tick);
+	return random_from_key(key);
+}
+
+WC_Random wc_random_split(const WC_Random* random, const uint32_t id)
+{
+	const uint64_t key = (uint64_t)random->key[1] << 32 | random->key[0];
+	return random_from_key(random_splitmix(key ^ random_splitmix(id)));
+}
+
+uint32_t wc_random_at(const WC_Random* random, const uint32_t index)
+{
+	return random_hash(random->key, index);
+}
+
+uint32_t wc_random_u32(WC_Random* random)
+{
+	return random_hash(random->key, random->counter++);
+}
+
+uint32_t wc_random_below(WC_Random* random, const uint32_t n)
+{
+	return (uint32_t)(((uint64_t)wc_random_u32(random) * n) >> 32);
+}
+
+float wc_random_float(WC_Random* random)
+{
+	return (float)(wc_random_u32(random) >> 8) * (1.0f / 16777216.0f);
+}
+
+float wc_random_range(WC_Random* random, const float min, const float max)
+{
+	return min + wc_random_float(random) * (max - min);
+}
+
+//-------------------------------------------------------------------------------------------------
+// Batches
+
+#if defined(WC_MATH_AVX2)
+	#define RANDOM_LANES 8
+typedef __m256i RandomWide;
+
+static inline RandomWide random_wide_mix(RandomWide x)
+{
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32(0x7feb352d));
+	x = _mm256_xor_si256(x, _mm256_srli_epi32(x, 15));
+	x = _mm256_mullo_epi32(x, _mm256_set1_epi32((int)0x846ca68bu));
+	return _mm256_xor_si256(x, _mm256_srli_epi32(x, 16));
+}
+
+static inline RandomWide random_wide_next(const WC_Random* random, const uint32_t counter)
+{
+	const RandomWide counters = _mm256_add_epi32(_mm256_set1_epi32((int)counter), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+	const RandomWide x = random_wide_mix(_mm256_xor_si256(counters, _mm256_set1_epi32((int)random->key[0])));
+	return random_wide_mix(_mm256_add_epi32(x, _mm256_set1_epi32((int)random->key[1])));
+}
+
+// High halves of the 32x32 products, even and odd lanes separately
+static inline RandomWide random_wide_below(const RandomWide x, const uint32_t n)
+{
+	const RandomWide range = _mm256_set1_epi32((int)n);
+	const RandomWide even = _mm256_srli_epi64(_mm256_mul_epu32(x, range), 32);
+	const RandomWide odd = _mm256_mul_epu32(_mm256_srli_epi64(x, 32), range);
+	return _mm256_blend_epi32(even, odd, 0xAA);
+}
+
+static inline __m256 random_wide_float(const RandomWide x)
+{
+	return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(x, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+static inline void random_wide_store(uint32_t* out, const RandomWide x)
+{
+	_mm256_storeu_si256((RandomWide*)out, x);
+}
+#elif defined(WC_MATH_NEON)
+	#define RANDOM_LANES 4
+typedef uint32x4_t RandomWide;
+
+static inline RandomWide random_wide_mix(RandomWide x)
+{
+	x = veorq_u32(x, vshrq_n_u32(x, 16));
+	x = vmulq_u32(x, vdupq_n_u32(0x7feb352du));
+	x = veorq_u32(x, vshrq_n_u32(x, 15));
+	x = vmulq_u32(x, vdupq_n_u32(0x846ca68bu));
+	return veorq_u32(x, vshrq_n_u32(x, 16));
+}
+
+static inline RandomWide random_wide_next(const WC_Random* random, const uint32_t counter)
+{
+	static const uint32_t lanes[4] = {0, 1, 2, 3};
+	const RandomWide counters = vaddq_u32(vdupq_n_u32(counter), vld1q_u32(lanes));
+	const RandomWide x = random_wide_mix(veorq_u32(counters, vdupq_n_u32(random->key[0])));
+	return random_wide_mix(vaddq_u32(x, vdupq_n_u32(random->key[1])));
+}
+
+static inline RandomWide random_wide_below(const RandomWide x, const uint32_t n)
+{
+	const uint64x2_t low = vmull_n_u32(vget_low_u32(x), n);
+	const uint64x2_t high = vmull_high_n_u32(x, n);
+	return vcombine_u32(vshrn_n_u64(low, 32), vshrn_n_u64(high, 32));
+}
+
+static inline float32x4_t random_wide_float(const RandomWide x)
+{
+	return vmulq_n_f32(vcvtq_f32_u32(vshrq_n_u32(x, 8)), 1.0f / 16777216.0f);
+}
+
+static inline void random_wide_store(uint32_t* out, const RandomWide x)
+{
+	vst1q_u32(out, x);
+}
+#endif
+
+void wc_random_fill_u32(WC_Random* random, uint32_t* out, const uint32_t count)
+{
+	uint32_t i = 0;
+#if defined(RANDOM_LANES)
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+		random_wide_store(out + i, random_wide_next(random, random->counter + i));
+#endif
+	random->counter += i;
+	for (; i < count; i++)
+		out[i] = wc_random_u32(random);
+}
+
+void wc_random_fill_below(WC_Random* random, const uint32_t n, uint32_t* out, const uint32_t count)
+{
+	uint32_t i = 0;
+#if defined(RANDOM_LANES)
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+		random_wide_store(out + i, random_wide_below(random_wide_next(random, random->counter + i), n));
+#endif
+	random->counter += i;
+	for (; i < count; i++)
+		out[i] = wc_random_below(random, n);
+}
+
+void wc_random_fill_float(WC_Random* random, float* out, const uint32_t count)
+{
+	uint32_t i = 0;
+#if defined(WC_MATH_AVX2)
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+		_mm256_storeu_ps(out + i, random_wide_float(random_wide_next(random, random->counter + i)));
+#elif defined(WC_MATH_NEON)
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+		vst1q_f32(out + i, random_wide_float(random_wide_next(random, random->counter + i)));
+#endif
+	random->counter += i;
+	for (; i < count; i++)
+		out[i] = wc_random_float(random);
+}
+
+// Multiply then add like the scalar path. Compilers allowed to contract floating point (/fp:fast)
+// may still fuse the scalar one, so state that must stay in lockstep should use the integer draws.
+void wc_random_fill_range(WC_Random* random, const float min, const float max, float* out, const uint32_t count)
+{
+	uint32_t i = 0;
+#if defined(WC_MATH_AVX2)
+	const __m256 base = _mm256_set1_ps(min);
+	const __m256 extent = _mm256_set1_ps(max - min);
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+	{
+		const __m256 f = random_wide_float(random_wide_next(random, random->counter + i));
+		_mm256_storeu_ps(out + i, _mm256_add_ps(base, _mm256_mul_ps(f, extent)));
+	}
+#elif defined(WC_MATH_NEON)
+	const float32x4_t base = vdupq_n_f32(min);
+	for (; i + RANDOM_LANES <= count; i += RANDOM_LANES)
+	{
+		const float32x4_t f = random_wide_float(random_wide_next(random, random->counter + i));
+		vst1q_f32(out + i, vaddq_f32(base, vmulq_n_f32(f, max - min)));
+	}
+#endif
+	random->counter += i;
+	for (; i < count; i++)
+		out[i] = wc_random_range(random, min, max);
+}
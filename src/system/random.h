@@ -0,0 +1,38 @@
+#pragma once
+
+#include <stdint.h>
+
+// Counter-based random streams: a value is a keyed hash of its index, so a stream is just a key
+// and a counter. Every system, chunk and tick derives its own key from the match seed, which lets
+// parallel jobs draw without sharing state and replays stay identical for lockstep regardless of
+// how the work was split across threads.
+typedef struct WC_Random
+{
+	uint32_t key[2];
+	uint32_t counter;
+} WC_Random;
+
+// Independent stream for one system (a caller-chosen id), one chunk of its work and one tick.
+// Pass 0 for parts that do not apply.
+WC_Random wc_random_stream(uint64_t seed, uint32_t system, uint32_t chunk, uint64_t tick);
+// Child stream of an existing one, e.g. per unit within a chunk
+WC_Random wc_random_split(const WC_Random* random, uint32_t id);
+
+// Value at an index of the stream, without advancing it
+uint32_t wc_random_at(const WC_Random* random, uint32_t index);
+
+uint32_t wc_random_u32(WC_Random* random);
+// [0, n), unbiased enough for gameplay: the high half of a 32x32 multiply (Lemire, no rejection)
+uint32_t wc_random_below(WC_Random* random, uint32_t n);
+// [0, 1) with 24 bits, exact and identical on every platform
+float wc_random_float(WC_Random* random);
+float wc_random_range(WC_Random* random, float min, float max);
+
+// Batch generation, eight values per iteration with AVX2 and four with NEON. Each fill keeps the
+// stream position in sync with the scalar calls, so the two can be interleaved, and integer and
+// [0, 1) results match them bit for bit. Ranges may differ in the last bit unless floating point
+// contraction is disabled for random.c, since the compiler may fuse the scalar multiply-add.
+void wc_random_fill_u32(WC_Random* random, uint32_t* out, uint32_t count);
+void wc_random_fill_below(WC_Random* random, uint32_t n, uint32_t* out, uint32_t count);
+void wc_random_fill_float(WC_Random* random, float* out, uint32_t count);
+void wc_random_fill_range(WC_Random* random, float min, float max, float* out, uint32_t count);
@@ -0,0 +1,189 @@
+#include "startup.h"
+
+#include "job.h"
+
+#include <SDL3/SDL.h>
+
+// Polling interval of the main thread while only jobs are running
+#define STARTUP_POLL_NS 50000
+
+typedef enum
+{
+	STARTUP_PENDING,
+	STARTUP_RUNNING,
+	STARTUP_DONE,
+} StartupState;
+
+typedef struct
+{
+	const char* name;
+	WC_StartupFunc func;
+	void* data;
+	uint32_t after;
+	bool mainThread;
+	StartupState state; // Main thread only
+	SDL_AtomicInt finished;
+	int result;
+	uint32_t thread;
+	uint64_t begin;
+	uint64_t end;
+} StartupTask;
+
+typedef struct
+{
+	StartupTask tasks[WC_STARTUP_MAX_TASKS];
+	uint32_t count;
+} Startup;
+
+static Startup s_startup;
+
+static void startup_execute(StartupTask* task)
+{
+	task->thread = job_get_worker_index();
+	task->begin = SDL_GetPerformanceCounter();
+	task->result = task->func(task->data);
+	task->end = SDL_GetPerformanceCounter();
+	// Publishes result and timestamps to the polling main thread
+	SDL_SetAtomicInt(&task->finished, 1);
+}
+
+static void startup_job(void* data)
+{
+	startup_execute(data);
+}
+
+// Tasks in start order, with the overlap shown as the offset from the start of the run. The work
+// total is what a serial startup would have cost.
+static void startup_report(const uint64_t begin, const uint64_t end)
+{
+	const double ms_per_tick = 1000.0 / (double)SDL_GetPerformanceFrequency();
+	uint32_t order[WC_STARTUP_MAX_TASKS];
+	uint32_t started = 0;
+	double work = 0.0;
+	for (uint32_t i = 0; i < s_startup.count; i++)
+	{
+		if (s_startup.tasks[i].state != STARTUP_DONE)
+			continue;
+		uint32_t j = started++;
+		for (; j > 0 && s_startup.tasks[order[j - 1]].begin > s_startup.tasks[i].begin; j--)
+			order[j] = order[j - 1];
+		order[j] = i;
+		work += (double)(s_startup.tasks[i].end - s_startup.tasks[i].begin) * ms_per_tick;
+	}
+
+	const double total = (double)(end - begin) * ms_per_tick;
+	SDL_Log("Startup: %.2f ms, %.2f ms of work (%.1fx)\n", total, work, total > 0.0 ? work / total : 1.0);
+	for (uint32_t i = 0; i < started; i++)
+	{
+		const StartupTask* task = &s_startup.tasks[order[i]];
+		const double start = (double)(task->begin - begin) * ms_per_tick;
+		const double duration = (double)(task->end - task->begin) * ms_per_tick;
+		if (task->thread == job_get_worker_count())
+			SDL_Log("  %-20s %8.2f ms  at %8.2f ms  main%s\n", task->name, duration, start, task->result ? "  FAILED" : "");
+		else
+			SDL_Log("  %-20s %8.2f ms  at %8.2f ms  worker %u%s\n", task->name, duration, start, task->thread,
+					task->result ? "  FAILED" : "");
+	}
+}
+
+uint32_t wc_startup_add(const char* name, const WC_StartupFunc func, void* data, const uint32_t after, const bool main_thread)
+{
+	if (s_startup.count >= WC_STARTUP_MAX_TASKS)
+		return WC_STARTUP_NONE;
+
+	const uint32_t handle = s_startup.count++;
+	StartupTask* task = &s_startup.tasks[handle];
+	SDL_memset(task, 0, sizeof(*task));
+	task->name = name;
+	task->func = func;
+	task->data = data;
+	task->after = after;
+	task->mainThread = main_thread;
+	task->state = STARTUP_PENDING;
+	return handle;
+}
+
+int wc_startup_run(void)
+{
+	const uint64_t begin = SDL_GetPerformanceCounter();
+	uint32_t done = 0;
+	uint32_t running = 0;
+	bool failed = false;
+
+	for (uint32_t i = 0; i < s_startup.count; i++)
+	{
+		// Dependencies on later or missing tasks could never be met
+		if (s_startup.tasks[i].after & ~(WC_STARTUP_AFTER(i) - 1))
+		{
+			SDL_LogError(SDL_LOG_CATEGORY_APPLICATION, "Startup task %s depends on a later task\n", s_startup.tasks[i].name);
+			s_startup.count = 0;
+			return EXIT_FAILURE;
+		}
+	}
+
+	for (;;)
+	{
+		// Retire finished jobs first so their dependents can start in this pass
+		for (uint32_t i = 0; i < s_startup.count; i++)
+		{
+			StartupTask* task = &s_startup.tasks[i];
+			if (task->state == STARTUP_RUNNING && SDL_GetAtomicInt(&task->finished))
+			{
+				task->state = STARTUP_DONE;
+				done |= WC_STARTUP_AFTER(i);
+				running--;
+				failed |= task->result != 0;
+			}
+		}
+
+		// Jobs are launched before any main-thread task runs, so they overlap with it
+		StartupTask* inline_task = NULL;
+		uint32_t pending = 0;
+		for (uint32_t i = 0; i < s_startup.count; i++)
+		{
+			StartupTask* task = &s_startup.tasks[i];
+			if (task->state != STARTUP_PENDING)
+				continue;
+			pending++;
+			if (failed || (task->after & done) != task->after)
+				continue;
+			if (task->mainThread)
+			{
+				if (!inline_task)
+					inline_task = task;
+				continue;
+			}
+			const JobHandle job = job_create(startup_job, task);
+			if (job.value == INVALID_JOB_HANDLE.value)
+			{
+				// Out of job slots: run it here rather than stall the graph
+				inline_task = task;
+				continue;
+			}
+			task->state = STARTUP_RUNNING;
+			running++;
+			job_run(job);
+		}
+
+		if (inline_task && !failed)
+		{
+			startup_execute(inline_task);
+			inline_task->state = STARTUP_DONE;
+			done |= WC_STARTUP_AFTER((uint32_t)(inline_task - s_startup.tasks));
+			failed |= inline_task->result != 0;
+			continue;
+		}
+
+		if (running == 0)
+		{
+			// Nothing left that can start: either finished, failed, or a task was skipped
+			failed |= pending > 0;
+			break;
+		}
+		SDL_DelayNS(STARTUP_POLL_NS);
+	}
+
+	startup_report(begin, SDL_GetPerformanceCounter());
+	s_startup.count = 0;
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
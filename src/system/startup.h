@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define WC_STARTUP_MAX_TASKS 32
+#define WC_STARTUP_NONE UINT32_MAX
+
+// Dependency mask bit for a task handle returned by wc_startup_add
+#define WC_STARTUP_AFTER(task) (1u << (task))
+
+typedef int (*WC_StartupFunc)(void* data);
+
+// Initialization task graph. Each task runs once all the tasks in its dependency mask have
+// finished: main-thread tasks (SDL video, Vulkan objects tied to the window) inline on the caller,
+// the rest as jobs, so independent steps overlap. Needs the job system. Names must outlive the run.
+// Returns WC_STARTUP_NONE when the graph is full.
+uint32_t wc_startup_add(const char* name, WC_StartupFunc func, void* data, uint32_t after, bool main_thread);
+
+// Runs the graph to completion and logs a timing report. A task returning non-zero stops any
+// further tasks from starting; those already running are waited for. Clears the graph for reuse.
+// Returns non-zero on failure.
+int wc_startup_run(void);
@@ -0,0 +1,94 @@
+// Build tool: packs compiled SPIR-V modules into one archive the game maps at startup.
+// Usage: shader_pack <output.pak> <module.spv>...
+
+#include "../render/shader_pack.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void* read_file(const char* path, uint32_t* size)
+{
+	FILE* file = fopen(path, "rb");
+	if (!file)
+		return NULL;
+	fseek(file, 0, SEEK_END);
+	const long length = ftell(file);
+	rewind(file);
+
+	void* data = length > 0 ? malloc((size_t)length) : NULL;
+	if (!data || fread(data, 1, (size_t)length, file) != (size_t)length)
+	{
+		free(data);
+		fclose(file);
+		return NULL;
+	}
+	fclose(file);
+	*size = (uint32_t)length;
+	return data;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc < 2)
+	{
+		fprintf(stderr, "usage: shader_pack <output.pak> <module.spv>...\n");
+		return EXIT_FAILURE;
+	}
+
+	const uint32_t count = (uint32_t)(argc - 2);
+	WC_ShaderPackHeader header = {WC_SHADER_PACK_MAGIC, WC_SHADER_PACK_VERSION, count, 0};
+	WC_ShaderPackEntry* entries = calloc(count ? count : 1, sizeof(WC_ShaderPackEntry));
+	void** modules = calloc(count ? count : 1, sizeof(void*));
+
+	uint32_t offset = (uint32_t)(sizeof(header) + count * sizeof(WC_ShaderPackEntry));
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const char* path = argv[i + 2];
+		modules[i] = read_file(path, &entries[i].size);
+		if (!modules[i] || entries[i].size % 4 != 0)
+		{
+			fprintf(stderr, "shader_pack: cannot read SPIR-V module %s\n", path);
+			return EXIT_FAILURE;
+		}
+
+		// Entry name is the file name without directory and .spv extension
+		const char* name = path;
+		for (const char* c = path; *c; c++)
+		{
+			if (*c == '/' || *c == '\\')
+				name = c + 1;
+		}
+		size_t length = strlen(name);
+		if (length > 4 && strcmp(name + length - 4, ".spv") == 0)
+			length -= 4;
+		if (length >= WC_SHADER_PACK_NAME_LENGTH)
+		{
+			fprintf(stderr, "shader_pack: module name too long: %s\n", name);
+			return EXIT_FAILURE;
+		}
+		memcpy(entries[i].name, name, length);
+
+		entries[i].offset = offset;
+		offset += entries[i].size;
+	}
+
+	FILE* output = fopen(argv[1], "wb");
+	if (!output)
+	{
+		fprintf(stderr, "shader_pack: cannot write %s\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fwrite(&header, sizeof(header), 1, output);
+	fwrite(entries, sizeof(WC_ShaderPackEntry), count, output);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		fwrite(modules[i], 1, entries[i].size, output);
+		free(modules[i]);
+	}
+	const int failed = ferror(output);
+	fclose(output);
+	free(modules);
+	free(entries);
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}